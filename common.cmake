@@ -21,7 +21,9 @@ if(TODO MATCHES "ON")
 endif()
 
 
-set(LIBS ${LIBS} ${CHECK_LIBRARIES} ${PROJECT})
+find_package(Threads)
+
+set(LIBS ${LIBS} ${CHECK_LIBRARIES} ${PROJECT} ${CMAKE_THREAD_LIBS_INIT})
 
 include_directories( include ${ADDITIONAL_INCLUDE_DIRECTORIES} )
 
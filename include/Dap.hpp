@@ -34,6 +34,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Dap_Traits.hpp"
 #include "Dap_Vec.hpp"
 #include "Dap_Math.hpp"
+#include "Dap_Instrument.hpp"
+#include "Dap_Aligned.hpp"
 #include "Dap_Block.hpp"
+#include "Dap_DynBlock.hpp"
+#include "Dap_BlockView.hpp"
+#include "Dap_BlockExpr.hpp"
 #include "Dap_SIMD.hpp"
 #include "Dap_BiQuad.hpp"
+#include "Dap_BiQuadBank.hpp"
+#include "Dap_FIR.hpp"
+#include "Dap_FFT.hpp"
+#include "Dap_Convolver.hpp"
+#include "Dap_Dispatch.hpp"
+#include "Dap_PCM.hpp"
+#include "Dap_Reduce.hpp"
+#include "Dap_ThreadPool.hpp"
+#include "Dap_ParallelBlock.hpp"
@@ -0,0 +1,164 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+
+#include <cstdlib>
+#include <limits>
+#include <new>
+#if defined( _MSC_VER )
+#include <malloc.h>
+#endif
+
+DAP_NAMESPACE_BEGIN
+
+namespace AlignedDetail
+{
+
+/// Allocate size bytes aligned to alignment, a power of two, throwing std::bad_alloc on failure
+inline void *allocate( std::size_t size, std::size_t alignment )
+{
+    void *p = 0;
+    if ( alignment < sizeof( void * ) )
+    {
+        alignment = sizeof( void * );
+    }
+#if defined( _MSC_VER )
+    p = _aligned_malloc( size, alignment );
+#else
+    if ( posix_memalign( &p, alignment, size ) != 0 )
+    {
+        p = 0;
+    }
+#endif
+    if ( !p )
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+/// Free memory from allocate
+inline void deallocate( void *p )
+{
+#if defined( _MSC_VER )
+    _aligned_free( p );
+#else
+    free( p );
+#endif
+}
+}
+
+/// True if p is a multiple of alignment
+inline bool is_aligned( void const *p, std::size_t alignment )
+{
+    return reinterpret_cast<std::uintptr_t>( p ) % alignment == 0;
+}
+
+/**
+ * A standard allocator whose storage is aligned to Align bytes, for
+ * std::vector and the other containers of SIMD_Vector or of samples that
+ * are read a SIMD_Vector at a time. Align must be a power of two and at
+ * least alignof( T ); it defaults to a cache line, which is enough for
+ * every SIMD_Vector.
+ */
+template <typename T, std::size_t Align = DAP_CACHELINESIZE>
+class aligned_allocator
+{
+  public:
+    static_assert( Align != 0 && ( Align & ( Align - 1 ) ) == 0, "the alignment must be a power of two" );
+    static_assert( Align >= alignof( T ), "the alignment must be at least that of T" );
+
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = T const *;
+    using reference = T &;
+    using const_reference = T const &;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    /// The alignment in bytes of every allocation
+    static const std::size_t alignment = Align;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, Align>;
+    };
+
+    aligned_allocator() {}
+
+    template <typename U>
+    aligned_allocator( aligned_allocator<U, Align> const & )
+    {
+    }
+
+    /// Storage for n items, throwing std::bad_alloc on failure
+    T *allocate( std::size_t n )
+    {
+        if ( n > max_size() )
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>( AlignedDetail::allocate( n * sizeof( T ), Align ) );
+    }
+
+    void deallocate( T *p, std::size_t ) { AlignedDetail::deallocate( p ); }
+
+    std::size_t max_size() const { return std::numeric_limits<std::size_t>::max() / sizeof( T ); }
+
+    template <typename U, typename... Args>
+    void construct( U *p, Args &&... args )
+    {
+        ::new ( static_cast<void *>( p ) ) U( std::forward<Args>( args )... );
+    }
+
+    template <typename U>
+    void destroy( U *p )
+    {
+        p->~U();
+    }
+};
+
+template <typename T, typename U, std::size_t Align>
+bool operator==( aligned_allocator<T, Align> const &, aligned_allocator<U, Align> const & )
+{
+    return true;
+}
+
+template <typename T, typename U, std::size_t Align>
+bool operator!=( aligned_allocator<T, Align> const &, aligned_allocator<U, Align> const & )
+{
+    return false;
+}
+
+DAP_NAMESPACE_END
@@ -34,11 +34,12 @@
 
 #include "Dap_World.hpp"
 #include "Dap_Block.hpp"
+#include "Dap_BlockView.hpp"
 #include "Dap_Vec.hpp"
 #include "Dap_Math.hpp"
+#include "Dap_Dispatch.hpp"
 
-namespace Dap
-{
+DAP_NAMESPACE_BEGIN
 
 template <typename T>
 struct BiQuad
@@ -245,24 +246,465 @@ struct BiQuad
     {
         coeffs = other.coeffs;
         state = other.state;
+        return *this;
     }
 
     T operator()( T const &input_value )
+    {
+        return step( coeffs, state.z1, state.z2, input_value );
+    }
+
+    /// One sample of the transposed direct form II section described by c, with the state held in z1 and z2.
+    /// Written with fma so that the loop carried path from z1 through the output back into z1 is two multiply-adds
+    static T step( Coeffs const &c, T &z1, T &z2, T const &input_value )
     {
         T output_value;
 
-        output_value = ( input_value * coeffs.a0 ) + state.z1;
-        state.z1 = ( input_value * coeffs.a1 ) + state.z2 - ( coeffs.b1 * output_value );
-        state.z2 = ( input_value * coeffs.a2 ) - ( coeffs.b2 * output_value );
+        output_value = fma( input_value, c.a0, z1 );
+        z1 = fma( output_value, -c.b1, fma( input_value, c.a1, z2 ) );
+        z2 = fma( output_value, -c.b2, input_value * c.a2 );
 
         return output_value;
     }
 
+    /// Filter n samples from input to output. The coefficients and state are held in locals for the whole buffer
+    /// and the state is written back once at the end. input and output may be the same buffer. For float and
+    /// double this is the biquad kernel of the runtime dispatch table, see Dap_Dispatch.hpp
+    void process( T const *input, T *output, std::size_t n )
+    {
+        process_items( input, output, n, has_dispatch_kernels<T>() );
+    }
+
+    /// Filter n samples in place
+    void process( T *buffer, std::size_t n )
+    {
+        process( buffer, buffer, n );
+    }
+
+    /// Filter the line of the input block along the specified axis into the same line of the output block.
+    /// The line is selected by the positions of the other two dimensions, in (width,height,depth) order
+    template <typename ContainerT>
+    void process( ContainerT const &input,
+                  ContainerT &output,
+                  Axis axis = Axis::width,
+                  std::size_t other0 = 0,
+                  std::size_t other1 = 0,
+                  typename Traits<ContainerT>::twist_type * = 0 )
+    {
+        const std::size_t n = axis_size( input, axis );
+        if ( process_line( input,
+                           output,
+                           axis,
+                           other0,
+                           other1,
+                           n,
+                           std::is_same<typename BlockDetail::layout<ContainerT>::value_type, T>() ) )
+        {
+            return;
+        }
+
+        const Coeffs c = coeffs;
+        T z1 = state.z1;
+        T z2 = state.z2;
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            auto pos = axis_position( axis, i, other0, other1 );
+            const T input_value = get( input, std::get<0>( pos ), std::get<1>( pos ), std::get<2>( pos ) );
+            const T output_value = step( c, z1, z2, input_value );
+            set( output, output_value, std::get<0>( pos ), std::get<1>( pos ), std::get<2>( pos ) );
+        }
+
+        state.z1 = z1;
+        state.z2 = z2;
+    }
+
+    /// Filter the line of the block along the specified axis in place
+    template <typename ContainerT>
+    void process( ContainerT &srcdest,
+                  Axis axis = Axis::width,
+                  std::size_t other0 = 0,
+                  std::size_t other1 = 0,
+                  typename Traits<ContainerT>::twist_type * = 0 )
+    {
+        process( srcdest, srcdest, axis, other0, other1 );
+    }
+
     friend std::ostream &operator<<( std::ostream &o, BiQuad const &v )
     {
         o << "coeffs: " << v.coeffs << std::endl;
         o << "state : " << v.state << std::endl;
         return o;
     }
+
+  private:
+    void process_items( T const *input, T *output, std::size_t n, std::false_type )
+    {
+        const Coeffs c = coeffs;
+        T z1 = state.z1;
+        T z2 = state.z2;
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            const T input_value = input[i];
+            const T output_value = step( c, z1, z2, input_value );
+            output[i] = output_value;
+        }
+
+        state.z1 = z1;
+        state.z2 = z2;
+    }
+
+    void process_items( T const *input, T *output, std::size_t n, std::true_type )
+    {
+        const T c[5] = {coeffs.a0, coeffs.a1, coeffs.a2, coeffs.b1, coeffs.b2};
+        T z[2] = {state.z1, state.z2};
+        dispatch_for<T>().biquad( c, z, input, output, n );
+        state.z1 = z[0];
+        state.z2 = z[1];
+    }
+
+    /// Filter the line as one buffer when it is contiguous in both blocks, returning false if it is not
+    template <typename ContainerT>
+    bool process_line( ContainerT const &input,
+                       ContainerT &output,
+                       Axis axis,
+                       std::size_t other0,
+                       std::size_t other1,
+                       std::size_t n,
+                       std::true_type )
+    {
+        const std::size_t a = static_cast<std::size_t>( axis );
+        const std::array<std::size_t, 3> is = BlockDetail::axis_strides( input );
+        const std::array<std::size_t, 3> os = BlockDetail::axis_strides( output );
+        if ( ( is[a] != 1 || os[a] != 1 ) && n > 1 )
+        {
+            return false;
+        }
+        auto pos = axis_position( axis, 0, other0, other1 );
+        const std::size_t w = std::get<0>( pos ), h = std::get<1>( pos ), d = std::get<2>( pos );
+        process( BlockDetail::layout<ContainerT>::items( input ) + w * is[0] + h * is[1] + d * is[2],
+                 BlockDetail::layout<ContainerT>::items( output ) + w * os[0] + h * os[1] + d * os[2],
+                 n );
+        return true;
+    }
+
+    template <typename ContainerT>
+    bool process_line( ContainerT const &, ContainerT &, Axis, std::size_t, std::size_t, std::size_t, std::false_type )
+    {
+        return false;
+    }
+};
+
+/**
+ * A chain of Stages BiQuad sections run over a buffer in a single pass.
+ * Each sample goes through every stage before the next sample is read, so
+ * the values between stages are never written to memory. The stage loop is
+ * unrolled at compile time. The sections are designed with the usual
+ * BiQuad<T>::Coeffs::calculate_* functions via coeffs[stage]
+ */
+template <typename T, std::size_t Stages>
+struct BiQuadCascade
+{
+    static_assert( Stages > 0, "BiQuadCascade needs at least one stage" );
+
+    typedef T value_type;
+    typedef typename BiQuad<T>::Coeffs Coeffs;
+    typedef typename BiQuad<T>::State State;
+    static const std::size_t stages = Stages;
+
+    std::array<Coeffs, Stages> coeffs;
+    std::array<State, Stages> state;
+
+    BiQuadCascade() : coeffs(), state()
+    {
+    }
+
+    T operator()( T const &input_value )
+    {
+        T z1[Stages], z2[Stages];
+        load_state( z1, z2 );
+        T output_value = run( &coeffs[0], z1, z2, input_value, std::integral_constant<std::size_t, 0>() );
+        store_state( z1, z2 );
+        return output_value;
+    }
+
+    /// Filter n samples from input to output through all stages. input and output may be the same buffer
+    void process( T const *input, T *output, std::size_t n )
+    {
+        const std::array<Coeffs, Stages> c = coeffs;
+        T z1[Stages], z2[Stages];
+        load_state( z1, z2 );
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            output[i] = run( &c[0], z1, z2, input[i], std::integral_constant<std::size_t, 0>() );
+        }
+
+        store_state( z1, z2 );
+    }
+
+    /// Filter n samples in place
+    void process( T *buffer, std::size_t n )
+    {
+        process( buffer, buffer, n );
+    }
+
+    /// Filter the line of the input block along the specified axis into the same line of the output block.
+    /// The line is selected by the positions of the other two dimensions, in (width,height,depth) order
+    template <typename ContainerT>
+    void process( ContainerT const &input,
+                  ContainerT &output,
+                  Axis axis = Axis::width,
+                  std::size_t other0 = 0,
+                  std::size_t other1 = 0,
+                  typename Traits<ContainerT>::twist_type * = 0 )
+    {
+        const std::array<Coeffs, Stages> c = coeffs;
+        T z1[Stages], z2[Stages];
+        load_state( z1, z2 );
+
+        const std::size_t n = axis_size( input, axis );
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            auto pos = axis_position( axis, i, other0, other1 );
+            const T input_value = get( input, std::get<0>( pos ), std::get<1>( pos ), std::get<2>( pos ) );
+            const T output_value = run( &c[0], z1, z2, input_value, std::integral_constant<std::size_t, 0>() );
+            set( output, output_value, std::get<0>( pos ), std::get<1>( pos ), std::get<2>( pos ) );
+        }
+
+        store_state( z1, z2 );
+    }
+
+    /// Filter the line of the block along the specified axis in place
+    template <typename ContainerT>
+    void process( ContainerT &srcdest,
+                  Axis axis = Axis::width,
+                  std::size_t other0 = 0,
+                  std::size_t other1 = 0,
+                  typename Traits<ContainerT>::twist_type * = 0 )
+    {
+        process( srcdest, srcdest, axis, other0, other1 );
+    }
+
+    friend std::ostream &operator<<( std::ostream &o, BiQuadCascade const &v )
+    {
+        for ( std::size_t s = 0; s < Stages; ++s )
+        {
+            o << "stage " << s << " coeffs: " << v.coeffs[s] << std::endl;
+            o << "stage " << s << " state : " << v.state[s] << std::endl;
+        }
+        return o;
+    }
+
+  private:
+    void load_state( T *z1, T *z2 ) const
+    {
+        for ( std::size_t s = 0; s < Stages; ++s )
+        {
+            z1[s] = state[s].z1;
+            z2[s] = state[s].z2;
+        }
+    }
+
+    void store_state( T const *z1, T const *z2 )
+    {
+        for ( std::size_t s = 0; s < Stages; ++s )
+        {
+            state[s].z1 = z1[s];
+            state[s].z2 = z2[s];
+        }
+    }
+
+    /// Run the sample through stage Stage and all of the following stages
+    template <std::size_t Stage>
+    static T run( Coeffs const *c, T *z1, T *z2, T const &input_value, std::integral_constant<std::size_t, Stage> )
+    {
+        return run( c,
+                    z1,
+                    z2,
+                    BiQuad<T>::step( c[Stage], z1[Stage], z2[Stage], input_value ),
+                    std::integral_constant<std::size_t, Stage + 1>() );
+    }
+
+    static T run( Coeffs const *, T *, T *, T const &input_value, std::integral_constant<std::size_t, Stages> )
+    {
+        return input_value;
+    }
+};
+
+/**
+ * Single channel BiQuad that computes N consecutive samples per SIMD_Vector<T,N>.
+ *
+ * The transposed direct form II section is written in state space form and
+ * unrolled N samples ahead: for a block of inputs x[0..N-1] and the state
+ * (z1,z2) at the start of the block,
+ *
+ *   y = z1 * state_response[0] + z2 * state_response[1] + sum_j x[j] * input_response[j]
+ *
+ * where input_response[j] is the impulse response delayed by j samples and
+ * truncated to the block. The input terms do not depend on the state, so the
+ * only serial work per block is the update of (z1,z2) from the last two
+ * outputs, which takes a handful of scalar operations.
+ *
+ * The result matches BiQuad<T>::operator() up to rounding. Measured against
+ * the same section evaluated exactly, the error is within 5x that of
+ * operator() for corner frequencies above fs/100. Below that the look-ahead
+ * responses are ill conditioned and the error grows with N, up to 20x that
+ * of operator() for N=8 at fs/2000, or 40x when built with FMA because
+ * operator() itself is then about twice as accurate.
+ *
+ * Call set_coeffs() to change the filter; it recalculates the look-ahead
+ * responses.
+ */
+template <typename T, std::size_t N>
+struct BiQuadLookAhead
+{
+    static_assert( N >= 2, "BiQuadLookAhead needs at least two samples per block" );
+
+    typedef T value_type;
+    typedef SIMD_Vector<T, N> vector_type;
+    typedef typename BiQuad<T>::Coeffs Coeffs;
+    typedef typename BiQuad<T>::State State;
+    static const std::size_t block_size = N;
+
+    State state;
+
+    BiQuadLookAhead() : state()
+    {
+        Coeffs c;
+        c.set( 0, 1.0, 0.0, 0.0, 0.0, 0.0 );
+        set_coeffs( c );
+    }
+
+    explicit BiQuadLookAhead( Coeffs const &c ) : state()
+    {
+        set_coeffs( c );
+    }
+
+    Coeffs const &coeffs() const
+    {
+        return m_coeffs;
+    }
+
+    /// Set the filter coefficients and recalculate the state and input responses over one block
+    void set_coeffs( Coeffs const &c )
+    {
+        m_coeffs = c;
+
+        // evaluated in double precision so that float filters only round once
+        const double a0 = c.a0, a1 = c.a1, a2 = c.a2, b1 = c.b1, b2 = c.b2;
+        double impulse[N];
+        double from_z1[N], from_z2[N];
+        {
+            double z1 = 0.0, z2 = 0.0;
+            for ( std::size_t k = 0; k < N; ++k )
+            {
+                double x = k == 0 ? 1.0 : 0.0;
+                double y = x * a0 + z1;
+                z1 = x * a1 + z2 - b1 * y;
+                z2 = x * a2 - b2 * y;
+                impulse[k] = y;
+            }
+        }
+        for ( std::size_t which = 0; which < 2; ++which )
+        {
+            double z1 = which == 0 ? 1.0 : 0.0, z2 = which == 0 ? 0.0 : 1.0;
+            for ( std::size_t k = 0; k < N; ++k )
+            {
+                double y = z1;
+                z1 = z2 - b1 * y;
+                z2 = -b2 * y;
+                ( which == 0 ? from_z1 : from_z2 )[k] = y;
+            }
+        }
+
+        m_state_last[0] = static_cast<T>( from_z1[N - 1] );
+        m_state_last[1] = static_cast<T>( from_z2[N - 1] );
+        m_state_prev[0] = static_cast<T>( from_z1[N - 2] );
+        m_state_prev[1] = static_cast<T>( from_z2[N - 2] );
+        for ( std::size_t k = 0; k < N; ++k )
+        {
+            m_state_response[0][k] = static_cast<T>( from_z1[k] );
+            m_state_response[1][k] = static_cast<T>( from_z2[k] );
+            for ( std::size_t j = 0; j < N; ++j )
+            {
+                m_input_response[j][k] = static_cast<T>( k >= j ? impulse[k - j] : 0.0 );
+            }
+        }
+    }
+
+    T operator()( T const &input_value )
+    {
+        return BiQuad<T>::step( m_coeffs, state.z1, state.z2, input_value );
+    }
+
+    /// Filter n samples from input to output, N at a time. The last n % N samples are run one at a time.
+    /// input and output may be the same buffer
+    void process( T const *input, T *output, std::size_t n )
+    {
+        const T a1 = m_coeffs.a1;
+        const T a2 = m_coeffs.a2;
+        const T b1 = m_coeffs.b1;
+        const T b2 = m_coeffs.b2;
+        T z1 = state.z1;
+        T z2 = state.z2;
+
+        std::size_t i = 0;
+        for ( ; i + N <= n; i += N )
+        {
+            T x[N];
+            for ( std::size_t j = 0; j < N; ++j )
+            {
+                x[j] = input[i + j];
+            }
+
+            // the response to the block's input does not depend on the state, so it can overlap the previous block
+            vector_type y = m_input_response[0] * x[0];
+            for ( std::size_t j = 1; j < N; ++j )
+            {
+                vector_type xj;
+                y = fma( m_input_response[j], splat( xj, x[j] ), y );
+            }
+
+            const T y0_last = y[N - 1];
+            const T y0_prev = y[N - 2];
+
+            vector_type vz1, vz2;
+            y = fma( m_state_response[0], splat( vz1, z1 ), fma( m_state_response[1], splat( vz2, z2 ), y ) );
+            for ( std::size_t j = 0; j < N; ++j )
+            {
+                output[i + j] = y[j];
+            }
+
+            // the state after the block follows from the last two samples. They are recomputed with scalar
+            // arithmetic from the state independent part so that the dependency between blocks is short
+            const T y_last = fma( m_state_last[0], z1, fma( m_state_last[1], z2, y0_last ) );
+            const T y_prev = fma( m_state_prev[0], z1, fma( m_state_prev[1], z2, y0_prev ) );
+            z2 = fma( y_last, -b2, x[N - 1] * a2 );
+            z1 = fma( y_last, -b1, fma( x[N - 1], a1, fma( y_prev, -b2, x[N - 2] * a2 ) ) );
+        }
+
+        for ( ; i < n; ++i )
+        {
+            output[i] = BiQuad<T>::step( m_coeffs, z1, z2, input[i] );
+        }
+
+        state.z1 = z1;
+        state.z2 = z2;
+    }
+
+    /// Filter n samples in place
+    void process( T *buffer, std::size_t n )
+    {
+        process( buffer, buffer, n );
+    }
+
+  private:
+    Coeffs m_coeffs;
+    vector_type m_state_response[2];
+    vector_type m_input_response[N];
+    T m_state_last[2];
+    T m_state_prev[2];
 };
-}
+DAP_NAMESPACE_END
@@ -0,0 +1,304 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_SIMD.hpp"
+#include "Dap_BiQuad.hpp"
+#include "Dap_Dispatch.hpp"
+#include "Dap_ThreadPool.hpp"
+#include <cstring>
+
+DAP_NAMESPACE_BEGIN
+
+/**
+ * A bank of independent BiQuad sections, one per channel.
+ *
+ * The coefficients and state are stored as separate cache aligned arrays
+ * (struct of arrays) padded up to a whole number of native SIMD chunks.
+ * process() walks one chunk of channels at a time through all of the frames,
+ * with that chunk's coefficients and state held in registers, prefetching
+ * the input a few frames ahead. The padding lanes have zero coefficients and
+ * state, so a channel count that is not a multiple of the SIMD width is
+ * handled by the same vector code; only the loads and stores of the samples
+ * of the last chunk are shortened. For float and double the chunks are run by
+ * the biquad_bank kernel of the runtime dispatch table, see Dap_Dispatch.hpp,
+ * in the widest registers of the host; it is given the padded channel count,
+ * so its last partial register also runs in those padding lanes.
+ *
+ * Large banks are split by chunk across the workers of a persistent
+ * ThreadPool, see pool, max_threads and parallel_min_samples, so a call
+ * never starts or joins threads of its own.
+ */
+template <typename T, std::size_t Channels>
+struct BiQuadBank
+{
+    static_assert( Channels > 0, "BiQuadBank needs at least one channel" );
+
+    typedef T value_type;
+    typedef typename BiQuad<T>::Coeffs Coeffs;
+
+    static const std::size_t channels = Channels;
+    static const std::size_t chunk_size = simd_native_size<T>::value;
+    static const std::size_t chunks = ( Channels + chunk_size - 1 ) / chunk_size;
+    static const std::size_t padded_channels = chunks * chunk_size;
+    typedef SIMD_Vector<T, chunk_size> chunk_type;
+
+    /// Only split the work across threads when a call processes at least this many samples
+    static const std::size_t parallel_min_samples = 65536;
+
+    /// How many frames ahead of the current frame to prefetch the input
+    static const std::size_t prefetch_distance = 8;
+
+    DAP_CACHE_ALIGN std::array<T, padded_channels> a0;
+    DAP_CACHE_ALIGN std::array<T, padded_channels> a1;
+    DAP_CACHE_ALIGN std::array<T, padded_channels> a2;
+    DAP_CACHE_ALIGN std::array<T, padded_channels> b1;
+    DAP_CACHE_ALIGN std::array<T, padded_channels> b2;
+    DAP_CACHE_ALIGN std::array<T, padded_channels> z1;
+    DAP_CACHE_ALIGN std::array<T, padded_channels> z2;
+
+    /// The most tasks that process() splits a call into, the calling thread included. Defaults to the number of
+    /// hardware threads; 1 keeps all of the work on the calling thread
+    std::size_t max_threads;
+
+    /// The pool that runs the tasks, or nullptr for ThreadPool::shared(), which is started on the first call that
+    /// is split
+    ThreadPool *pool;
+
+    BiQuadBank() : max_threads( std::max<std::size_t>( 1, std::thread::hardware_concurrency() ) ), pool( nullptr )
+    {
+        a0.fill( T( 0 ) );
+        a1.fill( T( 0 ) );
+        a2.fill( T( 0 ) );
+        b1.fill( T( 0 ) );
+        b2.fill( T( 0 ) );
+        reset();
+    }
+
+    /// Clear the state of every channel
+    void reset()
+    {
+        z1.fill( T( 0 ) );
+        z2.fill( T( 0 ) );
+    }
+
+    void set( std::size_t channel, double na0, double na1, double na2, double nb1, double nb2 )
+    {
+        a0[channel] = static_cast<T>( na0 );
+        a1[channel] = static_cast<T>( na1 );
+        a2[channel] = static_cast<T>( na2 );
+        b1[channel] = static_cast<T>( nb1 );
+        b2[channel] = static_cast<T>( nb2 );
+    }
+
+    /// Set the coefficients of one channel from a section designed with the BiQuad<T>::Coeffs::calculate_* functions
+    void set_coeffs( std::size_t channel, Coeffs const &c )
+    {
+        set( channel, c.a0, c.a1, c.a2, c.b1, c.b2 );
+    }
+
+    Coeffs get_coeffs( std::size_t channel ) const
+    {
+        Coeffs c;
+        c.set( 0, a0[channel], a1[channel], a2[channel], b1[channel], b2[channel] );
+        return c;
+    }
+
+    /// Filter frames of interleaved samples. Frame f of channel c is at input[f * frame_stride + c].
+    /// input and output may be the same buffer
+    void process( T const *input, T *output, std::size_t frames, std::size_t frame_stride = Channels )
+    {
+        std::size_t threads = std::min( max_threads, chunks );
+        if ( threads < 2 || frames * Channels < parallel_min_samples )
+        {
+            process_chunks( input, output, frames, frame_stride, 0, chunks );
+            return;
+        }
+
+        // split on cache line boundaries so that no two tasks write to the same line of a frame
+        const std::size_t chunks_per_line = std::max<std::size_t>( 1, DAP_CACHELINESIZE / sizeof( chunk_type ) );
+        const std::size_t lines = ( chunks + chunks_per_line - 1 ) / chunks_per_line;
+        threads = std::min( threads, lines );
+        const Split split = {input, output, frames, frame_stride, ( ( lines + threads - 1 ) / threads ) * chunks_per_line};
+        const std::size_t tasks = ( chunks + split.chunks_per_task - 1 ) / split.chunks_per_task;
+
+        // two pointers of captures fit in the std::function without a heap allocation
+        ThreadPool &workers = pool ? *pool : ThreadPool::shared();
+        workers.parallel_for( tasks, [this, &split]( std::size_t t )
+                              {
+            process_chunks( split.input,
+                            split.output,
+                            split.frames,
+                            split.frame_stride,
+                            t * split.chunks_per_task,
+                            std::min( chunks, ( t + 1 ) * split.chunks_per_task ) );
+        } );
+    }
+
+    /// Filter frames in place
+    void process( T *buffer, std::size_t frames, std::size_t frame_stride = Channels )
+    {
+        process( buffer, buffer, frames, frame_stride );
+    }
+
+  private:
+    /// The arguments of one call of process() split into tasks
+    struct Split
+    {
+        T const *input;
+        T *output;
+        std::size_t frames;
+        std::size_t frame_stride;
+        std::size_t chunks_per_task;
+    };
+
+    /// Number of real channels in the last chunk
+    static const std::size_t last_chunk_channels = Channels - ( chunks - 1 ) * chunk_size;
+
+    static chunk_type const &chunk_at( std::array<T, padded_channels> const &a, std::size_t first )
+    {
+        return *reinterpret_cast<chunk_type const *>( &a[first] );
+    }
+
+    static chunk_type &chunk_at( std::array<T, padded_channels> &a, std::size_t first )
+    {
+        return *reinterpret_cast<chunk_type *>( &a[first] );
+    }
+
+    void process_chunks(
+        T const *input, T *output, std::size_t frames, std::size_t frame_stride, std::size_t first_chunk, std::size_t last_chunk )
+    {
+        process_chunks( input, output, frames, frame_stride, first_chunk, last_chunk, has_dispatch_kernels<T>() );
+    }
+
+    void process_chunks( T const *input,
+                         T *output,
+                         std::size_t frames,
+                         std::size_t frame_stride,
+                         std::size_t first_chunk,
+                         std::size_t last_chunk,
+                         std::true_type )
+    {
+        // the arrays are padded to whole chunks, which the kernel runs in the padding lanes of its last register
+        const std::size_t first = first_chunk * chunk_size;
+        const std::size_t last = std::min( Channels, last_chunk * chunk_size );
+        const DispatchBiQuadBank<T> bank = {a0.data() + first,
+                                            a1.data() + first,
+                                            a2.data() + first,
+                                            b1.data() + first,
+                                            b2.data() + first,
+                                            z1.data() + first,
+                                            z2.data() + first,
+                                            last - first,
+                                            ( last_chunk - first_chunk ) * chunk_size};
+        dispatch_for<T>().biquad_bank( bank, input + first, output + first, frames, frame_stride );
+    }
+
+    void process_chunks( T const *input,
+                         T *output,
+                         std::size_t frames,
+                         std::size_t frame_stride,
+                         std::size_t first_chunk,
+                         std::size_t last_chunk,
+                         std::false_type )
+    {
+        for ( std::size_t chunk = first_chunk; chunk < last_chunk; ++chunk )
+        {
+            if ( chunk + 1 < chunks )
+            {
+                process_chunk<chunk_size>( input, output, frames, frame_stride, chunk * chunk_size );
+            }
+            else
+            {
+                process_chunk<last_chunk_channels>( input, output, frames, frame_stride, chunk * chunk_size );
+            }
+        }
+    }
+
+    /// Run Count channels starting at channel 'first' through all frames
+    template <std::size_t Count>
+    void process_chunk( T const *input, T *output, std::size_t frames, std::size_t frame_stride, std::size_t first )
+    {
+        const chunk_type ca0 = chunk_at( a0, first );
+        const chunk_type ca1 = chunk_at( a1, first );
+        const chunk_type ca2 = chunk_at( a2, first );
+        const chunk_type nb1 = -chunk_at( b1, first );
+        const chunk_type nb2 = -chunk_at( b2, first );
+        chunk_type cz1 = chunk_at( z1, first );
+        chunk_type cz2 = chunk_at( z2, first );
+
+        // the padding lanes of a partial chunk read as zero and their results are not stored
+        chunk_type input_value;
+        zero( input_value );
+
+        T const *in = input + first;
+        T *out = output + first;
+        for ( std::size_t f = 0; f < frames; ++f, in += frame_stride, out += frame_stride )
+        {
+            if ( f + prefetch_distance < frames )
+            {
+                DAP_PREFETCH( in + prefetch_distance * frame_stride );
+            }
+
+            std::memcpy( input_value.data(), in, Count * sizeof( T ) );
+            chunk_type output_value = fma( input_value, ca0, cz1 );
+            cz1 = fma( output_value, nb1, fma( input_value, ca1, cz2 ) );
+            cz2 = fma( output_value, nb2, input_value * ca2 );
+            std::memcpy( out, output_value.data(), Count * sizeof( T ) );
+        }
+
+        chunk_at( z1, first ) = cz1;
+        chunk_at( z2, first ) = cz2;
+    }
+};
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::channels;
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::chunk_size;
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::chunks;
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::padded_channels;
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::parallel_min_samples;
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::prefetch_distance;
+
+template <typename T, std::size_t Channels>
+const std::size_t BiQuadBank<T, Channels>::last_chunk_channels;
+DAP_NAMESPACE_END
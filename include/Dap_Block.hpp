@@ -34,12 +34,23 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Dap_Vec.hpp"
 #include "Dap_Traits.hpp"
 #include "Dap_Twist.hpp"
+#include "Dap_Instrument.hpp"
+#include "Dap_Aligned.hpp"
+#include "Dap_Dispatch.hpp"
 
-namespace Dap
-{
+/// Size in bytes from which make_block and copy_block write whole blocks around the cache; 0 never does.
+/// Streaming only pays off on blocks much larger than the last level cache, and by how much depends on the
+/// machine, so it is off unless a build sets it
+#ifndef DAP_STREAM_STORE_BYTES
+#define DAP_STREAM_STORE_BYTES ( 0 )
+#endif
+
+DAP_NAMESPACE_BEGIN
 
 /**
- * 3 dimensional array block indexed by Width, Height, and Depth
+ * 3 dimensional array block indexed by Width, Height, and Depth. The items
+ * are aligned to the native SIMD width, on the stack, in other objects and,
+ * through the class operator new, on the heap.
  */
 template <typename T, typename TwistType, std::size_t Width, std::size_t Height = 1, std::size_t Depth = 1>
 struct Block
@@ -56,7 +67,20 @@ struct Block
     static const size_t raw_index1_size = twist_array_type::raw_index1_size;
     static const size_t raw_index2_size = twist_array_type::raw_index2_size;
 
-    array_type content;
+    /// The alignment in bytes of data(), the native SIMD width or that of T if larger
+    static const size_t alignment = DAP_SIMD_NATIVE_BYTES > alignof( T ) ? DAP_SIMD_NATIVE_BYTES : alignof( T );
+
+    alignas( alignment ) array_type content;
+
+    static void *operator new( std::size_t size ) { return AlignedDetail::allocate( size, alignment ); }
+    static void *operator new[]( std::size_t size ) { return AlignedDetail::allocate( size, alignment ); }
+    static void operator delete( void *p ) { AlignedDetail::deallocate( p ); }
+    static void operator delete[]( void *p ) { AlignedDetail::deallocate( p ); }
+
+    /// The first of the width*height*depth contiguous items, in raw index order
+    value_type *data() { return twist_array_type::data( content ); }
+
+    value_type const *data() const { return twist_array_type::data( content ); }
 };
 
 /**
@@ -80,6 +104,38 @@ struct Traits<Block<T, TwistType, Width, Height, Depth> >
     static const size_t raw_index2_size = twist_array_type::raw_index2_size;
 };
 
+/**
+ * Selects one of the (width,height,depth) dimensions of a container
+ */
+enum class Axis
+{
+    width,
+    height,
+    depth
+};
+
+/**
+ * The number of items along the specified axis of a container
+ */
+template <typename ContainerT>
+std::size_t axis_size( Axis axis, typename Traits<ContainerT>::twist_array_type * = 0 )
+{
+    using ContainerTraits = Traits<ContainerT>;
+    return axis == Axis::width ? ContainerTraits::width : ( axis == Axis::height ? ContainerTraits::height : ContainerTraits::depth );
+}
+
+/**
+ * The (width,height,depth) position of item 'pos' along the specified axis.
+ * The remaining two dimensions are given in (width,height,depth) order by other0 and other1
+ */
+inline std::tuple<std::size_t, std::size_t, std::size_t>
+    axis_position( Axis axis, std::size_t pos, std::size_t other0 = 0, std::size_t other1 = 0 )
+{
+    return axis == Axis::width ? std::make_tuple( pos, other0, other1 ) : ( axis == Axis::height
+                                                                              ? std::make_tuple( other0, pos, other1 )
+                                                                              : std::make_tuple( other0, other1, pos ) );
+}
+
 template <typename ContainerT>
 auto get( ContainerT &c,
           std::size_t width_pos = 0,
@@ -130,7 +186,7 @@ auto rawget( ContainerT const &c,
              std::size_t i0 = 0,
              std::size_t i1 = 0,
              std::size_t i2 = 0,
-             typename Traits<ContainerT>::twist_array_type * = 0 ) -> typename Traits<ContainerT>::value_type &
+             typename Traits<ContainerT>::twist_array_type * = 0 ) -> typename Traits<ContainerT>::value_type
 {
     using twist_array_type = typename Traits<ContainerT>::twist_array_type;
     return twist_array_type::rawget( c.content, i0, i1, i2 );
@@ -148,159 +204,719 @@ auto rawset( ContainerT &c,
     twist_array_type::rawset( c.content, v, i0, i1, i2 );
 }
 
-template <typename ContainerT, typename Functor>
-void apply_block( ContainerT &srcdest, Functor f, typename Traits<ContainerT>::twist_array_type * = 0 )
+namespace BlockDetail
+{
+
+/**
+ * Layout of the storage of a block. The items are indexed
+ * [raw index0][raw index1][raw index2] and the item at raw indexes (a,b,i)
+ * is at items() + a * raw_stride0() + b * raw_stride1() + i * raw_stride2().
+ * A Block is contiguous, raw index2 fastest, so the whole block is one run
+ * of item_count() items, and its sizes are compile time constants.
+ * Containers sized at run time specialize this template and set is_static
+ * to false; views into other storage also set is_contiguous to false.
+ * alignment is the alignment in bytes that items() is guaranteed to have.
+ */
+template <typename ContainerT>
+struct layout
 {
     using ContainerTraits = Traits<ContainerT>;
-    using ContainerTwistType = typename ContainerTraits::twist_type;
-    using ValueType = typename ContainerTraits::value_type;
+    using twist_type = typename ContainerTraits::twist_type;
+    using value_type = typename ContainerTraits::value_type;
+
+    static const bool is_static = true;
+    static const bool is_contiguous = true;
+    static const std::size_t alignment = ContainerT::alignment;
+
+    static std::size_t width( ContainerT const & )
+    {
+        return ContainerTraits::width;
+    }
+
+    static std::size_t height( ContainerT const & )
+    {
+        return ContainerTraits::height;
+    }
+
+    static std::size_t depth( ContainerT const & )
+    {
+        return ContainerTraits::depth;
+    }
+
+    static std::size_t raw_index0_size( ContainerT const & )
+    {
+        return ContainerTraits::raw_index0_size;
+    }
+
+    static std::size_t raw_index1_size( ContainerT const & )
+    {
+        return ContainerTraits::raw_index1_size;
+    }
+
+    static std::size_t raw_index2_size( ContainerT const & )
+    {
+        return ContainerTraits::raw_index2_size;
+    }
+
+    static std::size_t raw_stride0( ContainerT const & )
+    {
+        return ContainerTraits::raw_index1_size * ContainerTraits::raw_index2_size;
+    }
+
+    static std::size_t raw_stride1( ContainerT const & )
+    {
+        return ContainerTraits::raw_index2_size;
+    }
+
+    static std::size_t raw_stride2( ContainerT const & )
+    {
+        return 1;
+    }
+
+    static std::size_t item_count( ContainerT const & )
+    {
+        return ContainerTraits::raw_index0_size * ContainerTraits::raw_index1_size * ContainerTraits::raw_index2_size;
+    }
+
+    static value_type *items( ContainerT &c )
+    {
+        return c.data();
+    }
+
+    static value_type const *items( ContainerT const &c )
+    {
+        return c.data();
+    }
+};
+
+/// Check that two blocks have the same width, height and depth: at compile time when both sizes are static
+template <typename Container1T,
+          typename Container2T,
+          bool Static = layout<Container1T>::is_static && layout<Container2T>::is_static>
+struct size_check
+{
+    static void check( Container1T const &, Container2T const & )
+    {
+        static_assert( Traits<Container1T>::width == Traits<Container2T>::width, "Width different between Source and Destination" );
+        static_assert( Traits<Container1T>::height == Traits<Container2T>::height,
+                       "Height different between Source and Destination" );
+        static_assert( Traits<Container1T>::depth == Traits<Container2T>::depth, "Depth different between Source and Destination" );
+    }
+};
 
-    for ( std::size_t c = 0; c < ContainerTraits::raw_index2_size; ++c )
+/// ...and at run time otherwise, throwing std::invalid_argument
+template <typename Container1T, typename Container2T>
+struct size_check<Container1T, Container2T, false>
+{
+    static void check( Container1T const &a, Container2T const &b )
     {
-        for ( std::size_t b = 0; b < ContainerTraits::raw_index1_size; ++b )
+        if ( layout<Container1T>::width( a ) != layout<Container2T>::width( b )
+             || layout<Container1T>::height( a ) != layout<Container2T>::height( b )
+             || layout<Container1T>::depth( a ) != layout<Container2T>::depth( b ) )
         {
-            for ( std::size_t a = 0; a < ContainerTraits::raw_index0_size; ++a )
-            {
-                auto pos = std::make_tuple( a, b, c );
-                std::size_t w = ContainerTwistType::width_pos_from( pos );
-                std::size_t h = ContainerTwistType::height_pos_from( pos );
-                std::size_t d = ContainerTwistType::depth_pos_from( pos );
+            throw std::invalid_argument( "block sizes differ" );
+        }
+    }
+};
 
-                ValueType &v = rawget( srcdest.content, w, h, d );
-                v = f( v, w, h, d );
+template <typename Container1T, typename Container2T>
+void check_same_size( Container1T const &a, Container2T const &b )
+{
+    size_check<Container1T, Container2T>::check( a, b );
+}
+
+/// Call f( item, width_pos, height_pos, depth_pos ) for every item of c in storage order
+template <typename ContainerT, typename Functor>
+void for_each_item( ContainerT &c, Functor f )
+{
+    using Layout = layout<typename std::remove_const<ContainerT>::type>;
+    using twist_type = typename Layout::twist_type;
+    const std::size_t size0 = Layout::raw_index0_size( c );
+    const std::size_t size1 = Layout::raw_index1_size( c );
+    const std::size_t size2 = Layout::raw_index2_size( c );
+    const std::size_t stride0 = Layout::raw_stride0( c );
+    const std::size_t stride1 = Layout::raw_stride1( c );
+    const std::size_t stride2 = Layout::raw_stride2( c );
+    auto base = Layout::items( c );
+
+    for ( std::size_t a = 0; a < size0; ++a )
+    {
+        for ( std::size_t b = 0; b < size1; ++b )
+        {
+            auto p = base + a * stride0 + b * stride1;
+            for ( std::size_t i = 0; i < size2; ++i )
+            {
+                auto pos = std::make_tuple( a, b, i );
+                f( p[i * stride2],
+                   twist_type::width_pos_from( pos ),
+                   twist_type::height_pos_from( pos ),
+                   twist_type::depth_pos_from( pos ) );
             }
         }
     }
 }
 
-template <typename SourceContainerT, typename DestinationContainerT, typename Functor>
-auto apply_block( SourceContainerT const &src,
-                  DestinationContainerT &dest,
-                  Functor f,
-                  typename Traits<SourceContainerT>::twist_array_type * = 0,
-                  typename Traits<DestinationContainerT>::twist_array_type * = 0 ) -> void
+/// Call f( item, width_pos, height_pos, depth_pos ) for the items of rows [first_row, last_row) of c in storage
+/// order. Row a * raw_index1_size + b is the raw_index2_size contiguous items at raw indexes (a, b, *)
+template <typename ContainerT, typename Functor>
+void for_each_item_in_rows( ContainerT &c, std::size_t first_row, std::size_t last_row, Functor f )
 {
-    using SourceContainerTraits = Traits<SourceContainerT>;
-    using DestinationContainerTraits = Traits<DestinationContainerT>;
-    using DestinationContainerTwistType = typename DestinationContainerTraits::twist_type;
-    using SourceValueType = typename SourceContainerTraits::value_type;
-    using DestinationValueType = typename DestinationContainerTraits::value_type;
-
-    static_assert( SourceContainerTraits::width == DestinationContainerTraits::width,
-                   "Width different between Source and Destination" );
-    static_assert( SourceContainerTraits::height == DestinationContainerTraits::height,
-                   "Height different between Source and Destination" );
-    static_assert( SourceContainerTraits::depth == DestinationContainerTraits::depth,
-                   "Depth different between Source and Destination" );
+    using Layout = layout<typename std::remove_const<ContainerT>::type>;
+    using twist_type = typename Layout::twist_type;
+    const std::size_t size1 = Layout::raw_index1_size( c );
+    const std::size_t size2 = Layout::raw_index2_size( c );
+    const std::size_t stride0 = Layout::raw_stride0( c );
+    const std::size_t stride1 = Layout::raw_stride1( c );
+    const std::size_t stride2 = Layout::raw_stride2( c );
+    auto base = Layout::items( c );
+
+    for ( std::size_t row = first_row; row < last_row; ++row )
+    {
+        const std::size_t a = row / size1;
+        const std::size_t b = row % size1;
+        auto p = base + a * stride0 + b * stride1;
+        for ( std::size_t i = 0; i < size2; ++i )
+        {
+            auto pos = std::make_tuple( a, b, i );
+            f( p[i * stride2],
+               twist_type::width_pos_from( pos ),
+               twist_type::height_pos_from( pos ),
+               twist_type::depth_pos_from( pos ) );
+        }
+    }
+}
 
-    for ( std::size_t c = 0; c < DestinationContainerTraits::raw_index2_size; ++c )
+/// Set n items to v, one native SIMD_Vector at a time. If stream is true p is aligned to the native SIMD width
+/// and the vectors are written around the cache
+template <typename T>
+void fill_items_simd( T *p, std::size_t n, T v, bool stream )
+{
+    typedef SIMD_Vector<T, simd_native_size<T>::value> V;
+    const std::size_t w = simd_native_size<T>::value;
+    const std::size_t whole = n - n % w;
+    V x;
+    splat( x, v );
+    if ( stream )
     {
-        for ( std::size_t b = 0; b < DestinationContainerTraits::raw_index1_size; ++b )
+        for ( std::size_t i = 0; i < whole; i += w )
         {
-            for ( std::size_t a = 0; a < DestinationContainerTraits::raw_index0_size; ++a )
-            {
-                auto pos = std::make_tuple( a, b, c );
-                std::size_t w = DestinationContainerTwistType::width_pos_from( pos );
-                std::size_t h = DestinationContainerTwistType::height_pos_from( pos );
-                std::size_t d = DestinationContainerTwistType::depth_pos_from( pos );
+            x.stream( p + i );
+        }
+        simd_stream_fence();
+    }
+    else
+    {
+        for ( std::size_t i = 0; i < whole; i += w )
+        {
+            x.store( p + i );
+        }
+    }
+    for ( std::size_t i = whole; i < n; ++i )
+    {
+        p[i] = v;
+    }
+}
 
-                DestinationValueType v = f( get( src.content, w, h, d ), w, h, d );
-                rawset( dest.content, v, w, h, d );
-            }
+/// Copy n items, one native SIMD_Vector at a time. If stream is true dest is aligned to the native SIMD width
+/// and the vectors are written around the cache
+template <typename T>
+void copy_items_simd( T *dest, T const *src, std::size_t n, bool stream )
+{
+    typedef SIMD_Vector<T, simd_native_size<T>::value> V;
+    const std::size_t w = simd_native_size<T>::value;
+    const std::size_t whole = n - n % w;
+    V x;
+    if ( stream )
+    {
+        for ( std::size_t i = 0; i < whole; i += w )
+        {
+            x.load( src + i );
+            x.stream( dest + i );
+        }
+        simd_stream_fence();
+    }
+    else
+    {
+        for ( std::size_t i = 0; i < whole; i += w )
+        {
+            x.load( src + i );
+            x.store( dest + i );
         }
     }
+    for ( std::size_t i = whole; i < n; ++i )
+    {
+        dest[i] = src[i];
+    }
 }
 
-template <typename Container1T, typename Container2T, typename ResultContainerT, typename Functor>
-auto apply_block( Container1T const &c1,
-                  Container2T const &c2,
-                  ResultContainerT &r,
-                  Functor f,
-                  typename Traits<Container1T>::twist_array_type * = 0,
-                  typename Traits<Container2T>::twist_array_type * = 0,
-                  typename Traits<ResultContainerT>::twist_array_type * = 0 ) -> void
+template <typename T>
+void fill_items( T *p, std::size_t n, T const &v, bool = false )
 {
-    using Container1Traits = Traits<Container1T>;
-    using Container2Traits = Traits<Container2T>;
-    using ResultContainerTraits = Traits<ResultContainerT>;
-    using ResultContainerTwistType = typename ResultContainerTraits::twist_type;
-    using ValueType1 = typename Container1Traits::value_type;
-    using ValueType2 = typename Container2Traits::value_type;
-    using ValueTypeResult = typename ResultContainerTraits::value_type;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        p[i] = v;
+    }
+}
 
-    static_assert( Container1Traits::width == Container2Traits::width, "Width different between Source and Destination" );
-    static_assert( Container1Traits::height == Container2Traits::height, "Height different between Source and Destination" );
-    static_assert( Container1Traits::depth == Container2Traits::depth, "Depth different between Source and Destination" );
+inline void fill_items( float *p, std::size_t n, float const &v, bool stream = false )
+{
+    fill_items_simd( p, n, v, stream );
+}
+
+inline void fill_items( double *p, std::size_t n, double const &v, bool stream = false )
+{
+    fill_items_simd( p, n, v, stream );
+}
 
-    for ( std::size_t c = 0; c < ResultContainerTraits::raw_index2_size; ++c )
+template <typename T>
+void copy_items( T *dest, T const *src, std::size_t n, bool = false )
+{
+    for ( std::size_t i = 0; i < n; ++i )
     {
-        for ( std::size_t b = 0; b < ResultContainerTraits::raw_index1_size; ++b )
-        {
-            for ( std::size_t a = 0; a < ResultContainerTraits::raw_index0_size; ++a )
-            {
-                auto pos = std::make_tuple( a, b, c );
-                std::size_t w = ResultContainerTwistType::width_pos_from( pos );
-                std::size_t h = ResultContainerTwistType::height_pos_from( pos );
-                std::size_t d = ResultContainerTwistType::depth_pos_from( pos );
+        dest[i] = src[i];
+    }
+}
 
-                ValueTypeResult v = f( get( c1.content, w, h, d ), get( c2.content, w, h, d ), w, h, d );
-                rawset( r.content, v, w, h, d );
-            }
+inline void copy_items( float *dest, float const *src, std::size_t n, bool stream = false )
+{
+    copy_items_simd( dest, src, n, stream );
+}
+
+inline void copy_items( double *dest, double const *src, std::size_t n, bool stream = false )
+{
+    copy_items_simd( dest, src, n, stream );
+}
+
+const std::size_t stream_store_bytes = DAP_STREAM_STORE_BYTES;
+
+/// True if the n items of a container of this layout are written around the cache: there are enough of them and
+/// the container guarantees the alignment that SIMD_Vector::stream needs
+template <typename LayoutT>
+bool stream_stores( std::size_t n )
+{
+    return stream_store_bytes != 0 && n * sizeof( typename LayoutT::value_type ) >= stream_store_bytes
+           && LayoutT::alignment >= DAP_SIMD_NATIVE_BYTES;
+}
+
+/// Edge in items of the square tiles that transpose_items moves at a time, so that a source and a destination
+/// tile of floats fit in L1 together
+const std::size_t transpose_tile_size = 32;
+
+/// dest[j * dest_stride + i] = src[i * src_stride + j] for i < rows and j < cols, one item at a time
+template <typename T>
+void transpose_tile_scalar(
+    T const *src, std::size_t src_stride, T *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    for ( std::size_t i = 0; i < rows; ++i )
+    {
+        for ( std::size_t j = 0; j < cols; ++j )
+        {
+            dest[j * dest_stride + i] = src[i * src_stride + j];
         }
     }
 }
 
-template <typename TwistType, std::size_t Width, std::size_t Height, std::size_t Depth, typename T>
-auto make_block( T const &elem ) -> Block<T, TwistType, Width, Height, Depth>
+template <typename T>
+void transpose_tile_simd( T const *src,
+                          std::size_t src_stride,
+                          T *dest,
+                          std::size_t dest_stride,
+                          std::size_t rows,
+                          std::size_t cols,
+                          std::integral_constant<std::size_t, 1> )
 {
-    using Container = Block<T, TwistType, Width, Height, Depth>;
-    using ContainerTraits = Traits<Container>;
-    Container r;
+    transpose_tile_scalar( src, src_stride, dest, dest_stride, rows, cols );
+}
 
-    for ( std::size_t c = 0; c < ContainerTraits::raw_index2_size; ++c )
+/// The same, with each W x W square transposed in the registers of SIMD_Vector<T, W>. The ragged edges go
+/// through the narrow registers, then one item at a time
+template <typename T, std::size_t W>
+void transpose_tile_simd( T const *src,
+                          std::size_t src_stride,
+                          T *dest,
+                          std::size_t dest_stride,
+                          std::size_t rows,
+                          std::size_t cols,
+                          std::integral_constant<std::size_t, W> )
+{
+    typedef SIMD_Vector<T, W> V;
+    typedef std::integral_constant<std::size_t, W == simd_register_sizes<T>::narrow ? 1 : simd_register_sizes<T>::narrow>
+        edge_width;
+    const std::size_t whole_rows = rows - rows % W;
+    const std::size_t whole_cols = cols - cols % W;
+    V r[W];
+    for ( std::size_t i = 0; i < whole_rows; i += W )
     {
-        for ( std::size_t b = 0; b < ContainerTraits::raw_index1_size; ++b )
+        for ( std::size_t j = 0; j < whole_cols; j += W )
         {
-            for ( std::size_t a = 0; a < ContainerTraits::raw_index0_size; ++a )
+            DAP_UNROLL
+            for ( std::size_t k = 0; k < W; ++k )
             {
-                rawset( r, elem, a, b, c );
+                r[k].load( src + ( i + k ) * src_stride + j );
+            }
+            transpose( r );
+            DAP_UNROLL
+            for ( std::size_t k = 0; k < W; ++k )
+            {
+                r[k].store( dest + ( j + k ) * dest_stride + i );
             }
         }
     }
+    transpose_tile_simd(
+        src + whole_cols, src_stride, dest + whole_cols * dest_stride, dest_stride, whole_rows, cols - whole_cols, edge_width() );
+    transpose_tile_simd(
+        src + whole_rows * src_stride, src_stride, dest + whole_rows, dest_stride, rows - whole_rows, cols, edge_width() );
+}
 
-    return r;
+template <typename T>
+void transpose_tile( T const *src, std::size_t src_stride, T *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    transpose_tile_scalar( src, src_stride, dest, dest_stride, rows, cols );
 }
 
-template <typename T, typename TwistType, std::size_t Width, std::size_t Height, std::size_t Depth, typename Functor>
-auto fill_block( Functor f ) -> Block<T, TwistType, Width, Height, Depth>
+inline void
+    transpose_tile( float const *src, std::size_t src_stride, float *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
 {
-    using Container = Block<T, TwistType, Width, Height, Depth>;
-    using ContainerTraits = Traits<Container>;
-    using ContainerTwistType = typename Container::twist_type;
-    using value_type = typename ContainerTraits::value_type;
-    Container r;
+    transpose_tile_simd( src,
+                         src_stride,
+                         dest,
+                         dest_stride,
+                         rows,
+                         cols,
+                         std::integral_constant<std::size_t, simd_register_sizes<float>::wide>() );
+}
 
-    for ( std::size_t c = 0; c < ContainerTraits::raw_index2_size; ++c )
+inline void transpose_tile(
+    double const *src, std::size_t src_stride, double *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    transpose_tile_simd( src,
+                         src_stride,
+                         dest,
+                         dest_stride,
+                         rows,
+                         cols,
+                         std::integral_constant<std::size_t, simd_register_sizes<double>::wide>() );
+}
+
+/**
+ * dest[j * dest_stride + i] = src[i * src_stride + j] for i < rows and j < cols.
+ * The matrix is moved one transpose_tile_size square at a time so that both
+ * the strided reads or writes of a tile stay in cache.
+ */
+template <typename T>
+void transpose_items( T const *src, std::size_t src_stride, T *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    for ( std::size_t i = 0; i < rows; i += transpose_tile_size )
     {
-        for ( std::size_t b = 0; b < ContainerTraits::raw_index1_size; ++b )
+        // not std::min, whose instantiation would be shared by the dispatch variants that inline this
+        const std::size_t tile_rows = rows - i < transpose_tile_size ? rows - i : transpose_tile_size;
+        for ( std::size_t j = 0; j < cols; j += transpose_tile_size )
         {
-            for ( std::size_t a = 0; a < ContainerTraits::raw_index0_size; ++a )
-            {
-                auto pos = std::make_tuple( a, b, c );
-                std::size_t w = ContainerTwistType::width_pos_from( pos );
-                std::size_t h = ContainerTwistType::height_pos_from( pos );
-                std::size_t d = ContainerTwistType::depth_pos_from( pos );
+            const std::size_t tile_cols = cols - j < transpose_tile_size ? cols - j : transpose_tile_size;
+            transpose_tile( src + i * src_stride + j, src_stride, dest + j * dest_stride + i, dest_stride, tile_rows, tile_cols );
+        }
+    }
+}
+
+/// transpose_items, by the transpose kernel of the runtime dispatch table for float and double, see Dap_Dispatch.hpp
+template <typename T>
+void transpose_dispatched(
+    T const *src, std::size_t src_stride, T *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    transpose_items( src, src_stride, dest, dest_stride, rows, cols );
+}
+
+inline void transpose_dispatched(
+    float const *src, std::size_t src_stride, float *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    dispatch_for<float>().transpose( src, rows, cols, src_stride, dest, dest_stride );
+}
+
+inline void transpose_dispatched(
+    double const *src, std::size_t src_stride, double *dest, std::size_t dest_stride, std::size_t rows, std::size_t cols )
+{
+    dispatch_for<double>().transpose( src, rows, cols, src_stride, dest, dest_stride );
+}
+
+/// Whether two containers store their items in the same order as single runs, so that they may be walked in step
+template <typename Container1T, typename Container2T>
+struct same_layout
+    : public std::integral_constant<bool,
+                                    std::is_same<typename Traits<Container1T>::twist_type,
+                                                 typename Traits<Container2T>::twist_type>::value
+                                        && layout<Container1T>::is_contiguous && layout<Container2T>::is_contiguous>
+{
+};
+
+/// src and dest in the same order: walk both storages in step
+template <typename SourceContainerT, typename DestinationContainerT, typename Functor>
+void apply_items( SourceContainerT const &src, DestinationContainerT &dest, Functor f, std::true_type )
+{
+    auto s = layout<SourceContainerT>::items( src );
+    for_each_item( dest, [&]( typename Traits<DestinationContainerT>::value_type &v, std::size_t w, std::size_t h, std::size_t d )
+                   {
+        v = f( *s++, w, h, d );
+    } );
+}
 
-                value_type v = f(w, h, d);
-                rawset( r, v, a, b, c );
+/// src in a different order: walk dest in storage order and gather from src
+template <typename SourceContainerT, typename DestinationContainerT, typename Functor>
+void apply_items( SourceContainerT const &src, DestinationContainerT &dest, Functor f, std::false_type )
+{
+    for_each_item( dest, [&]( typename Traits<DestinationContainerT>::value_type &v, std::size_t w, std::size_t h, std::size_t d )
+                   {
+        v = f( get( src, w, h, d ), w, h, d );
+    } );
+}
+
+template <typename Container1T, typename Container2T, typename ResultContainerT, typename Functor>
+void apply_items( Container1T const &c1, Container2T const &c2, ResultContainerT &r, Functor f, std::true_type )
+{
+    auto s1 = layout<Container1T>::items( c1 );
+    auto s2 = layout<Container2T>::items( c2 );
+    for_each_item( r, [&]( typename Traits<ResultContainerT>::value_type &v, std::size_t w, std::size_t h, std::size_t d )
+                   {
+        v = f( *s1++, *s2++, w, h, d );
+    } );
+}
+
+template <typename Container1T, typename Container2T, typename ResultContainerT, typename Functor>
+void apply_items( Container1T const &c1, Container2T const &c2, ResultContainerT &r, Functor f, std::false_type )
+{
+    for_each_item( r, [&]( typename Traits<ResultContainerT>::value_type &v, std::size_t w, std::size_t h, std::size_t d )
+                   {
+        v = f( get( c1, w, h, d ), get( c2, w, h, d ), w, h, d );
+    } );
+}
+
+/// The distance in items between neighbours along the width, height and depth axes of c
+template <typename ContainerT>
+std::array<std::size_t, 3> axis_strides( ContainerT const &c )
+{
+    using Layout = layout<ContainerT>;
+    using twist_type = typename Layout::twist_type;
+    const std::size_t raw_strides[3] = {Layout::raw_stride0( c ), Layout::raw_stride1( c ), Layout::raw_stride2( c )};
+    return {{raw_strides[twist_type::width_index], raw_strides[twist_type::height_index], raw_strides[twist_type::depth_index]}};
+}
+
+/// The axis whose stride is 1, preferring the given one, or 3 if there is none
+inline std::size_t unit_stride_axis( std::array<std::size_t, 3> const &strides, std::size_t preferred )
+{
+    return strides[preferred] == 1 ? preferred : ( strides[0] == 1 ? 0 : ( strides[1] == 1 ? 1 : ( strides[2] == 1 ? 2 : 3 ) ) );
+}
+
+/**
+ * Copy every item of src to the same (width,height,depth) position of dest
+ * when the two are stored in different orders. The contiguous axis of each
+ * is the one whose stride is 1, which for a twisted view is not the fastest
+ * axis of its twist. If both have the same contiguous axis, whole rows are
+ * copied; otherwise each plane of the contiguous axes of src and dest is
+ * transposed with transpose_dispatched. Views without a contiguous axis are
+ * copied item by item.
+ */
+template <typename SourceContainerT, typename DestinationContainerT>
+void copy_items_twisted( SourceContainerT const &src, DestinationContainerT &dest )
+{
+    using SourceLayout = layout<SourceContainerT>;
+    using DestinationLayout = layout<DestinationContainerT>;
+    using source_twist = typename SourceLayout::twist_type;
+    using destination_twist = typename DestinationLayout::twist_type;
+
+    const std::size_t n[3] = {SourceLayout::width( src ), SourceLayout::height( src ), SourceLayout::depth( src )};
+    const std::array<std::size_t, 3> ss = axis_strides( src );
+    const std::array<std::size_t, 3> ds = axis_strides( dest );
+    auto s = SourceLayout::items( src );
+    auto d = DestinationLayout::items( dest );
+
+    // x is the contiguous axis of dest and y the contiguous axis of src
+    const std::size_t x = unit_stride_axis( ds, destination_twist::raw_index2_map );
+    const std::size_t y = unit_stride_axis( ss, source_twist::raw_index2_map );
+    if ( x == 3 || y == 3 )
+    {
+        apply_items( src,
+                     dest,
+                     []( typename SourceLayout::value_type const &v, std::size_t, std::size_t, std::size_t )
+                     {
+                         return v;
+                     },
+                     std::false_type() );
+    }
+    else if ( x == y )
+    {
+        const std::size_t a = x == destination_twist::raw_index2_map ? destination_twist::raw_index0_map : ( x == 0 ? 1 : 0 );
+        const std::size_t b = 3 - x - a;
+        for ( std::size_t i = 0; i < n[a]; ++i )
+        {
+            for ( std::size_t j = 0; j < n[b]; ++j )
+            {
+                copy_items( d + i * ds[a] + j * ds[b], s + i * ss[a] + j * ss[b], n[x] );
             }
         }
     }
+    else
+    {
+        const std::size_t z = 3 - x - y;
+        for ( std::size_t k = 0; k < n[z]; ++k )
+        {
+            transpose_dispatched( s + k * ss[z], ss[x], d + k * ds[z], ds[y], n[x], n[y] );
+        }
+    }
+}
+}
+
+/**
+ * The block algorithms below visit items in storage order, raw index2
+ * fastest, so every pass over a block reads and writes memory
+ * sequentially. When the source and destination share a twist they are
+ * walked in step; otherwise the destination is written sequentially and the
+ * source is gathered by (width,height,depth). make_block and copy_block of
+ * float or double blocks move a native SIMD_Vector at a time. copy_block and
+ * twist_block between different twists transpose cache sized tiles instead,
+ * so that neither the reads nor the writes stride across the whole block;
+ * for float and double the tiles are moved by the runtime dispatched
+ * transpose kernel, see Dap_Dispatch.hpp. Blocks of at least DAP_STREAM_STORE_BYTES that make_block fills or that
+ * copy_block copies as one run are written with non-temporal stores.
+ *
+ * Each algorithm takes an optional instrumentation policy, see
+ * Dap_Instrument.hpp, that records its items, bytes and cycles.
+ */
+
+/// The number of items along the specified axis of c
+template <typename ContainerT>
+std::size_t axis_size( ContainerT const &c, Axis axis, typename Traits<ContainerT>::twist_type * = 0 )
+{
+    using Layout = BlockDetail::layout<ContainerT>;
+    return axis == Axis::width ? Layout::width( c ) : ( axis == Axis::height ? Layout::height( c ) : Layout::depth( c ) );
+}
+
+/// Replace every item v of srcdest by f( v, width_pos, height_pos, depth_pos )
+template <typename InstrumentT = NoInstrument, typename ContainerT, typename Functor>
+void apply_block( ContainerT &srcdest, Functor f, typename Traits<ContainerT>::twist_type * = 0 )
+{
+    using ValueType = typename Traits<ContainerT>::value_type;
+    const std::size_t n = BlockDetail::layout<ContainerT>::item_count( srcdest );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::apply_block, n, 2 * n * sizeof( ValueType ) );
+
+    BlockDetail::for_each_item( srcdest, [&]( ValueType &v, std::size_t w, std::size_t h, std::size_t d )
+                                {
+        v = f( v, w, h, d );
+    } );
+}
+
+/// Set each item of dest to f( src item, width_pos, height_pos, depth_pos )
+template <typename InstrumentT = NoInstrument, typename SourceContainerT, typename DestinationContainerT, typename Functor>
+auto apply_block( SourceContainerT const &src,
+                  DestinationContainerT &dest,
+                  Functor f,
+                  typename Traits<SourceContainerT>::twist_type * = 0,
+                  typename Traits<DestinationContainerT>::twist_type * = 0 ) -> void
+{
+    BlockDetail::check_same_size( src, dest );
+    const std::size_t n = BlockDetail::layout<DestinationContainerT>::item_count( dest );
+    InstrumentDetail::scope<InstrumentT> instrument(
+        BlockOperation::apply_block,
+        n,
+        n * ( sizeof( typename Traits<SourceContainerT>::value_type ) + sizeof( typename Traits<DestinationContainerT>::value_type ) ) );
+    BlockDetail::apply_items( src, dest, f, BlockDetail::same_layout<SourceContainerT, DestinationContainerT>() );
+}
+
+/// Set each item of r to f( c1 item, c2 item, width_pos, height_pos, depth_pos )
+template <typename InstrumentT = NoInstrument,
+          typename Container1T,
+          typename Container2T,
+          typename ResultContainerT,
+          typename Functor>
+auto apply_block( Container1T const &c1,
+                  Container2T const &c2,
+                  ResultContainerT &r,
+                  Functor f,
+                  typename Traits<Container1T>::twist_type * = 0,
+                  typename Traits<Container2T>::twist_type * = 0,
+                  typename Traits<ResultContainerT>::twist_type * = 0 ) -> void
+{
+    BlockDetail::check_same_size( c1, c2 );
+    BlockDetail::check_same_size( c1, r );
+    const std::size_t n = BlockDetail::layout<ResultContainerT>::item_count( r );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::apply_block,
+                                                     n,
+                                                     n * ( sizeof( typename Traits<Container1T>::value_type )
+                                                           + sizeof( typename Traits<Container2T>::value_type )
+                                                           + sizeof( typename Traits<ResultContainerT>::value_type ) ) );
+    BlockDetail::apply_items( c1,
+                              c2,
+                              r,
+                              f,
+                              std::integral_constant<bool,
+                                                     BlockDetail::same_layout<Container1T, ResultContainerT>::value
+                                                         && BlockDetail::same_layout<Container2T, ResultContainerT>::value>() );
+}
+
+/// Copy every item of src to the same (width,height,depth) position of dest, whatever their twists
+template <typename InstrumentT = NoInstrument, typename SourceContainerT, typename DestinationContainerT>
+auto copy_block( SourceContainerT const &src,
+                 DestinationContainerT &dest,
+                 typename Traits<SourceContainerT>::twist_type * = 0,
+                 typename Traits<DestinationContainerT>::twist_type * = 0 ) -> void
+{
+    BlockDetail::check_same_size( src, dest );
+    const std::size_t n = BlockDetail::layout<DestinationContainerT>::item_count( dest );
+    InstrumentDetail::scope<InstrumentT> instrument(
+        BlockOperation::copy_block, n, 2 * n * sizeof( typename Traits<DestinationContainerT>::value_type ) );
+    if ( BlockDetail::same_layout<SourceContainerT, DestinationContainerT>::value )
+    {
+        BlockDetail::copy_items( BlockDetail::layout<DestinationContainerT>::items( dest ),
+                                 BlockDetail::layout<SourceContainerT>::items( src ),
+                                 n,
+                                 BlockDetail::stream_stores<BlockDetail::layout<DestinationContainerT> >( n ) );
+    }
+    else
+    {
+        BlockDetail::copy_items_twisted( src, dest );
+    }
+}
+
+template <typename TwistType,
+          std::size_t Width,
+          std::size_t Height,
+          std::size_t Depth,
+          typename InstrumentT = NoInstrument,
+          typename T>
+auto make_block( T const &elem ) -> Block<T, TwistType, Width, Height, Depth>
+{
+    using Container = Block<T, TwistType, Width, Height, Depth>;
+    using Layout = BlockDetail::layout<Container>;
+    Container r;
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::make_block, Layout::item_count( r ), sizeof( r.content ) );
+
+    BlockDetail::fill_items( Layout::items( r ), Layout::item_count( r ), elem, BlockDetail::stream_stores<Layout>( Layout::item_count( r ) ) );
 
     return r;
 }
 
-template <int TwistAmount, typename InputContainerType>
+template <typename T,
+          typename TwistType,
+          std::size_t Width,
+          std::size_t Height,
+          std::size_t Depth,
+          typename InstrumentT = NoInstrument,
+          typename Functor>
+auto fill_block( Functor f ) -> Block<T, TwistType, Width, Height, Depth>
+{
+    using Container = Block<T, TwistType, Width, Height, Depth>;
+    Container r;
+    InstrumentDetail::scope<InstrumentT> instrument(
+        BlockOperation::fill_block, BlockDetail::layout<Container>::item_count( r ), sizeof( r.content ) );
+
+    BlockDetail::for_each_item( r, [&]( T &v, std::size_t w, std::size_t h, std::size_t d )
+                                {
+        v = f( w, h, d );
+    } );
+
+    return r;
+}
+
+/// A copy of input stored in the twist that Twister<TwistAmount> makes of the twist of input
+template <int TwistAmount, typename InstrumentT = NoInstrument, typename InputContainerType>
 auto twist_block( InputContainerType const &input )
     -> Block<typename Traits<InputContainerType>::value_type,
              typename Twister<typename InputContainerType::twist_type, TwistAmount>::output_twist,
@@ -308,38 +924,19 @@ auto twist_block( InputContainerType const &input )
              Traits<InputContainerType>::height,
              Traits<InputContainerType>::depth>
 {
-    using InputContainerTwistType = typename InputContainerType::twist_type;
     using InputContainerTraits = Traits<InputContainerType>;
     using OutputContainerType = Block<typename Traits<InputContainerType>::value_type,
                                       typename Twister<typename InputContainerType::twist_type, TwistAmount>::output_twist,
                                       InputContainerTraits::width,
                                       InputContainerTraits::height,
                                       InputContainerTraits::depth>;
-    using OutputContainerTraits = Traits<OutputContainerType>;
-    using OutputContainerTwistType = typename OutputContainerType::twist_type;
 
     OutputContainerType r;
+    InstrumentDetail::scope<InstrumentT> instrument(
+        BlockOperation::twist_block, BlockDetail::layout<OutputContainerType>::item_count( r ), 2 * sizeof( r.content ) );
 
-    std::cout << "raw_i0_size: " << OutputContainerTraits::raw_index0_size << std::endl;
-    std::cout << "raw_i1_size: " << OutputContainerTraits::raw_index1_size << std::endl;
-    std::cout << "raw_i2_size: " << OutputContainerTraits::raw_index2_size << std::endl;
-    
-    for ( std::size_t c = 0; c < OutputContainerTraits::raw_index2_size; ++c )
-    {
-        for ( std::size_t b = 0; b < OutputContainerTraits::raw_index1_size; ++b )
-        {
-            for ( std::size_t a = 0; a < OutputContainerTraits::raw_index0_size; ++a )
-            {
-                auto pos = std::make_tuple( a, b, c );
-                std::size_t w = InputContainerTwistType::width_pos_from( pos );
-                std::size_t h = InputContainerTwistType::height_pos_from( pos );
-                std::size_t d = InputContainerTwistType::depth_pos_from( pos );
-
-                rawset( r, get( input, w, h, d ), a, b, c );
-            }
-        }
-    }
+    copy_block( input, r );
 
     return r;
 }
-}
+DAP_NAMESPACE_END
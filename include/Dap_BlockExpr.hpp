@@ -0,0 +1,792 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Traits.hpp"
+#include "Dap_Twist.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_BlockView.hpp"
+#include "Dap_Instrument.hpp"
+#include "Dap_Dispatch.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+/** \addtogroup block_expression operator+ operator- operator* operator/ min max fma evaluate_block
+ *
+ * Arithmetic on whole blocks. The operators and min, max and fma take any
+ * mix of Block, DynBlock, BlockView, block expressions and scalars and do
+ * no work themselves: they return an expression that records the operation
+ * and refers to the operands. evaluate_block( e, dest ) then computes every
+ * item of dest in one pass, so
+ *
+ *     evaluate_block( a * g + b * ( 1.0f - g ), out );
+ *
+ * reads a, b and g once each and writes out once, with no temporary blocks.
+ *
+ * dest is walked in storage order and each operand is read at the same
+ * (width,height,depth) position, whatever its twist. When every operand is
+ * contiguous along the rows of dest, float and double rows are computed a
+ * native SIMD_Vector at a time, or, when the host has wider registers than
+ * the build, by the scale, add, multiply and multiply_add kernels of the
+ * runtime dispatch table (see Dap_Dispatch.hpp) for the rows that are a + b,
+ * a * b, a * scalar, scalar * a or fma( a, b, c ) of blocks a, b and c.
+ * Otherwise the operands are gathered item by
+ * item, and dest is walked in tiles of transpose_tile_size items of the
+ * rows that are neighbours along the contiguous axis of a gathered operand,
+ * so each of its cache lines is read once. When every operand is stored exactly like a
+ * contiguous dest, the whole block is a single run. dest may also be an
+ * operand.
+ *
+ * All operands must have the same value_type and the same size as dest;
+ * scalars are converted to that value_type. The operands must outlive the
+ * expression, so evaluate it in the statement that builds it.
+ */
+/**@{*/
+
+namespace BlockExprDetail
+{
+
+/// The base of every expression node, used to recognize them
+struct Expression
+{
+};
+
+template <typename T>
+struct always_void
+{
+    typedef void type;
+};
+
+template <typename X, typename Enable = void>
+struct has_twist : std::false_type
+{
+};
+
+template <typename X>
+struct has_twist<X, typename always_void<typename Traits<X>::twist_type>::type> : std::true_type
+{
+};
+
+/// What an operand is: 0 not an operand, 1 an expression, 2 a container or 3 a scalar
+template <typename X>
+struct operand_kind
+    : std::integral_constant<int,
+                             std::is_base_of<Expression, X>::value
+                                 ? 1
+                                 : ( has_twist<X>::value ? 2 : ( std::is_arithmetic<X>::value ? 3 : 0 ) )>
+{
+};
+
+/// What a row cursor reads: items in memory, one repeated value, or the result of an operation on other cursors
+enum class CursorKind
+{
+    memory,
+    scalar,
+    operation
+};
+
+template <CursorKind Kind>
+using cursor_kind = std::integral_constant<CursorKind, Kind>;
+
+typedef cursor_kind<CursorKind::memory> memory_cursor;
+typedef cursor_kind<CursorKind::scalar> scalar_cursor;
+
+/// The SIMD_Vector width that expressions of T are evaluated with, 1 when T has none
+template <typename T>
+struct vector_width : std::integral_constant<std::size_t, 1>
+{
+};
+
+template <>
+struct vector_width<float> : simd_native_size<float>
+{
+};
+
+template <>
+struct vector_width<double> : simd_native_size<double>
+{
+};
+
+template <typename T>
+T min_of( T const &a, T const &b )
+{
+    return b < a ? b : a;
+}
+
+template <typename T, std::size_t N>
+SIMD_Vector<T, N> min_of( SIMD_Vector<T, N> const &a, SIMD_Vector<T, N> const &b )
+{
+    return select( b < a, b, a );
+}
+
+template <typename T>
+T max_of( T const &a, T const &b )
+{
+    return a < b ? b : a;
+}
+
+template <typename T, std::size_t N>
+SIMD_Vector<T, N> max_of( SIMD_Vector<T, N> const &a, SIMD_Vector<T, N> const &b )
+{
+    return select( a < b, b, a );
+}
+
+template <typename T>
+T fma_of( T const &a, T const &b, T const &c )
+{
+    return a * b + c;
+}
+
+inline float fma_of( float a, float b, float c )
+{
+    return fma( a, b, c );
+}
+
+inline double fma_of( double a, double b, double c )
+{
+    return fma( a, b, c );
+}
+
+template <typename T, std::size_t N>
+SIMD_Vector<T, N> fma_of( SIMD_Vector<T, N> const &a, SIMD_Vector<T, N> const &b, SIMD_Vector<T, N> const &c )
+{
+    return fma( a, b, c );
+}
+
+struct Add
+{
+    template <typename V>
+    static V apply( V const &a, V const &b )
+    {
+        return a + b;
+    }
+};
+
+struct Subtract
+{
+    template <typename V>
+    static V apply( V const &a, V const &b )
+    {
+        return a - b;
+    }
+};
+
+struct Multiply
+{
+    template <typename V>
+    static V apply( V const &a, V const &b )
+    {
+        return a * b;
+    }
+};
+
+struct Divide
+{
+    template <typename V>
+    static V apply( V const &a, V const &b )
+    {
+        return a / b;
+    }
+};
+
+struct Min
+{
+    template <typename V>
+    static V apply( V const &a, V const &b )
+    {
+        return min_of( a, b );
+    }
+};
+
+struct Max
+{
+    template <typename V>
+    static V apply( V const &a, V const &b )
+    {
+        return max_of( a, b );
+    }
+};
+
+/// A leaf that reads the items of a container through a read only view of it
+template <typename T, typename TwistType>
+class Terminal : public Expression
+{
+  public:
+    using value_type = T;
+    static const std::size_t operand_count = 1;
+
+    /// Reads one row of the leaf, i items from the start of the row at a time
+    struct Cursor
+    {
+        typedef memory_cursor kind;
+
+        T const *p;
+        std::size_t stride;
+
+        T item( std::size_t i ) const { return p[i * stride]; }
+
+        /// Only used when stride is 1
+        template <typename V>
+        V vector( std::size_t i ) const
+        {
+            V x;
+            x.load( p + i );
+            return x;
+        }
+
+        bool dispatch( T *, std::size_t ) const { return false; }
+    };
+
+    explicit Terminal( BlockView<T const, TwistType> const &view ) : m_view( view ) {}
+
+    template <typename DestinationContainerT>
+    void check_size( DestinationContainerT const &dest ) const
+    {
+        BlockDetail::check_same_size( m_view, dest );
+    }
+
+    /// True if the leaf has these width, height and depth strides
+    bool has_strides( std::array<std::size_t, 3> const &strides ) const
+    {
+        return m_view.width_stride() == strides[0] && m_view.height_stride() == strides[1]
+               && m_view.depth_stride() == strides[2];
+    }
+
+    /// 3 if the items along axis are adjacent in memory, otherwise the axis along which they are, or axis itself
+    /// if there is none
+    std::size_t gathered_axis( std::size_t axis ) const
+    {
+        const std::array<std::size_t, 3> strides = {{m_view.width_stride(), m_view.height_stride(), m_view.depth_stride()}};
+        const std::size_t contiguous = BlockDetail::unit_stride_axis( strides, axis );
+        return contiguous == axis ? 3 : ( contiguous == 3 ? axis : contiguous );
+    }
+
+    /// The row that starts at item pos and runs along axis
+    Cursor row( std::array<std::size_t, 3> const &pos, std::size_t axis ) const
+    {
+        const std::size_t strides[3] = {m_view.width_stride(), m_view.height_stride(), m_view.depth_stride()};
+        return Cursor{m_view.data() + pos[0] * strides[0] + pos[1] * strides[1] + pos[2] * strides[2], strides[axis]};
+    }
+
+  private:
+    BlockView<T const, TwistType> m_view;
+};
+
+/// A leaf that is the same value at every position
+template <typename T>
+class Scalar : public Expression
+{
+  public:
+    using value_type = T;
+    static const std::size_t operand_count = 0;
+
+    struct Cursor
+    {
+        typedef scalar_cursor kind;
+
+        T v;
+
+        T item( std::size_t ) const { return v; }
+
+        template <typename V>
+        V vector( std::size_t ) const
+        {
+            V x;
+            splat( x, v );
+            return x;
+        }
+
+        bool dispatch( T *, std::size_t ) const { return false; }
+    };
+
+    explicit Scalar( T v ) : m_v( v ) {}
+
+    template <typename DestinationContainerT>
+    void check_size( DestinationContainerT const & ) const
+    {
+    }
+
+    bool has_strides( std::array<std::size_t, 3> const & ) const { return true; }
+
+    std::size_t gathered_axis( std::size_t ) const { return 3; }
+
+    Cursor row( std::array<std::size_t, 3> const &, std::size_t ) const { return Cursor{m_v}; }
+
+  private:
+    T m_v;
+};
+
+/// The operations of two cursors without a kernel in the dispatch table. Returns false and leaves dest alone
+template <typename Op, typename T, typename L, typename R, typename LKind, typename RKind>
+bool dispatch_binary( Op, L const &, R const &, T *, std::size_t, LKind, RKind )
+{
+    return false;
+}
+
+template <typename T, typename L, typename R>
+bool dispatch_binary( Add, L const &l, R const &r, T *dest, std::size_t n, memory_cursor, memory_cursor )
+{
+    dispatch_for<T>().add( l.p, r.p, dest, n );
+    return true;
+}
+
+template <typename T, typename L, typename R>
+bool dispatch_binary( Multiply, L const &l, R const &r, T *dest, std::size_t n, memory_cursor, memory_cursor )
+{
+    dispatch_for<T>().multiply( l.p, r.p, dest, n );
+    return true;
+}
+
+template <typename T, typename L, typename R>
+bool dispatch_binary( Multiply, L const &l, R const &r, T *dest, std::size_t n, memory_cursor, scalar_cursor )
+{
+    dispatch_for<T>().scale( l.p, r.v, dest, n );
+    return true;
+}
+
+template <typename T, typename L, typename R>
+bool dispatch_binary( Multiply, L const &l, R const &r, T *dest, std::size_t n, scalar_cursor, memory_cursor )
+{
+    dispatch_for<T>().scale( r.p, l.v, dest, n );
+    return true;
+}
+
+template <typename T, typename A, typename B, typename C, typename AKind, typename BKind, typename CKind>
+bool dispatch_fma( A const &, B const &, C const &, T *, std::size_t, AKind, BKind, CKind )
+{
+    return false;
+}
+
+template <typename T, typename A, typename B, typename C>
+bool dispatch_fma( A const &a, B const &b, C const &c, T *dest, std::size_t n, memory_cursor, memory_cursor, memory_cursor )
+{
+    dispatch_for<T>().multiply_add( a.p, b.p, c.p, dest, n );
+    return true;
+}
+
+/// Op::apply( l, r ) at every position
+template <typename Op, typename L, typename R>
+class Binary : public Expression
+{
+  public:
+    static_assert( std::is_same<typename L::value_type, typename R::value_type>::value,
+                   "block expression operands must have the same value_type" );
+    using value_type = typename L::value_type;
+    static const std::size_t operand_count = L::operand_count + R::operand_count;
+
+    struct Cursor
+    {
+        typedef cursor_kind<CursorKind::operation> kind;
+
+        typename L::Cursor l;
+        typename R::Cursor r;
+
+        value_type item( std::size_t i ) const { return Op::apply( l.item( i ), r.item( i ) ); }
+
+        template <typename V>
+        V vector( std::size_t i ) const
+        {
+            return Op::apply( l.template vector<V>( i ), r.template vector<V>( i ) );
+        }
+
+        /// Compute the n items of the contiguous row into dest with a dispatched kernel, see dispatch_row
+        bool dispatch( value_type *dest, std::size_t n ) const
+        {
+            return dispatch_binary( Op(), l, r, dest, n, typename L::Cursor::kind(), typename R::Cursor::kind() );
+        }
+    };
+
+    Binary( L const &l, R const &r ) : m_l( l ), m_r( r ) {}
+
+    template <typename DestinationContainerT>
+    void check_size( DestinationContainerT const &dest ) const
+    {
+        m_l.check_size( dest );
+        m_r.check_size( dest );
+    }
+
+    bool has_strides( std::array<std::size_t, 3> const &strides ) const
+    {
+        return m_l.has_strides( strides ) && m_r.has_strides( strides );
+    }
+
+    std::size_t gathered_axis( std::size_t axis ) const
+    {
+        const std::size_t l = m_l.gathered_axis( axis );
+        return l != 3 ? l : m_r.gathered_axis( axis );
+    }
+
+    Cursor row( std::array<std::size_t, 3> const &pos, std::size_t axis ) const
+    {
+        return Cursor{m_l.row( pos, axis ), m_r.row( pos, axis )};
+    }
+
+  private:
+    L m_l;
+    R m_r;
+};
+
+/// a * b + c at every position, fused where the target has FMA instructions
+template <typename A, typename B, typename C>
+class FusedMultiplyAdd : public Expression
+{
+  public:
+    static_assert( std::is_same<typename A::value_type, typename B::value_type>::value
+                       && std::is_same<typename A::value_type, typename C::value_type>::value,
+                   "block expression operands must have the same value_type" );
+    using value_type = typename A::value_type;
+    static const std::size_t operand_count = A::operand_count + B::operand_count + C::operand_count;
+
+    struct Cursor
+    {
+        typedef cursor_kind<CursorKind::operation> kind;
+
+        typename A::Cursor a;
+        typename B::Cursor b;
+        typename C::Cursor c;
+
+        value_type item( std::size_t i ) const { return fma_of( a.item( i ), b.item( i ), c.item( i ) ); }
+
+        template <typename V>
+        V vector( std::size_t i ) const
+        {
+            return fma_of( a.template vector<V>( i ), b.template vector<V>( i ), c.template vector<V>( i ) );
+        }
+
+        /// Compute the n items of the contiguous row into dest with a dispatched kernel, see dispatch_row
+        bool dispatch( value_type *dest, std::size_t n ) const
+        {
+            return dispatch_fma(
+                a, b, c, dest, n, typename A::Cursor::kind(), typename B::Cursor::kind(), typename C::Cursor::kind() );
+        }
+    };
+
+    FusedMultiplyAdd( A const &a, B const &b, C const &c ) : m_a( a ), m_b( b ), m_c( c ) {}
+
+    template <typename DestinationContainerT>
+    void check_size( DestinationContainerT const &dest ) const
+    {
+        m_a.check_size( dest );
+        m_b.check_size( dest );
+        m_c.check_size( dest );
+    }
+
+    bool has_strides( std::array<std::size_t, 3> const &strides ) const
+    {
+        return m_a.has_strides( strides ) && m_b.has_strides( strides ) && m_c.has_strides( strides );
+    }
+
+    std::size_t gathered_axis( std::size_t axis ) const
+    {
+        const std::size_t a = m_a.gathered_axis( axis );
+        const std::size_t b = a != 3 ? a : m_b.gathered_axis( axis );
+        return b != 3 ? b : m_c.gathered_axis( axis );
+    }
+
+    Cursor row( std::array<std::size_t, 3> const &pos, std::size_t axis ) const
+    {
+        return Cursor{m_a.row( pos, axis ), m_b.row( pos, axis ), m_c.row( pos, axis )};
+    }
+
+  private:
+    A m_a;
+    B m_b;
+    C m_c;
+};
+
+/// The expression node for an operand X of an expression whose items are T
+template <typename X, typename T, int Kind = operand_kind<X>::value>
+struct operand
+{
+};
+
+template <typename X, typename T>
+struct operand<X, T, 1>
+{
+    using type = X;
+    static type make( X const &x ) { return x; }
+};
+
+template <typename X, typename T>
+struct operand<X, T, 2>
+{
+    using type = Terminal<T, typename Traits<X>::twist_type>;
+    static type make( X const &x ) { return type( view_block( x ) ); }
+};
+
+template <typename X, typename T>
+struct operand<X, T, 3>
+{
+    using type = Scalar<T>;
+    static type make( X const &x ) { return type( static_cast<T>( x ) ); }
+};
+
+/// The value_type of an operand that is not a scalar
+template <typename X, int Kind = operand_kind<X>::value>
+struct operand_value_type
+{
+};
+
+template <typename X>
+struct operand_value_type<X, 1>
+{
+    using type = typename X::value_type;
+};
+
+template <typename X>
+struct operand_value_type<X, 2>
+{
+    using type = typename Traits<X>::value_type;
+};
+
+/// True if X is an expression or a container
+template <typename X>
+struct is_block_operand : std::integral_constant<bool, operand_kind<X>::value == 1 || operand_kind<X>::value == 2>
+{
+};
+
+/// True if A and B can be the operands of an expression: neither is anything but a block or a scalar and at
+/// least one is a block
+template <typename A, typename B>
+struct are_operands : std::integral_constant<bool,
+                                             operand_kind<A>::value != 0 && operand_kind<B>::value != 0
+                                                 && ( is_block_operand<A>::value || is_block_operand<B>::value )>
+{
+};
+
+template <typename Op, typename A, typename B>
+struct binary
+{
+    using value_type = typename operand_value_type<typename std::conditional<is_block_operand<A>::value, A, B>::type>::type;
+    using type = Binary<Op, typename operand<A, value_type>::type, typename operand<B, value_type>::type>;
+
+    static type make( A const &a, B const &b )
+    {
+        return type( operand<A, value_type>::make( a ), operand<B, value_type>::make( b ) );
+    }
+};
+
+template <typename A, typename B, typename C>
+struct fused_multiply_add
+{
+    using value_type = typename operand_value_type<typename std::conditional<
+        is_block_operand<A>::value,
+        A,
+        typename std::conditional<is_block_operand<B>::value, B, C>::type>::type>::type;
+    using type = FusedMultiplyAdd<typename operand<A, value_type>::type,
+                                  typename operand<B, value_type>::type,
+                                  typename operand<C, value_type>::type>;
+
+    static type make( A const &a, B const &b, C const &c )
+    {
+        return type( operand<A, value_type>::make( a ), operand<B, value_type>::make( b ), operand<C, value_type>::make( c ) );
+    }
+};
+
+/// Store items first to last - 1 of the row cursor to dest, dest_stride items apart
+template <typename T, typename CursorT>
+void evaluate_items( CursorT const &cursor, T *dest, std::size_t dest_stride, std::size_t first, std::size_t last )
+{
+    for ( std::size_t i = first; i < last; ++i )
+    {
+        dest[i * dest_stride] = cursor.item( i );
+    }
+}
+
+/// Store the n items of the row cursor to dest, dest_stride items apart
+template <typename T, typename CursorT>
+void evaluate_row( CursorT const &cursor, T *dest, std::size_t dest_stride, std::size_t n, std::false_type )
+{
+    evaluate_items( cursor, dest, dest_stride, 0, n );
+}
+
+/// Compute the n items of the contiguous row cursor into dest with the kernels of the runtime dispatch table, if the
+/// selected variant has wider registers than the SIMD_Vector that evaluate_row uses and the row is one that has a
+/// kernel. Returns false, leaving dest alone, otherwise
+template <typename T, typename CursorT>
+bool dispatch_row( CursorT const &cursor, T *dest, std::size_t n )
+{
+    return dispatch().register_bytes > vector_width<T>::value * sizeof( T ) && cursor.dispatch( dest, n );
+}
+
+/// As above, a SIMD_Vector at a time when dest and every operand are contiguous
+template <typename T, typename CursorT>
+void evaluate_row( CursorT const &cursor, T *dest, std::size_t dest_stride, std::size_t n, std::true_type )
+{
+    if ( dest_stride == 1 && dispatch_row( cursor, dest, n ) )
+    {
+        return;
+    }
+    typedef SIMD_Vector<T, vector_width<T>::value> V;
+    const std::size_t w = vector_width<T>::value;
+    const std::size_t whole = dest_stride == 1 ? n - n % w : 0;
+    for ( std::size_t i = 0; i < whole; i += w )
+    {
+        cursor.template vector<V>( i ).store( dest + i );
+    }
+    evaluate_items( cursor, dest, dest_stride, whole, n );
+}
+
+template <typename T, typename CursorT>
+void evaluate_row( CursorT const &cursor, T *dest, std::size_t dest_stride, std::size_t n )
+{
+    evaluate_row( cursor, dest, dest_stride, n, std::integral_constant<bool, ( vector_width<T>::value > 1 )>() );
+}
+}
+
+template <typename A, typename B>
+auto operator+( A const &a, B const &b ) -> typename std::
+    enable_if<BlockExprDetail::are_operands<A, B>::value, BlockExprDetail::binary<BlockExprDetail::Add, A, B> >::type::type
+{
+    return BlockExprDetail::binary<BlockExprDetail::Add, A, B>::make( a, b );
+}
+
+template <typename A, typename B>
+auto operator-( A const &a, B const &b ) -> typename std::
+    enable_if<BlockExprDetail::are_operands<A, B>::value, BlockExprDetail::binary<BlockExprDetail::Subtract, A, B> >::type::type
+{
+    return BlockExprDetail::binary<BlockExprDetail::Subtract, A, B>::make( a, b );
+}
+
+template <typename A, typename B>
+auto operator*( A const &a, B const &b ) -> typename std::
+    enable_if<BlockExprDetail::are_operands<A, B>::value, BlockExprDetail::binary<BlockExprDetail::Multiply, A, B> >::type::type
+{
+    return BlockExprDetail::binary<BlockExprDetail::Multiply, A, B>::make( a, b );
+}
+
+template <typename A, typename B>
+auto operator/( A const &a, B const &b ) -> typename std::
+    enable_if<BlockExprDetail::are_operands<A, B>::value, BlockExprDetail::binary<BlockExprDetail::Divide, A, B> >::type::type
+{
+    return BlockExprDetail::binary<BlockExprDetail::Divide, A, B>::make( a, b );
+}
+
+/// The smaller of a and b at every position
+template <typename A, typename B>
+auto min( A const &a, B const &b ) -> typename std::
+    enable_if<BlockExprDetail::are_operands<A, B>::value, BlockExprDetail::binary<BlockExprDetail::Min, A, B> >::type::type
+{
+    return BlockExprDetail::binary<BlockExprDetail::Min, A, B>::make( a, b );
+}
+
+/// The larger of a and b at every position
+template <typename A, typename B>
+auto max( A const &a, B const &b ) -> typename std::
+    enable_if<BlockExprDetail::are_operands<A, B>::value, BlockExprDetail::binary<BlockExprDetail::Max, A, B> >::type::type
+{
+    return BlockExprDetail::binary<BlockExprDetail::Max, A, B>::make( a, b );
+}
+
+/// a * b + c at every position, see \ref simd_fma
+template <typename A, typename B, typename C>
+auto fma( A const &a, B const &b, C const &c ) ->
+    typename std::enable_if<( BlockExprDetail::are_operands<A, B>::value && BlockExprDetail::operand_kind<C>::value != 0 )
+                                || ( BlockExprDetail::are_operands<A, C>::value && BlockExprDetail::operand_kind<B>::value != 0 ),
+                            BlockExprDetail::fused_multiply_add<A, B, C> >::type::type
+{
+    return BlockExprDetail::fused_multiply_add<A, B, C>::make( a, b, c );
+}
+
+/// Set every item of dest to the value of the expression e at its position.
+/// Throws std::invalid_argument if an operand is not the size of dest
+template <typename InstrumentT = NoInstrument, typename ExpressionT, typename DestinationContainerT>
+auto evaluate_block( ExpressionT const &e, DestinationContainerT &dest, typename Traits<DestinationContainerT>::twist_type * = 0 ) ->
+    typename std::enable_if<std::is_base_of<BlockExprDetail::Expression, ExpressionT>::value>::type
+{
+    using Layout = BlockDetail::layout<DestinationContainerT>;
+    using twist_type = typename Layout::twist_type;
+    using T = typename Traits<DestinationContainerT>::value_type;
+    static_assert( std::is_same<T, typename ExpressionT::value_type>::value,
+                   "a block expression must have the value_type of its destination" );
+    e.check_size( dest );
+    const std::size_t n = Layout::item_count( dest );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::apply_block, n, ( ExpressionT::operand_count + 1 ) * n * sizeof( T ) );
+
+    const std::array<std::size_t, 3> ds = BlockDetail::axis_strides( dest );
+    T *d = Layout::items( dest );
+    const std::array<std::size_t, 3> origin = {{0, 0, 0}};
+    if ( Layout::is_contiguous && e.has_strides( ds ) )
+    {
+        // every operand is stored like dest, so the block is one row
+        BlockExprDetail::evaluate_row( e.row( origin, twist_type::raw_index2_map ), d, 1, n );
+        return;
+    }
+
+    const std::size_t a = twist_type::raw_index0_map, b = twist_type::raw_index1_map, x = twist_type::raw_index2_map;
+    const std::size_t size[3] = {Layout::width( dest ), Layout::height( dest ), Layout::depth( dest )};
+    std::array<std::size_t, 3> pos = origin;
+    const std::size_t y = e.gathered_axis( x );
+    if ( y == 3 )
+    {
+        for ( pos[a] = 0; pos[a] < size[a]; ++pos[a] )
+        {
+            for ( pos[b] = 0; pos[b] < size[b]; ++pos[b] )
+            {
+                BlockExprDetail::evaluate_row( e.row( pos, x ), d + pos[a] * ds[a] + pos[b] * ds[b], ds[x], size[x] );
+            }
+        }
+        return;
+    }
+
+    if ( y == x )
+    {
+        for ( pos[a] = 0; pos[a] < size[a]; ++pos[a] )
+        {
+            for ( pos[b] = 0; pos[b] < size[b]; ++pos[b] )
+            {
+                BlockExprDetail::evaluate_items( e.row( pos, x ), d + pos[a] * ds[a] + pos[b] * ds[b], ds[x], 0, size[x] );
+            }
+        }
+        return;
+    }
+
+    // an operand is contiguous along y instead of x, so do a tile of the row at each y in turn, which reads
+    // whole cache lines of that operand while they are loaded
+    const std::size_t z = 3 - x - y;
+    const std::size_t tile = BlockDetail::transpose_tile_size;
+    for ( pos[z] = 0; pos[z] < size[z]; ++pos[z] )
+    {
+        for ( std::size_t first = 0; first < size[x]; first += tile )
+        {
+            for ( pos[y] = 0; pos[y] < size[y]; ++pos[y] )
+            {
+                BlockExprDetail::evaluate_items(
+                    e.row( pos, x ), d + pos[z] * ds[z] + pos[y] * ds[y], ds[x], first, std::min( first + tile, size[x] ) );
+            }
+        }
+    }
+}
+
+/**@}*/
+
+DAP_NAMESPACE_END
@@ -0,0 +1,355 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Traits.hpp"
+#include "Dap_Twist.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_DynBlock.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+/**
+ * A non-owning window onto the items of a Block, DynBlock or another view.
+ * It holds a pointer to its (0,0,0) item, its width, height and depth and
+ * the distance in items between neighbours along each of those axes, so a
+ * sub-block, a single slice and a decimated view are all the same type.
+ * The view keeps the twist of the storage it looks at, so the block
+ * algorithms still visit its items in the order they are in memory.
+ *
+ * T is const for a read only view. Copying a view is cheap and copies no
+ * items; the storage must outlive it.
+ */
+template <typename T, typename TwistType>
+class BlockView
+{
+  public:
+    using twist_type = TwistType;
+    using value_type = typename std::remove_const<T>::type;
+    using element_type = T;
+
+    BlockView( element_type *data,
+               std::size_t width,
+               std::size_t height,
+               std::size_t depth,
+               std::size_t width_stride,
+               std::size_t height_stride,
+               std::size_t depth_stride )
+        : m_data( data )
+        , m_width( width )
+        , m_height( height )
+        , m_depth( depth )
+        , m_width_stride( width_stride )
+        , m_height_stride( height_stride )
+        , m_depth_stride( depth_stride )
+    {
+    }
+
+    /// A read only view of a writable one
+    operator BlockView<value_type const, twist_type>() const
+    {
+        return BlockView<value_type const, twist_type>(
+            m_data, m_width, m_height, m_depth, m_width_stride, m_height_stride, m_depth_stride );
+    }
+
+    std::size_t width() const { return m_width; }
+    std::size_t height() const { return m_height; }
+    std::size_t depth() const { return m_depth; }
+
+    std::size_t width_stride() const { return m_width_stride; }
+    std::size_t height_stride() const { return m_height_stride; }
+    std::size_t depth_stride() const { return m_depth_stride; }
+
+    /// The total number of items
+    std::size_t size() const { return m_width * m_height * m_depth; }
+
+    std::size_t raw_index0_size() const { return twist_type::raw_index0_from( dimensions() ); }
+    std::size_t raw_index1_size() const { return twist_type::raw_index1_from( dimensions() ); }
+    std::size_t raw_index2_size() const { return twist_type::raw_index2_from( dimensions() ); }
+
+    /// The distance in items between neighbours along raw index 0, 1 or 2
+    std::size_t raw_stride( std::size_t raw_index ) const
+    {
+        return raw_index == twist_type::width_index ? m_width_stride
+                                                    : ( raw_index == twist_type::height_index ? m_height_stride : m_depth_stride );
+    }
+
+    /// The (0,0,0) item
+    element_type *data() const { return m_data; }
+
+    element_type &get( std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos ) const
+    {
+        return m_data[width_pos * m_width_stride + height_pos * m_height_stride + depth_pos * m_depth_stride];
+    }
+
+  private:
+    std::tuple<std::size_t, std::size_t, std::size_t> dimensions() const
+    {
+        return std::make_tuple( m_width, m_height, m_depth );
+    }
+
+    element_type *m_data;
+    std::size_t m_width;
+    std::size_t m_height;
+    std::size_t m_depth;
+    std::size_t m_width_stride;
+    std::size_t m_height_stride;
+    std::size_t m_depth_stride;
+};
+
+/**
+ * Traits for a view. Like DynBlock it has no compile time sizes and no
+ * twist_array_type
+ */
+template <typename T, typename TwistType>
+struct Traits<BlockView<T, TwistType> >
+{
+    using value_type = typename std::remove_const<T>::type;
+    using twist_type = TwistType;
+    using container_type = BlockView<T, twist_type>;
+};
+
+namespace BlockDetail
+{
+
+/// The items of a view are strided along every axis
+template <typename T, typename TwistType>
+struct layout<BlockView<T, TwistType> >
+{
+    using ContainerT = BlockView<T, TwistType>;
+    using twist_type = TwistType;
+    using value_type = typename std::remove_const<T>::type;
+
+    static const bool is_static = false;
+    static const bool is_contiguous = false;
+    static const std::size_t alignment = alignof( value_type );
+
+    static std::size_t width( ContainerT const &c ) { return c.width(); }
+    static std::size_t height( ContainerT const &c ) { return c.height(); }
+    static std::size_t depth( ContainerT const &c ) { return c.depth(); }
+    static std::size_t raw_index0_size( ContainerT const &c ) { return c.raw_index0_size(); }
+    static std::size_t raw_index1_size( ContainerT const &c ) { return c.raw_index1_size(); }
+    static std::size_t raw_index2_size( ContainerT const &c ) { return c.raw_index2_size(); }
+    static std::size_t raw_stride0( ContainerT const &c ) { return c.raw_stride( 0 ); }
+    static std::size_t raw_stride1( ContainerT const &c ) { return c.raw_stride( 1 ); }
+    static std::size_t raw_stride2( ContainerT const &c ) { return c.raw_stride( 2 ); }
+    static std::size_t item_count( ContainerT const &c ) { return c.size(); }
+    static T *items( ContainerT const &c ) { return c.data(); }
+};
+
+/// The view type of a container, read only when the container is const
+template <typename ContainerT>
+struct view_of
+{
+    using value_type = typename Traits<typename std::remove_const<ContainerT>::type>::value_type;
+    using twist_type = typename Traits<typename std::remove_const<ContainerT>::type>::twist_type;
+    using type = BlockView<typename std::conditional<std::is_const<ContainerT>::value, value_type const, value_type>::type,
+                           twist_type>;
+};
+
+template <typename T, typename TwistType>
+struct view_of<BlockView<T, TwistType> >
+{
+    using type = BlockView<T, TwistType>;
+};
+
+template <typename T, typename TwistType>
+struct view_of<BlockView<T, TwistType> const>
+{
+    using type = BlockView<T, TwistType>;
+};
+}
+
+template <typename T, typename TwistType>
+auto get( BlockView<T, TwistType> const &c, std::size_t width_pos = 0, std::size_t height_pos = 0, std::size_t depth_pos = 0 )
+    -> T &
+{
+    return c.get( width_pos, height_pos, depth_pos );
+}
+
+template <typename T, typename TwistType>
+auto set( BlockView<T, TwistType> const &c,
+          typename std::remove_const<T>::type const &v,
+          std::size_t width_pos = 0,
+          std::size_t height_pos = 0,
+          std::size_t depth_pos = 0 ) -> void
+{
+    c.get( width_pos, height_pos, depth_pos ) = v;
+}
+
+/** \addtogroup block_view view_block sub_block slice_block stride_block twist_view materialize
+ *
+ * Make views of a Block, DynBlock or BlockView. A view of a const container
+ * is read only. None of them copy items except materialize.
+ */
+/**@{*/
+
+/// A view of all of c
+template <typename ContainerT>
+auto view_block( ContainerT &c, typename Traits<typename std::remove_const<ContainerT>::type>::twist_type * = 0 ) ->
+    typename BlockDetail::view_of<ContainerT>::type
+{
+    using Layout = BlockDetail::layout<typename std::remove_const<ContainerT>::type>;
+    const std::array<std::size_t, 3> strides = BlockDetail::axis_strides( c );
+    return typename BlockDetail::view_of<ContainerT>::type(
+        Layout::items( c ), Layout::width( c ), Layout::height( c ), Layout::depth( c ), strides[0], strides[1], strides[2] );
+}
+
+template <typename T, typename TwistType>
+BlockView<T, TwistType> view_block( BlockView<T, TwistType> const &c )
+{
+    return c;
+}
+
+/// The width x height x depth window of c whose (0,0,0) item is c's (width_pos,height_pos,depth_pos) item.
+/// Throws std::out_of_range if the window does not fit in c
+template <typename T, typename TwistType>
+BlockView<T, TwistType> sub_block( BlockView<T, TwistType> const &c,
+                                   std::size_t width_pos,
+                                   std::size_t height_pos,
+                                   std::size_t depth_pos,
+                                   std::size_t width,
+                                   std::size_t height = 1,
+                                   std::size_t depth = 1 )
+{
+    if ( width_pos + width > c.width() || height_pos + height > c.height() || depth_pos + depth > c.depth() )
+    {
+        throw std::out_of_range( "sub_block" );
+    }
+    return BlockView<T, TwistType>( &c.get( width_pos, height_pos, depth_pos ),
+                                    width,
+                                    height,
+                                    depth,
+                                    c.width_stride(),
+                                    c.height_stride(),
+                                    c.depth_stride() );
+}
+
+template <typename ContainerT>
+auto sub_block( ContainerT &c,
+                std::size_t width_pos,
+                std::size_t height_pos,
+                std::size_t depth_pos,
+                std::size_t width,
+                std::size_t height = 1,
+                std::size_t depth = 1,
+                typename Traits<typename std::remove_const<ContainerT>::type>::twist_type * = 0 ) ->
+    typename BlockDetail::view_of<ContainerT>::type
+{
+    return sub_block( view_block( c ), width_pos, height_pos, depth_pos, width, height, depth );
+}
+
+/// The single slice of c at pos along axis; the view is 1 item along that axis.
+/// Throws std::out_of_range if pos is outside c
+template <typename T, typename TwistType>
+BlockView<T, TwistType> slice_block( BlockView<T, TwistType> const &c, Axis axis, std::size_t pos )
+{
+    return sub_block( c,
+                      axis == Axis::width ? pos : 0,
+                      axis == Axis::height ? pos : 0,
+                      axis == Axis::depth ? pos : 0,
+                      axis == Axis::width ? 1 : c.width(),
+                      axis == Axis::height ? 1 : c.height(),
+                      axis == Axis::depth ? 1 : c.depth() );
+}
+
+template <typename ContainerT>
+auto slice_block( ContainerT &c,
+                  Axis axis,
+                  std::size_t pos,
+                  typename Traits<typename std::remove_const<ContainerT>::type>::twist_type * = 0 ) ->
+    typename BlockDetail::view_of<ContainerT>::type
+{
+    return slice_block( view_block( c ), axis, pos );
+}
+
+/// Every width_step'th, height_step'th and depth_step'th item of c, starting with (0,0,0).
+/// Throws std::invalid_argument if a step is 0
+template <typename T, typename TwistType>
+BlockView<T, TwistType>
+    stride_block( BlockView<T, TwistType> const &c, std::size_t width_step, std::size_t height_step = 1, std::size_t depth_step = 1 )
+{
+    if ( width_step == 0 || height_step == 0 || depth_step == 0 )
+    {
+        throw std::invalid_argument( "stride_block" );
+    }
+    return BlockView<T, TwistType>( c.data(),
+                                    ( c.width() + width_step - 1 ) / width_step,
+                                    ( c.height() + height_step - 1 ) / height_step,
+                                    ( c.depth() + depth_step - 1 ) / depth_step,
+                                    c.width_stride() * width_step,
+                                    c.height_stride() * height_step,
+                                    c.depth_stride() * depth_step );
+}
+
+template <typename ContainerT>
+auto stride_block( ContainerT &c,
+                   std::size_t width_step,
+                   std::size_t height_step = 1,
+                   std::size_t depth_step = 1,
+                   typename Traits<typename std::remove_const<ContainerT>::type>::twist_type * = 0 ) ->
+    typename BlockDetail::view_of<ContainerT>::type
+{
+    return stride_block( view_block( c ), width_step, height_step, depth_step );
+}
+
+/// A view of c that is visited in the twist that Twister<TwistAmount> makes of the twist of c.
+/// Every item stays at the same (width,height,depth) position, so twisted views of twisted views
+/// are a single view whose twist is the composition of them all
+template <int TwistAmount, typename T, typename TwistType>
+auto twist_view( BlockView<T, TwistType> const &c ) -> BlockView<T, typename Twister<TwistType, TwistAmount>::output_twist>
+{
+    return BlockView<T, typename Twister<TwistType, TwistAmount>::output_twist>(
+        c.data(), c.width(), c.height(), c.depth(), c.width_stride(), c.height_stride(), c.depth_stride() );
+}
+
+template <int TwistAmount, typename ContainerT>
+auto twist_view( ContainerT &c, typename Traits<typename std::remove_const<ContainerT>::type>::twist_type * = 0 )
+    -> BlockView<typename BlockDetail::view_of<ContainerT>::type::element_type,
+                 typename Twister<typename Traits<typename std::remove_const<ContainerT>::type>::twist_type, TwistAmount>::output_twist>
+{
+    return twist_view<TwistAmount>( view_block( c ) );
+}
+
+/// A DynBlock stored in the twist of the view c, holding a copy of its items. The copy is a single
+/// copy_block, which transposes tiles when the storage under c has a different twist
+template <typename InstrumentT = NoInstrument, typename T, typename TwistType>
+auto materialize( BlockView<T, TwistType> const &c ) -> DynBlock<typename std::remove_const<T>::type, TwistType>
+{
+    DynBlock<typename std::remove_const<T>::type, TwistType> r( c.width(), c.height(), c.depth() );
+    copy_block<InstrumentT>( c, r );
+    return r;
+}
+
+/**@}*/
+
+DAP_NAMESPACE_END
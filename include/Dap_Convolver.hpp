@@ -0,0 +1,275 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Aligned.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_BlockView.hpp"
+#include "Dap_SIMD.hpp"
+#include "Dap_FFT.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+namespace ConvolverDetail
+{
+
+/// acc[k] += x[k] * h[k] for the n bins of a packed real spectrum, where bin 0 holds two real bins and only its parts
+/// multiply. The bins run through the native complex vector
+template <typename T>
+void multiply_accumulate( std::complex<T> *acc, std::complex<T> const *x, std::complex<T> const *h, std::size_t n )
+{
+    typedef std::complex<T> complex_type;
+    typedef SIMD_Vector<complex_type, simd_native_size<complex_type>::value> vector_type;
+    const std::size_t lanes = vector_type::vector_size;
+    const complex_type packed( acc[0].real() + x[0].real() * h[0].real(), acc[0].imag() + x[0].imag() * h[0].imag() );
+
+    std::size_t k = 0;
+    for ( ; k + lanes <= n; k += lanes )
+    {
+        vector_type va, vx, vh;
+        va.load( acc + k );
+        vx.load( x + k );
+        vh.load( h + k );
+        fma( vx, vh, va ).store( acc + k );
+    }
+    for ( ; k < n; ++k )
+    {
+        acc[k] = fma( x[k], h[k], acc[k] );
+    }
+    acc[0] = packed;
+}
+}
+
+/**
+ * A uniformly partitioned overlap-save convolver, for impulse responses far
+ * too long to convolve directly: reverbs, speaker and room correction.
+ *
+ * Each channel's impulse response is cut into partitions of BlockSize taps,
+ * and each partition is kept as the spectrum of a 2 * BlockSize point real
+ * FFT. Every call to process() takes BlockSize new frames per channel,
+ * transforms the last 2 * BlockSize input samples once, and pushes that
+ * spectrum onto a frequency domain delay line of one spectrum per partition.
+ * The output spectrum is the sum of each delayed input spectrum times its
+ * partition, a complex multiply accumulate run on the native complex SIMD
+ * vectors, and one inverse FFT turns it into BlockSize output frames.
+ *
+ * The output of each call is the input of that same call convolved with the
+ * impulse response, so the only latency is the BlockSize frames of the
+ * buffer itself. The work per call is the same every time: one forward and
+ * one inverse FFT and a multiply accumulate over every partition, with no
+ * allocation, whatever the signal. The partition count, and so the cost, is
+ * set by the longest response the constructor allows; shorter responses are
+ * padded with silent partitions.
+ *
+ * The buffers are Block, DynBlock or BlockView containers whose width is
+ * BlockSize frames. Each row of frames, one for each height and depth
+ * position, is one channel, and channel h + height * d is the row at height
+ * h and depth d.
+ */
+template <typename T, std::size_t BlockSize>
+class Convolver
+{
+    static_assert( BlockSize >= 2 && ( BlockSize & ( BlockSize - 1 ) ) == 0, "Convolver block size must be a power of two" );
+
+  public:
+    typedef T value_type;
+    typedef std::complex<T> complex_type;
+    typedef FFT<T, 2 * BlockSize> fft_type;
+
+    /// The number of frames each call to process() takes and returns
+    static const std::size_t block_size = BlockSize;
+
+    /// The number of bins in the spectrum of each partition
+    static const std::size_t spectrum_size = fft_type::spectrum_size;
+
+    /// A convolver for channels channels of impulse responses of up to max_taps taps, all silent to begin with
+    Convolver( std::size_t channels, std::size_t max_taps )
+        : m_channels( channels )
+        , m_partitions( std::max<std::size_t>( 1, ( max_taps + BlockSize - 1 ) / BlockSize ) )
+        , m_current( 0 )
+        , m_filters( channels * m_partitions * spectrum_size )
+        , m_delay_line( channels * m_partitions * spectrum_size )
+        , m_history( channels * 2 * BlockSize )
+        , m_accumulator( spectrum_size )
+        , m_frame( 2 * BlockSize )
+    {
+        // the FFT's constructor sizes its work buffer for the real transforms, so process() never allocates
+    }
+
+    std::size_t channels() const
+    {
+        return m_channels;
+    }
+
+    std::size_t partitions() const
+    {
+        return m_partitions;
+    }
+
+    /// The longest impulse response that fits in the partitions
+    std::size_t max_taps() const
+    {
+        return m_partitions * BlockSize;
+    }
+
+    /// Set the impulse response of one channel. Throws std::out_of_range for a channel that does not exist and
+    /// std::invalid_argument for more than max_taps() taps
+    void set_impulse_response( std::size_t channel, T const *taps, std::size_t count )
+    {
+        if ( channel >= m_channels )
+        {
+            throw std::out_of_range( "Convolver channel" );
+        }
+        if ( count > max_taps() )
+        {
+            throw std::invalid_argument( "Convolver impulse response is too long" );
+        }
+
+        // the partitions are padded with BlockSize zeros, and carry the scaling of the unnormalized inverse FFT
+        const T scale = T( 1 ) / T( 2 * BlockSize );
+        complex_type *filter = m_filters.data() + channel * m_partitions * spectrum_size;
+        for ( std::size_t p = 0; p < m_partitions; ++p )
+        {
+            std::fill( m_frame.begin(), m_frame.end(), T( 0 ) );
+            for ( std::size_t i = 0; i < BlockSize && p * BlockSize + i < count; ++i )
+            {
+                m_frame[i] = taps[p * BlockSize + i] * scale;
+            }
+            m_fft.forward_real( m_frame.data(), filter + p * spectrum_size );
+        }
+    }
+
+    /// Set the impulse response of every channel
+    void set_impulse_response( T const *taps, std::size_t count )
+    {
+        for ( std::size_t c = 0; c < m_channels; ++c )
+        {
+            set_impulse_response( c, taps, count );
+        }
+    }
+
+    /// Clear the input history and the delay line, as if every channel had only ever had silence as input
+    void reset()
+    {
+        std::fill( m_history.begin(), m_history.end(), T( 0 ) );
+        std::fill( m_delay_line.begin(), m_delay_line.end(), complex_type() );
+        m_current = 0;
+    }
+
+    /// Convolve BlockSize frames of every channel from input to output, which may be the same block. Throws
+    /// std::invalid_argument if the blocks are not BlockSize frames of channels() channels
+    template <typename InputContainerT, typename OutputContainerT>
+    void process( InputContainerT const &input, OutputContainerT &output )
+    {
+        BlockDetail::check_same_size( input, output );
+        auto in = view_block( input );
+        auto out = view_block( output );
+        if ( in.width() != BlockSize || in.height() * in.depth() != m_channels )
+        {
+            throw std::invalid_argument( "Convolver block size" );
+        }
+        for ( std::size_t c = 0; c < m_channels; ++c )
+        {
+            const std::size_t h = c % in.height();
+            const std::size_t d = c / in.height();
+            process_channel( c, &in.get( 0, h, d ), in.width_stride(), &out.get( 0, h, d ), out.width_stride() );
+        }
+        advance();
+    }
+
+    /// Convolve BlockSize frames of every channel, from planar buffers where channel c starts at
+    /// input + c * channel_stride. input and output may be the same buffer
+    void process( T const *input, T *output, std::size_t channel_stride = BlockSize )
+    {
+        for ( std::size_t c = 0; c < m_channels; ++c )
+        {
+            process_channel( c, input + c * channel_stride, 1, output + c * channel_stride, 1 );
+        }
+        advance();
+    }
+
+  private:
+    /// Shift BlockSize frames of one channel into its history, push their spectrum onto the delay line, and write out
+    /// the sum over the partitions
+    void process_channel( std::size_t channel, T const *input, std::size_t input_stride, T *output, std::size_t output_stride )
+    {
+        T *history = m_history.data() + channel * 2 * BlockSize;
+        std::copy( history + BlockSize, history + 2 * BlockSize, history );
+        for ( std::size_t i = 0; i < BlockSize; ++i )
+        {
+            history[BlockSize + i] = input[i * input_stride];
+        }
+
+        complex_type *delay_line = m_delay_line.data() + channel * m_partitions * spectrum_size;
+        complex_type const *filter = m_filters.data() + channel * m_partitions * spectrum_size;
+        m_fft.forward_real( history, delay_line + m_current * spectrum_size );
+
+        // partition p of the filter meets the input spectrum from p blocks ago
+        std::fill( m_accumulator.begin(), m_accumulator.end(), complex_type() );
+        for ( std::size_t p = 0; p < m_partitions; ++p )
+        {
+            const std::size_t slot = ( m_current + m_partitions - p ) % m_partitions;
+            ConvolverDetail::multiply_accumulate(
+                m_accumulator.data(), delay_line + slot * spectrum_size, filter + p * spectrum_size, spectrum_size );
+        }
+
+        // the first half of the circular convolution wraps around; the second half is the linear convolution
+        m_fft.inverse_real( m_accumulator.data(), m_frame.data() );
+        for ( std::size_t i = 0; i < BlockSize; ++i )
+        {
+            output[i * output_stride] = m_frame[BlockSize + i];
+        }
+    }
+
+    void advance()
+    {
+        m_current = ( m_current + 1 ) % m_partitions;
+    }
+
+    std::size_t m_channels;
+    std::size_t m_partitions;
+    std::size_t m_current;
+    fft_type m_fft;
+    std::vector<complex_type, aligned_allocator<complex_type> > m_filters;
+    std::vector<complex_type, aligned_allocator<complex_type> > m_delay_line;
+    std::vector<T, aligned_allocator<T> > m_history;
+    std::vector<complex_type, aligned_allocator<complex_type> > m_accumulator;
+    std::vector<T, aligned_allocator<T> > m_frame;
+};
+
+template <typename T, std::size_t BlockSize>
+const std::size_t Convolver<T, BlockSize>::block_size;
+
+template <typename T, std::size_t BlockSize>
+const std::size_t Convolver<T, BlockSize>::spectrum_size;
+
+DAP_NAMESPACE_END
@@ -0,0 +1,220 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+
+/**
+ * Runtime CPU dispatch.
+ *
+ * The SIMD_Vector backends are chosen at compile time. A library built for
+ * the baseline never uses AVX and one built with -mavx faults on older
+ * hosts, so the block level kernels below are also compiled once per
+ * instruction set variant (src/Dap_Dispatch_*.cpp, each with its own ISA
+ * flags) and the best one the running CPU supports is picked on first use.
+ *
+ * The environment variable DAP_CPU_VARIANT (baseline, sse2, avx or avx2)
+ * forces a variant. A variant that is not compiled in or not supported by
+ * the CPU falls back to the best available one below it.
+ *
+ * The kernels only take raw pointers and sizes, so this header is outside
+ * of the per-ISA inline namespace and the table is shared by all variants.
+ *
+ * For float and double, BiQuad::process, BiQuadBank::process, the
+ * transposes of copy_block and twist_block and the PCM conversions all call
+ * through the table returned by dispatch_for<T>(). So do the transcendental
+ * functions of SIMD_Vectors of several native registers and the contiguous
+ * rows of evaluate_block that are a + b, a * b, a * scalar or fma( a, b, c ),
+ * when the selected variant has wider registers than the build.
+ */
+
+namespace Dap
+{
+
+enum class CpuVariant
+{
+    baseline, ///< compiled with the flags of the rest of the library
+    sse2,
+    avx,
+    avx2 ///< AVX2 and FMA
+};
+
+static const std::size_t cpu_variant_count = 4;
+
+enum class MathFunction
+{
+    sin,
+    cos,
+    tan,
+    exp,
+    exp2,
+    log,
+    log2
+};
+
+static const std::size_t math_function_count = 7;
+
+/// Integer PCM sample formats, little endian, with full scale at -1.0 and just under 1.0
+enum class PCMFormat
+{
+    int16,
+    int24, ///< packed in three bytes
+    int32
+};
+
+static const std::size_t pcm_format_count = 3;
+
+/// The bytes of one sample of the format
+inline std::size_t pcm_format_bytes( PCMFormat format )
+{
+    return format == PCMFormat::int16 ? 2 : format == PCMFormat::int24 ? 3 : 4;
+}
+
+/// The state of the TPDF dither of pcm_encode: an xorshift32 generator per lane of the widest variant, none of them 0
+struct DispatchDither
+{
+    std::uint32_t state[8];
+};
+
+/// A bank of independent biquad sections held as arrays of one item per channel. The arrays hold padded_channels
+/// items, the channels filtered followed by padding lanes of zero coefficients and state
+template <typename T>
+struct DispatchBiQuadBank
+{
+    T const *a0;
+    T const *a1;
+    T const *a2;
+    T const *b1;
+    T const *b2;
+    T *z1;
+    T *z2;
+    std::size_t channels;
+    std::size_t padded_channels;
+};
+
+/// The kernels of one variant for one sample type
+template <typename T>
+struct DispatchKernelSet
+{
+    /// Filter count samples through one section. coeffs is { a0, a1, a2, b1, b2 }, state is { z1, z2 }
+    void ( *biquad )( T const *coeffs, T *state, T const *input, T *output, std::size_t count );
+
+    /// Filter frames of bank.channels interleaved samples. Frame f of the input starts at input[f * frame_stride].
+    /// The channels past the last whole register run in the padding lanes of one more register
+    void ( *biquad_bank )( DispatchBiQuadBank<T> const &bank, T const *input, T *output, std::size_t frames,
+                           std::size_t frame_stride );
+
+    /// output = input * gain
+    void ( *scale )( T const *input, T gain, T *output, std::size_t count );
+
+    /// output = a + b
+    void ( *add )( T const *a, T const *b, T *output, std::size_t count );
+
+    /// output = a * b
+    void ( *multiply )( T const *a, T const *b, T *output, std::size_t count );
+
+    /// output = a * b + c
+    void ( *multiply_add )( T const *a, T const *b, T const *c, T *output, std::size_t count );
+
+    /// dest[col * dest_stride + row] = src[row * src_stride + col]. The buffers may not overlap
+    void ( *transpose )( T const *src, std::size_t rows, std::size_t cols, std::size_t src_stride, T *dest,
+                         std::size_t dest_stride );
+
+    /// output[i] = f(input[i]) for each MathFunction f, with the accuracy of the SIMD_Vector implementation
+    void ( *math[math_function_count] )( T const *input, T *output, std::size_t count );
+
+    /// output[i] = sample i of input * gain / full scale, for samples of each PCMFormat
+    void ( *pcm_decode[pcm_format_count] )( void const *input, T gain, T *output, std::size_t count );
+
+    /// sample i of output = input[i] * gain * full scale, plus a step of TPDF dither unless dither is null, rounded to
+    /// nearest and saturated, for samples of each PCMFormat
+    void ( *pcm_encode[pcm_format_count] )( T const *input, T gain, void *output, std::size_t count, DispatchDither *dither );
+};
+
+struct DispatchKernels
+{
+    CpuVariant variant;
+    std::size_t register_bytes; ///< the width of the widest SIMD register the variant uses
+    DispatchKernelSet<float> f32;
+    DispatchKernelSet<double> f64;
+
+    template <typename T>
+    DispatchKernelSet<T> const &get() const;
+};
+
+template <>
+inline DispatchKernelSet<float> const &DispatchKernels::get<float>() const
+{
+    return f32;
+}
+
+template <>
+inline DispatchKernelSet<double> const &DispatchKernels::get<double>() const
+{
+    return f64;
+}
+
+/// The name used for the variant by DAP_CPU_VARIANT
+const char *cpu_variant_name( CpuVariant v );
+
+/// True if the running CPU and operating system support the instructions of the variant
+bool cpu_supports( CpuVariant v );
+
+/// The kernels of a variant, or nullptr if it was not compiled in or the CPU does not support it
+DispatchKernels const *dispatch_kernels( CpuVariant v );
+
+/// The kernels selected on first use from the CPU features and DAP_CPU_VARIANT
+DispatchKernels const &dispatch();
+
+/// The kernels selected for samples of type T
+template <typename T>
+inline DispatchKernelSet<T> const &dispatch_for()
+{
+    return dispatch().get<T>();
+}
+
+/// True for the sample types that have a DispatchKernelSet
+template <typename T>
+struct has_dispatch_kernels : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value>
+{
+};
+
+/// Entry points of the variant translation units, for dispatch_kernels() only: they do not check cpu_supports(), so
+/// calling one for a variant the CPU lacks runs illegal instructions. Each returns nullptr when its file was not built
+/// with the ISA flags
+namespace DispatchVariantDetail
+{
+DispatchKernels const *kernels_baseline();
+DispatchKernels const *kernels_sse2();
+DispatchKernels const *kernels_avx();
+DispatchKernels const *kernels_avx2();
+}
+}
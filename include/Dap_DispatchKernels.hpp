@@ -0,0 +1,392 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_SIMD.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_BiQuad.hpp"
+#include "Dap_Dispatch.hpp"
+#include "Dap_DispatchPCM.hpp"
+
+/**
+ * The bodies of the runtime dispatched kernels. This header is only included
+ * by src/Dap_Dispatch*.cpp; each of those files compiles it with different
+ * ISA flags into its own inline namespace and hands out the resulting table.
+ *
+ * Everything the kernels call must live in that inline namespace or be a
+ * plain C function. A template or inline function of namespace std that is
+ * not inlined, such as std::copy or the float overload of std::fma at -O0,
+ * is emitted as a weak symbol under the same name by every file, and the
+ * linker keeps any one of them for the whole program: the AVX2 copy would
+ * then run on CPUs without AVX2. Use loops and the C library functions
+ * (std::fmaf, std::lrintf, FLT_MIN, HUGE_VALF) instead.
+ */
+
+DAP_NAMESPACE_BEGIN
+
+namespace DispatchDetail
+{
+
+template <typename T>
+struct native
+{
+    static const std::size_t size = simd_native_size<T>::value;
+    typedef SIMD_Vector<T, size> vector_type;
+
+    static vector_type load( T const *p )
+    {
+        vector_type v;
+        v.load( p );
+        return v;
+    }
+
+    static void store( T *p, vector_type const &v )
+    {
+        v.store( p );
+    }
+};
+
+template <typename T>
+void biquad( T const *coeffs, T *state, T const *input, T *output, std::size_t count )
+{
+    typename BiQuad<T>::Coeffs c;
+    c.a0 = coeffs[0];
+    c.a1 = coeffs[1];
+    c.a2 = coeffs[2];
+    c.b1 = coeffs[3];
+    c.b2 = coeffs[4];
+    T z1 = state[0];
+    T z2 = state[1];
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        output[i] = BiQuad<T>::step( c, z1, z2, input[i] );
+    }
+    state[0] = z1;
+    state[1] = z2;
+}
+
+/// How many frames ahead of the current frame biquad_bank prefetches the input
+static const std::size_t biquad_bank_prefetch_frames = 8;
+
+/// Run all frames through Regs native registers worth of channels starting at first, with the coefficients and
+/// state held in registers
+template <typename T, std::size_t Regs>
+void biquad_bank_chunk( DispatchBiQuadBank<T> const &bank, std::size_t first, T const *input, T *output,
+                        std::size_t frames, std::size_t frame_stride )
+{
+    typedef native<T> N;
+    typedef typename N::vector_type V;
+    V a0[Regs], a1[Regs], a2[Regs], nb1[Regs], nb2[Regs], z1[Regs], z2[Regs];
+    for ( std::size_t r = 0; r < Regs; ++r )
+    {
+        std::size_t ch = first + r * N::size;
+        a0[r] = N::load( bank.a0 + ch );
+        a1[r] = N::load( bank.a1 + ch );
+        a2[r] = N::load( bank.a2 + ch );
+        nb1[r] = -N::load( bank.b1 + ch );
+        nb2[r] = -N::load( bank.b2 + ch );
+        z1[r] = N::load( bank.z1 + ch );
+        z2[r] = N::load( bank.z2 + ch );
+    }
+
+    for ( std::size_t f = 0; f < frames; ++f )
+    {
+        if ( f + biquad_bank_prefetch_frames < frames )
+        {
+            DAP_PREFETCH( input + ( f + biquad_bank_prefetch_frames ) * frame_stride + first );
+        }
+        for ( std::size_t r = 0; r < Regs; ++r )
+        {
+            std::size_t pos = f * frame_stride + first + r * N::size;
+            V x = N::load( input + pos );
+            V y = fma( x, a0[r], z1[r] );
+            z1[r] = fma( y, nb1[r], fma( x, a1[r], z2[r] ) );
+            z2[r] = fma( y, nb2[r], x * a2[r] );
+            N::store( output + pos, y );
+        }
+    }
+
+    for ( std::size_t r = 0; r < Regs; ++r )
+    {
+        std::size_t ch = first + r * N::size;
+        N::store( bank.z1 + ch, z1[r] );
+        N::store( bank.z2 + ch, z2[r] );
+    }
+}
+
+/// Load lanes items from p into a register whose other lanes are zero
+template <typename T>
+typename native<T>::vector_type load_lanes( T const *p, std::size_t lanes )
+{
+    typedef native<T> N;
+    if ( lanes == N::size )
+    {
+        return N::load( p );
+    }
+    T padded[N::size];
+    for ( std::size_t j = 0; j < N::size; ++j )
+    {
+        padded[j] = j < lanes ? p[j] : T( 0 );
+    }
+    return N::load( padded );
+}
+
+/// Store the first lanes items of v to p
+template <typename T>
+void store_lanes( T *p, typename native<T>::vector_type const &v, std::size_t lanes )
+{
+    typedef native<T> N;
+    if ( lanes == N::size )
+    {
+        N::store( p, v );
+        return;
+    }
+    T padded[N::size];
+    N::store( padded, v );
+    for ( std::size_t j = 0; j < lanes; ++j )
+    {
+        p[j] = padded[j];
+    }
+}
+
+/// Run all frames through the fewer than one register of channels from first to bank.channels, in the lanes of one
+/// register. The padding lanes filter zeros with zero coefficients; when the bank's arrays are padded that far the
+/// coefficients and state are loaded whole, and only the samples of each frame are staged
+template <typename T>
+void biquad_bank_tail( DispatchBiQuadBank<T> const &bank, std::size_t first, T const *input, T *output,
+                       std::size_t frames, std::size_t frame_stride )
+{
+    typedef native<T> N;
+    typedef typename N::vector_type V;
+    const std::size_t count = bank.channels - first;
+    const std::size_t lanes = first + N::size <= bank.padded_channels ? N::size : count;
+    const V a0 = load_lanes( bank.a0 + first, lanes );
+    const V a1 = load_lanes( bank.a1 + first, lanes );
+    const V a2 = load_lanes( bank.a2 + first, lanes );
+    const V nb1 = -load_lanes( bank.b1 + first, lanes );
+    const V nb2 = -load_lanes( bank.b2 + first, lanes );
+    V z1 = load_lanes( bank.z1 + first, lanes );
+    V z2 = load_lanes( bank.z2 + first, lanes );
+
+    for ( std::size_t f = 0; f < frames; ++f )
+    {
+        if ( f + biquad_bank_prefetch_frames < frames )
+        {
+            DAP_PREFETCH( input + ( f + biquad_bank_prefetch_frames ) * frame_stride + first );
+        }
+        std::size_t pos = f * frame_stride + first;
+        V x = load_lanes( input + pos, count );
+        V y = fma( x, a0, z1 );
+        z1 = fma( y, nb1, fma( x, a1, z2 ) );
+        z2 = fma( y, nb2, x * a2 );
+        store_lanes( output + pos, y, count );
+    }
+
+    store_lanes( bank.z1 + first, z1, lanes );
+    store_lanes( bank.z2 + first, z2, lanes );
+}
+
+template <typename T>
+void biquad_bank( DispatchBiQuadBank<T> const &bank, T const *input, T *output, std::size_t frames,
+                  std::size_t frame_stride )
+{
+    // two registers per coefficient keeps all seven arrays of a chunk in the 16 named registers
+    static const std::size_t regs = 2;
+    static const std::size_t chunk = regs * native<T>::size;
+    std::size_t first = 0;
+    for ( ; first + chunk <= bank.channels; first += chunk )
+    {
+        biquad_bank_chunk<T, regs>( bank, first, input, output, frames, frame_stride );
+    }
+    for ( ; first + native<T>::size <= bank.channels; first += native<T>::size )
+    {
+        biquad_bank_chunk<T, 1>( bank, first, input, output, frames, frame_stride );
+    }
+    if ( first < bank.channels )
+    {
+        biquad_bank_tail( bank, first, input, output, frames, frame_stride );
+    }
+}
+
+template <typename T>
+void scale( T const *input, T gain, T *output, std::size_t count )
+{
+    typedef native<T> N;
+    std::size_t i = 0;
+    for ( ; i + N::size <= count; i += N::size )
+    {
+        N::store( output + i, N::load( input + i ) * gain );
+    }
+    for ( ; i < count; ++i )
+    {
+        output[i] = input[i] * gain;
+    }
+}
+
+template <typename T>
+void add( T const *a, T const *b, T *output, std::size_t count )
+{
+    typedef native<T> N;
+    std::size_t i = 0;
+    for ( ; i + N::size <= count; i += N::size )
+    {
+        N::store( output + i, N::load( a + i ) + N::load( b + i ) );
+    }
+    for ( ; i < count; ++i )
+    {
+        output[i] = a[i] + b[i];
+    }
+}
+
+template <typename T>
+void multiply( T const *a, T const *b, T *output, std::size_t count )
+{
+    typedef native<T> N;
+    std::size_t i = 0;
+    for ( ; i + N::size <= count; i += N::size )
+    {
+        N::store( output + i, N::load( a + i ) * N::load( b + i ) );
+    }
+    for ( ; i < count; ++i )
+    {
+        output[i] = a[i] * b[i];
+    }
+}
+
+template <typename T>
+void multiply_add( T const *a, T const *b, T const *c, T *output, std::size_t count )
+{
+    typedef native<T> N;
+    std::size_t i = 0;
+    for ( ; i + N::size <= count; i += N::size )
+    {
+        N::store( output + i, fma( N::load( a + i ), N::load( b + i ), N::load( c + i ) ) );
+    }
+    for ( ; i < count; ++i )
+    {
+        output[i] = fma( a[i], b[i], c[i] );
+    }
+}
+
+/// Transpose in square tiles so that both the reads and the writes of a tile stay in cache, with the squares of
+/// each tile transposed in the registers of this variant
+template <typename T>
+void transpose( T const *src, std::size_t rows, std::size_t cols, std::size_t src_stride, T *dest,
+                std::size_t dest_stride )
+{
+    BlockDetail::transpose_items( src, src_stride, dest, dest_stride, rows, cols );
+}
+
+#define DAP_DISPATCH_MATH_OP( name )                                                                                             \
+    struct math_##name                                                                                                           \
+    {                                                                                                                            \
+        template <typename V>                                                                                                    \
+        static V apply( V const &v )                                                                                             \
+        {                                                                                                                        \
+            return name( v );                                                                                                    \
+        }                                                                                                                        \
+    };
+
+DAP_DISPATCH_MATH_OP( sin )
+DAP_DISPATCH_MATH_OP( cos )
+DAP_DISPATCH_MATH_OP( tan )
+DAP_DISPATCH_MATH_OP( exp )
+DAP_DISPATCH_MATH_OP( exp2 )
+DAP_DISPATCH_MATH_OP( log )
+DAP_DISPATCH_MATH_OP( log2 )
+
+#undef DAP_DISPATCH_MATH_OP
+
+template <typename T, typename OpT>
+void math( T const *input, T *output, std::size_t count )
+{
+    typedef native<T> N;
+    std::size_t i = 0;
+    for ( ; i + N::size <= count; i += N::size )
+    {
+        N::store( output + i, OpT::apply( N::load( input + i ) ) );
+    }
+    if ( i < count )
+    {
+        // pad the tail with ones, which is inside the domain of every function
+        T tail[N::size];
+        for ( std::size_t j = 0; j < N::size; ++j )
+        {
+            tail[j] = i + j < count ? input[i + j] : T( 1 );
+        }
+        N::store( tail, OpT::apply( N::load( tail ) ) );
+        for ( std::size_t j = 0; i + j < count; ++j )
+        {
+            output[i + j] = tail[j];
+        }
+    }
+}
+
+template <typename T>
+DispatchKernelSet<T> make_kernel_set()
+{
+    DispatchKernelSet<T> k;
+    k.biquad = &biquad<T>;
+    k.biquad_bank = &biquad_bank<T>;
+    k.scale = &scale<T>;
+    k.add = &add<T>;
+    k.multiply = &multiply<T>;
+    k.multiply_add = &multiply_add<T>;
+    k.transpose = &transpose<T>;
+    k.math[static_cast<std::size_t>( MathFunction::sin )] = &math<T, math_sin>;
+    k.math[static_cast<std::size_t>( MathFunction::cos )] = &math<T, math_cos>;
+    k.math[static_cast<std::size_t>( MathFunction::tan )] = &math<T, math_tan>;
+    k.math[static_cast<std::size_t>( MathFunction::exp )] = &math<T, math_exp>;
+    k.math[static_cast<std::size_t>( MathFunction::exp2 )] = &math<T, math_exp2>;
+    k.math[static_cast<std::size_t>( MathFunction::log )] = &math<T, math_log>;
+    k.math[static_cast<std::size_t>( MathFunction::log2 )] = &math<T, math_log2>;
+    k.pcm_decode[static_cast<std::size_t>( PCMFormat::int16 )] = &pcm_decode<PCMFormat::int16, T>;
+    k.pcm_decode[static_cast<std::size_t>( PCMFormat::int24 )] = &pcm_decode<PCMFormat::int24, T>;
+    k.pcm_decode[static_cast<std::size_t>( PCMFormat::int32 )] = &pcm_decode<PCMFormat::int32, T>;
+    k.pcm_encode[static_cast<std::size_t>( PCMFormat::int16 )] = &pcm_encode<PCMFormat::int16, T>;
+    k.pcm_encode[static_cast<std::size_t>( PCMFormat::int24 )] = &pcm_encode<PCMFormat::int24, T>;
+    k.pcm_encode[static_cast<std::size_t>( PCMFormat::int32 )] = &pcm_encode<PCMFormat::int32, T>;
+    return k;
+}
+
+inline DispatchKernels make_kernels( CpuVariant variant )
+{
+    DispatchKernels k;
+    k.variant = variant;
+    k.register_bytes = DAP_SIMD_NATIVE_BYTES;
+    k.f32 = make_kernel_set<float>();
+    k.f64 = make_kernel_set<double>();
+    return k;
+}
+}
+
+DAP_NAMESPACE_END
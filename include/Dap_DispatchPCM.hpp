@@ -0,0 +1,521 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_SIMD.hpp"
+#include "Dap_Dispatch.hpp"
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+/**
+ * The bodies of the PCM conversion kernels of the dispatch table, included
+ * by Dap_DispatchKernels.hpp. SIMD_Vector has no integer lanes, so these use
+ * the intrinsics of the variant directly: eight samples at a time with AVX2,
+ * four with SSE2 (which the avx variant also takes, AVX having no 256 bit
+ * integer operations), and the scalar code alone elsewhere. The scalar code
+ * also converts the samples left over at the end.
+ */
+
+#if defined( __AVX2__ )
+#define DAP_DISPATCH_PCM_LANES 8
+#elif defined( __SSE2__ )
+#define DAP_DISPATCH_PCM_LANES 4
+#endif
+
+DAP_NAMESPACE_BEGIN
+
+namespace DispatchDetail
+{
+
+/// Byte level access to the samples of one PCMFormat. slack is the number of samples past the end of a vector of
+/// them that its loads and stores may touch
+template <PCMFormat Format>
+struct pcm_format;
+
+template <>
+struct pcm_format<PCMFormat::int16>
+{
+    static const std::size_t bytes = 2;
+    static const std::size_t slack = 0;
+    static const std::int32_t max = 32767;
+
+    static double full_scale()
+    {
+        return 32768.0;
+    }
+
+    static std::int32_t load( unsigned char const *p )
+    {
+        return static_cast<std::int16_t>( p[0] | ( p[1] << 8 ) );
+    }
+
+    static void store( unsigned char *p, std::int32_t v )
+    {
+        p[0] = static_cast<unsigned char>( v );
+        p[1] = static_cast<unsigned char>( v >> 8 );
+    }
+};
+
+template <>
+struct pcm_format<PCMFormat::int24>
+{
+    static const std::size_t bytes = 3;
+    static const std::size_t slack = 2;
+    static const std::int32_t max = 8388607;
+
+    static double full_scale()
+    {
+        return 8388608.0;
+    }
+
+    static std::int32_t load( unsigned char const *p )
+    {
+        const std::int32_t v = p[0] | ( p[1] << 8 ) | ( p[2] << 16 );
+        return ( v ^ 0x800000 ) - 0x800000;
+    }
+
+    static void store( unsigned char *p, std::int32_t v )
+    {
+        p[0] = static_cast<unsigned char>( v );
+        p[1] = static_cast<unsigned char>( v >> 8 );
+        p[2] = static_cast<unsigned char>( v >> 16 );
+    }
+};
+
+template <>
+struct pcm_format<PCMFormat::int32>
+{
+    static const std::size_t bytes = 4;
+    static const std::size_t slack = 0;
+    static const std::int32_t max = 2147483647;
+
+    static double full_scale()
+    {
+        return 2147483648.0;
+    }
+
+    static std::int32_t load( unsigned char const *p )
+    {
+        return static_cast<std::int32_t>( std::uint32_t( p[0] ) | ( std::uint32_t( p[1] ) << 8 )
+                                          | ( std::uint32_t( p[2] ) << 16 ) | ( std::uint32_t( p[3] ) << 24 ) );
+    }
+
+    static void store( unsigned char *p, std::int32_t v )
+    {
+        const std::uint32_t u = static_cast<std::uint32_t>( v );
+        p[0] = static_cast<unsigned char>( u );
+        p[1] = static_cast<unsigned char>( u >> 8 );
+        p[2] = static_cast<unsigned char>( u >> 16 );
+        p[3] = static_cast<unsigned char>( u >> 24 );
+    }
+};
+
+/// The C library functions rather than the float overloads of <cmath>, which are templates of namespace std and
+/// would be shared with the other variants, see Dap_DispatchKernels.hpp
+inline float pcm_toward_zero( float v )
+{
+    return std::nextafterf( v, 0.0f );
+}
+
+inline double pcm_toward_zero( double v )
+{
+    return std::nextafter( v, 0.0 );
+}
+
+inline long pcm_round( float v )
+{
+    return std::lrintf( v );
+}
+
+inline long pcm_round( double v )
+{
+    return std::lrint( v );
+}
+
+/// The largest T that rounds to a sample no larger than the format's largest. For int32 and float that is just
+/// under 2^31, as 2^31 - 1 itself rounds up to 2^31
+template <PCMFormat Format, typename T>
+T pcm_max()
+{
+    const T hi = static_cast<T>( pcm_format<Format>::max );
+    return static_cast<double>( hi ) > pcm_format<Format>::max ? pcm_toward_zero( hi ) : hi;
+}
+
+inline std::uint32_t xorshift( std::uint32_t s )
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+/// One step of TPDF dither: the difference of two uniform values in [0, 1), from the generator state
+template <typename T>
+T pcm_tpdf( std::uint32_t &state )
+{
+    state = xorshift( state );
+    const T u1 = static_cast<T>( state >> 8 );
+    state = xorshift( state );
+    const T u2 = static_cast<T>( state >> 8 );
+    return ( u1 - u2 ) * T( 1.0 / 16777216.0 );
+}
+
+template <PCMFormat Format, typename T>
+void pcm_decode_scalar( unsigned char const *input, T scale, T *output, std::size_t count )
+{
+    typedef pcm_format<Format> F;
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        output[i] = static_cast<T>( F::load( input + i * F::bytes ) ) * scale;
+    }
+}
+
+/// first is the index of the first sample, which picks the dither generator lane
+template <PCMFormat Format, typename T>
+void pcm_encode_scalar(
+    T const *input, T scale, unsigned char *output, std::size_t count, DispatchDither *dither, std::size_t first )
+{
+    typedef pcm_format<Format> F;
+    const T lo = static_cast<T>( -F::full_scale() );
+    const T hi = pcm_max<Format, T>();
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        T v = input[i] * scale;
+        if ( dither )
+        {
+            v += pcm_tpdf<T>( dither->state[( first + i ) % 8] );
+        }
+        // written so that NaN ends up at lo
+        v = v > lo ? v : lo;
+        v = v < hi ? v : hi;
+        F::store( output + i * F::bytes, static_cast<std::int32_t>( pcm_round( v ) ) );
+    }
+}
+
+#if defined( __AVX2__ )
+
+typedef __m256i pcm_ints;
+typedef __m256 pcm_dither;
+
+template <PCMFormat Format>
+pcm_ints pcm_load( unsigned char const *p );
+
+template <>
+inline pcm_ints pcm_load<PCMFormat::int16>( unsigned char const *p )
+{
+    return _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<__m128i const *>( p ) ) );
+}
+
+/// Each half takes four samples of one 16 byte load, moves their bytes to the top of each lane and shifts them down
+/// with their sign
+template <>
+inline pcm_ints pcm_load<PCMFormat::int24>( unsigned char const *p )
+{
+    const __m128i low = _mm_loadu_si128( reinterpret_cast<__m128i const *>( p ) );
+    const __m128i high = _mm_loadu_si128( reinterpret_cast<__m128i const *>( p + 12 ) );
+    const __m256i bytes = _mm256_inserti128_si256( _mm256_castsi128_si256( low ), high, 1 );
+    const __m256i spread = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+    return _mm256_srai_epi32( _mm256_shuffle_epi8( bytes, spread ), 8 );
+}
+
+template <>
+inline pcm_ints pcm_load<PCMFormat::int32>( unsigned char const *p )
+{
+    return _mm256_loadu_si256( reinterpret_cast<__m256i const *>( p ) );
+}
+
+template <PCMFormat Format>
+void pcm_store( unsigned char *p, pcm_ints v );
+
+template <>
+inline void pcm_store<PCMFormat::int16>( unsigned char *p, pcm_ints v )
+{
+    _mm_storeu_si128( reinterpret_cast<__m128i *>( p ),
+                      _mm_packs_epi32( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) ) );
+}
+
+/// Each half packs its low three bytes of each lane into 12 bytes. The 16 byte store of the low half is partly
+/// written over by the high half, which itself writes 4 bytes into the next samples
+template <>
+inline void pcm_store<PCMFormat::int24>( unsigned char *p, pcm_ints v )
+{
+    const __m256i pack = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+    const __m256i packed = _mm256_shuffle_epi8( v, pack );
+    _mm_storeu_si128( reinterpret_cast<__m128i *>( p ), _mm256_castsi256_si128( packed ) );
+    _mm_storeu_si128( reinterpret_cast<__m128i *>( p + 12 ), _mm256_extracti128_si256( packed, 1 ) );
+}
+
+template <>
+inline void pcm_store<PCMFormat::int32>( unsigned char *p, pcm_ints v )
+{
+    _mm256_storeu_si256( reinterpret_cast<__m256i *>( p ), v );
+}
+
+inline void pcm_to_real( pcm_ints v, float scale, float *output )
+{
+    _mm256_storeu_ps( output, _mm256_mul_ps( _mm256_cvtepi32_ps( v ), _mm256_set1_ps( scale ) ) );
+}
+
+inline void pcm_to_real( pcm_ints v, double scale, double *output )
+{
+    const __m256d s = _mm256_set1_pd( scale );
+    _mm256_storeu_pd( output, _mm256_mul_pd( _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) ), s ) );
+    _mm256_storeu_pd( output + 4, _mm256_mul_pd( _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) ), s ) );
+}
+
+/// max and min take their second operand when the first is NaN, so NaN ends up at lo
+inline pcm_ints pcm_from_real( float const *input, float scale, float lo, float hi, pcm_dither dither )
+{
+    __m256 x = _mm256_fmadd_ps( _mm256_loadu_ps( input ), _mm256_set1_ps( scale ), dither );
+    x = _mm256_min_ps( _mm256_max_ps( x, _mm256_set1_ps( lo ) ), _mm256_set1_ps( hi ) );
+    return _mm256_cvtps_epi32( x );
+}
+
+inline pcm_ints pcm_from_real( double const *input, double scale, double lo, double hi, pcm_dither dither )
+{
+    const __m256d s = _mm256_set1_pd( scale );
+    const __m256d l = _mm256_set1_pd( lo );
+    const __m256d h = _mm256_set1_pd( hi );
+    __m256d x0 = _mm256_fmadd_pd( _mm256_loadu_pd( input ), s, _mm256_cvtps_pd( _mm256_castps256_ps128( dither ) ) );
+    __m256d x1 = _mm256_fmadd_pd( _mm256_loadu_pd( input + 4 ), s, _mm256_cvtps_pd( _mm256_extractf128_ps( dither, 1 ) ) );
+    x0 = _mm256_min_pd( _mm256_max_pd( x0, l ), h );
+    x1 = _mm256_min_pd( _mm256_max_pd( x1, l ), h );
+    return _mm256_inserti128_si256( _mm256_castsi128_si256( _mm256_cvtpd_epi32( x0 ) ), _mm256_cvtpd_epi32( x1 ), 1 );
+}
+
+inline pcm_ints pcm_xorshift( pcm_ints s )
+{
+    s = _mm256_xor_si256( s, _mm256_slli_epi32( s, 13 ) );
+    s = _mm256_xor_si256( s, _mm256_srli_epi32( s, 17 ) );
+    return _mm256_xor_si256( s, _mm256_slli_epi32( s, 5 ) );
+}
+
+inline pcm_dither pcm_tpdf( pcm_ints &state )
+{
+    state = pcm_xorshift( state );
+    const __m256 u1 = _mm256_cvtepi32_ps( _mm256_srli_epi32( state, 8 ) );
+    state = pcm_xorshift( state );
+    const __m256 u2 = _mm256_cvtepi32_ps( _mm256_srli_epi32( state, 8 ) );
+    return _mm256_mul_ps( _mm256_sub_ps( u1, u2 ), _mm256_set1_ps( 1.0f / 16777216.0f ) );
+}
+
+inline pcm_dither pcm_no_dither()
+{
+    return _mm256_setzero_ps();
+}
+
+inline pcm_ints pcm_load_state( DispatchDither const *dither )
+{
+    return _mm256_loadu_si256( reinterpret_cast<__m256i const *>( dither->state ) );
+}
+
+inline void pcm_store_state( DispatchDither *dither, pcm_ints state )
+{
+    _mm256_storeu_si256( reinterpret_cast<__m256i *>( dither->state ), state );
+}
+
+#elif defined( __SSE2__ )
+
+typedef __m128i pcm_ints;
+typedef __m128 pcm_dither;
+
+template <PCMFormat Format>
+pcm_ints pcm_load( unsigned char const *p );
+
+template <>
+inline pcm_ints pcm_load<PCMFormat::int16>( unsigned char const *p )
+{
+    const __m128i v = _mm_loadl_epi64( reinterpret_cast<__m128i const *>( p ) );
+    return _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 );
+}
+
+/// SSE2 has no byte shuffle, so the three byte samples are put together one at a time
+template <>
+inline pcm_ints pcm_load<PCMFormat::int24>( unsigned char const *p )
+{
+    typedef pcm_format<PCMFormat::int24> F;
+    return _mm_setr_epi32( F::load( p ), F::load( p + 3 ), F::load( p + 6 ), F::load( p + 9 ) );
+}
+
+template <>
+inline pcm_ints pcm_load<PCMFormat::int32>( unsigned char const *p )
+{
+    return _mm_loadu_si128( reinterpret_cast<__m128i const *>( p ) );
+}
+
+template <PCMFormat Format>
+void pcm_store( unsigned char *p, pcm_ints v );
+
+template <>
+inline void pcm_store<PCMFormat::int16>( unsigned char *p, pcm_ints v )
+{
+    _mm_storel_epi64( reinterpret_cast<__m128i *>( p ), _mm_packs_epi32( v, v ) );
+}
+
+template <>
+inline void pcm_store<PCMFormat::int24>( unsigned char *p, pcm_ints v )
+{
+    typedef pcm_format<PCMFormat::int24> F;
+    DAP_SIMD_ALIGN std::int32_t lanes[4];
+    _mm_store_si128( reinterpret_cast<__m128i *>( lanes ), v );
+    for ( std::size_t k = 0; k < 4; ++k )
+    {
+        F::store( p + 3 * k, lanes[k] );
+    }
+}
+
+template <>
+inline void pcm_store<PCMFormat::int32>( unsigned char *p, pcm_ints v )
+{
+    _mm_storeu_si128( reinterpret_cast<__m128i *>( p ), v );
+}
+
+inline void pcm_to_real( pcm_ints v, float scale, float *output )
+{
+    _mm_storeu_ps( output, _mm_mul_ps( _mm_cvtepi32_ps( v ), _mm_set1_ps( scale ) ) );
+}
+
+inline void pcm_to_real( pcm_ints v, double scale, double *output )
+{
+    const __m128d s = _mm_set1_pd( scale );
+    _mm_storeu_pd( output, _mm_mul_pd( _mm_cvtepi32_pd( v ), s ) );
+    _mm_storeu_pd( output + 2, _mm_mul_pd( _mm_cvtepi32_pd( _mm_srli_si128( v, 8 ) ), s ) );
+}
+
+/// max and min take their second operand when the first is NaN, so NaN ends up at lo
+inline pcm_ints pcm_from_real( float const *input, float scale, float lo, float hi, pcm_dither dither )
+{
+    __m128 x = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( input ), _mm_set1_ps( scale ) ), dither );
+    x = _mm_min_ps( _mm_max_ps( x, _mm_set1_ps( lo ) ), _mm_set1_ps( hi ) );
+    return _mm_cvtps_epi32( x );
+}
+
+inline pcm_ints pcm_from_real( double const *input, double scale, double lo, double hi, pcm_dither dither )
+{
+    const __m128d s = _mm_set1_pd( scale );
+    const __m128d l = _mm_set1_pd( lo );
+    const __m128d h = _mm_set1_pd( hi );
+    __m128d x0 = _mm_add_pd( _mm_mul_pd( _mm_loadu_pd( input ), s ), _mm_cvtps_pd( dither ) );
+    __m128d x1 = _mm_add_pd( _mm_mul_pd( _mm_loadu_pd( input + 2 ), s ), _mm_cvtps_pd( _mm_movehl_ps( dither, dither ) ) );
+    x0 = _mm_min_pd( _mm_max_pd( x0, l ), h );
+    x1 = _mm_min_pd( _mm_max_pd( x1, l ), h );
+    return _mm_unpacklo_epi64( _mm_cvtpd_epi32( x0 ), _mm_cvtpd_epi32( x1 ) );
+}
+
+inline pcm_ints pcm_xorshift( pcm_ints s )
+{
+    s = _mm_xor_si128( s, _mm_slli_epi32( s, 13 ) );
+    s = _mm_xor_si128( s, _mm_srli_epi32( s, 17 ) );
+    return _mm_xor_si128( s, _mm_slli_epi32( s, 5 ) );
+}
+
+inline pcm_dither pcm_tpdf( pcm_ints &state )
+{
+    state = pcm_xorshift( state );
+    const __m128 u1 = _mm_cvtepi32_ps( _mm_srli_epi32( state, 8 ) );
+    state = pcm_xorshift( state );
+    const __m128 u2 = _mm_cvtepi32_ps( _mm_srli_epi32( state, 8 ) );
+    return _mm_mul_ps( _mm_sub_ps( u1, u2 ), _mm_set1_ps( 1.0f / 16777216.0f ) );
+}
+
+inline pcm_dither pcm_no_dither()
+{
+    return _mm_setzero_ps();
+}
+
+/// Only the first four generators run in this variant
+inline pcm_ints pcm_load_state( DispatchDither const *dither )
+{
+    return _mm_loadu_si128( reinterpret_cast<__m128i const *>( dither->state ) );
+}
+
+inline void pcm_store_state( DispatchDither *dither, pcm_ints state )
+{
+    _mm_storeu_si128( reinterpret_cast<__m128i *>( dither->state ), state );
+}
+
+#endif
+
+template <PCMFormat Format, typename T>
+void pcm_decode( void const *input, T gain, T *output, std::size_t count )
+{
+    typedef pcm_format<Format> F;
+    unsigned char const *in = static_cast<unsigned char const *>( input );
+    const T scale = gain / static_cast<T>( F::full_scale() );
+    std::size_t i = 0;
+#if defined( DAP_DISPATCH_PCM_LANES )
+    for ( ; i + DAP_DISPATCH_PCM_LANES + F::slack <= count; i += DAP_DISPATCH_PCM_LANES )
+    {
+        pcm_to_real( pcm_load<Format>( in + i * F::bytes ), scale, output + i );
+    }
+#endif
+    pcm_decode_scalar<Format>( in + i * F::bytes, scale, output + i, count - i );
+}
+
+template <PCMFormat Format, typename T>
+void pcm_encode( T const *input, T gain, void *output, std::size_t count, DispatchDither *dither )
+{
+    typedef pcm_format<Format> F;
+    unsigned char *out = static_cast<unsigned char *>( output );
+    const T scale = gain * static_cast<T>( F::full_scale() );
+    std::size_t i = 0;
+#if defined( DAP_DISPATCH_PCM_LANES )
+    const T lo = static_cast<T>( -F::full_scale() );
+    const T hi = pcm_max<Format, T>();
+    if ( dither )
+    {
+        pcm_ints state = pcm_load_state( dither );
+        for ( ; i + DAP_DISPATCH_PCM_LANES + F::slack <= count; i += DAP_DISPATCH_PCM_LANES )
+        {
+            pcm_store<Format>( out + i * F::bytes, pcm_from_real( input + i, scale, lo, hi, pcm_tpdf( state ) ) );
+        }
+        pcm_store_state( dither, state );
+    }
+    else
+    {
+        for ( ; i + DAP_DISPATCH_PCM_LANES + F::slack <= count; i += DAP_DISPATCH_PCM_LANES )
+        {
+            pcm_store<Format>( out + i * F::bytes, pcm_from_real( input + i, scale, lo, hi, pcm_no_dither() ) );
+        }
+    }
+#endif
+    pcm_encode_scalar<Format>( input + i, scale, out + i * F::bytes, count - i, dither, i );
+}
+}
+
+DAP_NAMESPACE_END
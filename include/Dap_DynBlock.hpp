@@ -0,0 +1,339 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Traits.hpp"
+#include "Dap_Twist.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_Aligned.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+/**
+ * 3 dimensional array block indexed by Width, Height, and Depth whose sizes
+ * are given at run time. The items live in one cache line aligned heap
+ * allocation laid out like the content of a Block of the same twist, so
+ * raw index2 is contiguous. A DynBlock is move only; moving it just hands
+ * over the allocation and leaves the source empty.
+ */
+template <typename T, typename TwistType>
+class DynBlock
+{
+  public:
+    using twist_type = TwistType;
+    using value_type = T;
+
+    /// The alignment in bytes of data()
+    static const std::size_t alignment = DAP_CACHELINESIZE;
+
+    DynBlock() : m_width( 0 ), m_height( 0 ), m_depth( 0 ), m_data( 0 ) {}
+
+    /// Allocate width*height*depth default initialized items, throwing std::bad_alloc if the byte count overflows
+    explicit DynBlock( std::size_t width, std::size_t height = 1, std::size_t depth = 1 )
+        : m_width( width ), m_height( height ), m_depth( depth ), m_data( 0 )
+    {
+        construct( 0 );
+    }
+
+    /// Allocate width*height*depth items, each a copy of elem, throwing std::bad_alloc if the byte count overflows
+    DynBlock( std::size_t width, std::size_t height, std::size_t depth, value_type const &elem )
+        : m_width( width ), m_height( height ), m_depth( depth ), m_data( 0 )
+    {
+        construct( &elem );
+    }
+
+    DynBlock( DynBlock const & ) = delete;
+    DynBlock &operator=( DynBlock const & ) = delete;
+
+    DynBlock( DynBlock &&other ) noexcept : m_width( other.m_width ),
+                                             m_height( other.m_height ),
+                                             m_depth( other.m_depth ),
+                                             m_data( other.m_data )
+    {
+        other.release();
+    }
+
+    DynBlock &operator=( DynBlock &&other ) noexcept
+    {
+        if ( this != &other )
+        {
+            destroy();
+            m_width = other.m_width;
+            m_height = other.m_height;
+            m_depth = other.m_depth;
+            m_data = other.m_data;
+            other.release();
+        }
+        return *this;
+    }
+
+    ~DynBlock() { destroy(); }
+
+    std::size_t width() const { return m_width; }
+    std::size_t height() const { return m_height; }
+    std::size_t depth() const { return m_depth; }
+
+    /// The total number of items
+    std::size_t size() const { return m_width * m_height * m_depth; }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t raw_index0_size() const { return twist_type::raw_index0_from( dimensions() ); }
+    std::size_t raw_index1_size() const { return twist_type::raw_index1_from( dimensions() ); }
+    std::size_t raw_index2_size() const { return twist_type::raw_index2_from( dimensions() ); }
+
+    /// The first of the size() contiguous items, aligned to DAP_CACHELINESIZE
+    value_type *data() { return m_data; }
+    value_type const *data() const { return m_data; }
+
+    value_type &rawget( std::size_t i0, std::size_t i1, std::size_t i2 )
+    {
+        return m_data[( i0 * raw_index1_size() + i1 ) * raw_index2_size() + i2];
+    }
+
+    value_type const &rawget( std::size_t i0, std::size_t i1, std::size_t i2 ) const
+    {
+        return m_data[( i0 * raw_index1_size() + i1 ) * raw_index2_size() + i2];
+    }
+
+    /// The distance in items between neighbours along raw index 0, 1 or 2
+    std::size_t raw_stride( std::size_t raw_index ) const
+    {
+        return raw_index == 2 ? 1 : ( raw_index == 1 ? raw_index2_size() : raw_index1_size() * raw_index2_size() );
+    }
+
+    /// The position in data() of the item at (width_pos,height_pos,depth_pos)
+    std::size_t linear_index( std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos ) const
+    {
+        return width_pos * raw_stride( twist_type::width_index ) + height_pos * raw_stride( twist_type::height_index )
+               + depth_pos * raw_stride( twist_type::depth_index );
+    }
+
+    value_type &get( std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos )
+    {
+        return m_data[linear_index( width_pos, height_pos, depth_pos )];
+    }
+
+    value_type const &get( std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos ) const
+    {
+        return m_data[linear_index( width_pos, height_pos, depth_pos )];
+    }
+
+  private:
+    std::tuple<std::size_t, std::size_t, std::size_t> dimensions() const
+    {
+        return std::make_tuple( m_width, m_height, m_depth );
+    }
+
+    /// Allocate the items and construct each as a copy of *elem, or default initialized when elem is null. If an
+    /// item's constructor throws, the items already built are destroyed and the storage freed before rethrowing
+    void construct( value_type const *elem )
+    {
+        const std::size_t max_items = std::numeric_limits<std::size_t>::max() / sizeof( value_type );
+        if ( m_height != 0 && m_depth != 0
+             && ( m_width > max_items / m_height || m_width * m_height > max_items / m_depth ) )
+        {
+            throw std::bad_alloc();
+        }
+        const std::size_t count = size();
+        if ( count == 0 )
+        {
+            return;
+        }
+        value_type *data = static_cast<value_type *>( AlignedDetail::allocate( count * sizeof( value_type ), alignment ) );
+        std::size_t built = 0;
+        try
+        {
+            for ( ; built < count; ++built )
+            {
+                if ( elem )
+                {
+                    new ( data + built ) value_type( *elem );
+                }
+                else
+                {
+                    new ( data + built ) value_type;
+                }
+            }
+        }
+        catch ( ... )
+        {
+            while ( built > 0 )
+            {
+                data[--built].~value_type();
+            }
+            AlignedDetail::deallocate( data );
+            throw;
+        }
+        m_data = data;
+    }
+
+    void destroy()
+    {
+        if ( m_data )
+        {
+            for ( std::size_t i = 0; i < size(); ++i )
+            {
+                m_data[i].~value_type();
+            }
+            AlignedDetail::deallocate( m_data );
+        }
+        release();
+    }
+
+    void release()
+    {
+        m_width = 0;
+        m_height = 0;
+        m_depth = 0;
+        m_data = 0;
+    }
+
+    std::size_t m_width;
+    std::size_t m_height;
+    std::size_t m_depth;
+    value_type *m_data;
+};
+
+/**
+ * Traits for a run time sized block. There are no compile time sizes and no
+ * twist_array_type, so only the algorithms that ask the layout for their
+ * sizes accept it
+ */
+template <typename T, typename TwistType>
+struct Traits<DynBlock<T, TwistType> >
+{
+    using value_type = T;
+    using twist_type = TwistType;
+    using container_type = DynBlock<T, twist_type>;
+};
+
+namespace BlockDetail
+{
+
+/// The sizes of a DynBlock are only known at run time
+template <typename T, typename TwistType>
+struct layout<DynBlock<T, TwistType> >
+{
+    using ContainerT = DynBlock<T, TwistType>;
+    using twist_type = TwistType;
+    using value_type = T;
+
+    static const bool is_static = false;
+    static const bool is_contiguous = true;
+    static const std::size_t alignment = ContainerT::alignment;
+
+    static std::size_t width( ContainerT const &c ) { return c.width(); }
+    static std::size_t height( ContainerT const &c ) { return c.height(); }
+    static std::size_t depth( ContainerT const &c ) { return c.depth(); }
+    static std::size_t raw_index0_size( ContainerT const &c ) { return c.raw_index0_size(); }
+    static std::size_t raw_index1_size( ContainerT const &c ) { return c.raw_index1_size(); }
+    static std::size_t raw_index2_size( ContainerT const &c ) { return c.raw_index2_size(); }
+    static std::size_t raw_stride0( ContainerT const &c ) { return c.raw_stride( 0 ); }
+    static std::size_t raw_stride1( ContainerT const &c ) { return c.raw_stride( 1 ); }
+    static std::size_t raw_stride2( ContainerT const & ) { return 1; }
+    static std::size_t item_count( ContainerT const &c ) { return c.size(); }
+    static value_type *items( ContainerT &c ) { return c.data(); }
+    static value_type const *items( ContainerT const &c ) { return c.data(); }
+};
+}
+
+template <typename T, typename TwistType>
+auto get( DynBlock<T, TwistType> &c, std::size_t width_pos = 0, std::size_t height_pos = 0, std::size_t depth_pos = 0 ) -> T &
+{
+    return c.get( width_pos, height_pos, depth_pos );
+}
+
+template <typename T, typename TwistType>
+auto get( DynBlock<T, TwistType> const &c, std::size_t width_pos = 0, std::size_t height_pos = 0, std::size_t depth_pos = 0 )
+    -> T
+{
+    return c.get( width_pos, height_pos, depth_pos );
+}
+
+template <typename T, typename TwistType>
+auto set( DynBlock<T, TwistType> &c,
+          T const &v,
+          std::size_t width_pos = 0,
+          std::size_t height_pos = 0,
+          std::size_t depth_pos = 0 ) -> void
+{
+    c.get( width_pos, height_pos, depth_pos ) = v;
+}
+
+template <typename T, typename TwistType>
+auto rawget( DynBlock<T, TwistType> &c, std::size_t i0 = 0, std::size_t i1 = 0, std::size_t i2 = 0 ) -> T &
+{
+    return c.rawget( i0, i1, i2 );
+}
+
+template <typename T, typename TwistType>
+auto rawget( DynBlock<T, TwistType> const &c, std::size_t i0 = 0, std::size_t i1 = 0, std::size_t i2 = 0 ) -> T const &
+{
+    return c.rawget( i0, i1, i2 );
+}
+
+template <typename T, typename TwistType>
+auto rawset( DynBlock<T, TwistType> &c, T const &v, std::size_t i0 = 0, std::size_t i1 = 0, std::size_t i2 = 0 ) -> void
+{
+    c.rawget( i0, i1, i2 ) = v;
+}
+
+/// Run time sized form of make_block
+template <typename TwistType, typename InstrumentT = NoInstrument, typename T>
+auto make_block( T const &elem, std::size_t width, std::size_t height = 1, std::size_t depth = 1 ) -> DynBlock<T, TwistType>
+{
+    DynBlock<T, TwistType> r( width, height, depth );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::make_block, r.size(), r.size() * sizeof( T ) );
+
+    BlockDetail::fill_items(
+        r.data(), r.size(), elem, BlockDetail::stream_stores<BlockDetail::layout<DynBlock<T, TwistType> > >( r.size() ) );
+
+    return r;
+}
+
+/// Run time sized form of fill_block
+template <typename T, typename TwistType, typename InstrumentT = NoInstrument, typename Functor>
+auto fill_block( Functor f, std::size_t width, std::size_t height = 1, std::size_t depth = 1 ) -> DynBlock<T, TwistType>
+{
+    DynBlock<T, TwistType> r( width, height, depth );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::fill_block, r.size(), r.size() * sizeof( T ) );
+
+    BlockDetail::for_each_item( r, [&]( T &v, std::size_t w, std::size_t h, std::size_t d )
+                                {
+        v = f( w, h, d );
+    } );
+
+    return r;
+}
+
+DAP_NAMESPACE_END
@@ -0,0 +1,585 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Aligned.hpp"
+#include "Dap_SIMD.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+namespace FFTDetail
+{
+
+/// One pass of a Stockham autosort FFT: m butterflies of `radix` points each, over items s apart. The radix 4
+/// passes keep the twiddles for the butterflies at twiddle_offset as three runs of m, for outputs 1, 2 and 3
+struct Pass
+{
+    std::size_t radix;
+    std::size_t m;
+    std::size_t s;
+    std::size_t twiddle_offset;
+};
+
+/// The passes and twiddles of a complex FFT of n points. Radix 4 passes run first, and when n is an odd power of two
+/// a single radix 8 (or for n = 2, radix 2) pass runs last, where it needs no twiddles
+template <typename T>
+class Plan
+{
+  public:
+    typedef std::complex<T> complex_type;
+
+    explicit Plan( std::size_t n ) : m_size( n )
+    {
+        std::size_t s = 1;
+        while ( n > 1 )
+        {
+            const std::size_t radix = ( n == 8 || n == 2 ) ? n : 4;
+            const Pass pass = {radix, n / radix, s, m_twiddles.size()};
+            if ( pass.m > 1 )
+            {
+                for ( std::size_t k = 1; k < 4; ++k )
+                {
+                    for ( std::size_t p = 0; p < pass.m; ++p )
+                    {
+                        m_twiddles.push_back( twiddle( k * p, n ) );
+                    }
+                }
+            }
+            m_passes.push_back( pass );
+            n /= radix;
+            s *= radix;
+        }
+    }
+
+    /// exp( -2 pi i k / n )
+    static complex_type twiddle( std::size_t k, std::size_t n )
+    {
+        const long double angle = -2.0L * 3.14159265358979323846264338327950288L * k / n;
+        return complex_type( static_cast<T>( std::cos( angle ) ), static_cast<T>( std::sin( angle ) ) );
+    }
+
+    std::size_t m_size;
+    std::vector<Pass> m_passes;
+    std::vector<complex_type, aligned_allocator<complex_type> > m_twiddles;
+};
+
+template <typename E>
+inline void load( E &e, E const *p )
+{
+    e = *p;
+}
+
+template <typename E, typename ItemT>
+inline void load( E &e, ItemT const *p )
+{
+    e.load( p );
+}
+
+template <typename E>
+inline void store( E const &e, E *p )
+{
+    *p = e;
+}
+
+template <typename E, typename ItemT>
+inline void store( E const &e, ItemT *p )
+{
+    e.store( p );
+}
+
+template <typename E, typename T>
+inline E broadcast( std::complex<T> const &w )
+{
+    E e;
+    splat( e, w );
+    return e;
+}
+
+template <typename T>
+inline std::complex<T> multiply( std::complex<T> const &a, std::complex<T> const &b )
+{
+    return std::complex<T>( a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real() );
+}
+
+template <typename E>
+inline E multiply( E const &a, E const &b )
+{
+    return a * b;
+}
+
+template <typename T>
+inline std::complex<T> scale( std::complex<T> const &a, T s )
+{
+    return std::complex<T>( a.real() * s, a.imag() * s );
+}
+
+template <typename T, std::size_t N>
+inline SIMD_Vector<std::complex<T>, N> scale( SIMD_Vector<std::complex<T>, N> const &a, T s )
+{
+    return a * std::complex<T>( s, T( 0 ) );
+}
+
+template <typename T, std::size_t N>
+inline SIMD_SplitComplex<T, N> scale( SIMD_SplitComplex<T, N> const &a, T s )
+{
+    typename SIMD_SplitComplex<T, N>::plane_type t;
+    return a * splat( t, s );
+}
+
+/// a times the twiddle w, or its conjugate for the inverse transform
+template <bool Inverse, typename E>
+inline E twiddle( E const &a, E const &w )
+{
+    return Inverse ? conj_multiply( a, w ) : multiply( a, w );
+}
+
+/// a times -i for the forward transform, i for the inverse
+template <bool Inverse, typename E>
+inline E rotate( E const &a )
+{
+    return Inverse ? times_i( a ) : -times_i( a );
+}
+
+template <bool Inverse, typename E>
+inline void butterfly4( E const &a, E const &b, E const &c, E const &d, E &y0, E &y1, E &y2, E &y3 )
+{
+    const E apc = a + c;
+    const E amc = a - c;
+    const E bpd = b + d;
+    const E rbmd = rotate<Inverse>( b - d );
+    y0 = apc + bpd;
+    y1 = amc + rbmd;
+    y2 = apc - bpd;
+    y3 = amc - rbmd;
+}
+
+/// Radix 4 pass whose stride is a whole number of E, so each butterfly works on as many sub-transforms as E has lanes
+template <bool Inverse, typename E, typename ItemT, typename T>
+void radix4_pass( ItemT const *x, ItemT *y, Pass const &pass, std::complex<T> const *twiddles )
+{
+    const std::size_t m = pass.m;
+    const std::size_t s = pass.s;
+    const std::size_t step = simd_size<E>::value;
+    std::complex<T> const *w = twiddles + pass.twiddle_offset;
+    for ( std::size_t p = 0; p < m; ++p )
+    {
+        ItemT const *xp = x + s * p;
+        ItemT *yp = y + 4 * s * p;
+        E w1 = broadcast<E>( std::complex<T>( 1 ) ), w2 = w1, w3 = w1;
+        if ( m > 1 )
+        {
+            w1 = broadcast<E>( w[p] );
+            w2 = broadcast<E>( w[m + p] );
+            w3 = broadcast<E>( w[2 * m + p] );
+        }
+        for ( std::size_t q = 0; q < s; q += step )
+        {
+            E a, b, c, d, y0, y1, y2, y3;
+            load( a, xp + q );
+            load( b, xp + q + s * m );
+            load( c, xp + q + 2 * s * m );
+            load( d, xp + q + 3 * s * m );
+            butterfly4<Inverse>( a, b, c, d, y0, y1, y2, y3 );
+            if ( m > 1 )
+            {
+                y1 = twiddle<Inverse>( y1, w1 );
+                y2 = twiddle<Inverse>( y2, w2 );
+                y3 = twiddle<Inverse>( y3, w3 );
+            }
+            store( y0, yp + q );
+            store( y1, yp + q + s );
+            store( y2, yp + q + 2 * s );
+            store( y3, yp + q + 3 * s );
+        }
+    }
+}
+
+/// Radix 4 pass with stride 1, the first pass, vectorized across the butterflies instead. The twiddles load
+/// straight from their runs, and the four outputs of each butterfly are scattered to their adjacent slots
+template <bool Inverse, typename V, typename T>
+void radix4_first_pass( std::complex<T> const *x, std::complex<T> *y, Pass const &pass, std::complex<T> const *twiddles )
+{
+    const std::size_t m = pass.m;
+    const std::size_t step = V::vector_size;
+    std::complex<T> const *w = twiddles + pass.twiddle_offset;
+    for ( std::size_t p = 0; p < m; p += step )
+    {
+        V a, b, c, d, y0, y1, y2, y3, w1, w2, w3;
+        a.load( x + p );
+        b.load( x + p + m );
+        c.load( x + p + 2 * m );
+        d.load( x + p + 3 * m );
+        butterfly4<Inverse>( a, b, c, d, y0, y1, y2, y3 );
+        w1.load( w + p );
+        w2.load( w + m + p );
+        w3.load( w + 2 * m + p );
+        y1 = twiddle<Inverse>( y1, w1 );
+        y2 = twiddle<Inverse>( y2, w2 );
+        y3 = twiddle<Inverse>( y3, w3 );
+        for ( std::size_t l = 0; l < step; ++l )
+        {
+            std::complex<T> *yp = y + 4 * ( p + l );
+            yp[0] = y0[l];
+            yp[1] = y1[l];
+            yp[2] = y2[l];
+            yp[3] = y3[l];
+        }
+    }
+}
+
+/// The last pass when the size is an odd power of two: one 8 point DFT per sub-transform, with no twiddles
+template <bool Inverse, typename E, typename ItemT, typename T>
+void radix8_pass( ItemT const *x, ItemT *y, Pass const &pass, T )
+{
+    const std::size_t s = pass.s;
+    const std::size_t step = simd_size<E>::value;
+    const T r = T( 0.707106781186547524400844362104849039L );
+    for ( std::size_t q = 0; q < s; q += step )
+    {
+        E a[8];
+        for ( std::size_t k = 0; k < 8; ++k )
+        {
+            load( a[k], x + q + k * s );
+        }
+        // two 4 point DFTs of the even and odd items, then the odd ones turned by the powers of exp( -2 pi i / 8 )
+        E e0, e1, e2, e3, o0, o1, o2, o3;
+        butterfly4<Inverse>( a[0], a[2], a[4], a[6], e0, e1, e2, e3 );
+        butterfly4<Inverse>( a[1], a[3], a[5], a[7], o0, o1, o2, o3 );
+        o1 = scale( o1 + rotate<Inverse>( o1 ), r );
+        o2 = rotate<Inverse>( o2 );
+        o3 = scale( rotate<Inverse>( o3 ) - o3, r );
+        store( e0 + o0, y + q );
+        store( e1 + o1, y + q + s );
+        store( e2 + o2, y + q + 2 * s );
+        store( e3 + o3, y + q + 3 * s );
+        store( e0 - o0, y + q + 4 * s );
+        store( e1 - o1, y + q + 5 * s );
+        store( e2 - o2, y + q + 6 * s );
+        store( e3 - o3, y + q + 7 * s );
+    }
+}
+
+/// The only pass of a 2 point transform
+template <typename E, typename ItemT>
+void radix2_pass( ItemT const *x, ItemT *y, Pass const &pass )
+{
+    const std::size_t s = pass.s;
+    const std::size_t step = simd_size<E>::value;
+    for ( std::size_t q = 0; q < s; q += step )
+    {
+        E a, b;
+        load( a, x + q );
+        load( b, x + q + s );
+        store( a + b, y + q );
+        store( a - b, y + q + s );
+    }
+}
+
+template <bool Inverse, typename E, typename ItemT, typename T>
+void run_pass( ItemT const *x, ItemT *y, Pass const &pass, std::complex<T> const *twiddles )
+{
+    switch ( pass.radix )
+    {
+    case 4:
+        radix4_pass<Inverse, E>( x, y, pass, twiddles );
+        break;
+    case 8:
+        radix8_pass<Inverse, E>( x, y, pass, T() );
+        break;
+    default:
+        radix2_pass<E>( x, y, pass );
+        break;
+    }
+}
+
+/// A pass over std::complex items, run on the vector V where the stride or the butterflies allow it
+template <bool Inverse, typename V, typename T>
+void run_pass( std::complex<T> const *x, std::complex<T> *y, Pass const &pass, std::complex<T> const *twiddles, V const * )
+{
+    const std::size_t lanes = V::vector_size;
+    if ( pass.s % lanes == 0 )
+    {
+        run_pass<Inverse, V>( x, y, pass, twiddles );
+    }
+    else if ( pass.s == 1 && pass.radix == 4 && pass.m % lanes == 0 )
+    {
+        radix4_first_pass<Inverse, V>( x, y, pass, twiddles );
+    }
+    else
+    {
+        run_pass<Inverse, std::complex<T> >( x, y, pass, twiddles );
+    }
+}
+
+/// A pass over SIMD_SplitComplex items, which are independent transforms in each lane
+template <bool Inverse, typename V, typename T, std::size_t N>
+void run_pass( SIMD_SplitComplex<T, N> const *x,
+               SIMD_SplitComplex<T, N> *y,
+               Pass const &pass,
+               std::complex<T> const *twiddles,
+               V const * )
+{
+    run_pass<Inverse, SIMD_SplitComplex<T, N> >( x, y, pass, twiddles );
+}
+
+/// Run every pass of the plan from in to out. The passes alternate between out and work, arranged so that the last
+/// one writes out. When in is out the first pass cannot write there, so it writes work and a copy finishes the job
+template <bool Inverse, typename V, typename ItemT, typename T>
+void transform( Plan<T> const &plan, ItemT const *in, ItemT *out, ItemT *work )
+{
+    const std::size_t passes = plan.m_passes.size();
+    ItemT const *src = in;
+    ItemT *dest = ( passes % 2 == 1 && in != out ) ? out : work;
+    for ( std::size_t i = 0; i < passes; ++i )
+    {
+        run_pass<Inverse>( src, dest, plan.m_passes[i], plan.m_twiddles.data(), static_cast<V const *>( 0 ) );
+        src = dest;
+        dest = ( dest == out ) ? work : out;
+    }
+    if ( src != out )
+    {
+        std::copy( src, src + plan.m_size, out );
+    }
+}
+
+/// Turn the half size transform z of the even and odd samples into the packed spectrum of the real signal, in place.
+/// h[k] is -i exp( -2 pi i k / n ) / 2 for the full size n
+template <typename E, typename T>
+void real_forward_post( E *z, std::size_t half, std::complex<T> const *h )
+{
+    // the DC and Nyquist bins are both real and share bin 0
+    const E c = conj( z[0] );
+    z[0] = c + times_i( c );
+    for ( std::size_t k = 1; 2 * k <= half; ++k )
+    {
+        const std::size_t j = half - k;
+        const E zk = z[k];
+        const E cj = conj( z[j] );
+        const E e = scale( zk + cj, T( 0.5 ) );
+        const E t = multiply( zk - cj, broadcast<E>( h[k] ) );
+        z[k] = e + t;
+        if ( j != k )
+        {
+            z[j] = conj( e - t );
+        }
+    }
+}
+
+/// The inverse of real_forward_post, from the packed spectrum x into the half size spectrum z, scaled by 2
+template <typename E, typename T>
+void real_inverse_pre( E const *x, E *z, std::size_t half, std::complex<T> const *h )
+{
+    const E c = conj( x[0] );
+    z[0] = c + times_i( c );
+    for ( std::size_t k = 1; 2 * k <= half; ++k )
+    {
+        const std::size_t j = half - k;
+        const E xk = x[k];
+        const E cj = conj( x[j] );
+        const E e = xk + cj;
+        E t = conj_multiply( xk - cj, broadcast<E>( h[k] ) );
+        t = t + t;
+        z[k] = e + t;
+        if ( j != k )
+        {
+            z[j] = conj( e - t );
+        }
+    }
+}
+}
+
+/** \addtogroup fft FFT
+ *
+ * FFT<T, Size> transforms Size points of float or double, Size a power of
+ * two from 4 up. The twiddles are worked out once, by the constructor, into
+ * aligned storage. Each transform is a Stockham autosort FFT of radix 4
+ * passes plus one radix 8 pass for the odd powers of two, so the output is
+ * in natural order with no bit reversal. The butterflies run on the native
+ * SIMD_Vector<std::complex<T>, N>: across adjacent sub-transforms once the
+ * stride allows, and across adjacent butterflies in the first pass.
+ *
+ * forward() and inverse() transform Size complex points. inverse() is not
+ * scaled, so inverse( forward( x ) ) is Size * x.
+ *
+ * forward_real() transforms Size real points with a transform of half the
+ * size, and writes the Size / 2 bins 0 to Size / 2 - 1 of the spectrum in
+ * the packed form: bin 0 carries the real DC bin in its real part and the
+ * real Nyquist bin in its imaginary part. inverse_real() takes that packed
+ * spectrum back to Size real points, scaled by Size like inverse().
+ *
+ * The batched overloads take SIMD_SplitComplex<T, N> and SIMD_Vector<T, N>
+ * items and run N independent transforms at once, one per lane, for N
+ * channels of audio say. All of the arithmetic is then full width, with no
+ * shuffles at all.
+ *
+ * The transforms may run in place. They use a work buffer held by the FFT, so
+ * one FFT must not run transforms on two threads at once. The constructor
+ * sizes that buffer for the complex and real transforms and for batches of
+ * the native width, simd_native_size<T>, so none of those allocate. Call
+ * reserve<N>() before the first transform of any other batch width N to keep
+ * it from allocating on first use.
+ */
+/**@{*/
+
+template <typename T, std::size_t Size>
+class FFT
+{
+    static_assert( Size >= 4 && ( Size & ( Size - 1 ) ) == 0, "FFT size must be a power of two, at least 4" );
+
+  public:
+    typedef T value_type;
+    typedef std::complex<T> complex_type;
+
+    /// The native vector of complex items that the butterflies run on
+    typedef SIMD_Vector<complex_type, simd_native_size<complex_type>::value> vector_type;
+
+    /// The number of points in each transform
+    static const std::size_t transform_size = Size;
+
+    /// The number of bins in a packed real spectrum
+    static const std::size_t spectrum_size = Size / 2;
+
+    FFT() : m_plan( Size ), m_half_plan( Size / 2 ), m_real_twiddles( Size / 4 + 1 )
+    {
+        // -i exp( -2 pi i k / Size ) / 2, for real_forward_post and real_inverse_pre
+        for ( std::size_t k = 0; k < m_real_twiddles.size(); ++k )
+        {
+            const complex_type w = FFTDetail::Plan<T>::twiddle( k, Size );
+            m_real_twiddles[k] = complex_type( w.imag() / 2, -w.real() / 2 );
+        }
+        reserve<simd_native_size<T>::value>();
+    }
+
+    /// Size the work buffer for every transform, including batches of N channels, so that none of them allocate
+    template <std::size_t N>
+    void reserve()
+    {
+        work<complex_type>( Size );
+        work<SIMD_SplitComplex<T, N> >( Size );
+    }
+
+    /// Transform Size complex points from in to out
+    void forward( complex_type const *in, complex_type *out )
+    {
+        FFTDetail::transform<false, vector_type>( m_plan, in, out, work<complex_type>( Size ) );
+    }
+
+    /// Inverse transform Size complex points from in to out, without scaling
+    void inverse( complex_type const *in, complex_type *out )
+    {
+        FFTDetail::transform<true, vector_type>( m_plan, in, out, work<complex_type>( Size ) );
+    }
+
+    /// Transform Size real points from in to the packed spectrum of Size / 2 bins at out
+    void forward_real( value_type const *in, complex_type *out )
+    {
+        FFTDetail::transform<false, vector_type>(
+            m_half_plan, reinterpret_cast<complex_type const *>( in ), out, work<complex_type>( Size / 2 ) );
+        FFTDetail::real_forward_post( out, Size / 2, m_real_twiddles.data() );
+    }
+
+    /// Inverse transform the packed spectrum of Size / 2 bins at in to Size real points at out, scaled by Size
+    void inverse_real( complex_type const *in, value_type *out )
+    {
+        complex_type *z = reinterpret_cast<complex_type *>( out );
+        FFTDetail::real_inverse_pre( in, z, Size / 2, m_real_twiddles.data() );
+        FFTDetail::transform<true, vector_type>( m_half_plan, z, z, work<complex_type>( Size / 2 ) );
+    }
+
+    /// Transform N channels of Size complex points at once, one channel per lane
+    template <std::size_t N>
+    void forward( SIMD_SplitComplex<T, N> const *in, SIMD_SplitComplex<T, N> *out )
+    {
+        FFTDetail::transform<false, vector_type>( m_plan, in, out, work<SIMD_SplitComplex<T, N> >( Size ) );
+    }
+
+    /// Inverse transform N channels of Size complex points at once, one channel per lane, without scaling
+    template <std::size_t N>
+    void inverse( SIMD_SplitComplex<T, N> const *in, SIMD_SplitComplex<T, N> *out )
+    {
+        FFTDetail::transform<true, vector_type>( m_plan, in, out, work<SIMD_SplitComplex<T, N> >( Size ) );
+    }
+
+    /// Transform N channels of Size real points at once, one channel per lane, to N packed spectra
+    template <std::size_t N>
+    void forward_real( SIMD_Vector<T, N> const *in, SIMD_SplitComplex<T, N> *out )
+    {
+        for ( std::size_t k = 0; k < Size / 2; ++k )
+        {
+            out[k] = SIMD_SplitComplex<T, N>( in[2 * k], in[2 * k + 1] );
+        }
+        FFTDetail::transform<false, vector_type>( m_half_plan, out, out, work<SIMD_SplitComplex<T, N> >( Size / 2 ) );
+        FFTDetail::real_forward_post( out, Size / 2, m_real_twiddles.data() );
+    }
+
+    /// Inverse transform N packed spectra to N channels of Size real points at once, one channel per lane, scaled by
+    /// Size
+    template <std::size_t N>
+    void inverse_real( SIMD_SplitComplex<T, N> const *in, SIMD_Vector<T, N> *out )
+    {
+        SIMD_SplitComplex<T, N> *z = work<SIMD_SplitComplex<T, N> >( Size );
+        FFTDetail::real_inverse_pre( in, z, Size / 2, m_real_twiddles.data() );
+        FFTDetail::transform<true, vector_type>( m_half_plan, z, z, z + Size / 2 );
+        for ( std::size_t k = 0; k < Size / 2; ++k )
+        {
+            out[2 * k] = z[k].real();
+            out[2 * k + 1] = z[k].imag();
+        }
+    }
+
+  private:
+    /// The work buffer, grown to hold n items of E. Only a batch width that was not reserved ever grows it
+    template <typename E>
+    E *work( std::size_t n )
+    {
+        if ( m_work.size() < n * sizeof( E ) )
+        {
+            m_work.resize( n * sizeof( E ) );
+        }
+        return reinterpret_cast<E *>( m_work.data() );
+    }
+
+    FFTDetail::Plan<T> m_plan;
+    FFTDetail::Plan<T> m_half_plan;
+    std::vector<complex_type, aligned_allocator<complex_type> > m_real_twiddles;
+    std::vector<char, aligned_allocator<char> > m_work;
+};
+
+template <typename T, std::size_t Size>
+const std::size_t FFT<T, Size>::transform_size;
+
+template <typename T, std::size_t Size>
+const std::size_t FFT<T, Size>::spectrum_size;
+
+/**@}*/
+
+DAP_NAMESPACE_END
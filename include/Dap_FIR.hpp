@@ -0,0 +1,343 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Aligned.hpp"
+#include "Dap_SIMD.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+namespace FIRDetail
+{
+
+/// How many taps the dot product takes at a time: a native vector of them for float and double, and one for the
+/// SIMD_Vector items of a multi-channel FIR, which are already vectors across the channels
+template <typename T>
+struct tap_block : public std::integral_constant<std::size_t, simd_native_size<T>::value>
+{
+};
+
+template <typename T, std::size_t N>
+struct tap_block<SIMD_Vector<T, N> > : public std::integral_constant<std::size_t, 1>
+{
+};
+
+/// The sum of c[i] * x[i] for n items, in four independent sums to keep the multiply adds in flight
+template <typename T>
+T dot( T const *c, T const *x, std::size_t n )
+{
+    T acc0, acc1, acc2, acc3;
+    zero( acc0 );
+    zero( acc1 );
+    zero( acc2 );
+    zero( acc3 );
+    std::size_t i = 0;
+    for ( ; i + 4 <= n; i += 4 )
+    {
+        acc0 = fma( c[i], x[i], acc0 );
+        acc1 = fma( c[i + 1], x[i + 1], acc1 );
+        acc2 = fma( c[i + 2], x[i + 2], acc2 );
+        acc3 = fma( c[i + 3], x[i + 3], acc3 );
+    }
+    for ( ; i < n; ++i )
+    {
+        acc0 = fma( c[i], x[i], acc0 );
+    }
+    return ( acc0 + acc1 ) + ( acc2 + acc3 );
+}
+
+/// The sum of c[i] * x[i] for n items, n a whole number of native vectors, with the taps across the lanes. The
+/// coefficients are aligned and the history window need not be
+template <typename T>
+T dot_lanes( T const *c, T const *x, std::size_t n )
+{
+    typedef SIMD_Vector<T, simd_native_size<T>::value> vector_type;
+    const std::size_t lanes = vector_type::vector_size;
+    vector_type acc0, acc1, vc, vx;
+    zero( acc0 );
+    zero( acc1 );
+    std::size_t i = 0;
+    for ( ; i + 2 * lanes <= n; i += 2 * lanes )
+    {
+        vc.load( c + i );
+        vx.load( x + i );
+        acc0 = fma( vc, vx, acc0 );
+        vc.load( c + i + lanes );
+        vx.load( x + i + lanes );
+        acc1 = fma( vc, vx, acc1 );
+    }
+    if ( i < n )
+    {
+        vc.load( c + i );
+        vx.load( x + i );
+        acc0 = fma( vc, vx, acc0 );
+    }
+    return hsum( acc0 + acc1 );
+}
+
+inline float dot( float const *c, float const *x, std::size_t n )
+{
+    return dot_lanes( c, x, n );
+}
+
+inline double dot( double const *c, double const *x, std::size_t n )
+{
+    return dot_lanes( c, x, n );
+}
+}
+
+/**
+ * A direct form FIR filter, for the short filters (up to a few hundred taps)
+ * that run faster directly than through an FFT, see Convolver for long ones.
+ *
+ * The coefficients are kept reversed in cache aligned storage, padded with
+ * zeros to a whole number of native SIMD vectors. The history is a circular
+ * buffer written twice, at i and at i + capacity, so the last samples are
+ * always one contiguous window that the dot product reads with plain vector
+ * loads, with no wrap around to split it. The buffer holds a run of inputs
+ * beyond the window, and each call writes a whole run into it before
+ * working out the outputs for the run, so the vector loads never wait on the
+ * store of the sample just written.
+ *
+ * T is float or double for one channel, with the taps across the SIMD lanes.
+ * T is a SIMD_Vector<float, N> or SIMD_Vector<double, N> for N channels at
+ * once, one per lane, taking frames of N interleaved samples as vectors;
+ * the coefficients may differ per lane, or be shared with the scalar
+ * overload of set_coefficients().
+ *
+ * An FIR built with an interpolation factor L splits its coefficients into L
+ * polyphase sub-filters, and interpolate() writes L outputs per input from
+ * them without ever multiplying the zeros of the upsampled signal. The
+ * coefficients should carry the gain of L that makes up for those zeros.
+ * decimate() by M runs the whole filter only for the one input in M whose
+ * output it keeps. Both keep their phase from call to call, so the inputs
+ * may come in any number of frames at a time.
+ */
+template <typename T>
+class FIR
+{
+  public:
+    typedef T value_type;
+
+    /// float or double, the type of each lane of value_type
+    typedef typename simd_value_type<T>::type lane_type;
+
+    /// The most inputs written to the history ahead of their outputs
+    static const std::size_t max_run = 64;
+
+    /// An FIR without coefficients, which process(), decimate() and interpolate() refuse until set_coefficients()
+    FIR()
+        : m_taps( 0 ), m_interpolation( 1 ), m_phase_length( 0 ), m_run( 0 ), m_capacity( 0 ), m_position( 0 )
+        , m_decimation_phase( 0 )
+    {
+    }
+
+    FIR( value_type const *taps, std::size_t count, std::size_t interpolation = 1 )
+        : m_taps( 0 ), m_interpolation( 1 ), m_phase_length( 0 ), m_run( 0 ), m_capacity( 0 ), m_position( 0 )
+        , m_decimation_phase( 0 )
+    {
+        set_coefficients( taps, count, interpolation );
+    }
+
+    std::size_t taps() const
+    {
+        return m_taps;
+    }
+
+    std::size_t interpolation() const
+    {
+        return m_interpolation;
+    }
+
+    /// Set count coefficients, split into interpolation polyphase sub-filters, and clear the history. Throws
+    /// std::invalid_argument for no coefficients or an interpolation factor of 0
+    void set_coefficients( value_type const *taps, std::size_t count, std::size_t interpolation = 1 )
+    {
+        if ( count == 0 || interpolation == 0 )
+        {
+            throw std::invalid_argument( "FIR coefficients" );
+        }
+        const std::size_t block = FIRDetail::tap_block<T>::value;
+        const std::size_t phase_taps = ( count + interpolation - 1 ) / interpolation;
+        m_taps = count;
+        m_interpolation = interpolation;
+        m_phase_length = ( phase_taps + block - 1 ) / block * block;
+        m_run = std::min( max_run, std::max<std::size_t>( m_phase_length, 16 ) );
+        m_capacity = m_phase_length + m_run;
+
+        // sub-filter p holds taps p, p + L, p + 2L, ... reversed to line up with the oldest to newest history window
+        value_type z;
+        zero( z );
+        m_coeffs.assign( interpolation * m_phase_length, z );
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            const std::size_t p = i % interpolation;
+            m_coeffs[p * m_phase_length + m_phase_length - 1 - i / interpolation] = taps[i];
+        }
+        m_history.assign( 2 * m_capacity, z );
+        reset();
+    }
+
+    /// Set the same count coefficients for every lane of a multi-channel FIR
+    template <typename U>
+    typename std::enable_if<std::is_same<U, lane_type>::value && !std::is_same<U, value_type>::value>::type
+        set_coefficients( U const *taps, std::size_t count, std::size_t interpolation = 1 )
+    {
+        std::vector<value_type, aligned_allocator<value_type> > v( count );
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            splat( v[i], taps[i] );
+        }
+        set_coefficients( v.data(), count, interpolation );
+    }
+
+    /// Clear the history and the decimation phase
+    void reset()
+    {
+        value_type z;
+        zero( z );
+        std::fill( m_history.begin(), m_history.end(), z );
+        m_position = 0;
+        m_decimation_phase = 0;
+    }
+
+    /// Filter frames inputs to frames outputs. input and output may be the same buffer. Throws std::logic_error for an
+    /// interpolating FIR or one without coefficients
+    void process( value_type const *input, value_type *output, std::size_t frames )
+    {
+        check_single_phase();
+        for_each_window( input, frames, [&]( std::size_t i, value_type const *window )
+                         {
+                             output[i] = FIRDetail::dot( m_coeffs.data(), window, m_phase_length );
+                         } );
+    }
+
+    /// Filter one sample
+    value_type process( value_type const &input )
+    {
+        value_type output;
+        process( &input, &output, 1 );
+        return output;
+    }
+
+    /// Filter and keep one output in factor: the outputs for inputs 0, factor, 2 * factor and on, counting from the
+    /// last reset(). Returns the number of outputs written. input and output may be the same buffer. Throws
+    /// std::logic_error for an interpolating FIR or one without coefficients and std::invalid_argument for a factor
+    /// of 0
+    std::size_t decimate( value_type const *input, std::size_t frames, value_type *output, std::size_t factor )
+    {
+        check_single_phase();
+        if ( factor == 0 )
+        {
+            throw std::invalid_argument( "FIR decimation factor" );
+        }
+        std::size_t written = 0;
+        for_each_window( input, frames, [&]( std::size_t, value_type const *window )
+                         {
+                             if ( m_decimation_phase == 0 )
+                             {
+                                 output[written++] = FIRDetail::dot( m_coeffs.data(), window, m_phase_length );
+                             }
+                             m_decimation_phase = ( m_decimation_phase + 1 == factor ) ? 0 : m_decimation_phase + 1;
+                         } );
+        return written;
+    }
+
+    /// Upsample by interpolation() and filter, writing frames * interpolation() outputs. input and output must not
+    /// overlap. Throws std::logic_error for an FIR without coefficients
+    void interpolate( value_type const *input, std::size_t frames, value_type *output )
+    {
+        for_each_window( input, frames, [&]( std::size_t i, value_type const *window )
+                         {
+                             for ( std::size_t p = 0; p < m_interpolation; ++p )
+                             {
+                                 output[i * m_interpolation + p] =
+                                     FIRDetail::dot( m_coeffs.data() + p * m_phase_length, window, m_phase_length );
+                             }
+                         } );
+    }
+
+  private:
+    void check_single_phase() const
+    {
+        if ( m_interpolation != 1 )
+        {
+            throw std::logic_error( "FIR is interpolating" );
+        }
+    }
+
+    /// Write the inputs into the history a run at a time, then call f( i, window ) for each input i of the run, where
+    /// window is the m_phase_length inputs up to and including input i, oldest first. Every input of a run is read
+    /// before f sees the first of them, so f may write over the inputs. Throws std::logic_error before the
+    /// coefficients are set, when there is no history to write to
+    template <typename F>
+    void for_each_window( value_type const *input, std::size_t frames, F f )
+    {
+        if ( m_taps == 0 )
+        {
+            throw std::logic_error( "FIR has no coefficients" );
+        }
+        for ( std::size_t first = 0; first < frames; first += m_run )
+        {
+            const std::size_t run = std::min( m_run, frames - first );
+            const std::size_t start = m_position;
+            for ( std::size_t i = 0; i < run; ++i )
+            {
+                m_history[m_position] = input[first + i];
+                m_history[m_position + m_capacity] = input[first + i];
+                m_position = ( m_position + 1 == m_capacity ) ? 0 : m_position + 1;
+            }
+            // input first + i is in slot start + i, and its window starts m_phase_length - 1 slots before
+            std::size_t window = ( start + m_capacity + 1 - m_phase_length ) % m_capacity;
+            for ( std::size_t i = 0; i < run; ++i )
+            {
+                f( first + i, m_history.data() + window );
+                window = ( window + 1 == m_capacity ) ? 0 : window + 1;
+            }
+        }
+    }
+
+    std::size_t m_taps;
+    std::size_t m_interpolation;
+    std::size_t m_phase_length;
+    std::size_t m_run;
+    std::size_t m_capacity;
+    std::size_t m_position;
+    std::size_t m_decimation_phase;
+    std::vector<value_type, aligned_allocator<value_type> > m_coeffs;
+    std::vector<value_type, aligned_allocator<value_type> > m_history;
+};
+
+template <typename T>
+const std::size_t FIR<T>::max_run;
+
+DAP_NAMESPACE_END
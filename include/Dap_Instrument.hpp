@@ -0,0 +1,194 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include <chrono>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+DAP_NAMESPACE_BEGIN
+
+/**
+ * The block algorithms that report to an instrumentation policy
+ */
+enum class BlockOperation
+{
+    apply_block,
+    copy_block,
+    make_block,
+    fill_block,
+    twist_block
+};
+
+static const std::size_t block_operation_count = 5;
+
+inline const char *block_operation_name( BlockOperation op )
+{
+    static const char *names[block_operation_count] = {"apply_block", "copy_block", "make_block", "fill_block", "twist_block"};
+    return names[static_cast<std::size_t>( op )];
+}
+
+/**
+ * \addtogroup instrument NoInstrument CountingInstrument
+ *
+ * The block algorithms take an instrumentation policy as an optional
+ * template parameter. A policy has a static bool 'enabled' and, when it is
+ * true, a static record( op, items, bytes, cycles ) that is called once per
+ * call with the number of items visited, the bytes read plus written and the
+ * elapsed cycles. The default NoInstrument is disabled, and then no counter
+ * is read and nothing is recorded, so the call compiles to the same code as
+ * before.
+ */
+/**@{*/
+
+struct NoInstrument
+{
+    static const bool enabled = false;
+};
+
+/// Totals of one BlockOperation since the last reset
+struct InstrumentStats
+{
+    std::uint64_t calls;
+    std::uint64_t items;
+    std::uint64_t bytes;
+    std::uint64_t cycles;
+};
+
+/**
+ * Accumulates the calls, items, bytes and cycles of each BlockOperation in
+ * relaxed atomics, so that it may be shared by real time threads and read
+ * from another thread. Tag selects an independent set of totals.
+ */
+template <typename Tag = void>
+struct CountingInstrument
+{
+    static const bool enabled = true;
+
+    static void record( BlockOperation op, std::size_t items, std::size_t bytes, std::uint64_t cycles )
+    {
+        Counters &c = counters( op );
+        c.calls.fetch_add( 1, std::memory_order_relaxed );
+        c.items.fetch_add( items, std::memory_order_relaxed );
+        c.bytes.fetch_add( bytes, std::memory_order_relaxed );
+        c.cycles.fetch_add( cycles, std::memory_order_relaxed );
+    }
+
+    static InstrumentStats stats( BlockOperation op )
+    {
+        Counters const &c = counters( op );
+        InstrumentStats s = {c.calls.load( std::memory_order_relaxed ),
+                             c.items.load( std::memory_order_relaxed ),
+                             c.bytes.load( std::memory_order_relaxed ),
+                             c.cycles.load( std::memory_order_relaxed )};
+        return s;
+    }
+
+    static void reset()
+    {
+        for ( std::size_t i = 0; i < block_operation_count; ++i )
+        {
+            Counters &c = counters( static_cast<BlockOperation>( i ) );
+            c.calls.store( 0, std::memory_order_relaxed );
+            c.items.store( 0, std::memory_order_relaxed );
+            c.bytes.store( 0, std::memory_order_relaxed );
+            c.cycles.store( 0, std::memory_order_relaxed );
+        }
+    }
+
+  private:
+    struct Counters
+    {
+        std::atomic<std::uint64_t> calls;
+        std::atomic<std::uint64_t> items;
+        std::atomic<std::uint64_t> bytes;
+        std::atomic<std::uint64_t> cycles;
+    };
+
+    static Counters &counters( BlockOperation op )
+    {
+        static Counters c[block_operation_count];
+        return c[static_cast<std::size_t>( op )];
+    }
+};
+
+/**@}*/
+
+namespace InstrumentDetail
+{
+
+/// The time stamp counter where there is one, otherwise nanoseconds
+inline std::uint64_t cycle_count()
+{
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+    return __rdtsc();
+#elif defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+}
+
+/// Records one call of op with InstrumentT when it goes out of scope
+template <typename InstrumentT, bool Enabled = InstrumentT::enabled>
+class scope
+{
+  public:
+    scope( BlockOperation op, std::size_t items, std::size_t bytes )
+        : m_op( op ), m_items( items ), m_bytes( bytes ), m_start( cycle_count() )
+    {
+    }
+
+    ~scope() { InstrumentT::record( m_op, m_items, m_bytes, cycle_count() - m_start ); }
+
+  private:
+    BlockOperation m_op;
+    std::size_t m_items;
+    std::size_t m_bytes;
+    std::uint64_t m_start;
+};
+
+/// A disabled policy keeps nothing and reads no counter
+template <typename InstrumentT>
+class scope<InstrumentT, false>
+{
+  public:
+    scope( BlockOperation, std::size_t, std::size_t ) {}
+};
+}
+
+DAP_NAMESPACE_END
@@ -34,8 +34,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Dap_Traits.hpp"
 #include "Dap_Vec.hpp"
 
-namespace Dap
-{
+DAP_NAMESPACE_BEGIN
 namespace Constants
 {
 
@@ -189,4 +188,4 @@ static constexpr T recip_192k()
     return static_cast<T>( 1.0 / ( 192e3 ) );
 }
 }
-}
+DAP_NAMESPACE_END
@@ -0,0 +1,231 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_BlockView.hpp"
+#include "Dap_Dispatch.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+/** \addtogroup pcm PCM conversion
+ *
+ * Conversion between integer PCM samples, as they come from and go to audio
+ * I/O, and float or double. The PCMFormat is int16, packed three byte int24
+ * or int32, little endian. Full scale is 1.0: decoding divides by 2^15, 2^23
+ * or 2^31, and gain multiplies on top of that.
+ *
+ * Encoding rounds to nearest and saturates at the limits of the format, so
+ * an overload clips rather than wraps; NaN becomes the most negative sample.
+ * With a PCMDither it first adds triangular (TPDF) dither of one step peak,
+ * which decorrelates the rounding error from the signal.
+ *
+ * The kernels are in the runtime dispatch table, see Dap_Dispatch.hpp, so a
+ * baseline build still converts eight samples at a time on an AVX2 host.
+ *
+ * pcm_to_block() and block_to_pcm() convert interleaved frames straight to
+ * and from a Block, DynBlock or BlockView whose width is the frames, with
+ * each height and depth row one channel: channel h + height * d is the row at
+ * height h and depth d, as with Convolver. They walk the block in the order
+ * of its Twist. A block whose storage already interleaves the channels is
+ * converted in one pass; any other is converted a run of frames at a time
+ * through an interleaved buffer, and spread to the rows with the tiled
+ * transpose when the rows are contiguous and there are enough of them to
+ * fill its tiles, or one row at a time otherwise.
+ */
+/**@{*/
+
+/// The state of the TPDF dither of pcm_encode() and block_to_pcm(), kept from call to call so that the dither of
+/// successive buffers does not repeat
+class PCMDither
+{
+  public:
+    explicit PCMDither( std::uint32_t seed = 1 )
+    {
+        // a different, nonzero start for each generator
+        std::uint32_t s = seed;
+        for ( std::size_t k = 0; k < 8; ++k )
+        {
+            s = s * 1664525u + 1013904223u;
+            m_state.state[k] = s ? s : 1;
+        }
+    }
+
+    DispatchDither *state()
+    {
+        return &m_state;
+    }
+
+  private:
+    DispatchDither m_state;
+};
+
+/// Decode count PCM samples at input to output, times gain
+template <typename T>
+void pcm_decode( void const *input, PCMFormat format, T *output, std::size_t count, T gain = T( 1 ) )
+{
+    dispatch_for<T>().pcm_decode[static_cast<std::size_t>( format )]( input, gain, output, count );
+}
+
+/// Encode count samples at input times gain to PCM samples at output, with TPDF dither unless dither is null
+template <typename T>
+void pcm_encode(
+    T const *input, void *output, PCMFormat format, std::size_t count, T gain = T( 1 ), PCMDither *dither = 0 )
+{
+    dispatch_for<T>().pcm_encode[static_cast<std::size_t>( format )](
+        input, gain, output, count, dither ? dither->state() : 0 );
+}
+
+namespace PCMDetail
+{
+
+/// The items of the interleaved buffer used for blocks that do not interleave their channels
+static const std::size_t run_items = 2048;
+
+/// Fewer rows than this are copied one row at a time, as they would not fill the SIMD tiles of the transpose
+static const std::size_t transpose_rows = 4;
+
+/// dest[i * dest_stride] = src[i * src_stride] for i < count
+template <typename T>
+void copy_strided( T const *src, std::size_t src_stride, T *dest, std::size_t dest_stride, std::size_t count )
+{
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        dest[i * dest_stride] = src[i * src_stride];
+    }
+}
+
+/// True if the view stores frame f of channel c at f * channels + c
+template <typename ViewT>
+bool interleaved( ViewT const &v )
+{
+    const std::size_t channels = v.height() * v.depth();
+    return v.width_stride() == channels && ( v.height() == 1 || v.height_stride() == 1 )
+           && ( v.depth() == 1 || v.depth_stride() == v.height() );
+}
+}
+
+/// Decode the interleaved PCM frames at input into block, times gain. There are block.width() frames, each of
+/// height * depth samples
+template <typename ContainerT>
+void pcm_to_block( void const *input,
+                   PCMFormat format,
+                   ContainerT &block,
+                   typename BlockDetail::layout<ContainerT>::value_type gain = 1 )
+{
+    typedef typename BlockDetail::layout<ContainerT>::value_type T;
+    auto view = view_block( block );
+    const std::size_t frames = view.width();
+    const std::size_t height = view.height();
+    const std::size_t channels = height * view.depth();
+    if ( PCMDetail::interleaved( view ) )
+    {
+        pcm_decode( input, format, view.data(), frames * channels, gain );
+        return;
+    }
+
+    unsigned char const *in = static_cast<unsigned char const *>( input );
+    const std::size_t bytes = pcm_format_bytes( format );
+    const std::size_t run = std::max<std::size_t>( 1, PCMDetail::run_items / channels );
+    DAP_CACHE_ALIGN T buffer[PCMDetail::run_items];
+    std::vector<T> big_frames( channels > PCMDetail::run_items ? channels : 0 );
+    T *interleaved = big_frames.empty() ? buffer : big_frames.data();
+    for ( std::size_t first = 0; first < frames; first += run )
+    {
+        const std::size_t n = std::min( run, frames - first );
+        pcm_decode( in + first * channels * bytes, format, interleaved, n * channels, gain );
+        for ( std::size_t d = 0; d < view.depth(); ++d )
+        {
+            T *dest = &view.get( first, 0, d );
+            if ( view.width_stride() == 1 && height >= PCMDetail::transpose_rows )
+            {
+                BlockDetail::transpose_dispatched( interleaved + d * height, channels, dest, view.height_stride(), n, height );
+                continue;
+            }
+            for ( std::size_t h = 0; h < height; ++h )
+            {
+                PCMDetail::copy_strided(
+                    interleaved + d * height + h, channels, dest + h * view.height_stride(), view.width_stride(), n );
+            }
+        }
+    }
+}
+
+/// Encode block times gain to interleaved PCM frames at output, with TPDF dither unless dither is null
+template <typename ContainerT>
+void block_to_pcm( ContainerT const &block,
+                   void *output,
+                   PCMFormat format,
+                   typename BlockDetail::layout<ContainerT>::value_type gain = 1,
+                   PCMDither *dither = 0 )
+{
+    typedef typename BlockDetail::layout<ContainerT>::value_type T;
+    auto view = view_block( block );
+    const std::size_t frames = view.width();
+    const std::size_t height = view.height();
+    const std::size_t channels = height * view.depth();
+    if ( PCMDetail::interleaved( view ) )
+    {
+        pcm_encode( view.data(), output, format, frames * channels, gain, dither );
+        return;
+    }
+
+    unsigned char *out = static_cast<unsigned char *>( output );
+    const std::size_t bytes = pcm_format_bytes( format );
+    const std::size_t run = std::max<std::size_t>( 1, PCMDetail::run_items / channels );
+    DAP_CACHE_ALIGN T buffer[PCMDetail::run_items];
+    std::vector<T> big_frames( channels > PCMDetail::run_items ? channels : 0 );
+    T *interleaved = big_frames.empty() ? buffer : big_frames.data();
+    for ( std::size_t first = 0; first < frames; first += run )
+    {
+        const std::size_t n = std::min( run, frames - first );
+        for ( std::size_t d = 0; d < view.depth(); ++d )
+        {
+            T const *src = &view.get( first, 0, d );
+            if ( view.width_stride() == 1 && height >= PCMDetail::transpose_rows )
+            {
+                BlockDetail::transpose_dispatched( src, view.height_stride(), interleaved + d * height, channels, height, n );
+                continue;
+            }
+            for ( std::size_t h = 0; h < height; ++h )
+            {
+                PCMDetail::copy_strided(
+                    src + h * view.height_stride(), view.width_stride(), interleaved + d * height + h, channels, n );
+            }
+        }
+        pcm_encode( interleaved, out + first * channels * bytes, format, n * channels, gain, dither );
+    }
+}
+
+/**@}*/
+
+DAP_NAMESPACE_END
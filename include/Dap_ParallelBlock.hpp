@@ -0,0 +1,166 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Block.hpp"
+#include "Dap_ThreadPool.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+namespace ParallelBlockDetail
+{
+
+/// The least bytes of the destination that one task writes, so that each task streams through whole pages
+const std::size_t chunk_bytes = 64 * 1024;
+
+/**
+ * Split the rows of c, see BlockDetail::for_each_item_in_rows, into chunks of
+ * at least chunk_bytes and call f( first_row, last_row ) for each chunk on
+ * pool. The rows are numbered along the outer storage axes, so every chunk
+ * is one contiguous run of memory.
+ */
+template <typename ContainerT, typename RowsFunctor>
+void for_each_row_chunk( ThreadPool &pool, ContainerT const &c, RowsFunctor f )
+{
+    using Layout = BlockDetail::layout<ContainerT>;
+    const std::size_t rows = Layout::raw_index0_size( c ) * Layout::raw_index1_size( c );
+    const std::size_t row_bytes = std::max<std::size_t>( 1, Layout::raw_index2_size( c ) * sizeof( typename Layout::value_type ) );
+    const std::size_t chunk_rows = std::max<std::size_t>( 1, chunk_bytes / row_bytes );
+    const std::size_t chunks = ( rows + chunk_rows - 1 ) / chunk_rows;
+
+    pool.parallel_for( chunks, [&]( std::size_t i )
+                       {
+        f( i * chunk_rows, std::min( rows, ( i + 1 ) * chunk_rows ) );
+    } );
+}
+}
+
+/**
+ * \addtogroup parallel_block parallel_apply_block
+ *
+ * The forms of apply_block that spread the work over a ThreadPool. The
+ * destination is cut into contiguous runs of rows along its outer storage
+ * axes, and each run is one task. f is called exactly once per item with
+ * the same arguments as apply_block, so the results are identical to the
+ * serial forms, but the calls are concurrent and in no particular order;
+ * f must not depend on other items of the destination.
+ */
+/**@{*/
+
+/// Replace every item v of srcdest by f( v, width_pos, height_pos, depth_pos )
+template <typename InstrumentT = NoInstrument, typename ContainerT, typename Functor>
+void parallel_apply_block( ThreadPool &pool, ContainerT &srcdest, Functor f, typename Traits<ContainerT>::twist_type * = 0 )
+{
+    using ValueType = typename Traits<ContainerT>::value_type;
+    const std::size_t n = BlockDetail::layout<ContainerT>::item_count( srcdest );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::apply_block, n, 2 * n * sizeof( ValueType ) );
+
+    ParallelBlockDetail::for_each_row_chunk( pool, srcdest, [&]( std::size_t first_row, std::size_t last_row )
+                                             {
+        BlockDetail::for_each_item_in_rows( srcdest, first_row, last_row, [&]( ValueType &v, std::size_t w, std::size_t h, std::size_t d )
+                                            {
+            v = f( v, w, h, d );
+        } );
+    } );
+}
+
+/// Set each item of dest to f( src item, width_pos, height_pos, depth_pos )
+template <typename InstrumentT = NoInstrument, typename SourceContainerT, typename DestinationContainerT, typename Functor>
+auto parallel_apply_block( ThreadPool &pool,
+                           SourceContainerT const &src,
+                           DestinationContainerT &dest,
+                           Functor f,
+                           typename Traits<SourceContainerT>::twist_type * = 0,
+                           typename Traits<DestinationContainerT>::twist_type * = 0 ) -> void
+{
+    using ValueType = typename Traits<DestinationContainerT>::value_type;
+    BlockDetail::check_same_size( src, dest );
+    const std::size_t n = BlockDetail::layout<DestinationContainerT>::item_count( dest );
+    InstrumentDetail::scope<InstrumentT> instrument(
+        BlockOperation::apply_block,
+        n,
+        n * ( sizeof( typename Traits<SourceContainerT>::value_type ) + sizeof( ValueType ) ) );
+
+    const bool same_layout = BlockDetail::same_layout<SourceContainerT, DestinationContainerT>::value;
+    auto s = BlockDetail::layout<SourceContainerT>::items( src );
+    auto d = BlockDetail::layout<DestinationContainerT>::items( dest );
+    ParallelBlockDetail::for_each_row_chunk( pool, dest, [&]( std::size_t first_row, std::size_t last_row )
+                                             {
+        BlockDetail::for_each_item_in_rows( dest, first_row, last_row, [&]( ValueType &v, std::size_t w, std::size_t h, std::size_t dp )
+                                            {
+            v = f( same_layout ? s[&v - d] : get( src, w, h, dp ), w, h, dp );
+        } );
+    } );
+}
+
+/// Set each item of r to f( c1 item, c2 item, width_pos, height_pos, depth_pos )
+template <typename InstrumentT = NoInstrument,
+          typename Container1T,
+          typename Container2T,
+          typename ResultContainerT,
+          typename Functor>
+auto parallel_apply_block( ThreadPool &pool,
+                           Container1T const &c1,
+                           Container2T const &c2,
+                           ResultContainerT &r,
+                           Functor f,
+                           typename Traits<Container1T>::twist_type * = 0,
+                           typename Traits<Container2T>::twist_type * = 0,
+                           typename Traits<ResultContainerT>::twist_type * = 0 ) -> void
+{
+    using ValueType = typename Traits<ResultContainerT>::value_type;
+    BlockDetail::check_same_size( c1, c2 );
+    BlockDetail::check_same_size( c1, r );
+    const std::size_t n = BlockDetail::layout<ResultContainerT>::item_count( r );
+    InstrumentDetail::scope<InstrumentT> instrument( BlockOperation::apply_block,
+                                                     n,
+                                                     n * ( sizeof( typename Traits<Container1T>::value_type )
+                                                           + sizeof( typename Traits<Container2T>::value_type )
+                                                           + sizeof( ValueType ) ) );
+
+    const bool same_layout = BlockDetail::same_layout<Container1T, ResultContainerT>::value
+                             && BlockDetail::same_layout<Container2T, ResultContainerT>::value;
+    auto p1 = BlockDetail::layout<Container1T>::items( c1 );
+    auto p2 = BlockDetail::layout<Container2T>::items( c2 );
+    auto pr = BlockDetail::layout<ResultContainerT>::items( r );
+    ParallelBlockDetail::for_each_row_chunk( pool, r, [&]( std::size_t first_row, std::size_t last_row )
+                                             {
+        BlockDetail::for_each_item_in_rows( r, first_row, last_row, [&]( ValueType &v, std::size_t w, std::size_t h, std::size_t d )
+                                            {
+            v = same_layout ? f( p1[&v - pr], p2[&v - pr], w, h, d ) : f( get( c1, w, h, d ), get( c2, w, h, d ), w, h, d );
+        } );
+    } );
+}
+
+/**@}*/
+
+DAP_NAMESPACE_END
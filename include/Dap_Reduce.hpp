@@ -0,0 +1,389 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_SIMD.hpp"
+#include "Dap_Traits.hpp"
+#include "Dap_Block.hpp"
+
+DAP_NAMESPACE_BEGIN
+
+namespace ReduceDetail
+{
+
+struct Sum
+{
+    template <typename V>
+    static V prepare( V const &x )
+    {
+        return x;
+    }
+
+    template <typename V>
+    static V combine( V const &a, V const &b )
+    {
+        return a + b;
+    }
+
+    template <typename V>
+    static typename simd_value_type<V>::type horizontal( V const &a )
+    {
+        return hsum( a );
+    }
+
+    template <typename T>
+    static T identity()
+    {
+        return T( 0 );
+    }
+};
+
+struct Min
+{
+    template <typename V>
+    static V prepare( V const &x )
+    {
+        return x;
+    }
+
+    template <typename V>
+    static V combine( V const &a, V const &b )
+    {
+        return select( b < a, b, a );
+    }
+
+    template <typename V>
+    static typename simd_value_type<V>::type horizontal( V const &a )
+    {
+        return hmin( a );
+    }
+
+    template <typename T>
+    static T identity()
+    {
+        return std::numeric_limits<T>::infinity();
+    }
+};
+
+struct Max
+{
+    template <typename V>
+    static V prepare( V const &x )
+    {
+        return x;
+    }
+
+    template <typename V>
+    static V combine( V const &a, V const &b )
+    {
+        return select( b > a, b, a );
+    }
+
+    template <typename V>
+    static typename simd_value_type<V>::type horizontal( V const &a )
+    {
+        return hmax( a );
+    }
+
+    template <typename T>
+    static T identity()
+    {
+        return -std::numeric_limits<T>::infinity();
+    }
+};
+
+struct AbsMax : Max
+{
+    template <typename V>
+    static V prepare( V const &x )
+    {
+        using std::abs;
+        return abs( x );
+    }
+
+    template <typename T>
+    static T identity()
+    {
+        return T( 0 );
+    }
+};
+
+/// Reduce n items at p with four native vector accumulators so that consecutive combines do not wait on each other
+template <typename OpT, typename T>
+T reduce( T const *p, std::size_t n )
+{
+    static_assert( std::is_floating_point<T>::value, "block reductions take float or double samples" );
+    typedef SIMD_Vector<T, simd_native_size<T>::value> V;
+    const std::size_t w = simd_native_size<T>::value;
+    T r = OpT::template identity<T>();
+    std::size_t i = 0;
+
+    if ( n >= 4 * w )
+    {
+        V x0, x1, x2, x3;
+        x0.load( p );
+        x1.load( p + w );
+        x2.load( p + 2 * w );
+        x3.load( p + 3 * w );
+        V acc0 = OpT::prepare( x0 ), acc1 = OpT::prepare( x1 ), acc2 = OpT::prepare( x2 ), acc3 = OpT::prepare( x3 );
+        for ( i = 4 * w; i + 4 * w <= n; i += 4 * w )
+        {
+            x0.load( p + i );
+            x1.load( p + i + w );
+            x2.load( p + i + 2 * w );
+            x3.load( p + i + 3 * w );
+            acc0 = OpT::combine( acc0, OpT::prepare( x0 ) );
+            acc1 = OpT::combine( acc1, OpT::prepare( x1 ) );
+            acc2 = OpT::combine( acc2, OpT::prepare( x2 ) );
+            acc3 = OpT::combine( acc3, OpT::prepare( x3 ) );
+        }
+        for ( ; i + w <= n; i += w )
+        {
+            x0.load( p + i );
+            acc0 = OpT::combine( acc0, OpT::prepare( x0 ) );
+        }
+        r = OpT::horizontal( OpT::combine( OpT::combine( acc0, acc1 ), OpT::combine( acc2, acc3 ) ) );
+    }
+
+    for ( ; i < n; ++i )
+    {
+        r = OpT::combine( r, OpT::prepare( p[i] ) );
+    }
+    return r;
+}
+
+/// Reduce every item of c: as one run when its storage is contiguous, otherwise one raw index2 row at a time
+template <typename OpT, typename ContainerT>
+typename Traits<ContainerT>::value_type reduce_block( ContainerT const &c )
+{
+    using Layout = BlockDetail::layout<ContainerT>;
+    using T = typename Traits<ContainerT>::value_type;
+    auto p = Layout::items( c );
+    if ( Layout::is_contiguous )
+    {
+        return reduce<OpT>( p, Layout::item_count( c ) );
+    }
+
+    const std::size_t size0 = Layout::raw_index0_size( c ), size1 = Layout::raw_index1_size( c );
+    const std::size_t size2 = Layout::raw_index2_size( c );
+    const std::size_t stride0 = Layout::raw_stride0( c ), stride1 = Layout::raw_stride1( c );
+    const std::size_t stride2 = Layout::raw_stride2( c );
+    T r = OpT::template identity<T>();
+    for ( std::size_t a = 0; a < size0; ++a )
+    {
+        for ( std::size_t b = 0; b < size1; ++b )
+        {
+            auto row = p + a * stride0 + b * stride1;
+            if ( stride2 == 1 )
+            {
+                r = OpT::combine( r, reduce<OpT>( row, size2 ) );
+            }
+            else
+            {
+                for ( std::size_t i = 0; i < size2; ++i )
+                {
+                    r = OpT::combine( r, OpT::prepare( row[i * stride2] ) );
+                }
+            }
+        }
+    }
+    return r;
+}
+
+}
+
+/** \addtogroup block_reduce sum_block min_block max_block absmax_block dot_block
+ *
+ * Reductions of a run of float or double samples, used by metering and
+ * normalization. The samples are read as native width SIMD_Vector with four
+ * independent accumulators, which are combined and reduced horizontally once
+ * at the end; the remaining samples are folded in one at a time. Because the
+ * additions are reassociated the sums differ from a sequential loop in the
+ * last bits. The Block, DynBlock and BlockView overloads reduce every item of
+ * the block regardless of its twist; views are reduced one row at a time.
+ */
+/**@{*/
+
+/// Sum of n samples, 0 when n is 0
+template <typename T>
+T sum_block( T const *p, std::size_t n )
+{
+    return ReduceDetail::reduce<ReduceDetail::Sum>( p, n );
+}
+
+/// Smallest of n samples, +infinity when n is 0
+template <typename T>
+T min_block( T const *p, std::size_t n )
+{
+    return ReduceDetail::reduce<ReduceDetail::Min>( p, n );
+}
+
+/// Largest of n samples, -infinity when n is 0
+template <typename T>
+T max_block( T const *p, std::size_t n )
+{
+    return ReduceDetail::reduce<ReduceDetail::Max>( p, n );
+}
+
+/// Peak absolute value of n samples, 0 when n is 0
+template <typename T>
+T absmax_block( T const *p, std::size_t n )
+{
+    return ReduceDetail::reduce<ReduceDetail::AbsMax>( p, n );
+}
+
+/// Sum of the products of n samples of a and b, 0 when n is 0
+template <typename T>
+T dot_block( T const *a, T const *b, std::size_t n )
+{
+    static_assert( std::is_floating_point<T>::value, "block reductions take float or double samples" );
+    typedef SIMD_Vector<T, simd_native_size<T>::value> V;
+    const std::size_t w = simd_native_size<T>::value;
+    T r = T( 0 );
+    std::size_t i = 0;
+
+    if ( n >= 4 * w )
+    {
+        V a0, a1, a2, a3, b0, b1, b2, b3;
+        V acc0, acc1, acc2, acc3;
+        splat( acc0, T( 0 ) );
+        acc1 = acc0;
+        acc2 = acc0;
+        acc3 = acc0;
+        for ( ; i + 4 * w <= n; i += 4 * w )
+        {
+            a0.load( a + i );
+            a1.load( a + i + w );
+            a2.load( a + i + 2 * w );
+            a3.load( a + i + 3 * w );
+            b0.load( b + i );
+            b1.load( b + i + w );
+            b2.load( b + i + 2 * w );
+            b3.load( b + i + 3 * w );
+            acc0 = fma( a0, b0, acc0 );
+            acc1 = fma( a1, b1, acc1 );
+            acc2 = fma( a2, b2, acc2 );
+            acc3 = fma( a3, b3, acc3 );
+        }
+        for ( ; i + w <= n; i += w )
+        {
+            a0.load( a + i );
+            b0.load( b + i );
+            acc0 = fma( a0, b0, acc0 );
+        }
+        r = hsum( ( acc0 + acc1 ) + ( acc2 + acc3 ) );
+    }
+
+    for ( ; i < n; ++i )
+    {
+        r = fma( a[i], b[i], r );
+    }
+    return r;
+}
+
+template <typename ContainerT>
+auto sum_block( ContainerT const &c, typename Traits<ContainerT>::twist_type * = 0 ) ->
+    typename Traits<ContainerT>::value_type
+{
+    return ReduceDetail::reduce_block<ReduceDetail::Sum>( c );
+}
+
+template <typename ContainerT>
+auto min_block( ContainerT const &c, typename Traits<ContainerT>::twist_type * = 0 ) ->
+    typename Traits<ContainerT>::value_type
+{
+    return ReduceDetail::reduce_block<ReduceDetail::Min>( c );
+}
+
+template <typename ContainerT>
+auto max_block( ContainerT const &c, typename Traits<ContainerT>::twist_type * = 0 ) ->
+    typename Traits<ContainerT>::value_type
+{
+    return ReduceDetail::reduce_block<ReduceDetail::Max>( c );
+}
+
+template <typename ContainerT>
+auto absmax_block( ContainerT const &c, typename Traits<ContainerT>::twist_type * = 0 ) ->
+    typename Traits<ContainerT>::value_type
+{
+    return ReduceDetail::reduce_block<ReduceDetail::AbsMax>( c );
+}
+
+/// Both blocks must have the same size and twist so that their items line up in memory
+template <typename Container1T, typename Container2T>
+auto dot_block( Container1T const &a,
+                Container2T const &b,
+                typename Traits<Container1T>::twist_type * = 0,
+                typename Traits<Container2T>::twist_type * = 0 ) -> typename Traits<Container1T>::value_type
+{
+    static_assert( std::is_same<typename Traits<Container1T>::twist_type, typename Traits<Container2T>::twist_type>::value,
+                   "dot_block needs both blocks in the same twist" );
+    using Layout1 = BlockDetail::layout<Container1T>;
+    using Layout2 = BlockDetail::layout<Container2T>;
+    using T = typename Traits<Container1T>::value_type;
+    BlockDetail::check_same_size( a, b );
+    auto pa = Layout1::items( a );
+    auto pb = Layout2::items( b );
+    if ( Layout1::is_contiguous && Layout2::is_contiguous )
+    {
+        return dot_block( pa, pb, Layout1::item_count( a ) );
+    }
+
+    // views: one raw index2 row at a time
+    const std::size_t size0 = Layout1::raw_index0_size( a ), size1 = Layout1::raw_index1_size( a );
+    const std::size_t size2 = Layout1::raw_index2_size( a );
+    T r = T( 0 );
+    for ( std::size_t i0 = 0; i0 < size0; ++i0 )
+    {
+        for ( std::size_t i1 = 0; i1 < size1; ++i1 )
+        {
+            auto row_a = pa + i0 * Layout1::raw_stride0( a ) + i1 * Layout1::raw_stride1( a );
+            auto row_b = pb + i0 * Layout2::raw_stride0( b ) + i1 * Layout2::raw_stride1( b );
+            if ( Layout1::raw_stride2( a ) == 1 && Layout2::raw_stride2( b ) == 1 )
+            {
+                r += dot_block( row_a, row_b, size2 );
+            }
+            else
+            {
+                for ( std::size_t i = 0; i < size2; ++i )
+                {
+                    r = fma( row_a[i * Layout1::raw_stride2( a )], row_b[i * Layout2::raw_stride2( b )], r );
+                }
+            }
+        }
+    }
+    return r;
+}
+
+/**@}*/
+
+DAP_NAMESPACE_END
@@ -46,3 +46,49 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Dap_SIMD_Vector_avx32x8.hpp"
 #include "Dap_SIMD_Vector_avx64x4.hpp"
 #endif
+
+#include "Dap_SIMD_Vector_complex.hpp"
+
+#if defined( __SSE2__ )
+#include "Dap_SIMD_Vector_sse_complex32x2.hpp"
+#include "Dap_SIMD_Vector_sse_complex64x1.hpp"
+#endif
+
+#if defined( __AVX__ )
+#include "Dap_SIMD_Vector_avx_complex32x4.hpp"
+#include "Dap_SIMD_Vector_avx_complex64x2.hpp"
+#endif
+
+/// The size in bytes of the widest SIMD register enabled at compile time
+#ifndef DAP_SIMD_NATIVE_BYTES
+#if defined( __AVX__ )
+#define DAP_SIMD_NATIVE_BYTES ( 32 )
+#else
+#define DAP_SIMD_NATIVE_BYTES ( 16 )
+#endif
+#endif
+
+DAP_NAMESPACE_BEGIN
+
+/// The number of items of type T that fill the widest SIMD register enabled at compile time
+template <typename T>
+struct simd_native_size : public std::integral_constant<size_t, DAP_SIMD_NATIVE_BYTES / sizeof( T )>
+{
+};
+
+/** \addtogroup simd_stream_fence simd_stream_fence
+ *
+ * SIMD_Vector::stream writes around the cache, which saves reading the
+ * destination in when a whole block that is larger than the cache is
+ * overwritten. Those stores are weakly ordered, so call simd_stream_fence()
+ * after the last of them and before anything else reads the destination.
+ */
+/**@{*/
+inline void simd_stream_fence()
+{
+#if defined( __SSE2__ )
+    _mm_sfence();
+#endif
+}
+/**@}*/
+DAP_NAMESPACE_END
@@ -31,22 +31,26 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "Dap_World.hpp"
+#include "Dap_Dispatch.hpp"
 
+/// DAP_SIMD_ALIGN_TO( bytes ) aligns a SIMD_Vector specialization to the width of its register, DAP_SIMD_ALIGN to 16 bytes
 #if defined(_MSC_VER)
-#define DAP_SIMD_ALIGN _declspec( align( 16 ) )
+#define DAP_SIMD_ALIGN_TO( bytes ) _declspec( align( bytes ) )
 #else
-#define DAP_SIMD_ALIGN alignas( 16 )
+#define DAP_SIMD_ALIGN_TO( bytes ) alignas( bytes )
 #endif
+#define DAP_SIMD_ALIGN DAP_SIMD_ALIGN_TO( 16 )
 
-namespace Dap
-{
+DAP_NAMESPACE_BEGIN
 
 template <typename T, size_t N>
-class DAP_SIMD_ALIGN SIMD_Vector;
+class SIMD_Vector;
 template <typename T, size_t N>
 class DAP_SIMD_ALIGN SIMD_VectorRef;
 template <typename T, size_t N>
 class DAP_SIMD_ALIGN SIMD_VectorConstRef;
+template <typename T, size_t N>
+class SIMD_Mask;
 
 /** \addtogroup simd_splat splat */
 /**@{*/
@@ -57,7 +61,7 @@ inline float &splat( float &v, float a )
     return v;
 }
 
-inline double &splat( double &v, float a )
+inline double &splat( double &v, double a )
 {
     v = a;
     return v;
@@ -236,12 +240,12 @@ inline std::complex<T> less( std::complex<T> const &a, std::complex<T> const &b
 
 inline float less_equal( float a, float b )
 {
-    return a < b ? 1.0f : 0.0f;
+    return a <= b ? 1.0f : 0.0f;
 }
 
 inline double less_equal( double a, double b )
 {
-    return a < b ? 1.0 : 0.0;
+    return a <= b ? 1.0 : 0.0;
 }
 
 template <typename T>
@@ -294,16 +298,568 @@ inline std::complex<T> greater_equal( std::complex<T> const &a, std::complex<T>
 
 /**@}*/
 
-/// \todo log log2 log10 exp exp2 exp10
+/** \addtogroup simd_fma fma fms
+ *
+ * fma( a, b, c ) is a * b + c and fms( a, b, c ) is a * b - c. They are
+ * fused, with a single rounding, when the target has FMA instructions
+ * (__FMA__ on x86, __ARM_FEATURE_FMA on ARM) and are a multiply followed
+ * by an add otherwise, so that they never fall back to a slow library call.
+ */
+/**@{*/
+
+#if defined( __FMA__ ) || defined( __ARM_FEATURE_FMA )
+#define DAP_HAS_FMA 1
+#endif
+
+inline float fma( float a, float b, float c )
+{
+#if defined( DAP_HAS_FMA )
+    return std::fmaf( a, b, c );
+#else
+    return a * b + c;
+#endif
+}
+
+inline double fma( double a, double b, double c )
+{
+#if defined( DAP_HAS_FMA )
+    return std::fma( a, b, c );
+#else
+    return a * b + c;
+#endif
+}
+
+inline float fms( float a, float b, float c )
+{
+    return fma( a, b, -c );
+}
+
+inline double fms( double a, double b, double c )
+{
+    return fma( a, b, -c );
+}
+
+template <typename T>
+inline std::complex<T> fma( std::complex<T> const &a, std::complex<T> const &b, std::complex<T> const &c )
+{
+    return std::complex<T>( fms( a.real(), b.real(), fms( a.imag(), b.imag(), c.real() ) ),
+                            fma( a.real(), b.imag(), fma( a.imag(), b.real(), c.imag() ) ) );
+}
+
+template <typename T>
+inline std::complex<T> fms( std::complex<T> const &a, std::complex<T> const &b, std::complex<T> const &c )
+{
+    return fma( a, b, -c );
+}
+
+/**@}*/
+
+/** \addtogroup simd_conj conj conj_multiply norm times_i
+ *
+ * conj( a ) is the complex conjugate of a, conj_multiply( a, b ) is
+ * a * conj( b ), the product that correlations and cross spectra are built
+ * from, and norm( a ) is the squared magnitude of a. For real items conj is
+ * a itself. The complex forms multiply out the real and imaginary parts
+ * directly instead of going through std::complex operator*, which handles
+ * infinities with a library call. times_i( a ) is i * a, a quarter turn,
+ * which is only a swap of the parts and a sign change.
+ */
+/**@{*/
+
+inline float conj( float a )
+{
+    return a;
+}
+
+inline double conj( double a )
+{
+    return a;
+}
+
+inline float conj_multiply( float a, float b )
+{
+    return a * b;
+}
+
+inline double conj_multiply( double a, double b )
+{
+    return a * b;
+}
+
+template <typename T>
+inline std::complex<T> conj_multiply( std::complex<T> const &a, std::complex<T> const &b )
+{
+    return std::complex<T>( a.real() * b.real() + a.imag() * b.imag(), a.imag() * b.real() - a.real() * b.imag() );
+}
+
+template <typename T>
+inline std::complex<T> times_i( std::complex<T> const &a )
+{
+    return std::complex<T>( -a.imag(), a.real() );
+}
+
+/**@}*/
+
+/** \addtogroup simd_chunk simd_chunk
+ *
+ * The generic SIMD_Vector<T, N> and SIMD_Mask<T, N> are stored as N / W
+ * chunks, where W is the widest SIMD_Vector specialization enabled at
+ * compile time whose size divides N. Every operation runs once per chunk on
+ * the native registers, so SIMD_Vector<float, 16> is two __m256 with AVX and
+ * four __m128 with SSE, and the chunks are independent instructions the CPU
+ * can overlap. When no specialization fits, for example SIMD_Vector<float, 3>,
+ * the chunk is T itself and each operation works item by item.
+ */
+/**@{*/
+
+/// The sizes of the SIMD_Vector<T, N> specializations enabled at compile time, widest first, 1 when there are none
+template <typename T>
+struct simd_register_sizes
+{
+    static const size_t wide = 1;
+    static const size_t narrow = 1;
+};
+
+template <>
+struct simd_register_sizes<float>
+{
+#if defined( __AVX__ )
+    static const size_t wide = 8;
+    static const size_t narrow = 4;
+#elif defined( __SSE2__ ) || defined( __ARM_NEON__ )
+    static const size_t wide = 4;
+    static const size_t narrow = 4;
+#else
+    static const size_t wide = 1;
+    static const size_t narrow = 1;
+#endif
+};
+
+template <>
+struct simd_register_sizes<double>
+{
+#if defined( __AVX__ )
+    static const size_t wide = 4;
+    static const size_t narrow = 2;
+#elif defined( __SSE2__ )
+    static const size_t wide = 2;
+    static const size_t narrow = 2;
+#else
+    static const size_t wide = 1;
+    static const size_t narrow = 1;
+#endif
+};
+
+template <>
+struct simd_register_sizes<std::complex<float> >
+{
+#if defined( __AVX__ )
+    static const size_t wide = 4;
+    static const size_t narrow = 2;
+#elif defined( __SSE2__ )
+    static const size_t wide = 2;
+    static const size_t narrow = 2;
+#else
+    static const size_t wide = 1;
+    static const size_t narrow = 1;
+#endif
+};
+
+template <>
+struct simd_register_sizes<std::complex<double> >
+{
+#if defined( __AVX__ )
+    static const size_t wide = 2;
+    static const size_t narrow = 1;
+#else
+    static const size_t wide = 1;
+    static const size_t narrow = 1;
+#endif
+};
+
+/// The number of items in each chunk of the generic SIMD_Vector<T, N>
+template <typename T, size_t N>
+struct simd_chunk_size
+    : public std::integral_constant<size_t,
+                                    ( N > simd_register_sizes<T>::wide && N % simd_register_sizes<T>::wide == 0 )
+                                        ? simd_register_sizes<T>::wide
+                                        : ( ( N > simd_register_sizes<T>::narrow && N % simd_register_sizes<T>::narrow == 0 )
+                                                ? simd_register_sizes<T>::narrow
+                                                : 1 )>
+{
+};
+
+/// The vector and mask types of one chunk of the generic SIMD_Vector<T, N>
+template <typename T, size_t N, size_t ChunkSize = simd_chunk_size<T, N>::value>
+struct simd_chunk
+{
+    typedef SIMD_Vector<T, ChunkSize> type;
+    typedef SIMD_Mask<T, ChunkSize> mask_type;
+};
+
+template <typename T, size_t N>
+struct simd_chunk<T, N, 1>
+{
+    typedef T type;
+    typedef bool mask_type;
+};
+
+#if defined( __SSE2__ )
+/// A std::complex<double> fills a whole SSE register, so even single item chunks are SIMD_Vector<std::complex<double>, 1>
+template <size_t N>
+struct simd_chunk<std::complex<double>, N, 1>
+{
+    typedef SIMD_Vector<std::complex<double>, 1> type;
+    typedef bool mask_type;
+};
+#endif
+
+namespace SIMD_ChunkDetail
+{
+
+template <typename V, typename T>
+void load( V &v, T const *p )
+{
+    v.load( p );
+}
+
+template <typename T>
+void load( T &v, T const *p )
+{
+    v = *p;
+}
+
+template <typename V, typename T>
+void store( V const &v, T *p )
+{
+    v.store( p );
+}
+
+template <typename T>
+void store( T const &v, T *p )
+{
+    *p = v;
+}
+
+template <typename V, typename T>
+void stream( V const &v, T *p )
+{
+    v.stream( p );
+}
+
+template <typename T>
+void stream( T const &v, T *p )
+{
+    *p = v;
+}
+
+template <typename M>
+bool lane( M const &m, size_t index )
+{
+    return m[index];
+}
+
+inline bool lane( bool m, size_t )
+{
+    return m;
+}
+
+template <typename M>
+unsigned int bits( M const &m )
+{
+    return m.movemask();
+}
+
+inline unsigned int bits( bool m )
+{
+    return m ? 1u : 0u;
+}
+
+/// Apply f to count items by the array kernels of the runtime dispatch table, see Dap_Dispatch.hpp, when the
+/// selected variant has registers wider than chunk_bytes. Returns false, leaving output alone, otherwise and for the
+/// types without kernels
+template <typename T>
+bool dispatch_math( MathFunction, T const *, T *, size_t, size_t )
+{
+    return false;
+}
+
+inline bool dispatch_math( MathFunction f, float const *input, float *output, size_t count, size_t chunk_bytes )
+{
+    DispatchKernels const &k = dispatch();
+    if ( k.register_bytes <= chunk_bytes )
+    {
+        return false;
+    }
+    k.f32.math[static_cast<size_t>( f )]( input, output, count );
+    return true;
+}
+
+inline bool dispatch_math( MathFunction f, double const *input, double *output, size_t count, size_t chunk_bytes )
+{
+    DispatchKernels const &k = dispatch();
+    if ( k.register_bytes <= chunk_bytes )
+    {
+        return false;
+    }
+    k.f64.math[static_cast<size_t>( f )]( input, output, count );
+    return true;
+}
+}
+
+/**@}*/
+
+/** \addtogroup simd_mask select any all none
+ *
+ * Comparing two SIMD_Vector with ==, !=, <, <=, > or >= gives a
+ * SIMD_Mask<T,N> that holds the native comparison result, one lane per item.
+ * select( mask, a, b ) takes each lane from a where the mask is set and from
+ * b elsewhere, without branches. any(), all() and none() reduce a mask to a
+ * bool. The scalar overloads let the same code run with T = float or double,
+ * where the mask is a plain bool.
+ */
+/**@{*/
+
+inline float select( bool m, float a, float b )
+{
+    return m ? a : b;
+}
+
+inline double select( bool m, double a, double b )
+{
+    return m ? a : b;
+}
+
+inline bool any( bool m )
+{
+    return m;
+}
+
+inline bool all( bool m )
+{
+    return m;
+}
+
+inline bool none( bool m )
+{
+    return !m;
+}
+
+/// The generic mask, one chunk_mask_type per chunk of the matching SIMD_Vector, see \ref simd_chunk
+template <typename T, size_t N>
+class SIMD_Mask
+{
+  public:
+    typedef SIMD_Mask<T, N> mask_type;
+    typedef typename simd_chunk<T, N>::mask_type chunk_mask_type;
+
+    static const size_t vector_size = N;
+    static const size_t chunk_size = simd_chunk_size<T, N>::value;
+    static const size_t chunk_count = N / chunk_size;
+
+    chunk_mask_type m_chunk[chunk_count];
+
+    /// Default constructor does not initialize any values
+    SIMD_Mask()
+    {
+    }
+
+    /// Set every lane to v
+    explicit SIMD_Mask( bool v )
+    {
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            m_chunk[i] = chunk_mask_type( v );
+        }
+    }
+
+    bool operator[]( size_t index ) const
+    {
+        return SIMD_ChunkDetail::lane( m_chunk[index / chunk_size], index % chunk_size );
+    }
+
+    /// Bit i of the result is lane i, for masks of at most 32 lanes
+    unsigned int movemask() const
+    {
+        static_assert( N <= 32, "SIMD_Mask::movemask needs a mask of at most 32 lanes" );
+        unsigned int r = 0;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r |= SIMD_ChunkDetail::bits( m_chunk[i] ) << ( i * chunk_size );
+        }
+        return r;
+    }
+
+    friend bool any( mask_type const &m )
+    {
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            if ( any( m.m_chunk[i] ) )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    friend bool all( mask_type const &m )
+    {
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            if ( !all( m.m_chunk[i] ) )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool none( mask_type const &m )
+    {
+        return !any( m );
+    }
+
+    friend mask_type operator&( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] & b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator|( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] | b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator^( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] ^ b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator~( mask_type const &a )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] ^ chunk_mask_type( true );
+        }
+        return r;
+    }
+};
+
+/**@}*/
+
+/** \addtogroup simd_reduce hsum hmin hmax habsmax dot
+ *
+ * Horizontal reductions of one SIMD_Vector to a scalar. The SIMD backends
+ * fold the register in halves with shuffles, the scalar overloads return
+ * the value itself so the same code runs with T = float or double.
+ */
+/**@{*/
+
+inline float hsum( float a )
+{
+    return a;
+}
+
+inline double hsum( double a )
+{
+    return a;
+}
+
+template <typename T>
+inline std::complex<T> hsum( std::complex<T> const &a )
+{
+    return a;
+}
+
+inline float hmin( float a )
+{
+    return a;
+}
+
+inline double hmin( double a )
+{
+    return a;
+}
+
+inline float hmax( float a )
+{
+    return a;
+}
+
+inline double hmax( double a )
+{
+    return a;
+}
+
+inline float habsmax( float a )
+{
+    return std::fabs( a );
+}
+
+inline double habsmax( double a )
+{
+    return std::fabs( a );
+}
+
+inline float dot( float a, float b )
+{
+    return a * b;
+}
+
+inline double dot( double a, double b )
+{
+    return a * b;
+}
+
+/**@}*/
+
+/// \todo log10 exp10
 
 using std::sqrt;
 using std::arg;
 using std::abs;
+using std::norm;
 using std::sin;
 using std::cos;
+using std::tan;
+using std::exp;
+using std::exp2;
+using std::log;
+using std::log2;
+
+/// The alignment in bytes of a generic SIMD_Vector<T, N>: that of its chunks, so a vector of native registers is
+/// aligned to the register width, and never less than 16
+template <typename T, size_t N>
+struct simd_alignment
+    : public std::integral_constant<size_t, ( alignof( typename simd_chunk<T, N>::type ) > 16 ? alignof( typename simd_chunk<T, N>::type ) : 16 )>
+{
+};
 
 template <typename T, size_t N>
-class DAP_SIMD_ALIGN SIMD_Vector
+class alignas( simd_alignment<T, N>::value ) SIMD_Vector
 {
   public:
     /// The type of the vector
@@ -312,6 +868,12 @@ class DAP_SIMD_ALIGN SIMD_Vector
     /// The type that the vector contains
     using value_type = T;
 
+    /// The type of the result of comparing two vectors
+    typedef SIMD_Mask<T, N> mask_type;
+
+    /// The native vector, or T itself, that each chunk of items is stored in, see \ref simd_chunk
+    typedef typename simd_chunk<T, N>::type chunk_type;
+
     typedef value_type *pointer;
     typedef value_type const *const_pointer;
     typedef value_type &reference;
@@ -322,9 +884,17 @@ class DAP_SIMD_ALIGN SIMD_Vector
     typedef std::ptrdiff_t difference_type;
 
     static const size_type vector_size = N;
+    static const size_type chunk_size = simd_chunk_size<T, N>::value;
+    static const size_type chunk_count = N / chunk_size;
 
-    /// The items of the vector
-    value_type m_item[vector_size];
+    union
+    {
+        /// The items of the vector
+        value_type m_item[vector_size];
+
+        /// The items of the vector as chunks
+        chunk_type m_chunk[chunk_count];
+    };
 
     /// Default constructor does not initialize any values
     SIMD_Vector()
@@ -389,6 +959,36 @@ class DAP_SIMD_ALIGN SIMD_Vector
         return m_item;
     }
 
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            SIMD_ChunkDetail::load( m_chunk[i], p + i * chunk_size );
+        }
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            SIMD_ChunkDetail::store( m_chunk[i], p + i * chunk_size );
+        }
+    }
+
+    /// Store all items to memory aligned to the vector without loading it into the cache, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            SIMD_ChunkDetail::stream( m_chunk[i], p + i * chunk_size );
+        }
+    }
+
     /// array index operator returns a const ref to the item
     value_type const &operator[]( size_t index ) const
     {
@@ -424,18 +1024,20 @@ class DAP_SIMD_ALIGN SIMD_Vector
     /// Copy constructor
     SIMD_Vector( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            m_item[i] = other.m_item[i];
+            m_chunk[i] = other.m_chunk[i];
         }
     }
 
     /// Assignment operator
     simd_type const &operator=( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            m_item[i] = other.m_item[i];
+            m_chunk[i] = other.m_chunk[i];
         }
         return *this;
     }
@@ -515,9 +1117,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
 
     friend simd_type splat( simd_type &v, value_type a )
     {
-        for ( int i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            v.m_item[i] = a;
+            splat( v.m_chunk[i], a );
         }
         return v;
     }
@@ -536,12 +1139,37 @@ class DAP_SIMD_ALIGN SIMD_Vector
         return splat( v, t );
     }
 
+    /// a * b + c, see \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = fma( a.m_chunk[i], b.m_chunk[i], c.m_chunk[i] );
+        }
+        return r;
+    }
+
+    /// a * b - c, see \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = fms( a.m_chunk[i], b.m_chunk[i], c.m_chunk[i] );
+        }
+        return r;
+    }
+
     friend simd_type sqrt( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = sqrt( a[i] );
+            r.m_chunk[i] = sqrt( a.m_chunk[i] );
         }
         return r;
     }
@@ -549,9 +1177,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type arg( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = arg( a[i] );
+            r.m_chunk[i] = arg( a.m_chunk[i] );
         }
         return r;
     }
@@ -559,19 +1188,80 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type abs( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = abs( a.m_chunk[i] );
+        }
+        return r;
+    }
+
+    /// The squared magnitude of each item, see \ref simd_conj
+    friend simd_type norm( simd_type const &a )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = norm( a.m_chunk[i] );
+        }
+        return r;
+    }
+
+    /// The complex conjugate of each item, see \ref simd_conj
+    friend simd_type conj( simd_type const &a )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = conj( a.m_chunk[i] );
+        }
+        return r;
+    }
+
+    /// a * conj( b ), see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = abs( a[i] );
+            r.m_chunk[i] = conj_multiply( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
 
+    /// i * a for complex items, see \ref simd_conj
+    friend simd_type times_i( simd_type const &a )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = times_i( a.m_chunk[i] );
+        }
+        return r;
+    }
+
+    /// A vector of several native registers of float or double goes through the array kernels of the runtime
+    /// dispatch table for the transcendental functions when the host has wider registers than this build uses.
+    /// Returns false if it does not and r was not written
+    static bool dispatch_math( MathFunction f, simd_type const &a, simd_type &r )
+    {
+        return chunk_count > 1 && SIMD_ChunkDetail::dispatch_math( f, a.m_item, r.m_item, vector_size, sizeof( chunk_type ) );
+    }
+
     friend simd_type sin( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        if ( !dispatch_math( MathFunction::sin, a, r ) )
         {
-            r[i] = sin( a[i] );
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = sin( a.m_chunk[i] );
+            }
         }
         return r;
     }
@@ -579,9 +1269,83 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type cos( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        if ( !dispatch_math( MathFunction::cos, a, r ) )
+        {
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = cos( a.m_chunk[i] );
+            }
+        }
+        return r;
+    }
+
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        if ( !dispatch_math( MathFunction::tan, a, r ) )
         {
-            r[i] = cos( a[i] );
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = tan( a.m_chunk[i] );
+            }
+        }
+        return r;
+    }
+
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        if ( !dispatch_math( MathFunction::exp, a, r ) )
+        {
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = exp( a.m_chunk[i] );
+            }
+        }
+        return r;
+    }
+
+    friend simd_type exp2( simd_type const &a )
+    {
+        simd_type r;
+        if ( !dispatch_math( MathFunction::exp2, a, r ) )
+        {
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = exp2( a.m_chunk[i] );
+            }
+        }
+        return r;
+    }
+
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        if ( !dispatch_math( MathFunction::log, a, r ) )
+        {
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = log( a.m_chunk[i] );
+            }
+        }
+        return r;
+    }
+
+    friend simd_type log2( simd_type const &a )
+    {
+        simd_type r;
+        if ( !dispatch_math( MathFunction::log2, a, r ) )
+        {
+            DAP_UNROLL
+            for ( size_t i = 0; i < chunk_count; ++i )
+            {
+                r.m_chunk[i] = log2( a.m_chunk[i] );
+            }
         }
         return r;
     }
@@ -589,9 +1353,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type reciprocal( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = reciprocal( a[i] );
+            r.m_chunk[i] = reciprocal( a.m_chunk[i] );
         }
         return r;
     }
@@ -599,9 +1364,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator-( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = -a[i];
+            r.m_chunk[i] = -a.m_chunk[i];
         }
         return r;
     }
@@ -609,45 +1375,50 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator+( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = +a[i];
+            r.m_chunk[i] = +a.m_chunk[i];
         }
         return r;
     }
 
     friend simd_type operator+=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] += b;
+            a.m_chunk[i] += b;
         }
         return a;
     }
 
     friend simd_type operator-=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] -= b;
+            a.m_chunk[i] -= b;
         }
         return a;
     }
 
     friend simd_type operator*=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] *= b;
+            a.m_chunk[i] *= b;
         }
         return a;
     }
 
     friend simd_type operator/=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] /= b;
+            a.m_chunk[i] /= b;
         }
         return a;
     }
@@ -655,9 +1426,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator+( simd_type const &a, value_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] + b;
+            r.m_chunk[i] = a.m_chunk[i] + b;
         }
         return r;
     }
@@ -665,9 +1437,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator-( simd_type const &a, value_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] - b;
+            r.m_chunk[i] = a.m_chunk[i] - b;
         }
         return r;
     }
@@ -675,9 +1448,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator*( simd_type const &a, value_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] * b;
+            r.m_chunk[i] = a.m_chunk[i] * b;
         }
         return r;
     }
@@ -685,45 +1459,50 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator/( simd_type const &a, value_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] / b;
+            r.m_chunk[i] = a.m_chunk[i] / b;
         }
         return r;
     }
 
     friend simd_type operator+=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] += b[i];
+            a.m_chunk[i] += b.m_chunk[i];
         }
         return a;
     }
 
     friend simd_type operator-=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] -= b[i];
+            a.m_chunk[i] -= b.m_chunk[i];
         }
         return a;
     }
 
     friend simd_type operator*=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] *= b[i];
+            a.m_chunk[i] *= b.m_chunk[i];
         }
         return a;
     }
 
     friend simd_type operator/=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            a[i] /= b[i];
+            a.m_chunk[i] /= b.m_chunk[i];
         }
         return a;
     }
@@ -731,9 +1510,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator+( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] + b[i];
+            r.m_chunk[i] = a.m_chunk[i] + b.m_chunk[i];
         }
         return r;
     }
@@ -741,9 +1521,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator-( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] - b[i];
+            r.m_chunk[i] = a.m_chunk[i] - b.m_chunk[i];
         }
         return r;
     }
@@ -751,9 +1532,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator*( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] * b[i];
+            r.m_chunk[i] = a.m_chunk[i] * b.m_chunk[i];
         }
         return r;
     }
@@ -761,19 +1543,172 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type operator/( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] / b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator==( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] == b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator!=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] != b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator<( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = a[i] / b[i];
+            r.m_chunk[i] = a.m_chunk[i] < b.m_chunk[i];
         }
         return r;
     }
 
+    friend mask_type operator<=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] <= b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator>( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] > b.m_chunk[i];
+        }
+        return r;
+    }
+
+    friend mask_type operator>=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = a.m_chunk[i] >= b.m_chunk[i];
+        }
+        return r;
+    }
+
+    /// Each lane from a where m is set and from b elsewhere
+    friend simd_type select( mask_type const &m, simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
+        {
+            r.m_chunk[i] = select( m.m_chunk[i], a.m_chunk[i], b.m_chunk[i] );
+        }
+        return r;
+    }
+
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
+    {
+        chunk_type s = a.m_chunk[0];
+        DAP_UNROLL
+        for ( size_t i = 1; i < chunk_count; ++i )
+        {
+            s += a.m_chunk[i];
+        }
+        return hsum( s );
+    }
+
+    /// Smallest item
+    friend value_type hmin( simd_type const &a )
+    {
+        chunk_type s = a.m_chunk[0];
+        DAP_UNROLL
+        for ( size_t i = 1; i < chunk_count; ++i )
+        {
+            s = select( a.m_chunk[i] < s, a.m_chunk[i], s );
+        }
+        return hmin( s );
+    }
+
+    /// Largest item
+    friend value_type hmax( simd_type const &a )
+    {
+        chunk_type s = a.m_chunk[0];
+        DAP_UNROLL
+        for ( size_t i = 1; i < chunk_count; ++i )
+        {
+            s = select( a.m_chunk[i] > s, a.m_chunk[i], s );
+        }
+        return hmax( s );
+    }
+
+    /// Largest absolute value of any item
+    friend value_type habsmax( simd_type const &a )
+    {
+        chunk_type s = abs( a.m_chunk[0] );
+        DAP_UNROLL
+        for ( size_t i = 1; i < chunk_count; ++i )
+        {
+            const chunk_type v = abs( a.m_chunk[i] );
+            s = select( v > s, v, s );
+        }
+        return hmax( s );
+    }
+
+    /// Sum of the products of the items of a and b
+    friend value_type dot( simd_type const &a, simd_type const &b )
+    {
+        chunk_type s = a.m_chunk[0] * b.m_chunk[0];
+        DAP_UNROLL
+        for ( size_t i = 1; i < chunk_count; ++i )
+        {
+            s = fma( a.m_chunk[i], b.m_chunk[i], s );
+        }
+        return hsum( s );
+    }
+
+    /// Transpose the N x N matrix whose rows are rows[0..N-1]
+    friend void transpose( simd_type( &rows )[N] )
+    {
+        for ( size_t i = 0; i < N; ++i )
+        {
+            for ( size_t j = i + 1; j < N; ++j )
+            {
+                std::swap( rows[i].m_item[j], rows[j].m_item[i] );
+            }
+        }
+    }
+
     friend simd_type equal_to( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = equal_to( a[i], b[i] );
+            r.m_chunk[i] = equal_to( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
@@ -781,9 +1716,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = not_equal_to( a[i], b[i] );
+            r.m_chunk[i] = not_equal_to( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
@@ -791,9 +1727,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type less( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = less( a[i], b[i] );
+            r.m_chunk[i] = less( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
@@ -801,9 +1738,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type less_equal( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = less_equal( a[i], b[i] );
+            r.m_chunk[i] = less_equal( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
@@ -811,9 +1749,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type greater( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = greater( a[i], b[i] );
+            r.m_chunk[i] = greater( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
@@ -821,9 +1760,10 @@ class DAP_SIMD_ALIGN SIMD_Vector
     friend simd_type greater_equal( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
+        DAP_UNROLL
+        for ( size_t i = 0; i < chunk_count; ++i )
         {
-            r[i] = greater_equal( a[i], b[i] );
+            r.m_chunk[i] = greater_equal( a.m_chunk[i], b.m_chunk[i] );
         }
         return r;
     }
@@ -1032,6 +1972,41 @@ class DAP_SIMD_ALIGN SIMD_VectorRef
         return cos( v.m_ref );
     }
 
+    friend simd_type tan( simd_ref_type const &v )
+    {
+        return tan( v.m_ref );
+    }
+
+    friend simd_type exp( simd_ref_type const &v )
+    {
+        return exp( v.m_ref );
+    }
+
+    friend simd_type exp2( simd_ref_type const &v )
+    {
+        return exp2( v.m_ref );
+    }
+
+    friend simd_type log( simd_ref_type const &v )
+    {
+        return log( v.m_ref );
+    }
+
+    friend simd_type log2( simd_ref_type const &v )
+    {
+        return log2( v.m_ref );
+    }
+
+    friend simd_type fma( simd_ref_type const &a, simd_ref_type const &b, simd_ref_type const &c )
+    {
+        return fma( a.m_ref, b.m_ref, c.m_ref );
+    }
+
+    friend simd_type fms( simd_ref_type const &a, simd_ref_type const &b, simd_ref_type const &c )
+    {
+        return fms( a.m_ref, b.m_ref, c.m_ref );
+    }
+
     friend simd_type sqrt( simd_ref_type const &v )
     {
         return sqrt( v.m_ref );
@@ -1465,6 +2440,41 @@ class DAP_SIMD_ALIGN SIMD_VectorConstRef
         return cos( v.m_ref );
     }
 
+    friend simd_type tan( simd_ref_type const &v )
+    {
+        return tan( v.m_ref );
+    }
+
+    friend simd_type exp( simd_ref_type const &v )
+    {
+        return exp( v.m_ref );
+    }
+
+    friend simd_type exp2( simd_ref_type const &v )
+    {
+        return exp2( v.m_ref );
+    }
+
+    friend simd_type log( simd_ref_type const &v )
+    {
+        return log( v.m_ref );
+    }
+
+    friend simd_type log2( simd_ref_type const &v )
+    {
+        return log2( v.m_ref );
+    }
+
+    friend simd_type fma( simd_ref_type const &a, simd_ref_type const &b, simd_ref_type const &c )
+    {
+        return fma( a.m_ref, b.m_ref, c.m_ref );
+    }
+
+    friend simd_type fms( simd_ref_type const &a, simd_ref_type const &b, simd_ref_type const &c )
+    {
+        return fms( a.m_ref, b.m_ref, c.m_ref );
+    }
+
     friend simd_type sqrt( simd_ref_type const &v )
     {
         return sqrt( v.m_ref );
@@ -2075,4 +3085,4 @@ SimdT &set_flattened_item( SimdT &v, typename simd_flattened_type<SimdT>::type c
 }
 
 /**@]*/
-}
+DAP_NAMESPACE_END
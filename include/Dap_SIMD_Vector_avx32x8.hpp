@@ -35,16 +35,93 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #if defined( __AVX__ )
 #include "immintrin.h"
 
-namespace Dap
+DAP_NAMESPACE_BEGIN
+
+/// Mask holding the result of a comparison of two SIMD_Vector<float, 8>, all bits of a lane set when true
+template <>
+class SIMD_Mask<float, 8>
 {
+  public:
+    typedef SIMD_Mask<float, 8> mask_type;
+    typedef __m256 internal_type;
+
+    static const size_t vector_size = 8;
+
+    internal_type m_vec;
+
+    /// Default constructor does not initialize any values
+    SIMD_Mask()
+    {
+    }
+
+    /// Set every lane to v
+    explicit SIMD_Mask( bool v ) : m_vec( v ? _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) ) : _mm256_setzero_ps() )
+    {
+    }
+
+    bool operator[]( size_t index ) const
+    {
+        return ( movemask() >> index ) & 1;
+    }
+
+    /// Bit i of the result is lane i
+    unsigned int movemask() const
+    {
+        return static_cast<unsigned int>( _mm256_movemask_ps( m_vec ) );
+    }
+
+    friend bool any( mask_type const &m )
+    {
+        return m.movemask() != 0;
+    }
+
+    friend bool all( mask_type const &m )
+    {
+        return m.movemask() == 0xff;
+    }
+
+    friend bool none( mask_type const &m )
+    {
+        return m.movemask() == 0;
+    }
+
+    friend mask_type operator&( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_and_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator|( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_or_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator^( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_xor_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator~( mask_type const &a )
+    {
+        mask_type r;
+        r.m_vec = _mm256_xor_ps( a.m_vec, _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) ) );
+        return r;
+    }
+};
 
 template <>
-class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
+class DAP_SIMD_ALIGN_TO( 32 ) SIMD_Vector<float, 8>
 {
   public:
     typedef SIMD_Vector<float, 8> simd_type;
     typedef __m256 internal_type;
     typedef float value_type;
+    typedef SIMD_Mask<float, 8> mask_type;
 
     typedef value_type *pointer;
     typedef value_type const *const_pointer;
@@ -129,6 +206,24 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
         return m_item;
     }
 
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        m_vec = _mm256_loadu_ps( p );
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        _mm256_storeu_ps( p, m_vec );
+    }
+
+    /// Store all items to memory aligned to 32 bytes without loading it into the cache, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        _mm256_stream_ps( p, m_vec );
+    }
+
     /// array index operator returns a const ref to the item
     value_type const &operator[]( size_t index ) const
     {
@@ -162,21 +257,14 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
     }
 
     /// Copy constructor
-    SIMD_Vector( simd_type const &other )
+    SIMD_Vector( simd_type const &other ) : m_vec( other.m_vec )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
     }
 
     /// Assignment operator
     simd_type const &operator=( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
+        m_vec = other.m_vec;
         return *this;
     }
 
@@ -255,7 +343,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
 
     friend simd_type splat( simd_type &v, value_type a )
     {
-        for ( int i = 0; i < vector_size; ++i )
+        for ( size_t i = 0; i < vector_size; ++i )
         {
             v.m_item[i] = a;
         }
@@ -276,6 +364,30 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
         return splat( v, t );
     }
 
+    /// a * b + c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm256_fmadd_ps( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm256_add_ps( _mm256_mul_ps( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
+    /// a * b - c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm256_fmsub_ps( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm256_sub_ps( _mm256_mul_ps( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
     friend simd_type sqrt( simd_type const &a )
     {
         simd_type r;
@@ -288,41 +400,116 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
 
     friend simd_type arg( simd_type const &a )
     {
+        // 0 for positive values, pi for values with the sign bit set
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = arg( a[i] );
-        }
+        r.m_vec = _mm256_blendv_ps( _mm256_setzero_ps(), _mm256_set1_ps( 3.14159265358979323846f ), a.m_vec );
+        r.m_vec = _mm256_or_ps( r.m_vec, _mm256_cmp_ps( a.m_vec, a.m_vec, _CMP_UNORD_Q ) );
         return r;
     }
 
     friend simd_type abs( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = abs( a[i] );
-        }
+        r.m_vec = _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.m_vec );
         return r;
     }
 
+    /// The squared magnitude of each item, see \ref simd_conj
+    friend simd_type norm( simd_type const &a )
+    {
+        return a * a;
+    }
+
+    /// Real items are their own conjugates, see \ref simd_conj
+    friend simd_type conj( simd_type const &a )
+    {
+        return a;
+    }
+
+    /// a * conj( b ), which for real items is a * b, see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        return a * b;
+    }
+
+    /// Sine, max error 2.5 ulp for |x| <= 8192
     friend simd_type sin( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = sin( a[i] );
-        }
+        internal_type c;
+        sincos_kernel( a.m_vec, r.m_vec, c );
         return r;
     }
 
+    /// Cosine, max error 2.5 ulp for |x| <= 8192
     friend simd_type cos( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = cos( a[i] );
-        }
+        internal_type s;
+        sincos_kernel( a.m_vec, s, r.m_vec );
+        return r;
+    }
+
+    /// Tangent, max error 3.5 ulp for |x| <= 8192
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = tan_kernel( a.m_vec );
+        return r;
+    }
+
+    /// Natural exponential, max error 1 ulp. Overflows to inf and underflows through the subnormals to 0
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm256_max_ps( _mm256_set1_ps( -104.0f ), _mm256_min_ps( _mm256_set1_ps( 89.0f ), a.m_vec ) );
+        internal_type n = _mm256_round_ps( _mm256_mul_ps( x, _mm256_set1_ps( 1.44269504088896341f ) ),
+                                           _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+        x = _mm256_sub_ps( x, _mm256_mul_ps( n, _mm256_set1_ps( 0.693359375f ) ) );
+        x = _mm256_sub_ps( x, _mm256_mul_ps( n, _mm256_set1_ps( -2.12194440e-4f ) ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Base 2 exponential, max error 1.5 ulp
+    friend simd_type exp2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm256_max_ps( _mm256_set1_ps( -151.0f ), _mm256_min_ps( _mm256_set1_ps( 129.0f ), a.m_vec ) );
+        internal_type n = _mm256_round_ps( x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+        x = _mm256_mul_ps( _mm256_sub_ps( x, n ), _mm256_set1_ps( 0.693147180559945309f ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Natural logarithm, max error 1 ulp
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm256_mul_ps( x, x );
+        internal_type y = log_kernel( x, z );
+        y = _mm256_add_ps( y, _mm256_mul_ps( e, _mm256_set1_ps( -2.12194440e-4f ) ) );
+        y = _mm256_sub_ps( y, _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) );
+        x = _mm256_add_ps( x, y );
+        x = _mm256_add_ps( x, _mm256_mul_ps( e, _mm256_set1_ps( 0.693359375f ) ) );
+        r.m_vec = log_special( a.m_vec, x );
+        return r;
+    }
+
+    /// Base 2 logarithm, max error 1.5 ulp
+    friend simd_type log2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm256_mul_ps( x, x );
+        internal_type y = _mm256_sub_ps( log_kernel( x, z ), _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) );
+        internal_type log2ea = _mm256_set1_ps( 0.44269504088896340736f );
+        z = _mm256_add_ps( _mm256_mul_ps( y, log2ea ), _mm256_mul_ps( x, log2ea ) );
+        z = _mm256_add_ps( _mm256_add_ps( z, y ), _mm256_add_ps( x, e ) );
+        r.m_vec = log_special( a.m_vec, z );
         return r;
     }
 
@@ -349,10 +536,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
     friend simd_type operator-( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = -a[i];
-        }
+        r.m_vec = _mm256_xor_ps( _mm256_set1_ps( -0.0f ), a.m_vec );
         return r;
     }
 
@@ -368,216 +552,441 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 8>
 
     friend simd_type operator+=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] += b;
-        }
+        internal_type t = _mm256_set1_ps( b );
+        a.m_vec = _mm256_add_ps( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator-=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] -= b;
-        }
+        internal_type t = _mm256_set1_ps( b );
+        a.m_vec = _mm256_sub_ps( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator*=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] *= b;
-        }
+        internal_type t = _mm256_set1_ps( b );
+        a.m_vec = _mm256_mul_ps( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator/=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] /= b;
-        }
+        internal_type t = _mm256_set1_ps( b );
+        a.m_vec = _mm256_div_ps( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator+( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_ps( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] + b;
-        }
+        r.m_vec = _mm256_add_ps( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator-( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_ps( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] - b;
-        }
+        r.m_vec = _mm256_sub_ps( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator*( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_ps( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] * b;
-        }
+        r.m_vec = _mm256_mul_ps( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator/( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_ps( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] / b;
-        }
+        r.m_vec = _mm256_div_ps( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator+=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] += b[i];
-        }
+        a.m_vec = _mm256_add_ps( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator-=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] -= b[i];
-        }
+        a.m_vec = _mm256_sub_ps( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator*=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] *= b[i];
-        }
+        a.m_vec = _mm256_mul_ps( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator/=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] /= b[i];
-        }
+        a.m_vec = _mm256_div_ps( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator+( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] + b[i];
-        }
+        r.m_vec = _mm256_add_ps( a.m_vec, b.m_vec );
         return r;
     }
 
     friend simd_type operator-( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] - b[i];
-        }
+        r.m_vec = _mm256_sub_ps( a.m_vec, b.m_vec );
         return r;
     }
 
     friend simd_type operator*( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] * b[i];
-        }
+        r.m_vec = _mm256_mul_ps( a.m_vec, b.m_vec );
         return r;
     }
 
     friend simd_type operator/( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] / b[i];
-        }
+        r.m_vec = _mm256_div_ps( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator==( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_ps( a.m_vec, b.m_vec, _CMP_EQ_OQ );
         return r;
     }
 
-    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator!=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = not_equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_ps( a.m_vec, b.m_vec, _CMP_NEQ_UQ );
         return r;
     }
 
-    friend simd_type less( simd_type const &a, simd_type const &b )
+    friend mask_type operator<( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_ps( a.m_vec, b.m_vec, _CMP_LT_OQ );
         return r;
     }
 
-    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator<=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less_equal( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_ps( a.m_vec, b.m_vec, _CMP_LE_OQ );
         return r;
     }
 
-    friend simd_type greater( simd_type const &a, simd_type const &b )
+    friend mask_type operator>( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_ps( a.m_vec, b.m_vec, _CMP_GT_OQ );
         return r;
     }
 
-    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator>=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_cmp_ps( a.m_vec, b.m_vec, _CMP_GE_OQ );
+        return r;
+    }
+
+    /// Each lane from a where m is set and from b elsewhere
+    friend simd_type select( mask_type const &m, simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater_equal( a[i], b[i] );
-        }
+        r.m_vec = _mm256_blendv_ps( b.m_vec, a.m_vec, m.m_vec );
         return r;
     }
+
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
+    {
+        __m128 s = _mm_add_ps( _mm256_castps256_ps128( a.m_vec ), _mm256_extractf128_ps( a.m_vec, 1 ) );
+        s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+        s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Smallest item
+    friend value_type hmin( simd_type const &a )
+    {
+        __m128 s = _mm_min_ps( _mm256_castps256_ps128( a.m_vec ), _mm256_extractf128_ps( a.m_vec, 1 ) );
+        s = _mm_min_ps( s, _mm_movehl_ps( s, s ) );
+        s = _mm_min_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Largest item
+    friend value_type hmax( simd_type const &a )
+    {
+        __m128 s = _mm_max_ps( _mm256_castps256_ps128( a.m_vec ), _mm256_extractf128_ps( a.m_vec, 1 ) );
+        s = _mm_max_ps( s, _mm_movehl_ps( s, s ) );
+        s = _mm_max_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Largest absolute value of any item
+    friend value_type habsmax( simd_type const &a )
+    {
+        const internal_type v = _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.m_vec );
+        __m128 s = _mm_max_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+        s = _mm_max_ps( s, _mm_movehl_ps( s, s ) );
+        s = _mm_max_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Sum of the products of the items of a and b
+    friend value_type dot( simd_type const &a, simd_type const &b )
+    {
+        const internal_type v = _mm256_mul_ps( a.m_vec, b.m_vec );
+        __m128 s = _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+        s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+        s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Transpose in registers the 8x8 matrix whose rows are rows[0..7]
+    friend void transpose( simd_type( &rows )[8] )
+    {
+        const __m256 t0 = _mm256_unpacklo_ps( rows[0].m_vec, rows[1].m_vec );
+        const __m256 t1 = _mm256_unpackhi_ps( rows[0].m_vec, rows[1].m_vec );
+        const __m256 t2 = _mm256_unpacklo_ps( rows[2].m_vec, rows[3].m_vec );
+        const __m256 t3 = _mm256_unpackhi_ps( rows[2].m_vec, rows[3].m_vec );
+        const __m256 t4 = _mm256_unpacklo_ps( rows[4].m_vec, rows[5].m_vec );
+        const __m256 t5 = _mm256_unpackhi_ps( rows[4].m_vec, rows[5].m_vec );
+        const __m256 t6 = _mm256_unpacklo_ps( rows[6].m_vec, rows[7].m_vec );
+        const __m256 t7 = _mm256_unpackhi_ps( rows[6].m_vec, rows[7].m_vec );
+        const __m256 s0 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 s1 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        const __m256 s2 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 s3 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        const __m256 s4 = _mm256_shuffle_ps( t4, t6, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 s5 = _mm256_shuffle_ps( t4, t6, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        const __m256 s6 = _mm256_shuffle_ps( t5, t7, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 s7 = _mm256_shuffle_ps( t5, t7, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        rows[0].m_vec = _mm256_permute2f128_ps( s0, s4, 0x20 );
+        rows[1].m_vec = _mm256_permute2f128_ps( s1, s5, 0x20 );
+        rows[2].m_vec = _mm256_permute2f128_ps( s2, s6, 0x20 );
+        rows[3].m_vec = _mm256_permute2f128_ps( s3, s7, 0x20 );
+        rows[4].m_vec = _mm256_permute2f128_ps( s0, s4, 0x31 );
+        rows[5].m_vec = _mm256_permute2f128_ps( s1, s5, 0x31 );
+        rows[6].m_vec = _mm256_permute2f128_ps( s2, s6, 0x31 );
+        rows[7].m_vec = _mm256_permute2f128_ps( s3, s7, 0x31 );
+    }
+
+    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a == b, one( t ), zero( f ) );
+    }
+
+    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a != b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a < b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a <= b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a > b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a >= b, one( t ), zero( f ) );
+    }
+
+    /// Octant of |x| rounded up to even, as y = j and its value modulo 8
+    static internal_type octant( internal_type x, internal_type &j_mod_8 )
+    {
+        internal_type y = _mm256_mul_ps( _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( 1.27323954473516268615f ) ),
+                                                        _mm256_set1_ps( 1.0f ) ),
+                                         _mm256_set1_ps( 0.5f ) );
+        y = _mm256_add_ps( _mm256_floor_ps( y ), _mm256_floor_ps( y ) );
+        j_mod_8 = _mm256_sub_ps( y, _mm256_mul_ps( _mm256_floor_ps( _mm256_mul_ps( y, _mm256_set1_ps( 0.125f ) ) ),
+                                                   _mm256_set1_ps( 8.0f ) ) );
+        return y;
+    }
+
+    /// x - y * pi/4 in extended precision
+    static internal_type reduce( internal_type x, internal_type y )
+    {
+        x = _mm256_sub_ps( x, _mm256_mul_ps( y, _mm256_set1_ps( 0.78515625f ) ) );
+        x = _mm256_sub_ps( x, _mm256_mul_ps( y, _mm256_set1_ps( 2.4187564849853515625e-4f ) ) );
+        x = _mm256_sub_ps( x, _mm256_mul_ps( y, _mm256_set1_ps( 3.7747668102383613586e-8f ) ) );
+        return _mm256_sub_ps( x, _mm256_mul_ps( y, _mm256_set1_ps( 1.2816720341285448015e-12f ) ) );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate both the sine and cosine polynomials (Cephes sinf/cosf)
+    static void sincos_kernel( internal_type x, internal_type &s, internal_type &c )
+    {
+        internal_type sign_mask = _mm256_set1_ps( -0.0f );
+        internal_type sign_x = _mm256_and_ps( x, sign_mask );
+        x = _mm256_andnot_ps( sign_mask, x );
+
+        // octants 2,3 and 6,7 swap the polynomials, octants 4..7 negate the sine, 2..5 negate the cosine
+        internal_type j;
+        internal_type y = octant( x, j );
+        internal_type poly_mask = _mm256_or_ps( _mm256_cmp_ps( j, _mm256_set1_ps( 2.0f ), _CMP_EQ_OQ ),
+                                                _mm256_cmp_ps( j, _mm256_set1_ps( 6.0f ), _CMP_EQ_OQ ) );
+        internal_type sin_sign
+            = _mm256_xor_ps( sign_x, _mm256_and_ps( _mm256_cmp_ps( j, _mm256_set1_ps( 3.0f ), _CMP_GT_OQ ), sign_mask ) );
+        internal_type cos_sign = _mm256_and_ps( _mm256_and_ps( _mm256_cmp_ps( j, _mm256_set1_ps( 1.0f ), _CMP_GT_OQ ),
+                                                               _mm256_cmp_ps( j, _mm256_set1_ps( 5.0f ), _CMP_LT_OQ ) ),
+                                                sign_mask );
+
+        x = reduce( x, y );
+        internal_type z = _mm256_mul_ps( x, x );
+
+        internal_type yc = _mm256_set1_ps( 2.443315711809948e-5f );
+        yc = _mm256_add_ps( _mm256_mul_ps( yc, z ), _mm256_set1_ps( -1.388731625493765e-3f ) );
+        yc = _mm256_add_ps( _mm256_mul_ps( yc, z ), _mm256_set1_ps( 4.166664568298827e-2f ) );
+        yc = _mm256_mul_ps( _mm256_mul_ps( yc, z ), z );
+        yc = _mm256_sub_ps( yc, _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) );
+        yc = _mm256_add_ps( yc, _mm256_set1_ps( 1.0f ) );
+
+        internal_type ys = _mm256_set1_ps( -1.9515295891e-4f );
+        ys = _mm256_add_ps( _mm256_mul_ps( ys, z ), _mm256_set1_ps( 8.3321608736e-3f ) );
+        ys = _mm256_add_ps( _mm256_mul_ps( ys, z ), _mm256_set1_ps( -1.6666654611e-1f ) );
+        ys = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( ys, z ), x ), x );
+
+        s = _mm256_xor_ps( _mm256_blendv_ps( ys, yc, poly_mask ), sin_sign );
+        c = _mm256_xor_ps( _mm256_blendv_ps( yc, ys, poly_mask ), cos_sign );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate the tangent polynomial (Cephes tanf)
+    static internal_type tan_kernel( internal_type x )
+    {
+        internal_type sign_mask = _mm256_set1_ps( -0.0f );
+        internal_type sign_x = _mm256_and_ps( x, sign_mask );
+        x = _mm256_andnot_ps( sign_mask, x );
+
+        internal_type j;
+        internal_type y = octant( x, j );
+        internal_type recip_mask = _mm256_or_ps( _mm256_cmp_ps( j, _mm256_set1_ps( 2.0f ), _CMP_EQ_OQ ),
+                                                 _mm256_cmp_ps( j, _mm256_set1_ps( 6.0f ), _CMP_EQ_OQ ) );
+
+        x = reduce( x, y );
+        internal_type z = _mm256_mul_ps( x, x );
+
+        y = _mm256_set1_ps( 9.38540185543e-3f );
+        y = _mm256_add_ps( _mm256_mul_ps( y, z ), _mm256_set1_ps( 3.11992232697e-3f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, z ), _mm256_set1_ps( 2.44301354525e-2f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, z ), _mm256_set1_ps( 5.34112807005e-2f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, z ), _mm256_set1_ps( 1.33387994085e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, z ), _mm256_set1_ps( 3.33331568548e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( y, z ), x ), x );
+
+        // octants 2,3 and 6,7 give -1/tan
+        y = _mm256_blendv_ps( y, _mm256_div_ps( _mm256_set1_ps( -1.0f ), y ), recip_mask );
+        return _mm256_xor_ps( y, sign_x );
+    }
+
+    /// e^x for |x| <= ln(2)/2 (Cephes expf polynomial)
+    static internal_type exp_kernel( internal_type x )
+    {
+        internal_type z = _mm256_mul_ps( x, x );
+        internal_type y = _mm256_set1_ps( 1.9875691500e-4f );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 1.3981999507e-3f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 8.3334519073e-3f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 4.1665795894e-2f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 1.6666665459e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 5.0000001201e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, z ), x );
+        return _mm256_add_ps( y, _mm256_set1_ps( 1.0f ) );
+    }
+
+    /// 2^n for integer valued n in [-126,127]. n + 127 is placed in the low mantissa bits by adding 2^23,
+    /// then shifted into the exponent field
+    static internal_type pow2n( internal_type n )
+    {
+        __m256i bits = _mm256_castps_si256( _mm256_add_ps( n, _mm256_set1_ps( 8388608.0f + 127.0f ) ) );
+        __m128i lo = _mm_slli_epi32( _mm256_castsi256_si128( bits ), 23 );
+        __m128i hi = _mm_slli_epi32( _mm256_extractf128_si256( bits, 1 ), 23 );
+        return _mm256_castsi256_ps( _mm256_insertf128_si256( _mm256_castsi128_si256( lo ), hi, 1 ) );
+    }
+
+    /// y * 2^n. The scale is applied in two halves so that subnormal and overflowing results are still rounded
+    static internal_type ldexp_kernel( internal_type y, internal_type n )
+    {
+        internal_type n1 = _mm256_floor_ps( _mm256_mul_ps( n, _mm256_set1_ps( 0.5f ) ) );
+        internal_type n2 = _mm256_sub_ps( n, n1 );
+        return _mm256_mul_ps( _mm256_mul_ps( y, pow2n( n1 ) ), pow2n( n2 ) );
+    }
+
+    /// Split x into m-1 and e with x = m * 2^e and m in [sqrt(1/2),sqrt(2))
+    static internal_type log_reduce( internal_type x, internal_type &e )
+    {
+        internal_type subnormal = _mm256_cmp_ps( x, _mm256_set1_ps( FLT_MIN ), _CMP_LT_OQ );
+        x = _mm256_blendv_ps( x, _mm256_mul_ps( x, _mm256_set1_ps( 8388608.0f ) ), subnormal );
+
+        // the masked exponent field is an exact integer multiple of 2^23
+        internal_type exponent = _mm256_and_ps( x, _mm256_castsi256_ps( _mm256_set1_epi32( 0x7f800000 ) ) );
+        e = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_castps_si256( exponent ) ), _mm256_set1_ps( 1.0f / 8388608.0f ) );
+        e = _mm256_sub_ps( e, _mm256_set1_ps( 126.0f ) );
+        e = _mm256_sub_ps( e, _mm256_and_ps( subnormal, _mm256_set1_ps( 23.0f ) ) );
+        x = _mm256_or_ps( _mm256_and_ps( x, _mm256_castsi256_ps( _mm256_set1_epi32( 0x007fffff ) ) ),
+                          _mm256_castsi256_ps( _mm256_set1_epi32( 0x3f000000 ) ) );
+
+        internal_type one = _mm256_set1_ps( 1.0f );
+        internal_type small = _mm256_cmp_ps( x, _mm256_set1_ps( 0.707106781186547524f ), _CMP_LT_OQ );
+        e = _mm256_sub_ps( e, _mm256_and_ps( small, one ) );
+        return _mm256_add_ps( _mm256_sub_ps( x, one ), _mm256_and_ps( small, x ) );
+    }
+
+    /// log(1+x) - x + x^2/2 for reduced x, given z = x^2 (Cephes logf polynomial)
+    static internal_type log_kernel( internal_type x, internal_type z )
+    {
+        internal_type y = _mm256_set1_ps( 7.0376836292e-2f );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( -1.1514610310e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 1.1676998740e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( -1.2420140846e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 1.4249322787e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( -1.6668057665e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 2.0000714765e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( -2.4999993993e-1f ) );
+        y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( 3.3333331174e-1f ) );
+        return _mm256_mul_ps( _mm256_mul_ps( y, x ), z );
+    }
+
+    /// Patch the logarithm of the special inputs: 0 gives -inf, +inf gives +inf, negative and NaN give NaN
+    static internal_type log_special( internal_type a, internal_type r )
+    {
+        internal_type zero = _mm256_setzero_ps();
+        internal_type inf = _mm256_set1_ps( HUGE_VALF );
+        r = _mm256_blendv_ps( r, _mm256_sub_ps( zero, inf ), _mm256_cmp_ps( a, zero, _CMP_EQ_OQ ) );
+        r = _mm256_blendv_ps( r, inf, _mm256_cmp_ps( a, inf, _CMP_EQ_OQ ) );
+        return _mm256_or_ps( r, _mm256_cmp_ps( a, zero, _CMP_NGE_UQ ) );
+    }
 };
-}
+DAP_NAMESPACE_END
 
 #endif
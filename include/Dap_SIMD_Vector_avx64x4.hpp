@@ -35,16 +35,93 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #if defined( __AVX__ )
 #include "immintrin.h"
 
-namespace Dap
+DAP_NAMESPACE_BEGIN
+
+/// Mask holding the result of a comparison of two SIMD_Vector<double, 4>, all bits of a lane set when true
+template <>
+class SIMD_Mask<double, 4>
 {
+  public:
+    typedef SIMD_Mask<double, 4> mask_type;
+    typedef __m256d internal_type;
+
+    static const size_t vector_size = 4;
+
+    internal_type m_vec;
+
+    /// Default constructor does not initialize any values
+    SIMD_Mask()
+    {
+    }
+
+    /// Set every lane to v
+    explicit SIMD_Mask( bool v ) : m_vec( v ? _mm256_castsi256_pd( _mm256_set1_epi32( -1 ) ) : _mm256_setzero_pd() )
+    {
+    }
+
+    bool operator[]( size_t index ) const
+    {
+        return ( movemask() >> index ) & 1;
+    }
+
+    /// Bit i of the result is lane i
+    unsigned int movemask() const
+    {
+        return static_cast<unsigned int>( _mm256_movemask_pd( m_vec ) );
+    }
+
+    friend bool any( mask_type const &m )
+    {
+        return m.movemask() != 0;
+    }
+
+    friend bool all( mask_type const &m )
+    {
+        return m.movemask() == 0xf;
+    }
+
+    friend bool none( mask_type const &m )
+    {
+        return m.movemask() == 0;
+    }
+
+    friend mask_type operator&( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_and_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator|( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_or_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator^( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_xor_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator~( mask_type const &a )
+    {
+        mask_type r;
+        r.m_vec = _mm256_xor_pd( a.m_vec, _mm256_castsi256_pd( _mm256_set1_epi32( -1 ) ) );
+        return r;
+    }
+};
 
 template <>
-class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
+class DAP_SIMD_ALIGN_TO( 32 ) SIMD_Vector<double, 4>
 {
   public:
     typedef SIMD_Vector<double, 4> simd_type;
     typedef __m256d internal_type;
-    typedef float value_type;
+    typedef double value_type;
+    typedef SIMD_Mask<double, 4> mask_type;
 
     typedef value_type *pointer;
     typedef value_type const *const_pointer;
@@ -124,6 +201,24 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
         return m_item;
     }
 
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        m_vec = _mm256_loadu_pd( p );
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        _mm256_storeu_pd( p, m_vec );
+    }
+
+    /// Store all items to memory aligned to 32 bytes without loading it into the cache, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        _mm256_stream_pd( p, m_vec );
+    }
+
     /// array index operator returns a const ref to the item
     value_type const &operator[]( size_t index ) const
     {
@@ -157,21 +252,14 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
     }
 
     /// Copy constructor
-    SIMD_Vector( simd_type const &other )
+    SIMD_Vector( simd_type const &other ) : m_vec( other.m_vec )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
     }
 
     /// Assignment operator
     simd_type const &operator=( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
+        m_vec = other.m_vec;
         return *this;
     }
 
@@ -250,7 +338,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
 
     friend simd_type splat( simd_type &v, value_type a )
     {
-        for ( int i = 0; i < vector_size; ++i )
+        for ( size_t i = 0; i < vector_size; ++i )
         {
             v.m_item[i] = a;
         }
@@ -271,6 +359,30 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
         return splat( v, t );
     }
 
+    /// a * b + c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm256_fmadd_pd( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm256_add_pd( _mm256_mul_pd( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
+    /// a * b - c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm256_fmsub_pd( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm256_sub_pd( _mm256_mul_pd( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
     friend simd_type sqrt( simd_type const &a )
     {
         simd_type r;
@@ -283,41 +395,116 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
 
     friend simd_type arg( simd_type const &a )
     {
+        // 0 for positive values, pi for values with the sign bit set
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = arg( a[i] );
-        }
+        r.m_vec = _mm256_blendv_pd( _mm256_setzero_pd(), _mm256_set1_pd( 3.14159265358979323846 ), a.m_vec );
+        r.m_vec = _mm256_or_pd( r.m_vec, _mm256_cmp_pd( a.m_vec, a.m_vec, _CMP_UNORD_Q ) );
         return r;
     }
 
     friend simd_type abs( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = abs( a[i] );
-        }
+        r.m_vec = _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a.m_vec );
         return r;
     }
 
+    /// The squared magnitude of each item, see \ref simd_conj
+    friend simd_type norm( simd_type const &a )
+    {
+        return a * a;
+    }
+
+    /// Real items are their own conjugates, see \ref simd_conj
+    friend simd_type conj( simd_type const &a )
+    {
+        return a;
+    }
+
+    /// a * conj( b ), which for real items is a * b, see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        return a * b;
+    }
+
+    /// Sine, max error 2 ulp for |x| <= 2^20
     friend simd_type sin( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = sin( a[i] );
-        }
+        internal_type c;
+        sincos_kernel( a.m_vec, r.m_vec, c );
         return r;
     }
 
+    /// Cosine, max error 2 ulp for |x| <= 2^20
     friend simd_type cos( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = cos( a[i] );
-        }
+        internal_type s;
+        sincos_kernel( a.m_vec, s, r.m_vec );
+        return r;
+    }
+
+    /// Tangent, max error 2.5 ulp for |x| <= 2^20
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = tan_kernel( a.m_vec );
+        return r;
+    }
+
+    /// Natural exponential, max error 2 ulp. Overflows to inf and underflows through the subnormals to 0
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm256_max_pd( _mm256_set1_pd( -746.0 ), _mm256_min_pd( _mm256_set1_pd( 710.0 ), a.m_vec ) );
+        internal_type n = _mm256_round_pd( _mm256_mul_pd( x, _mm256_set1_pd( 1.4426950408889634073599 ) ),
+                                           _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+        x = _mm256_sub_pd( x, _mm256_mul_pd( n, _mm256_set1_pd( 6.93145751953125e-1 ) ) );
+        x = _mm256_sub_pd( x, _mm256_mul_pd( n, _mm256_set1_pd( 1.42860682030941723212e-6 ) ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Base 2 exponential, max error 2.5 ulp
+    friend simd_type exp2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm256_max_pd( _mm256_set1_pd( -1076.0 ), _mm256_min_pd( _mm256_set1_pd( 1025.0 ), a.m_vec ) );
+        internal_type n = _mm256_round_pd( x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+        x = _mm256_mul_pd( _mm256_sub_pd( x, n ), _mm256_set1_pd( 0.693147180559945309417232 ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Natural logarithm, max error 1 ulp
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm256_mul_pd( x, x );
+        internal_type y = log_kernel( x, z );
+        y = _mm256_sub_pd( y, _mm256_mul_pd( e, _mm256_set1_pd( 2.121944400546905827679e-4 ) ) );
+        y = _mm256_sub_pd( y, _mm256_mul_pd( z, _mm256_set1_pd( 0.5 ) ) );
+        x = _mm256_add_pd( x, y );
+        x = _mm256_add_pd( x, _mm256_mul_pd( e, _mm256_set1_pd( 0.693359375 ) ) );
+        r.m_vec = log_special( a.m_vec, x );
+        return r;
+    }
+
+    /// Base 2 logarithm, max error 1.5 ulp
+    friend simd_type log2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm256_mul_pd( x, x );
+        internal_type y = _mm256_sub_pd( log_kernel( x, z ), _mm256_mul_pd( z, _mm256_set1_pd( 0.5 ) ) );
+        internal_type log2ea = _mm256_set1_pd( 4.4269504088896340735992e-1 );
+        z = _mm256_add_pd( _mm256_mul_pd( y, log2ea ), _mm256_mul_pd( x, log2ea ) );
+        z = _mm256_add_pd( _mm256_add_pd( z, y ), _mm256_add_pd( x, e ) );
+        r.m_vec = log_special( a.m_vec, z );
         return r;
     }
 
@@ -344,10 +531,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
     friend simd_type operator-( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = -a[i];
-        }
+        r.m_vec = _mm256_xor_pd( _mm256_set1_pd( -0.0 ), a.m_vec );
         return r;
     }
 
@@ -363,216 +547,429 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 4>
 
     friend simd_type operator+=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] += b;
-        }
+        internal_type t = _mm256_set1_pd( b );
+        a.m_vec = _mm256_add_pd( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator-=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] -= b;
-        }
+        internal_type t = _mm256_set1_pd( b );
+        a.m_vec = _mm256_sub_pd( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator*=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] *= b;
-        }
+        internal_type t = _mm256_set1_pd( b );
+        a.m_vec = _mm256_mul_pd( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator/=( simd_type &a, value_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] /= b;
-        }
+        internal_type t = _mm256_set1_pd( b );
+        a.m_vec = _mm256_div_pd( a.m_vec, t );
         return a;
     }
 
     friend simd_type operator+( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_pd( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] + b;
-        }
+        r.m_vec = _mm256_add_pd( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator-( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_pd( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] - b;
-        }
+        r.m_vec = _mm256_sub_pd( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator*( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_pd( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] * b;
-        }
+        r.m_vec = _mm256_mul_pd( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator/( simd_type const &a, value_type const &b )
     {
+        internal_type t = _mm256_set1_pd( b );
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] / b;
-        }
+        r.m_vec = _mm256_div_pd( a.m_vec, t );
         return r;
     }
 
     friend simd_type operator+=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] += b[i];
-        }
+        a.m_vec = _mm256_add_pd( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator-=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] -= b[i];
-        }
+        a.m_vec = _mm256_sub_pd( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator*=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] *= b[i];
-        }
+        a.m_vec = _mm256_mul_pd( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator/=( simd_type &a, simd_type const &b )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            a[i] /= b[i];
-        }
+        a.m_vec = _mm256_div_pd( a.m_vec, b.m_vec );
         return a;
     }
 
     friend simd_type operator+( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] + b[i];
-        }
+        r.m_vec = _mm256_add_pd( a.m_vec, b.m_vec );
         return r;
     }
 
     friend simd_type operator-( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] - b[i];
-        }
+        r.m_vec = _mm256_sub_pd( a.m_vec, b.m_vec );
         return r;
     }
 
     friend simd_type operator*( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] * b[i];
-        }
+        r.m_vec = _mm256_mul_pd( a.m_vec, b.m_vec );
         return r;
     }
 
     friend simd_type operator/( simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = a[i] / b[i];
-        }
+        r.m_vec = _mm256_div_pd( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator==( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_pd( a.m_vec, b.m_vec, _CMP_EQ_OQ );
         return r;
     }
 
-    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator!=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = not_equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_pd( a.m_vec, b.m_vec, _CMP_NEQ_UQ );
         return r;
     }
 
-    friend simd_type less( simd_type const &a, simd_type const &b )
+    friend mask_type operator<( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_pd( a.m_vec, b.m_vec, _CMP_LT_OQ );
         return r;
     }
 
-    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator<=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less_equal( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_pd( a.m_vec, b.m_vec, _CMP_LE_OQ );
         return r;
     }
 
-    friend simd_type greater( simd_type const &a, simd_type const &b )
+    friend mask_type operator>( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm256_cmp_pd( a.m_vec, b.m_vec, _CMP_GT_OQ );
         return r;
     }
 
-    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator>=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm256_cmp_pd( a.m_vec, b.m_vec, _CMP_GE_OQ );
+        return r;
+    }
+
+    /// Each lane from a where m is set and from b elsewhere
+    friend simd_type select( mask_type const &m, simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater_equal( a[i], b[i] );
-        }
+        r.m_vec = _mm256_blendv_pd( b.m_vec, a.m_vec, m.m_vec );
         return r;
     }
+
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
+    {
+        __m128d s = _mm_add_pd( _mm256_castpd256_pd128( a.m_vec ), _mm256_extractf128_pd( a.m_vec, 1 ) );
+        s = _mm_add_sd( s, _mm_unpackhi_pd( s, s ) );
+        return _mm_cvtsd_f64( s );
+    }
+
+    /// Smallest item
+    friend value_type hmin( simd_type const &a )
+    {
+        __m128d s = _mm_min_pd( _mm256_castpd256_pd128( a.m_vec ), _mm256_extractf128_pd( a.m_vec, 1 ) );
+        s = _mm_min_sd( s, _mm_unpackhi_pd( s, s ) );
+        return _mm_cvtsd_f64( s );
+    }
+
+    /// Largest item
+    friend value_type hmax( simd_type const &a )
+    {
+        __m128d s = _mm_max_pd( _mm256_castpd256_pd128( a.m_vec ), _mm256_extractf128_pd( a.m_vec, 1 ) );
+        s = _mm_max_sd( s, _mm_unpackhi_pd( s, s ) );
+        return _mm_cvtsd_f64( s );
+    }
+
+    /// Largest absolute value of any item
+    friend value_type habsmax( simd_type const &a )
+    {
+        const internal_type v = _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a.m_vec );
+        __m128d s = _mm_max_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+        s = _mm_max_sd( s, _mm_unpackhi_pd( s, s ) );
+        return _mm_cvtsd_f64( s );
+    }
+
+    /// Sum of the products of the items of a and b
+    friend value_type dot( simd_type const &a, simd_type const &b )
+    {
+        const internal_type v = _mm256_mul_pd( a.m_vec, b.m_vec );
+        __m128d s = _mm_add_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+        s = _mm_add_sd( s, _mm_unpackhi_pd( s, s ) );
+        return _mm_cvtsd_f64( s );
+    }
+
+    /// Transpose in registers the 4x4 matrix whose rows are rows[0..3]
+    friend void transpose( simd_type( &rows )[4] )
+    {
+        const __m256d t0 = _mm256_unpacklo_pd( rows[0].m_vec, rows[1].m_vec );
+        const __m256d t1 = _mm256_unpackhi_pd( rows[0].m_vec, rows[1].m_vec );
+        const __m256d t2 = _mm256_unpacklo_pd( rows[2].m_vec, rows[3].m_vec );
+        const __m256d t3 = _mm256_unpackhi_pd( rows[2].m_vec, rows[3].m_vec );
+        rows[0].m_vec = _mm256_permute2f128_pd( t0, t2, 0x20 );
+        rows[1].m_vec = _mm256_permute2f128_pd( t1, t3, 0x20 );
+        rows[2].m_vec = _mm256_permute2f128_pd( t0, t2, 0x31 );
+        rows[3].m_vec = _mm256_permute2f128_pd( t1, t3, 0x31 );
+    }
+
+    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a == b, one( t ), zero( f ) );
+    }
+
+    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a != b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a < b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a <= b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a > b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a >= b, one( t ), zero( f ) );
+    }
+
+    /// Octant of |x| rounded up to even, as y = j and its value modulo 8
+    static internal_type octant( internal_type x, internal_type &j_mod_8 )
+    {
+        internal_type y = _mm256_mul_pd( _mm256_add_pd( _mm256_mul_pd( x, _mm256_set1_pd( 1.27323954473516268615 ) ),
+                                                        _mm256_set1_pd( 1.0 ) ),
+                                         _mm256_set1_pd( 0.5 ) );
+        y = _mm256_add_pd( _mm256_floor_pd( y ), _mm256_floor_pd( y ) );
+        j_mod_8 = _mm256_sub_pd( y, _mm256_mul_pd( _mm256_floor_pd( _mm256_mul_pd( y, _mm256_set1_pd( 0.125 ) ) ),
+                                                   _mm256_set1_pd( 8.0 ) ) );
+        return y;
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate both the sine and cosine polynomials (Cephes sin/cos)
+    static void sincos_kernel( internal_type x, internal_type &s, internal_type &c )
+    {
+        internal_type sign_mask = _mm256_set1_pd( -0.0 );
+        internal_type sign_x = _mm256_and_pd( x, sign_mask );
+        x = _mm256_andnot_pd( sign_mask, x );
+
+        // octants 2,3 and 6,7 swap the polynomials, octants 4..7 negate the sine, 2..5 negate the cosine
+        internal_type j;
+        internal_type y = octant( x, j );
+        internal_type poly_mask = _mm256_or_pd( _mm256_cmp_pd( j, _mm256_set1_pd( 2.0 ), _CMP_EQ_OQ ),
+                                                _mm256_cmp_pd( j, _mm256_set1_pd( 6.0 ), _CMP_EQ_OQ ) );
+        internal_type sin_sign
+            = _mm256_xor_pd( sign_x, _mm256_and_pd( _mm256_cmp_pd( j, _mm256_set1_pd( 3.0 ), _CMP_GT_OQ ), sign_mask ) );
+        internal_type cos_sign = _mm256_and_pd( _mm256_and_pd( _mm256_cmp_pd( j, _mm256_set1_pd( 1.0 ), _CMP_GT_OQ ),
+                                                               _mm256_cmp_pd( j, _mm256_set1_pd( 5.0 ), _CMP_LT_OQ ) ),
+                                                sign_mask );
+
+        // extended precision modular arithmetic
+        x = _mm256_sub_pd( x, _mm256_mul_pd( y, _mm256_set1_pd( 7.85398125648498535156e-1 ) ) );
+        x = _mm256_sub_pd( x, _mm256_mul_pd( y, _mm256_set1_pd( 3.77489470793079817668e-8 ) ) );
+        x = _mm256_sub_pd( x, _mm256_mul_pd( y, _mm256_set1_pd( 2.69515142907905952645e-15 ) ) );
+        internal_type z = _mm256_mul_pd( x, x );
+
+        internal_type yc = _mm256_set1_pd( -1.13585365213876817300e-11 );
+        yc = _mm256_add_pd( _mm256_mul_pd( yc, z ), _mm256_set1_pd( 2.08757008419747316778e-9 ) );
+        yc = _mm256_add_pd( _mm256_mul_pd( yc, z ), _mm256_set1_pd( -2.75573141792967388112e-7 ) );
+        yc = _mm256_add_pd( _mm256_mul_pd( yc, z ), _mm256_set1_pd( 2.48015872888517045348e-5 ) );
+        yc = _mm256_add_pd( _mm256_mul_pd( yc, z ), _mm256_set1_pd( -1.38888888888730564116e-3 ) );
+        yc = _mm256_add_pd( _mm256_mul_pd( yc, z ), _mm256_set1_pd( 4.16666666666665929218e-2 ) );
+        yc = _mm256_mul_pd( _mm256_mul_pd( yc, z ), z );
+        yc = _mm256_add_pd( _mm256_sub_pd( _mm256_set1_pd( 1.0 ), _mm256_mul_pd( z, _mm256_set1_pd( 0.5 ) ) ), yc );
+
+        internal_type ys = _mm256_set1_pd( 1.58962301576546568060e-10 );
+        ys = _mm256_add_pd( _mm256_mul_pd( ys, z ), _mm256_set1_pd( -2.50507477628578072866e-8 ) );
+        ys = _mm256_add_pd( _mm256_mul_pd( ys, z ), _mm256_set1_pd( 2.75573136213857245213e-6 ) );
+        ys = _mm256_add_pd( _mm256_mul_pd( ys, z ), _mm256_set1_pd( -1.98412698295895385996e-4 ) );
+        ys = _mm256_add_pd( _mm256_mul_pd( ys, z ), _mm256_set1_pd( 8.33333333332211858878e-3 ) );
+        ys = _mm256_add_pd( _mm256_mul_pd( ys, z ), _mm256_set1_pd( -1.66666666666666307295e-1 ) );
+        ys = _mm256_add_pd( _mm256_mul_pd( _mm256_mul_pd( ys, z ), x ), x );
+
+        s = _mm256_xor_pd( _mm256_blendv_pd( ys, yc, poly_mask ), sin_sign );
+        c = _mm256_xor_pd( _mm256_blendv_pd( yc, ys, poly_mask ), cos_sign );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate the tangent rational approximation (Cephes tan)
+    static internal_type tan_kernel( internal_type x )
+    {
+        internal_type sign_mask = _mm256_set1_pd( -0.0 );
+        internal_type sign_x = _mm256_and_pd( x, sign_mask );
+        x = _mm256_andnot_pd( sign_mask, x );
+
+        internal_type j;
+        internal_type y = octant( x, j );
+        internal_type recip_mask = _mm256_or_pd( _mm256_cmp_pd( j, _mm256_set1_pd( 2.0 ), _CMP_EQ_OQ ),
+                                                 _mm256_cmp_pd( j, _mm256_set1_pd( 6.0 ), _CMP_EQ_OQ ) );
+
+        x = _mm256_sub_pd( x, _mm256_mul_pd( y, _mm256_set1_pd( 7.853981554508209228515625e-1 ) ) );
+        x = _mm256_sub_pd( x, _mm256_mul_pd( y, _mm256_set1_pd( 7.94662735614792836714e-9 ) ) );
+        x = _mm256_sub_pd( x, _mm256_mul_pd( y, _mm256_set1_pd( 3.06161699786838294307e-17 ) ) );
+        internal_type z = _mm256_mul_pd( x, x );
+
+        internal_type p = _mm256_set1_pd( -1.30936939181383777646e4 );
+        p = _mm256_add_pd( _mm256_mul_pd( p, z ), _mm256_set1_pd( 1.15351664838587416140e6 ) );
+        p = _mm256_add_pd( _mm256_mul_pd( p, z ), _mm256_set1_pd( -1.79565251976484877988e7 ) );
+        internal_type q = _mm256_add_pd( z, _mm256_set1_pd( 1.36812963470692954678e4 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( -1.32089234440210967447e6 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( 2.50083801823357915839e7 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( -5.38695755929454629881e7 ) );
+        y = _mm256_add_pd( x, _mm256_mul_pd( x, _mm256_div_pd( _mm256_mul_pd( z, p ), q ) ) );
+
+        // octants 2,3 and 6,7 give -1/tan
+        y = _mm256_blendv_pd( y, _mm256_div_pd( _mm256_set1_pd( -1.0 ), y ), recip_mask );
+        return _mm256_xor_pd( y, sign_x );
+    }
+
+    /// e^x for |x| <= ln(2)/2 (Cephes exp Pade approximation)
+    static internal_type exp_kernel( internal_type x )
+    {
+        internal_type xx = _mm256_mul_pd( x, x );
+        internal_type p = _mm256_set1_pd( 1.26177193074810590878e-4 );
+        p = _mm256_add_pd( _mm256_mul_pd( p, xx ), _mm256_set1_pd( 3.02994407707441961300e-2 ) );
+        p = _mm256_add_pd( _mm256_mul_pd( p, xx ), _mm256_set1_pd( 9.99999999999999999910e-1 ) );
+        p = _mm256_mul_pd( p, x );
+        internal_type q = _mm256_set1_pd( 3.00198505138664455042e-6 );
+        q = _mm256_add_pd( _mm256_mul_pd( q, xx ), _mm256_set1_pd( 2.52448340349684104192e-3 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, xx ), _mm256_set1_pd( 2.27265548208155028766e-1 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, xx ), _mm256_set1_pd( 2.00000000000000000009e0 ) );
+        x = _mm256_div_pd( p, _mm256_sub_pd( q, p ) );
+        return _mm256_add_pd( _mm256_set1_pd( 1.0 ), _mm256_add_pd( x, x ) );
+    }
+
+    /// 2^n for integer valued n in [-1022,1023]. n + 1023 is placed in the low mantissa bits by adding 2^52,
+    /// then shifted into the exponent field
+    static internal_type pow2n( internal_type n )
+    {
+        __m256i bits = _mm256_castpd_si256( _mm256_add_pd( n, _mm256_set1_pd( 4503599627370496.0 + 1023.0 ) ) );
+        __m128i lo = _mm_slli_epi64( _mm256_castsi256_si128( bits ), 52 );
+        __m128i hi = _mm_slli_epi64( _mm256_extractf128_si256( bits, 1 ), 52 );
+        return _mm256_castsi256_pd( _mm256_insertf128_si256( _mm256_castsi128_si256( lo ), hi, 1 ) );
+    }
+
+    /// y * 2^n. The scale is applied in two halves so that subnormal and overflowing results are still rounded
+    static internal_type ldexp_kernel( internal_type y, internal_type n )
+    {
+        internal_type n1 = _mm256_floor_pd( _mm256_mul_pd( n, _mm256_set1_pd( 0.5 ) ) );
+        internal_type n2 = _mm256_sub_pd( n, n1 );
+        return _mm256_mul_pd( _mm256_mul_pd( y, pow2n( n1 ) ), pow2n( n2 ) );
+    }
+
+    /// Split x into m-1 and e with x = m * 2^e and m in [sqrt(1/2),sqrt(2))
+    static internal_type log_reduce( internal_type x, internal_type &e )
+    {
+        internal_type subnormal = _mm256_cmp_pd( x, _mm256_set1_pd( DBL_MIN ), _CMP_LT_OQ );
+        x = _mm256_blendv_pd( x, _mm256_mul_pd( x, _mm256_set1_pd( 18014398509481984.0 ) ), subnormal );
+
+        // gather the high 32 bits of each lane, which hold the exponent field
+        __m128 lo = _mm256_castps256_ps128( _mm256_castpd_ps( x ) );
+        __m128 hi = _mm256_extractf128_ps( _mm256_castpd_ps( x ), 1 );
+        __m128i high = _mm_and_si128( _mm_castps_si128( _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ),
+                                      _mm_set1_epi32( 0x7ff00000 ) );
+        e = _mm256_sub_pd( _mm256_mul_pd( _mm256_cvtepi32_pd( high ), _mm256_set1_pd( 1.0 / 1048576.0 ) ),
+                           _mm256_set1_pd( 1022.0 ) );
+        e = _mm256_sub_pd( e, _mm256_and_pd( subnormal, _mm256_set1_pd( 54.0 ) ) );
+        x = _mm256_or_pd( _mm256_and_pd( x, _mm256_castsi256_pd( _mm256_set1_epi64x( 0x000fffffffffffffLL ) ) ),
+                          _mm256_castsi256_pd( _mm256_set1_epi64x( 0x3fe0000000000000LL ) ) );
+
+        internal_type one = _mm256_set1_pd( 1.0 );
+        internal_type small = _mm256_cmp_pd( x, _mm256_set1_pd( 0.70710678118654752440 ), _CMP_LT_OQ );
+        e = _mm256_sub_pd( e, _mm256_and_pd( small, one ) );
+        return _mm256_add_pd( _mm256_sub_pd( x, one ), _mm256_and_pd( small, x ) );
+    }
+
+    /// log(1+x) - x + x^2/2 for reduced x, given z = x^2 (Cephes log rational approximation)
+    static internal_type log_kernel( internal_type x, internal_type z )
+    {
+        internal_type p = _mm256_set1_pd( 1.01875663804580931796e-4 );
+        p = _mm256_add_pd( _mm256_mul_pd( p, x ), _mm256_set1_pd( 4.97494994976747001425e-1 ) );
+        p = _mm256_add_pd( _mm256_mul_pd( p, x ), _mm256_set1_pd( 4.70579119878881725854e0 ) );
+        p = _mm256_add_pd( _mm256_mul_pd( p, x ), _mm256_set1_pd( 1.44989225341610930846e1 ) );
+        p = _mm256_add_pd( _mm256_mul_pd( p, x ), _mm256_set1_pd( 1.79368678507819816313e1 ) );
+        p = _mm256_add_pd( _mm256_mul_pd( p, x ), _mm256_set1_pd( 7.70838733755885391666e0 ) );
+        internal_type q = _mm256_add_pd( x, _mm256_set1_pd( 1.12873587189167450590e1 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, x ), _mm256_set1_pd( 4.52279145837532221105e1 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, x ), _mm256_set1_pd( 8.29875266912776603211e1 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, x ), _mm256_set1_pd( 7.11544750618563894466e1 ) );
+        q = _mm256_add_pd( _mm256_mul_pd( q, x ), _mm256_set1_pd( 2.31251620126765340583e1 ) );
+        return _mm256_mul_pd( x, _mm256_div_pd( _mm256_mul_pd( z, p ), q ) );
+    }
+
+    /// Patch the logarithm of the special inputs: 0 gives -inf, +inf gives +inf, negative and NaN give NaN
+    static internal_type log_special( internal_type a, internal_type r )
+    {
+        internal_type zero = _mm256_setzero_pd();
+        internal_type inf = _mm256_set1_pd( HUGE_VAL );
+        r = _mm256_blendv_pd( r, _mm256_sub_pd( zero, inf ), _mm256_cmp_pd( a, zero, _CMP_EQ_OQ ) );
+        r = _mm256_blendv_pd( r, inf, _mm256_cmp_pd( a, inf, _CMP_EQ_OQ ) );
+        return _mm256_or_pd( r, _mm256_cmp_pd( a, zero, _CMP_NGE_UQ ) );
+    }
 };
-}
+DAP_NAMESPACE_END
 
 #endif
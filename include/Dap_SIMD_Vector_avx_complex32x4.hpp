@@ -0,0 +1,603 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_SIMD_Vector_complex.hpp"
+#include "Dap_SIMD_Vector_avx32x8.hpp"
+
+#if defined( __AVX__ )
+#include "immintrin.h"
+
+DAP_NAMESPACE_BEGIN
+
+/// Four std::complex<float> interleaved in one __m256, see \ref simd_complex
+template <>
+class DAP_SIMD_ALIGN_TO( 32 ) SIMD_Vector<std::complex<float>, 4>
+{
+  public:
+    typedef SIMD_Vector<std::complex<float>, 4> simd_type;
+    typedef __m256 internal_type;
+    typedef std::complex<float> value_type;
+
+    /// The real vector of the interleaved real and imaginary parts
+    typedef SIMD_Vector<float, 8> parts_type;
+
+    typedef value_type *pointer;
+    typedef value_type const *const_pointer;
+    typedef value_type &reference;
+    typedef value_type const &const_reference;
+    typedef pointer iterator;
+    typedef const_pointer const_iterator;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    static const size_type vector_size = 4;
+
+    union
+    {
+        internal_type m_vec;
+        value_type m_item[vector_size];
+    };
+
+    /// Default constructor does not initialize any values
+    SIMD_Vector()
+    {
+    }
+
+    /// The Initializer list constructor sets the values
+    SIMD_Vector( value_type p1, value_type p2, value_type p3, value_type p4 )
+    {
+        m_item[0] = p1;
+        m_item[1] = p2;
+        m_item[2] = p3;
+        m_item[3] = p4;
+    }
+
+    /// Get the vector size
+    size_type size() const
+    {
+        return vector_size;
+    }
+
+    /// Get the vector maximum size
+    size_type max_size() const
+    {
+        return vector_size;
+    }
+
+    /// Is it empty
+    bool empty() const
+    {
+        return false;
+    }
+
+    /// Fill with a specific value
+    void fill( value_type const &a )
+    {
+        splat( *this, a );
+    }
+
+    /// Swap values in container with the other
+    void swap( simd_type &other ) noexcept
+    {
+        internal_type t = m_vec;
+        m_vec = other.m_vec;
+        other.m_vec = t;
+    }
+
+    /// Get underlying array
+    pointer data()
+    {
+        return m_item;
+    }
+
+    /// Get underlying array const
+    const_pointer data() const
+    {
+        return m_item;
+    }
+
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        m_vec = _mm256_loadu_ps( reinterpret_cast<float const *>( p ) );
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        _mm256_storeu_ps( reinterpret_cast<float *>( p ), m_vec );
+    }
+
+    /// Store all items to memory aligned to 32 bytes without loading it into the cache, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        _mm256_stream_ps( reinterpret_cast<float *>( p ), m_vec );
+    }
+
+    /// array index operator returns a const ref to the item
+    value_type const &operator[]( size_t index ) const
+    {
+        return m_item[index];
+    }
+
+    /// at() returns a non-const ref to the item, with range checking
+    value_type &at( size_t index )
+    {
+        if ( index > size() )
+        {
+            throw std::out_of_range( "SIMD_Vector" );
+        }
+        return m_item[index];
+    }
+
+    /// at() returns a const ref to the item, with range checking
+    value_type const &at( size_t index ) const
+    {
+        if ( index > size() )
+        {
+            throw std::out_of_range( "SIMD_Vector" );
+        }
+        return m_item[index];
+    }
+
+    /// array index operator returns a non-const ref to the item
+    value_type &operator[]( size_t index )
+    {
+        return m_item[index];
+    }
+
+    /// Copy constructor
+    SIMD_Vector( simd_type const &other ) : m_vec( other.m_vec )
+    {
+    }
+
+    /// Assignment operator
+    simd_type const &operator=( simd_type const &other )
+    {
+        m_vec = other.m_vec;
+        return *this;
+    }
+
+    /// Get the first item
+    reference front()
+    {
+        return m_item[0];
+    }
+
+    /// Get the first item (const)
+    const_reference front() const
+    {
+        return m_item[0];
+    }
+
+    /// Get the last item
+    reference back()
+    {
+        return m_item[vector_size - 1];
+    }
+
+    /// Get the last item (const)
+    const_reference back() const
+    {
+        return m_item[vector_size - 1];
+    }
+
+    /// Get the iterator for the beginning
+    iterator begin()
+    {
+        return &m_item[0];
+    }
+
+    /// Get the const_iterator for the beginning
+    const_iterator begin() const
+    {
+        return &m_item[0];
+    }
+
+    /// Get the const_iterator for the beginning
+    const_iterator cbegin() const
+    {
+        return &m_item[0];
+    }
+
+    /// Get the iterator for the end (one item past the last item)
+    iterator end()
+    {
+        return &m_item[vector_size];
+    }
+
+    /// Get the const_iterator for the end (one item past the last item)
+    const_iterator end() const
+    {
+        return &m_item[vector_size];
+    }
+
+    /// Get the const_iterator for the end (one item past the last item)
+    const_iterator cend() const
+    {
+        return &m_item[vector_size];
+    }
+
+    /// Output the vector to the ostream
+    template <typename CharT, typename TraitsT>
+    friend std::basic_ostream<CharT, TraitsT> &operator<<( std::basic_ostream<CharT, TraitsT> &str, simd_type const &a )
+    {
+        str << "{ ";
+        for ( auto i = std::begin( a ); i != std::end( a ); ++i )
+        {
+            str << *i << " ";
+        }
+        str << " }";
+        return str;
+    }
+
+    friend simd_type splat( simd_type &v, value_type const &a )
+    {
+        v.m_vec = _mm256_setr_ps( a.real(), a.imag(), a.real(), a.imag(), a.real(), a.imag(), a.real(), a.imag() );
+        return v;
+    }
+
+    friend simd_type zero( simd_type &v )
+    {
+        v.m_vec = _mm256_setzero_ps();
+        return v;
+    }
+
+    friend simd_type one( simd_type &v )
+    {
+        v.m_vec = _mm256_setr_ps( 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f );
+        return v;
+    }
+
+    /// a * b + c, the complex multiply accumulate, fused when built with FMA. See \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+        r.m_vec = fma_kernel( a.m_vec, b.m_vec, c.m_vec );
+        return r;
+    }
+
+    /// a * b - c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+        r.m_vec = fma_kernel( a.m_vec, b.m_vec, _mm256_xor_ps( c.m_vec, _mm256_set1_ps( -0.0f ) ) );
+        return r;
+    }
+
+    /// a * conj( b ), see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        r.m_vec = multiply_kernel( a.m_vec, conj_kernel( b.m_vec ) );
+        return r;
+    }
+
+    /// i * a, see \ref simd_conj
+    friend simd_type times_i( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = _mm256_xor_ps( swap_parts( a.m_vec ), _mm256_setr_ps( -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f ) );
+        return r;
+    }
+
+    friend simd_type conj( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = conj_kernel( a.m_vec );
+        return r;
+    }
+
+    /// The squared magnitude of each item, as the real part
+    friend simd_type norm( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = _mm256_and_ps( norm_kernel( a.m_vec ), real_mask() );
+        return r;
+    }
+
+    /// The magnitude of each item, as the real part. sqrt( norm( a ) ) so without the overflow protection of std::abs
+    friend simd_type abs( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = _mm256_sqrt_ps( _mm256_and_ps( norm_kernel( a.m_vec ), real_mask() ) );
+        return r;
+    }
+
+    /// The phase of each item, as the real part, see atan2
+    friend simd_type arg( simd_type const &a )
+    {
+        parts_type re, im;
+        re.m_vec = real_parts( a.m_vec );
+        im.m_vec = imag_parts( a.m_vec );
+        simd_type r;
+        r.m_vec = _mm256_and_ps( atan2( im, re ).m_vec, real_mask() );
+        return r;
+    }
+
+    friend simd_type sqrt( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = sqrt( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type sin( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = sin( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type cos( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = cos( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = tan( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = exp( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = log( a[i] );
+        }
+        return r;
+    }
+
+    /// conj( a ) / norm( a )
+    friend simd_type reciprocal( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = _mm256_div_ps( conj_kernel( a.m_vec ), norm_kernel( a.m_vec ) );
+        return r;
+    }
+
+    friend simd_type operator-( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = _mm256_xor_ps( _mm256_set1_ps( -0.0f ), a.m_vec );
+        return r;
+    }
+
+    friend simd_type operator+( simd_type const &a )
+    {
+        return a;
+    }
+
+    friend simd_type operator+=( simd_type &a, value_type const &b )
+    {
+        simd_type t;
+        a.m_vec = _mm256_add_ps( a.m_vec, splat( t, b ).m_vec );
+        return a;
+    }
+
+    friend simd_type operator-=( simd_type &a, value_type const &b )
+    {
+        simd_type t;
+        a.m_vec = _mm256_sub_ps( a.m_vec, splat( t, b ).m_vec );
+        return a;
+    }
+
+    friend simd_type operator*=( simd_type &a, value_type const &b )
+    {
+        simd_type t;
+        a.m_vec = multiply_kernel( a.m_vec, splat( t, b ).m_vec );
+        return a;
+    }
+
+    friend simd_type operator/=( simd_type &a, value_type const &b )
+    {
+        simd_type t;
+        a = a / splat( t, b );
+        return a;
+    }
+
+    friend simd_type operator+( simd_type const &a, value_type const &b )
+    {
+        simd_type r;
+        r.m_vec = _mm256_add_ps( a.m_vec, splat( r, b ).m_vec );
+        return r;
+    }
+
+    friend simd_type operator-( simd_type const &a, value_type const &b )
+    {
+        simd_type r;
+        r.m_vec = _mm256_sub_ps( a.m_vec, splat( r, b ).m_vec );
+        return r;
+    }
+
+    friend simd_type operator*( simd_type const &a, value_type const &b )
+    {
+        simd_type r;
+        r.m_vec = multiply_kernel( a.m_vec, splat( r, b ).m_vec );
+        return r;
+    }
+
+    friend simd_type operator/( simd_type const &a, value_type const &b )
+    {
+        simd_type t;
+        return a / splat( t, b );
+    }
+
+    friend simd_type operator+=( simd_type &a, simd_type const &b )
+    {
+        a.m_vec = _mm256_add_ps( a.m_vec, b.m_vec );
+        return a;
+    }
+
+    friend simd_type operator-=( simd_type &a, simd_type const &b )
+    {
+        a.m_vec = _mm256_sub_ps( a.m_vec, b.m_vec );
+        return a;
+    }
+
+    friend simd_type operator*=( simd_type &a, simd_type const &b )
+    {
+        a.m_vec = multiply_kernel( a.m_vec, b.m_vec );
+        return a;
+    }
+
+    friend simd_type operator/=( simd_type &a, simd_type const &b )
+    {
+        a = a / b;
+        return a;
+    }
+
+    friend simd_type operator+( simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        r.m_vec = _mm256_add_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend simd_type operator-( simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        r.m_vec = _mm256_sub_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend simd_type operator*( simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        r.m_vec = multiply_kernel( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    /// a * conj( b ) / norm( b ), without the rescaling std::complex does to avoid overflow
+    friend simd_type operator/( simd_type const &a, simd_type const &b )
+    {
+        simd_type r;
+        r.m_vec = _mm256_div_ps( multiply_kernel( a.m_vec, conj_kernel( b.m_vec ) ), norm_kernel( b.m_vec ) );
+        return r;
+    }
+
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
+    {
+        __m128 s = _mm_add_ps( _mm256_castps256_ps128( a.m_vec ), _mm256_extractf128_ps( a.m_vec, 1 ) );
+        s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+        return value_type( _mm_cvtss_f32( s ), _mm_cvtss_f32( _mm_shuffle_ps( s, s, 1 ) ) );
+    }
+
+    /// All bits set in the real parts, clear in the imaginary parts
+    static internal_type real_mask()
+    {
+        return _mm256_castsi256_ps( _mm256_setr_epi32( -1, 0, -1, 0, -1, 0, -1, 0 ) );
+    }
+
+    /// { a0.real, a0.real, a1.real, a1.real, ... }
+    static internal_type real_parts( internal_type a )
+    {
+        return _mm256_moveldup_ps( a );
+    }
+
+    /// { a0.imag, a0.imag, a1.imag, a1.imag, ... }
+    static internal_type imag_parts( internal_type a )
+    {
+        return _mm256_movehdup_ps( a );
+    }
+
+    /// { a0.imag, a0.real, a1.imag, a1.real, ... }
+    static internal_type swap_parts( internal_type a )
+    {
+        return _mm256_permute_ps( a, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+    }
+
+    static internal_type conj_kernel( internal_type a )
+    {
+        return _mm256_xor_ps( a, _mm256_setr_ps( 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f ) );
+    }
+
+    /// The squared magnitude of each item in both of its parts
+    static internal_type norm_kernel( internal_type a )
+    {
+        internal_type t = _mm256_mul_ps( a, a );
+        return _mm256_add_ps( t, swap_parts( t ) );
+    }
+
+    /// a.real * b + a.imag * swap( b ) with the products subtracted in the real parts and added in the imaginary parts
+    static internal_type multiply_kernel( internal_type a, internal_type b )
+    {
+        internal_type t = _mm256_mul_ps( imag_parts( a ), swap_parts( b ) );
+#if defined( __FMA__ )
+        return _mm256_fmaddsub_ps( real_parts( a ), b, t );
+#else
+        return _mm256_addsub_ps( _mm256_mul_ps( real_parts( a ), b ), t );
+#endif
+    }
+
+    /// a * b + c
+    static internal_type fma_kernel( internal_type a, internal_type b, internal_type c )
+    {
+#if defined( __FMA__ )
+        // a.imag * swap( b ) - c.real in the real parts, + c.imag in the imaginary parts, then a.real * b subtract/add that
+        internal_type t = _mm256_fmsubadd_ps( imag_parts( a ), swap_parts( b ), _mm256_xor_ps( c, _mm256_set1_ps( -0.0f ) ) );
+        return _mm256_fmaddsub_ps( real_parts( a ), b, t );
+#else
+        return _mm256_add_ps( multiply_kernel( a, b ), c );
+#endif
+    }
+};
+DAP_NAMESPACE_END
+#endif
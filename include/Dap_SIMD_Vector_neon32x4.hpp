@@ -35,8 +35,85 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #if defined( __ARM_NEON__ )
 #include <arm_neon.h>
 
-namespace Dap
+DAP_NAMESPACE_BEGIN
+
+/// Mask holding the result of a comparison of two SIMD_Vector<float, 4>, all bits of a lane set when true
+template <>
+class SIMD_Mask<float, 4>
 {
+  public:
+    typedef SIMD_Mask<float, 4> mask_type;
+    typedef uint32x4_t internal_type;
+
+    static const size_t vector_size = 4;
+
+    internal_type m_vec;
+
+    /// Default constructor does not initialize any values
+    SIMD_Mask()
+    {
+    }
+
+    /// Set every lane to v
+    explicit SIMD_Mask( bool v ) : m_vec( vdupq_n_u32( v ? 0xffffffffu : 0u ) )
+    {
+    }
+
+    bool operator[]( size_t index ) const
+    {
+        return ( movemask() >> index ) & 1;
+    }
+
+    /// Bit i of the result is lane i
+    unsigned int movemask() const
+    {
+        return ( vgetq_lane_u32( m_vec, 0 ) & 1u ) | ( vgetq_lane_u32( m_vec, 1 ) & 2u )
+               | ( vgetq_lane_u32( m_vec, 2 ) & 4u ) | ( vgetq_lane_u32( m_vec, 3 ) & 8u );
+    }
+
+    friend bool any( mask_type const &m )
+    {
+        return m.movemask() != 0;
+    }
+
+    friend bool all( mask_type const &m )
+    {
+        return m.movemask() == 0xf;
+    }
+
+    friend bool none( mask_type const &m )
+    {
+        return m.movemask() == 0;
+    }
+
+    friend mask_type operator&( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = vandq_u32( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator|( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = vorrq_u32( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator^( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = veorq_u32( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator~( mask_type const &a )
+    {
+        mask_type r;
+        r.m_vec = vmvnq_u32( a.m_vec );
+        return r;
+    }
+};
 
 template <>
 class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
@@ -45,6 +122,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
     typedef SIMD_Vector<float, 4> simd_type;
     typedef float32x4_t internal_type;
     typedef float value_type;
+    typedef SIMD_Mask<float, 4> mask_type;
 
     typedef value_type *pointer;
     typedef value_type const *const_pointer;
@@ -124,6 +202,24 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return m_item;
     }
 
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        m_vec = vld1q_f32( p );
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        vst1q_f32( p, m_vec );
+    }
+
+    /// NEON has no non-temporal store, so this is store, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        vst1q_f32( p, m_vec );
+    }
+
     /// array index operator returns a const ref to the item
     value_type const &operator[]( size_t index ) const
     {
@@ -157,21 +253,14 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
     }
 
     /// Copy constructor
-    SIMD_Vector( simd_type const &other )
+    SIMD_Vector( simd_type const &other ) : m_vec( other.m_vec )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
     }
 
     /// Assignment operator
     simd_type const &operator=( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
+        m_vec = other.m_vec;
         return *this;
     }
 
@@ -250,7 +339,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
 
     friend simd_type splat( simd_type &v, value_type a )
     {
-        for ( int i = 0; i < vector_size; ++i )
+        for ( size_t i = 0; i < vector_size; ++i )
         {
             v.m_item[i] = a;
         }
@@ -271,6 +360,30 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return splat( v, t );
     }
 
+    /// a * b + c, fused when the target has VFPv4 FMA. See \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __ARM_FEATURE_FMA )
+        r.m_vec = vfmaq_f32( c.m_vec, a.m_vec, b.m_vec );
+#else
+        r.m_vec = vmlaq_f32( c.m_vec, a.m_vec, b.m_vec );
+#endif
+        return r;
+    }
+
+    /// a * b - c, fused when the target has VFPv4 FMA. See \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __ARM_FEATURE_FMA )
+        r.m_vec = vnegq_f32( vfmsq_f32( c.m_vec, a.m_vec, b.m_vec ) );
+#else
+        r.m_vec = vnegq_f32( vmlsq_f32( c.m_vec, a.m_vec, b.m_vec ) );
+#endif
+        return r;
+    }
+
     friend simd_type sqrt( simd_type const &a )
     {
         simd_type r;
@@ -298,6 +411,24 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         {
             r[i] = abs( a[i] );
         }
+
+    /// The squared magnitude of each item, see \ref simd_conj
+    friend simd_type norm( simd_type const &a )
+    {
+        return a * a;
+    }
+
+    /// Real items are their own conjugates, see \ref simd_conj
+    friend simd_type conj( simd_type const &a )
+    {
+        return a;
+    }
+
+    /// a * conj( b ), which for real items is a * b, see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        return a * b;
+    }
         return r;
     }
 
@@ -321,6 +452,56 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return r;
     }
 
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = tan( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = exp( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type exp2( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = exp2( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = log( a[i] );
+        }
+        return r;
+    }
+
+    friend simd_type log2( simd_type const &a )
+    {
+        simd_type r;
+        for ( size_t i = 0; i < vector_size; ++i )
+        {
+            r[i] = log2( a[i] );
+        }
+        return r;
+    }
+
     friend simd_type reciprocal( simd_type const &a )
     {
         simd_type r;
@@ -478,65 +659,159 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return r;
     }
 
-    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator==( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = vceqq_f32( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator!=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = not_equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = vmvnq_u32( vceqq_f32( a.m_vec, b.m_vec ) );
         return r;
     }
 
-    friend simd_type less( simd_type const &a, simd_type const &b )
+    friend mask_type operator<( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = vcltq_f32( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator<=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less_equal( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = vcleq_f32( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type greater( simd_type const &a, simd_type const &b )
+    friend mask_type operator>( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = vcgtq_f32( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator>=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = vcgeq_f32( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    /// Each lane from a where m is set and from b elsewhere
+    friend simd_type select( mask_type const &m, simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater_equal( a[i], b[i] );
-        }
+        r.m_vec = vbslq_f32( m.m_vec, a.m_vec, b.m_vec );
         return r;
     }
+
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
+    {
+#if defined( __aarch64__ )
+        return vaddvq_f32( a.m_vec );
+#else
+        float32x2_t s = vadd_f32( vget_low_f32( a.m_vec ), vget_high_f32( a.m_vec ) );
+        return vget_lane_f32( vpadd_f32( s, s ), 0 );
+#endif
+    }
+
+    /// Smallest item
+    friend value_type hmin( simd_type const &a )
+    {
+#if defined( __aarch64__ )
+        return vminvq_f32( a.m_vec );
+#else
+        float32x2_t s = vmin_f32( vget_low_f32( a.m_vec ), vget_high_f32( a.m_vec ) );
+        return vget_lane_f32( vpmin_f32( s, s ), 0 );
+#endif
+    }
+
+    /// Largest item
+    friend value_type hmax( simd_type const &a )
+    {
+#if defined( __aarch64__ )
+        return vmaxvq_f32( a.m_vec );
+#else
+        float32x2_t s = vmax_f32( vget_low_f32( a.m_vec ), vget_high_f32( a.m_vec ) );
+        return vget_lane_f32( vpmax_f32( s, s ), 0 );
+#endif
+    }
+
+    /// Largest absolute value of any item
+    friend value_type habsmax( simd_type const &a )
+    {
+        const internal_type v = vabsq_f32( a.m_vec );
+#if defined( __aarch64__ )
+        return vmaxvq_f32( v );
+#else
+        float32x2_t s = vmax_f32( vget_low_f32( v ), vget_high_f32( v ) );
+        return vget_lane_f32( vpmax_f32( s, s ), 0 );
+#endif
+    }
+
+    /// Sum of the products of the items of a and b
+    friend value_type dot( simd_type const &a, simd_type const &b )
+    {
+        const internal_type v = vmulq_f32( a.m_vec, b.m_vec );
+#if defined( __aarch64__ )
+        return vaddvq_f32( v );
+#else
+        float32x2_t s = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+        return vget_lane_f32( vpadd_f32( s, s ), 0 );
+#endif
+    }
+
+    /// Transpose in registers the 4x4 matrix whose rows are rows[0..3]
+    friend void transpose( simd_type( &rows )[4] )
+    {
+        const float32x4x2_t p01 = vtrnq_f32( rows[0].m_vec, rows[1].m_vec );
+        const float32x4x2_t p23 = vtrnq_f32( rows[2].m_vec, rows[3].m_vec );
+        rows[0].m_vec = vcombine_f32( vget_low_f32( p01.val[0] ), vget_low_f32( p23.val[0] ) );
+        rows[1].m_vec = vcombine_f32( vget_low_f32( p01.val[1] ), vget_low_f32( p23.val[1] ) );
+        rows[2].m_vec = vcombine_f32( vget_high_f32( p01.val[0] ), vget_high_f32( p23.val[0] ) );
+        rows[3].m_vec = vcombine_f32( vget_high_f32( p01.val[1] ), vget_high_f32( p23.val[1] ) );
+    }
+
+    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a == b, one( t ), zero( f ) );
+    }
+
+    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a != b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a < b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a <= b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a > b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a >= b, one( t ), zero( f ) );
+    }
 };
-}
+DAP_NAMESPACE_END
 #endif
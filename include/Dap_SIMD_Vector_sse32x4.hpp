@@ -34,9 +34,92 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #if defined( __SSE__ )
 #include "xmmintrin.h"
+#include "emmintrin.h"
+#if defined( __SSE4_1__ )
+#include "smmintrin.h"
+#endif
+#if defined( __FMA__ )
+#include "immintrin.h"
+#endif
+
+DAP_NAMESPACE_BEGIN
 
-namespace Dap
+/// Mask holding the result of a comparison of two SIMD_Vector<float, 4>, all bits of a lane set when true
+template <>
+class SIMD_Mask<float, 4>
 {
+  public:
+    typedef SIMD_Mask<float, 4> mask_type;
+    typedef __m128 internal_type;
+
+    static const size_t vector_size = 4;
+
+    internal_type m_vec;
+
+    /// Default constructor does not initialize any values
+    SIMD_Mask()
+    {
+    }
+
+    /// Set every lane to v
+    explicit SIMD_Mask( bool v ) : m_vec( v ? _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) : _mm_setzero_ps() )
+    {
+    }
+
+    bool operator[]( size_t index ) const
+    {
+        return ( movemask() >> index ) & 1;
+    }
+
+    /// Bit i of the result is lane i
+    unsigned int movemask() const
+    {
+        return static_cast<unsigned int>( _mm_movemask_ps( m_vec ) );
+    }
+
+    friend bool any( mask_type const &m )
+    {
+        return m.movemask() != 0;
+    }
+
+    friend bool all( mask_type const &m )
+    {
+        return m.movemask() == 0xf;
+    }
+
+    friend bool none( mask_type const &m )
+    {
+        return m.movemask() == 0;
+    }
+
+    friend mask_type operator&( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_and_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator|( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_or_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator^( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_xor_ps( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator~( mask_type const &a )
+    {
+        mask_type r;
+        r.m_vec = _mm_xor_ps( a.m_vec, _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) );
+        return r;
+    }
+};
 
 template <>
 class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
@@ -45,6 +128,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
     typedef SIMD_Vector<float, 4> simd_type;
     typedef __m128 internal_type;
     typedef float value_type;
+    typedef SIMD_Mask<float, 4> mask_type;
 
     typedef value_type *pointer;
     typedef value_type const *const_pointer;
@@ -124,6 +208,24 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return m_item;
     }
 
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        m_vec = _mm_loadu_ps( p );
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        _mm_storeu_ps( p, m_vec );
+    }
+
+    /// Store all items to memory aligned to 16 bytes without loading it into the cache, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        _mm_stream_ps( p, m_vec );
+    }
+
     /// array index operator returns a const ref to the item
     value_type const &operator[]( size_t index ) const
     {
@@ -157,21 +259,14 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
     }
 
     /// Copy constructor
-    SIMD_Vector( simd_type const &other )
+    SIMD_Vector( simd_type const &other ) : m_vec( other.m_vec )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
     }
 
     /// Assignment operator
     simd_type const &operator=( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
+        m_vec = other.m_vec;
         return *this;
     }
 
@@ -266,18 +361,44 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return v;
     }
 
+    /// a * b + c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm_fmadd_ps( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm_add_ps( _mm_mul_ps( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
+    /// a * b - c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm_fmsub_ps( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm_sub_ps( _mm_mul_ps( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
     friend simd_type sqrt( simd_type const &a )
     {
-        return reciprocal( reciprocal_sqrt( a ) );
+        simd_type r;
+        r.m_vec = _mm_sqrt_ps( a.m_vec );
+        return r;
     }
 
     friend simd_type arg( simd_type const &a )
     {
+        // 0 for positive values, pi for values with the sign bit set
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = arg( a[i] );
-        }
+        internal_type negative = _mm_castsi128_ps( _mm_srai_epi32( _mm_castps_si128( a.m_vec ), 31 ) );
+        r.m_vec = _mm_or_ps( _mm_and_ps( negative, _mm_set1_ps( 3.14159265358979323846f ) ),
+                             _mm_cmpunord_ps( a.m_vec, a.m_vec ) );
         return r;
     }
 
@@ -288,23 +409,102 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return r;
     }
 
+    /// The squared magnitude of each item, see \ref simd_conj
+    friend simd_type norm( simd_type const &a )
+    {
+        return a * a;
+    }
+
+    /// Real items are their own conjugates, see \ref simd_conj
+    friend simd_type conj( simd_type const &a )
+    {
+        return a;
+    }
+
+    /// a * conj( b ), which for real items is a * b, see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        return a * b;
+    }
+
+    /// Sine, max error 2.5 ulp for |x| <= 8192
     friend simd_type sin( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = sin( a[i] );
-        }
+        internal_type c;
+        sincos_kernel( a.m_vec, r.m_vec, c );
         return r;
     }
 
+    /// Cosine, max error 2.5 ulp for |x| <= 8192
     friend simd_type cos( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = cos( a[i] );
-        }
+        internal_type s;
+        sincos_kernel( a.m_vec, s, r.m_vec );
+        return r;
+    }
+
+    /// Tangent, max error 3.5 ulp for |x| <= 8192
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = tan_kernel( a.m_vec );
+        return r;
+    }
+
+    /// Natural exponential, max error 1 ulp. Overflows to inf and underflows through the subnormals to 0
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm_max_ps( _mm_set1_ps( -104.0f ), _mm_min_ps( _mm_set1_ps( 89.0f ), a.m_vec ) );
+        __m128i n = _mm_cvtps_epi32( _mm_mul_ps( x, _mm_set1_ps( 1.44269504088896341f ) ) );
+        internal_type fn = _mm_cvtepi32_ps( n );
+        x = _mm_sub_ps( x, _mm_mul_ps( fn, _mm_set1_ps( 0.693359375f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( fn, _mm_set1_ps( -2.12194440e-4f ) ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Base 2 exponential, max error 1.5 ulp
+    friend simd_type exp2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm_max_ps( _mm_set1_ps( -151.0f ), _mm_min_ps( _mm_set1_ps( 129.0f ), a.m_vec ) );
+        __m128i n = _mm_cvtps_epi32( x );
+        x = _mm_mul_ps( _mm_sub_ps( x, _mm_cvtepi32_ps( n ) ), _mm_set1_ps( 0.693147180559945309f ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Natural logarithm, max error 1 ulp
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm_mul_ps( x, x );
+        internal_type y = log_kernel( x, z );
+        y = _mm_add_ps( y, _mm_mul_ps( e, _mm_set1_ps( -2.12194440e-4f ) ) );
+        y = _mm_sub_ps( y, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+        x = _mm_add_ps( x, y );
+        x = _mm_add_ps( x, _mm_mul_ps( e, _mm_set1_ps( 0.693359375f ) ) );
+        r.m_vec = log_special( a.m_vec, x );
+        return r;
+    }
+
+    /// Base 2 logarithm, max error 1.5 ulp
+    friend simd_type log2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm_mul_ps( x, x );
+        internal_type y = _mm_sub_ps( log_kernel( x, z ), _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+        internal_type log2ea = _mm_set1_ps( 0.44269504088896340736f );
+        z = _mm_add_ps( _mm_mul_ps( y, log2ea ), _mm_mul_ps( x, log2ea ) );
+        z = _mm_add_ps( _mm_add_ps( z, y ), _mm_add_ps( x, e ) );
+        r.m_vec = log_special( a.m_vec, z );
         return r;
     }
 
@@ -468,71 +668,287 @@ class DAP_SIMD_ALIGN SIMD_Vector<float, 4>
         return r;
     }
 
-    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator==( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        internal_type t = _mm_set1_ps( 1.0f );
-        internal_type f = _mm_setzero_ps();
+        mask_type r;
+        r.m_vec = _mm_cmpeq_ps( a.m_vec, b.m_vec );
+        return r;
+    }
 
-        internal_type x = _mm_cmpeq_ps( a.m_vec, b.m_vec );
-        r.m_vec = _mm_or_ps( _mm_and_ps( x, t ), _mm_andnot_ps( x, f ) );
+    friend mask_type operator!=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_cmpneq_ps( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator<( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        internal_type t = _mm_set1_ps( 1.0f );
-        internal_type f = _mm_setzero_ps();
+        mask_type r;
+        r.m_vec = _mm_cmplt_ps( a.m_vec, b.m_vec );
+        return r;
+    }
 
-        internal_type x = _mm_cmpneq_ps( a.m_vec, b.m_vec );
-        r.m_vec = _mm_or_ps( _mm_and_ps( x, t ), _mm_andnot_ps( x, f ) );
+    friend mask_type operator<=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_cmple_ps( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type less( simd_type const &a, simd_type const &b )
+    friend mask_type operator>( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        internal_type t = _mm_set1_ps( 1.0f );
-        internal_type f = _mm_setzero_ps();
+        mask_type r;
+        r.m_vec = _mm_cmpgt_ps( a.m_vec, b.m_vec );
+        return r;
+    }
 
-        internal_type x = _mm_cmpnlt_ps( a.m_vec, b.m_vec );
-        r.m_vec = _mm_or_ps( _mm_and_ps( x, t ), _mm_andnot_ps( x, f ) );
+    friend mask_type operator>=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_cmpge_ps( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    /// Each lane from a where m is set and from b elsewhere
+    friend simd_type select( mask_type const &m, simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        internal_type t = _mm_set1_ps( 1.0f );
-        internal_type f = _mm_setzero_ps();
-
-        internal_type x = _mm_cmpnle_ps( a.m_vec, b.m_vec );
-        r.m_vec = _mm_or_ps( _mm_and_ps( x, t ), _mm_andnot_ps( x, f ) );
+#if defined( __SSE4_1__ )
+        r.m_vec = _mm_blendv_ps( b.m_vec, a.m_vec, m.m_vec );
+#else
+        r.m_vec = _mm_or_ps( _mm_and_ps( m.m_vec, a.m_vec ), _mm_andnot_ps( m.m_vec, b.m_vec ) );
+#endif
         return r;
     }
 
-    friend simd_type greater( simd_type const &a, simd_type const &b )
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
     {
-        simd_type r;
-        internal_type t = _mm_set1_ps( 1.0f );
-        internal_type f = _mm_setzero_ps();
+        __m128 s = _mm_add_ps( a.m_vec, _mm_movehl_ps( a.m_vec, a.m_vec ) );
+        s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
 
-        internal_type x = _mm_cmpngt_ps( a.m_vec, b.m_vec );
-        r.m_vec = _mm_or_ps( _mm_and_ps( x, t ), _mm_andnot_ps( x, f ) );
-        return r;
+    /// Smallest item
+    friend value_type hmin( simd_type const &a )
+    {
+        __m128 s = _mm_min_ps( a.m_vec, _mm_movehl_ps( a.m_vec, a.m_vec ) );
+        s = _mm_min_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Largest item
+    friend value_type hmax( simd_type const &a )
+    {
+        __m128 s = _mm_max_ps( a.m_vec, _mm_movehl_ps( a.m_vec, a.m_vec ) );
+        s = _mm_max_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Largest absolute value of any item
+    friend value_type habsmax( simd_type const &a )
+    {
+        const internal_type v = _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.m_vec );
+        __m128 s = _mm_max_ps( v, _mm_movehl_ps( v, v ) );
+        s = _mm_max_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Sum of the products of the items of a and b
+    friend value_type dot( simd_type const &a, simd_type const &b )
+    {
+        const internal_type v = _mm_mul_ps( a.m_vec, b.m_vec );
+        __m128 s = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+        s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        return _mm_cvtss_f32( s );
+    }
+
+    /// Transpose in registers the 4x4 matrix whose rows are rows[0..3]
+    friend void transpose( simd_type( &rows )[4] )
+    {
+        _MM_TRANSPOSE4_PS( rows[0].m_vec, rows[1].m_vec, rows[2].m_vec, rows[3].m_vec );
+    }
+
+    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a == b, one( t ), zero( f ) );
+    }
+
+    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a != b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a < b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a <= b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a > b, one( t ), zero( f ) );
     }
 
     friend simd_type greater_equal( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        internal_type t = _mm_set1_ps( 1.0f );
-        internal_type f = _mm_setzero_ps();
+        simd_type t, f;
+        return select( a >= b, one( t ), zero( f ) );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate both the sine and cosine polynomials (Cephes sinf/cosf)
+    static void sincos_kernel( internal_type x, internal_type &s, internal_type &c )
+    {
+        internal_type sign_mask = _mm_set1_ps( -0.0f );
+        internal_type sign_x = _mm_and_ps( x, sign_mask );
+        x = _mm_andnot_ps( sign_mask, x );
+
+        // octant j = (int)(x * 4/pi), rounded up to even
+        __m128i j = _mm_cvttps_epi32( _mm_mul_ps( x, _mm_set1_ps( 1.27323954473516268615f ) ) );
+        j = _mm_and_si128( _mm_add_epi32( j, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( ~1 ) );
+        internal_type y = _mm_cvtepi32_ps( j );
+
+        // octants 2,3 and 6,7 swap the polynomials, octants 4..7 negate the sine, 2..5 negate the cosine
+        __m128i two = _mm_set1_epi32( 2 );
+        __m128i four = _mm_set1_epi32( 4 );
+        internal_type poly_mask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( j, two ), two ) );
+        internal_type sin_sign = _mm_xor_ps( sign_x, _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( j, four ), 29 ) ) );
+        internal_type cos_sign
+            = _mm_castsi128_ps( _mm_slli_epi32( _mm_andnot_si128( _mm_sub_epi32( j, two ), four ), 29 ) );
 
-        internal_type x = _mm_cmpnge_ps( a.m_vec, b.m_vec );
-        r.m_vec = _mm_or_ps( _mm_and_ps( x, t ), _mm_andnot_ps( x, f ) );
-        return r;
+        // extended precision modular arithmetic
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 0.78515625f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 2.4187564849853515625e-4f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 3.7747668102383613586e-8f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 1.2816720341285448015e-12f ) ) );
+        internal_type z = _mm_mul_ps( x, x );
+
+        internal_type yc = _mm_set1_ps( 2.443315711809948e-5f );
+        yc = _mm_add_ps( _mm_mul_ps( yc, z ), _mm_set1_ps( -1.388731625493765e-3f ) );
+        yc = _mm_add_ps( _mm_mul_ps( yc, z ), _mm_set1_ps( 4.166664568298827e-2f ) );
+        yc = _mm_mul_ps( _mm_mul_ps( yc, z ), z );
+        yc = _mm_sub_ps( yc, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+        yc = _mm_add_ps( yc, _mm_set1_ps( 1.0f ) );
+
+        internal_type ys = _mm_set1_ps( -1.9515295891e-4f );
+        ys = _mm_add_ps( _mm_mul_ps( ys, z ), _mm_set1_ps( 8.3321608736e-3f ) );
+        ys = _mm_add_ps( _mm_mul_ps( ys, z ), _mm_set1_ps( -1.6666654611e-1f ) );
+        ys = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( ys, z ), x ), x );
+
+        s = _mm_xor_ps( _mm_or_ps( _mm_and_ps( poly_mask, yc ), _mm_andnot_ps( poly_mask, ys ) ), sin_sign );
+        c = _mm_xor_ps( _mm_or_ps( _mm_and_ps( poly_mask, ys ), _mm_andnot_ps( poly_mask, yc ) ), cos_sign );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate the tangent polynomial (Cephes tanf)
+    static internal_type tan_kernel( internal_type x )
+    {
+        internal_type sign_mask = _mm_set1_ps( -0.0f );
+        internal_type sign_x = _mm_and_ps( x, sign_mask );
+        x = _mm_andnot_ps( sign_mask, x );
+
+        __m128i j = _mm_cvttps_epi32( _mm_mul_ps( x, _mm_set1_ps( 1.27323954473516268615f ) ) );
+        j = _mm_and_si128( _mm_add_epi32( j, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( ~1 ) );
+        internal_type y = _mm_cvtepi32_ps( j );
+        __m128i two = _mm_set1_epi32( 2 );
+        internal_type recip_mask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( j, two ), two ) );
+
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 0.78515625f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 2.4187564849853515625e-4f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 3.7747668102383613586e-8f ) ) );
+        x = _mm_sub_ps( x, _mm_mul_ps( y, _mm_set1_ps( 1.2816720341285448015e-12f ) ) );
+        internal_type z = _mm_mul_ps( x, x );
+
+        y = _mm_set1_ps( 9.38540185543e-3f );
+        y = _mm_add_ps( _mm_mul_ps( y, z ), _mm_set1_ps( 3.11992232697e-3f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, z ), _mm_set1_ps( 2.44301354525e-2f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, z ), _mm_set1_ps( 5.34112807005e-2f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, z ), _mm_set1_ps( 1.33387994085e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, z ), _mm_set1_ps( 3.33331568548e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( y, z ), x ), x );
+
+        // octants 2,3 and 6,7 give -1/tan
+        internal_type recip = _mm_div_ps( _mm_set1_ps( -1.0f ), y );
+        y = _mm_or_ps( _mm_and_ps( recip_mask, recip ), _mm_andnot_ps( recip_mask, y ) );
+        return _mm_xor_ps( y, sign_x );
+    }
+
+    /// e^x for |x| <= ln(2)/2 (Cephes expf polynomial)
+    static internal_type exp_kernel( internal_type x )
+    {
+        internal_type z = _mm_mul_ps( x, x );
+        internal_type y = _mm_set1_ps( 1.9875691500e-4f );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 1.3981999507e-3f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 8.3334519073e-3f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 4.1665795894e-2f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 1.6666665459e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 5.0000001201e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, z ), x );
+        return _mm_add_ps( y, _mm_set1_ps( 1.0f ) );
+    }
+
+    /// y * 2^n. The scale is applied in two halves so that subnormal and overflowing results are still rounded
+    static internal_type ldexp_kernel( internal_type y, __m128i n )
+    {
+        __m128i bias = _mm_set1_epi32( 127 );
+        __m128i n1 = _mm_srai_epi32( n, 1 );
+        __m128i n2 = _mm_sub_epi32( n, n1 );
+        y = _mm_mul_ps( y, _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( n1, bias ), 23 ) ) );
+        return _mm_mul_ps( y, _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( n2, bias ), 23 ) ) );
+    }
+
+    /// Split x into m-1 and e with x = m * 2^e and m in [sqrt(1/2),sqrt(2))
+    static internal_type log_reduce( internal_type x, internal_type &e )
+    {
+        internal_type subnormal = _mm_cmplt_ps( x, _mm_set1_ps( FLT_MIN ) );
+        x = _mm_or_ps( _mm_and_ps( subnormal, _mm_mul_ps( x, _mm_set1_ps( 8388608.0f ) ) ), _mm_andnot_ps( subnormal, x ) );
+
+        __m128i bits = _mm_castps_si128( x );
+        e = _mm_cvtepi32_ps( _mm_sub_epi32( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 126 ) ) );
+        e = _mm_sub_ps( e, _mm_and_ps( subnormal, _mm_set1_ps( 23.0f ) ) );
+        x = _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( bits, _mm_set1_epi32( 0x007fffff ) ), _mm_set1_epi32( 0x3f000000 ) ) );
+
+        internal_type one = _mm_set1_ps( 1.0f );
+        internal_type small = _mm_cmplt_ps( x, _mm_set1_ps( 0.707106781186547524f ) );
+        e = _mm_sub_ps( e, _mm_and_ps( small, one ) );
+        return _mm_add_ps( _mm_sub_ps( x, one ), _mm_and_ps( small, x ) );
+    }
+
+    /// log(1+x) - x + x^2/2 for reduced x, given z = x^2 (Cephes logf polynomial)
+    static internal_type log_kernel( internal_type x, internal_type z )
+    {
+        internal_type y = _mm_set1_ps( 7.0376836292e-2f );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( -1.1514610310e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 1.1676998740e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( -1.2420140846e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 1.4249322787e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( -1.6668057665e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 2.0000714765e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( -2.4999993993e-1f ) );
+        y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( 3.3333331174e-1f ) );
+        return _mm_mul_ps( _mm_mul_ps( y, x ), z );
+    }
+
+    /// Patch the logarithm of the special inputs: 0 gives -inf, +inf gives +inf, negative and NaN give NaN
+    static internal_type log_special( internal_type a, internal_type r )
+    {
+        internal_type zero = _mm_setzero_ps();
+        internal_type inf = _mm_set1_ps( HUGE_VALF );
+        internal_type zero_mask = _mm_cmpeq_ps( a, zero );
+        internal_type inf_mask = _mm_cmpeq_ps( a, inf );
+        r = _mm_or_ps( _mm_and_ps( zero_mask, _mm_sub_ps( zero, inf ) ), _mm_andnot_ps( zero_mask, r ) );
+        r = _mm_or_ps( _mm_and_ps( inf_mask, inf ), _mm_andnot_ps( inf_mask, r ) );
+        return _mm_or_ps( r, _mm_cmpnge_ps( a, zero ) );
     }
 };
-}
+DAP_NAMESPACE_END
 #endif
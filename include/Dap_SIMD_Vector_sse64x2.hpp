@@ -34,9 +34,92 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #if defined( __SSE__ )
 #include "xmmintrin.h"
+#include "emmintrin.h"
+#if defined( __SSE4_1__ )
+#include "smmintrin.h"
+#endif
+#if defined( __FMA__ )
+#include "immintrin.h"
+#endif
 
-namespace Dap
+DAP_NAMESPACE_BEGIN
+
+/// Mask holding the result of a comparison of two SIMD_Vector<double, 2>, all bits of a lane set when true
+template <>
+class SIMD_Mask<double, 2>
 {
+  public:
+    typedef SIMD_Mask<double, 2> mask_type;
+    typedef __m128d internal_type;
+
+    static const size_t vector_size = 2;
+
+    internal_type m_vec;
+
+    /// Default constructor does not initialize any values
+    SIMD_Mask()
+    {
+    }
+
+    /// Set every lane to v
+    explicit SIMD_Mask( bool v ) : m_vec( v ? _mm_castsi128_pd( _mm_set1_epi32( -1 ) ) : _mm_setzero_pd() )
+    {
+    }
+
+    bool operator[]( size_t index ) const
+    {
+        return ( movemask() >> index ) & 1;
+    }
+
+    /// Bit i of the result is lane i
+    unsigned int movemask() const
+    {
+        return static_cast<unsigned int>( _mm_movemask_pd( m_vec ) );
+    }
+
+    friend bool any( mask_type const &m )
+    {
+        return m.movemask() != 0;
+    }
+
+    friend bool all( mask_type const &m )
+    {
+        return m.movemask() == 0x3;
+    }
+
+    friend bool none( mask_type const &m )
+    {
+        return m.movemask() == 0;
+    }
+
+    friend mask_type operator&( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_and_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator|( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_or_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator^( mask_type const &a, mask_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_xor_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    friend mask_type operator~( mask_type const &a )
+    {
+        mask_type r;
+        r.m_vec = _mm_xor_pd( a.m_vec, _mm_castsi128_pd( _mm_set1_epi32( -1 ) ) );
+        return r;
+    }
+};
 
 template <>
 class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
@@ -45,6 +128,7 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
     typedef SIMD_Vector<double, 2> simd_type;
     typedef __m128d internal_type;
     typedef double value_type;
+    typedef SIMD_Mask<double, 2> mask_type;
 
     typedef value_type *pointer;
     typedef value_type const *const_pointer;
@@ -122,6 +206,24 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
         return m_item;
     }
 
+    /// Load all items from memory that need not be aligned
+    void load( const_pointer p )
+    {
+        m_vec = _mm_loadu_pd( p );
+    }
+
+    /// Store all items to memory that need not be aligned
+    void store( pointer p ) const
+    {
+        _mm_storeu_pd( p, m_vec );
+    }
+
+    /// Store all items to memory aligned to 16 bytes without loading it into the cache, see \ref simd_stream_fence
+    void stream( pointer p ) const
+    {
+        _mm_stream_pd( p, m_vec );
+    }
+
     /// array index operator returns a const ref to the item
     value_type const &operator[]( size_t index ) const
     {
@@ -155,21 +257,14 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
     }
 
     /// Copy constructor
-    SIMD_Vector( simd_type const &other )
+    SIMD_Vector( simd_type const &other ) : m_vec( other.m_vec )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
     }
 
     /// Assignment operator
     simd_type const &operator=( simd_type const &other )
     {
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            m_item[i] = other.m_item[i];
-        }
+        m_vec = other.m_vec;
         return *this;
     }
 
@@ -264,6 +359,30 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
         return v;
     }
 
+    /// a * b + c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fma( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm_fmadd_pd( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm_add_pd( _mm_mul_pd( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
+    /// a * b - c, fused when built with FMA. See \ref simd_fma
+    friend simd_type fms( simd_type const &a, simd_type const &b, simd_type const &c )
+    {
+        simd_type r;
+#if defined( __FMA__ )
+        r.m_vec = _mm_fmsub_pd( a.m_vec, b.m_vec, c.m_vec );
+#else
+        r.m_vec = _mm_sub_pd( _mm_mul_pd( a.m_vec, b.m_vec ), c.m_vec );
+#endif
+        return r;
+    }
+
     friend simd_type sqrt( simd_type const &a )
     {
         simd_type r;
@@ -276,11 +395,12 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
 
     friend simd_type arg( simd_type const &a )
     {
+        // 0 for positive values, pi for values with the sign bit set
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = arg( a[i] );
-        }
+        __m128i sign = _mm_srai_epi32( _mm_castpd_si128( a.m_vec ), 31 );
+        internal_type negative = _mm_castsi128_pd( _mm_shuffle_epi32( sign, _MM_SHUFFLE( 3, 3, 1, 1 ) ) );
+        r.m_vec = _mm_or_pd( _mm_and_pd( negative, _mm_set1_pd( 3.14159265358979323846 ) ),
+                             _mm_cmpunord_pd( a.m_vec, a.m_vec ) );
         return r;
     }
 
@@ -291,23 +411,102 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
         return r;
     }
 
+    /// The squared magnitude of each item, see \ref simd_conj
+    friend simd_type norm( simd_type const &a )
+    {
+        return a * a;
+    }
+
+    /// Real items are their own conjugates, see \ref simd_conj
+    friend simd_type conj( simd_type const &a )
+    {
+        return a;
+    }
+
+    /// a * conj( b ), which for real items is a * b, see \ref simd_conj
+    friend simd_type conj_multiply( simd_type const &a, simd_type const &b )
+    {
+        return a * b;
+    }
+
+    /// Sine, max error 2 ulp for |x| <= 2^20
     friend simd_type sin( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = sin( a[i] );
-        }
+        internal_type c;
+        sincos_kernel( a.m_vec, r.m_vec, c );
         return r;
     }
 
+    /// Cosine, max error 2 ulp for |x| <= 2^20
     friend simd_type cos( simd_type const &a )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = cos( a[i] );
-        }
+        internal_type s;
+        sincos_kernel( a.m_vec, s, r.m_vec );
+        return r;
+    }
+
+    /// Tangent, max error 2.5 ulp for |x| <= 2^20
+    friend simd_type tan( simd_type const &a )
+    {
+        simd_type r;
+        r.m_vec = tan_kernel( a.m_vec );
+        return r;
+    }
+
+    /// Natural exponential, max error 2 ulp. Overflows to inf and underflows through the subnormals to 0
+    friend simd_type exp( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm_max_pd( _mm_set1_pd( -746.0 ), _mm_min_pd( _mm_set1_pd( 710.0 ), a.m_vec ) );
+        __m128i n = _mm_cvtpd_epi32( _mm_mul_pd( x, _mm_set1_pd( 1.4426950408889634073599 ) ) );
+        internal_type fn = _mm_cvtepi32_pd( n );
+        x = _mm_sub_pd( x, _mm_mul_pd( fn, _mm_set1_pd( 6.93145751953125e-1 ) ) );
+        x = _mm_sub_pd( x, _mm_mul_pd( fn, _mm_set1_pd( 1.42860682030941723212e-6 ) ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Base 2 exponential, max error 2.5 ulp
+    friend simd_type exp2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type x = _mm_max_pd( _mm_set1_pd( -1076.0 ), _mm_min_pd( _mm_set1_pd( 1025.0 ), a.m_vec ) );
+        __m128i n = _mm_cvtpd_epi32( x );
+        x = _mm_mul_pd( _mm_sub_pd( x, _mm_cvtepi32_pd( n ) ), _mm_set1_pd( 0.693147180559945309417232 ) );
+        r.m_vec = ldexp_kernel( exp_kernel( x ), n );
+        return r;
+    }
+
+    /// Natural logarithm, max error 1 ulp
+    friend simd_type log( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm_mul_pd( x, x );
+        internal_type y = log_kernel( x, z );
+        y = _mm_sub_pd( y, _mm_mul_pd( e, _mm_set1_pd( 2.121944400546905827679e-4 ) ) );
+        y = _mm_sub_pd( y, _mm_mul_pd( z, _mm_set1_pd( 0.5 ) ) );
+        x = _mm_add_pd( x, y );
+        x = _mm_add_pd( x, _mm_mul_pd( e, _mm_set1_pd( 0.693359375 ) ) );
+        r.m_vec = log_special( a.m_vec, x );
+        return r;
+    }
+
+    /// Base 2 logarithm, max error 1.5 ulp
+    friend simd_type log2( simd_type const &a )
+    {
+        simd_type r;
+        internal_type e;
+        internal_type x = log_reduce( a.m_vec, e );
+        internal_type z = _mm_mul_pd( x, x );
+        internal_type y = _mm_sub_pd( log_kernel( x, z ), _mm_mul_pd( z, _mm_set1_pd( 0.5 ) ) );
+        internal_type log2ea = _mm_set1_pd( 4.4269504088896340735992e-1 );
+        z = _mm_add_pd( _mm_mul_pd( y, log2ea ), _mm_mul_pd( x, log2ea ) );
+        z = _mm_add_pd( _mm_add_pd( z, y ), _mm_add_pd( x, e ) );
+        r.m_vec = log_special( a.m_vec, z );
         return r;
     }
 
@@ -460,66 +659,298 @@ class DAP_SIMD_ALIGN SIMD_Vector<double, 2>
         return r;
     }
 
-    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator==( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm_cmpeq_pd( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    friend mask_type operator!=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = not_equal_to( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm_cmpneq_pd( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type less( simd_type const &a, simd_type const &b )
+    friend mask_type operator<( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm_cmplt_pd( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator<=( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = less_equal( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm_cmple_pd( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type greater( simd_type const &a, simd_type const &b )
+    friend mask_type operator>( simd_type const &a, simd_type const &b )
     {
-        simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater( a[i], b[i] );
-        }
+        mask_type r;
+        r.m_vec = _mm_cmpgt_pd( a.m_vec, b.m_vec );
         return r;
     }
 
-    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    friend mask_type operator>=( simd_type const &a, simd_type const &b )
+    {
+        mask_type r;
+        r.m_vec = _mm_cmpge_pd( a.m_vec, b.m_vec );
+        return r;
+    }
+
+    /// Each lane from a where m is set and from b elsewhere
+    friend simd_type select( mask_type const &m, simd_type const &a, simd_type const &b )
     {
         simd_type r;
-        for ( size_t i = 0; i < vector_size; ++i )
-        {
-            r[i] = greater_equal( a[i], b[i] );
-        }
+#if defined( __SSE4_1__ )
+        r.m_vec = _mm_blendv_pd( b.m_vec, a.m_vec, m.m_vec );
+#else
+        r.m_vec = _mm_or_pd( _mm_and_pd( m.m_vec, a.m_vec ), _mm_andnot_pd( m.m_vec, b.m_vec ) );
+#endif
         return r;
     }
+
+    /// Sum of all items
+    friend value_type hsum( simd_type const &a )
+    {
+        return _mm_cvtsd_f64( _mm_add_sd( a.m_vec, _mm_unpackhi_pd( a.m_vec, a.m_vec ) ) );
+    }
+
+    /// Smallest item
+    friend value_type hmin( simd_type const &a )
+    {
+        return _mm_cvtsd_f64( _mm_min_sd( a.m_vec, _mm_unpackhi_pd( a.m_vec, a.m_vec ) ) );
+    }
+
+    /// Largest item
+    friend value_type hmax( simd_type const &a )
+    {
+        return _mm_cvtsd_f64( _mm_max_sd( a.m_vec, _mm_unpackhi_pd( a.m_vec, a.m_vec ) ) );
+    }
+
+    /// Largest absolute value of any item
+    friend value_type habsmax( simd_type const &a )
+    {
+        const internal_type v = _mm_andnot_pd( _mm_set1_pd( -0.0 ), a.m_vec );
+        return _mm_cvtsd_f64( _mm_max_sd( v, _mm_unpackhi_pd( v, v ) ) );
+    }
+
+    /// Sum of the products of the items of a and b
+    friend value_type dot( simd_type const &a, simd_type const &b )
+    {
+        const internal_type v = _mm_mul_pd( a.m_vec, b.m_vec );
+        return _mm_cvtsd_f64( _mm_add_sd( v, _mm_unpackhi_pd( v, v ) ) );
+    }
+
+    /// Transpose in registers the 2x2 matrix whose rows are rows[0..1]
+    friend void transpose( simd_type( &rows )[2] )
+    {
+        const internal_type lo = _mm_unpacklo_pd( rows[0].m_vec, rows[1].m_vec );
+        rows[1].m_vec = _mm_unpackhi_pd( rows[0].m_vec, rows[1].m_vec );
+        rows[0].m_vec = lo;
+    }
+
+    friend simd_type equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a == b, one( t ), zero( f ) );
+    }
+
+    friend simd_type not_equal_to( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a != b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a < b, one( t ), zero( f ) );
+    }
+
+    friend simd_type less_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a <= b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a > b, one( t ), zero( f ) );
+    }
+
+    friend simd_type greater_equal( simd_type const &a, simd_type const &b )
+    {
+        simd_type t, f;
+        return select( a >= b, one( t ), zero( f ) );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate both the sine and cosine polynomials (Cephes sin/cos)
+    static void sincos_kernel( internal_type x, internal_type &s, internal_type &c )
+    {
+        internal_type sign_mask = _mm_set1_pd( -0.0 );
+        internal_type sign_x = _mm_and_pd( x, sign_mask );
+        x = _mm_andnot_pd( sign_mask, x );
+
+        // octant j = (int)(x * 4/pi), rounded up to even. The two octants live in the low 32 bit lanes
+        __m128i j = _mm_cvttpd_epi32( _mm_mul_pd( x, _mm_set1_pd( 1.27323954473516268615 ) ) );
+        j = _mm_and_si128( _mm_add_epi32( j, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( ~1 ) );
+        internal_type y = _mm_cvtepi32_pd( j );
+
+        // octants 2,3 and 6,7 swap the polynomials, octants 4..7 negate the sine, 2..5 negate the cosine
+        __m128i zero = _mm_setzero_si128();
+        __m128i two = _mm_set1_epi32( 2 );
+        __m128i four = _mm_set1_epi32( 4 );
+        __m128i poly = _mm_cmpeq_epi32( _mm_and_si128( j, two ), two );
+        internal_type poly_mask = _mm_castsi128_pd( _mm_unpacklo_epi32( poly, poly ) );
+        __m128i sin_flip = _mm_slli_epi32( _mm_and_si128( j, four ), 29 );
+        internal_type sin_sign = _mm_xor_pd( sign_x, _mm_castsi128_pd( _mm_unpacklo_epi32( zero, sin_flip ) ) );
+        __m128i cos_flip = _mm_slli_epi32( _mm_andnot_si128( _mm_sub_epi32( j, two ), four ), 29 );
+        internal_type cos_sign = _mm_castsi128_pd( _mm_unpacklo_epi32( zero, cos_flip ) );
+
+        // extended precision modular arithmetic
+        x = _mm_sub_pd( x, _mm_mul_pd( y, _mm_set1_pd( 7.85398125648498535156e-1 ) ) );
+        x = _mm_sub_pd( x, _mm_mul_pd( y, _mm_set1_pd( 3.77489470793079817668e-8 ) ) );
+        x = _mm_sub_pd( x, _mm_mul_pd( y, _mm_set1_pd( 2.69515142907905952645e-15 ) ) );
+        internal_type z = _mm_mul_pd( x, x );
+
+        internal_type yc = _mm_set1_pd( -1.13585365213876817300e-11 );
+        yc = _mm_add_pd( _mm_mul_pd( yc, z ), _mm_set1_pd( 2.08757008419747316778e-9 ) );
+        yc = _mm_add_pd( _mm_mul_pd( yc, z ), _mm_set1_pd( -2.75573141792967388112e-7 ) );
+        yc = _mm_add_pd( _mm_mul_pd( yc, z ), _mm_set1_pd( 2.48015872888517045348e-5 ) );
+        yc = _mm_add_pd( _mm_mul_pd( yc, z ), _mm_set1_pd( -1.38888888888730564116e-3 ) );
+        yc = _mm_add_pd( _mm_mul_pd( yc, z ), _mm_set1_pd( 4.16666666666665929218e-2 ) );
+        yc = _mm_mul_pd( _mm_mul_pd( yc, z ), z );
+        yc = _mm_add_pd( _mm_sub_pd( _mm_set1_pd( 1.0 ), _mm_mul_pd( z, _mm_set1_pd( 0.5 ) ) ), yc );
+
+        internal_type ys = _mm_set1_pd( 1.58962301576546568060e-10 );
+        ys = _mm_add_pd( _mm_mul_pd( ys, z ), _mm_set1_pd( -2.50507477628578072866e-8 ) );
+        ys = _mm_add_pd( _mm_mul_pd( ys, z ), _mm_set1_pd( 2.75573136213857245213e-6 ) );
+        ys = _mm_add_pd( _mm_mul_pd( ys, z ), _mm_set1_pd( -1.98412698295895385996e-4 ) );
+        ys = _mm_add_pd( _mm_mul_pd( ys, z ), _mm_set1_pd( 8.33333333332211858878e-3 ) );
+        ys = _mm_add_pd( _mm_mul_pd( ys, z ), _mm_set1_pd( -1.66666666666666307295e-1 ) );
+        ys = _mm_add_pd( _mm_mul_pd( _mm_mul_pd( ys, z ), x ), x );
+
+        s = _mm_xor_pd( _mm_or_pd( _mm_and_pd( poly_mask, yc ), _mm_andnot_pd( poly_mask, ys ) ), sin_sign );
+        c = _mm_xor_pd( _mm_or_pd( _mm_and_pd( poly_mask, ys ), _mm_andnot_pd( poly_mask, yc ) ), cos_sign );
+    }
+
+    /// Reduce x into [-pi/4,pi/4] and evaluate the tangent rational approximation (Cephes tan)
+    static internal_type tan_kernel( internal_type x )
+    {
+        internal_type sign_mask = _mm_set1_pd( -0.0 );
+        internal_type sign_x = _mm_and_pd( x, sign_mask );
+        x = _mm_andnot_pd( sign_mask, x );
+
+        __m128i j = _mm_cvttpd_epi32( _mm_mul_pd( x, _mm_set1_pd( 1.27323954473516268615 ) ) );
+        j = _mm_and_si128( _mm_add_epi32( j, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( ~1 ) );
+        internal_type y = _mm_cvtepi32_pd( j );
+        __m128i two = _mm_set1_epi32( 2 );
+        __m128i recip = _mm_cmpeq_epi32( _mm_and_si128( j, two ), two );
+        internal_type recip_mask = _mm_castsi128_pd( _mm_unpacklo_epi32( recip, recip ) );
+
+        x = _mm_sub_pd( x, _mm_mul_pd( y, _mm_set1_pd( 7.853981554508209228515625e-1 ) ) );
+        x = _mm_sub_pd( x, _mm_mul_pd( y, _mm_set1_pd( 7.94662735614792836714e-9 ) ) );
+        x = _mm_sub_pd( x, _mm_mul_pd( y, _mm_set1_pd( 3.06161699786838294307e-17 ) ) );
+        internal_type z = _mm_mul_pd( x, x );
+
+        internal_type p = _mm_set1_pd( -1.30936939181383777646e4 );
+        p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( 1.15351664838587416140e6 ) );
+        p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( -1.79565251976484877988e7 ) );
+        internal_type q = _mm_add_pd( z, _mm_set1_pd( 1.36812963470692954678e4 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( -1.32089234440210967447e6 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( 2.50083801823357915839e7 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( -5.38695755929454629881e7 ) );
+        y = _mm_add_pd( x, _mm_mul_pd( x, _mm_div_pd( _mm_mul_pd( z, p ), q ) ) );
+
+        // octants 2,3 and 6,7 give -1/tan
+        internal_type r = _mm_div_pd( _mm_set1_pd( -1.0 ), y );
+        y = _mm_or_pd( _mm_and_pd( recip_mask, r ), _mm_andnot_pd( recip_mask, y ) );
+        return _mm_xor_pd( y, sign_x );
+    }
+
+    /// e^x for |x| <= ln(2)/2 (Cephes exp Pade approximation)
+    static internal_type exp_kernel( internal_type x )
+    {
+        internal_type xx = _mm_mul_pd( x, x );
+        internal_type p = _mm_set1_pd( 1.26177193074810590878e-4 );
+        p = _mm_add_pd( _mm_mul_pd( p, xx ), _mm_set1_pd( 3.02994407707441961300e-2 ) );
+        p = _mm_add_pd( _mm_mul_pd( p, xx ), _mm_set1_pd( 9.99999999999999999910e-1 ) );
+        p = _mm_mul_pd( p, x );
+        internal_type q = _mm_set1_pd( 3.00198505138664455042e-6 );
+        q = _mm_add_pd( _mm_mul_pd( q, xx ), _mm_set1_pd( 2.52448340349684104192e-3 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, xx ), _mm_set1_pd( 2.27265548208155028766e-1 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, xx ), _mm_set1_pd( 2.00000000000000000009e0 ) );
+        x = _mm_div_pd( p, _mm_sub_pd( q, p ) );
+        return _mm_add_pd( _mm_set1_pd( 1.0 ), _mm_add_pd( x, x ) );
+    }
+
+    /// y * 2^n for the two 32 bit integers in the low half of n. The scale is applied in two halves so that
+    /// subnormal and overflowing results are still rounded
+    static internal_type ldexp_kernel( internal_type y, __m128i n )
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i bias = _mm_set1_epi32( 1023 );
+        __m128i n1 = _mm_srai_epi32( n, 1 );
+        __m128i n2 = _mm_sub_epi32( n, n1 );
+        y = _mm_mul_pd( y, _mm_castsi128_pd( _mm_slli_epi64( _mm_unpacklo_epi32( _mm_add_epi32( n1, bias ), zero ), 52 ) ) );
+        return _mm_mul_pd( y, _mm_castsi128_pd( _mm_slli_epi64( _mm_unpacklo_epi32( _mm_add_epi32( n2, bias ), zero ), 52 ) ) );
+    }
+
+    /// Split x into m-1 and e with x = m * 2^e and m in [sqrt(1/2),sqrt(2))
+    static internal_type log_reduce( internal_type x, internal_type &e )
+    {
+        internal_type subnormal = _mm_cmplt_pd( x, _mm_set1_pd( DBL_MIN ) );
+        x = _mm_or_pd( _mm_and_pd( subnormal, _mm_mul_pd( x, _mm_set1_pd( 18014398509481984.0 ) ) ),
+                       _mm_andnot_pd( subnormal, x ) );
+
+        // the exponent field sits in the high 32 bits of each lane
+        __m128i high = _mm_shuffle_epi32( _mm_castpd_si128( x ), _MM_SHUFFLE( 3, 1, 3, 1 ) );
+        high = _mm_and_si128( high, _mm_set1_epi32( 0x7ff00000 ) );
+        e = _mm_sub_pd( _mm_mul_pd( _mm_cvtepi32_pd( high ), _mm_set1_pd( 1.0 / 1048576.0 ) ), _mm_set1_pd( 1022.0 ) );
+        e = _mm_sub_pd( e, _mm_and_pd( subnormal, _mm_set1_pd( 54.0 ) ) );
+        x = _mm_or_pd( _mm_and_pd( x, _mm_castsi128_pd( _mm_set1_epi64x( 0x000fffffffffffffLL ) ) ),
+                       _mm_castsi128_pd( _mm_set1_epi64x( 0x3fe0000000000000LL ) ) );
+
+        internal_type one = _mm_set1_pd( 1.0 );
+        internal_type small = _mm_cmplt_pd( x, _mm_set1_pd( 0.70710678118654752440 ) );
+        e = _mm_sub_pd( e, _mm_and_pd( small, one ) );
+        return _mm_add_pd( _mm_sub_pd( x, one ), _mm_and_pd( small, x ) );
+    }
+
+    /// log(1+x) - x + x^2/2 for reduced x, given z = x^2 (Cephes log rational approximation)
+    static internal_type log_kernel( internal_type x, internal_type z )
+    {
+        internal_type p = _mm_set1_pd( 1.01875663804580931796e-4 );
+        p = _mm_add_pd( _mm_mul_pd( p, x ), _mm_set1_pd( 4.97494994976747001425e-1 ) );
+        p = _mm_add_pd( _mm_mul_pd( p, x ), _mm_set1_pd( 4.70579119878881725854e0 ) );
+        p = _mm_add_pd( _mm_mul_pd( p, x ), _mm_set1_pd( 1.44989225341610930846e1 ) );
+        p = _mm_add_pd( _mm_mul_pd( p, x ), _mm_set1_pd( 1.79368678507819816313e1 ) );
+        p = _mm_add_pd( _mm_mul_pd( p, x ), _mm_set1_pd( 7.70838733755885391666e0 ) );
+        internal_type q = _mm_add_pd( x, _mm_set1_pd( 1.12873587189167450590e1 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, x ), _mm_set1_pd( 4.52279145837532221105e1 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, x ), _mm_set1_pd( 8.29875266912776603211e1 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, x ), _mm_set1_pd( 7.11544750618563894466e1 ) );
+        q = _mm_add_pd( _mm_mul_pd( q, x ), _mm_set1_pd( 2.31251620126765340583e1 ) );
+        return _mm_mul_pd( x, _mm_div_pd( _mm_mul_pd( z, p ), q ) );
+    }
+
+    /// Patch the logarithm of the special inputs: 0 gives -inf, +inf gives +inf, negative and NaN give NaN
+    static internal_type log_special( internal_type a, internal_type r )
+    {
+        internal_type zero = _mm_setzero_pd();
+        internal_type inf = _mm_set1_pd( HUGE_VAL );
+        internal_type zero_mask = _mm_cmpeq_pd( a, zero );
+        internal_type inf_mask = _mm_cmpeq_pd( a, inf );
+        r = _mm_or_pd( _mm_and_pd( zero_mask, _mm_sub_pd( zero, inf ) ), _mm_andnot_pd( zero_mask, r ) );
+        r = _mm_or_pd( _mm_and_pd( inf_mask, inf ), _mm_andnot_pd( inf_mask, r ) );
+        return _mm_or_pd( r, _mm_cmpnge_pd( a, zero ) );
+    }
 };
-}
+DAP_NAMESPACE_END
 
 #endif
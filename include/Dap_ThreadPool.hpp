@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * A reusable pool of worker threads with one task queue per worker.
+ *
+ * parallel_for() deals its tasks round robin onto the queues. A worker takes
+ * from the back of its own queue and, when that is empty, steals from the
+ * front of the others, so a worker that drew slow chunks is helped by the
+ * rest. The calling thread steals too until every task of its call is done,
+ * which also makes nested calls safe. Workers sleep while all queues are
+ * empty.
+ *
+ * The pool only deals in indexes and std::function, so like the dispatch
+ * table it is outside of the per-ISA inline namespace and is built once.
+ */
+
+namespace Dap
+{
+
+class ThreadPool
+{
+  public:
+    /// Start threads workers, by default one per hardware thread. With pin, worker i is bound to core i where the
+    /// platform supports it
+    explicit ThreadPool( std::size_t threads = 0, bool pin = false );
+
+    ThreadPool( ThreadPool const & ) = delete;
+    ThreadPool &operator=( ThreadPool const & ) = delete;
+
+    /// Stops and joins the workers. Must not be called while a parallel_for is running
+    ~ThreadPool();
+
+    /// The number of worker threads
+    std::size_t size() const { return m_workers.size(); }
+
+    /// Call f( i ) once for each i in [0, count) on the workers and the calling thread and return when all are done.
+    /// The first exception thrown by f is rethrown here once the other tasks have finished
+    void parallel_for( std::size_t count, std::function<void( std::size_t )> const &f );
+
+    /// A pool with one worker per hardware thread, started on first use
+    static ThreadPool &shared();
+
+  private:
+    struct Job;
+
+    struct Task
+    {
+        Job *job;
+        std::size_t index;
+    };
+
+    /// Padded so that the heap allocations of two queues never share a cache line
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        char padding[DAP_CACHELINESIZE];
+    };
+
+    bool pop( std::size_t own, Task &task );
+    void run( Task const &task );
+    void worker( std::size_t own, bool pin );
+
+    std::vector<std::unique_ptr<Queue> > m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<std::size_t> m_pending;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    bool m_stop;
+};
+}
@@ -32,11 +32,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Dap_World.hpp"
 
-namespace Dap
-{
+DAP_NAMESPACE_BEGIN
 
 template <typename ContainerT>
 struct Traits
 {
 };
-}
+DAP_NAMESPACE_END
@@ -33,8 +33,7 @@
 #include "Dap_World.hpp"
 #include <array>
 
-namespace Dap
-{
+DAP_NAMESPACE_BEGIN
 
 template <std::size_t WidthIndex, std::size_t HeightIndex, std::size_t DepthIndex>
 struct Twist
@@ -168,6 +167,12 @@ struct Twister<InputTwist, 5>
 
 using twist5 = Twister<Twist<0, 1, 2>, 5>::output_twist;
 
+/**
+ * Storage of a Width x Height x Depth array of T in the raw index order of
+ * TwistType. The items are one flat contiguous array where raw index2 is the
+ * fastest moving, and each (width,height,depth) axis has a compile time
+ * stride, so that the position of an item is a single multiply-add chain.
+ */
 template <typename T, typename TwistType, std::size_t Width, std::size_t Height = 1, std::size_t Depth = 1>
 struct twist_array
 {
@@ -176,56 +181,69 @@ struct twist_array
     static const std::size_t raw_index0_size = dimensions_type::raw_index0_size;
     static const std::size_t raw_index1_size = dimensions_type::raw_index1_size;
     static const std::size_t raw_index2_size = dimensions_type::raw_index2_size;
+    static const std::size_t item_count = Width * Height * Depth;
     const std::size_t depth_size = Depth;
     const std::size_t height_size = Height;
     const std::size_t width_size = Width;
     using value_type = T;
 
-    using type = std::array<std::array<std::array<value_type, raw_index2_size>, raw_index1_size>, raw_index0_size>;
+    using type = std::array<value_type, item_count>;
+
+    /// The distance in items between neighbours along each (width,height,depth) axis
+    static const std::size_t width_stride
+        = ( twist_type::width_index == 2 ? 1 : ( twist_type::width_index == 1 ? raw_index2_size : raw_index1_size * raw_index2_size ) );
+    static const std::size_t height_stride
+        = ( twist_type::height_index == 2 ? 1
+                                           : ( twist_type::height_index == 1 ? raw_index2_size : raw_index1_size * raw_index2_size ) );
+    static const std::size_t depth_stride
+        = ( twist_type::depth_index == 2 ? 1 : ( twist_type::depth_index == 1 ? raw_index2_size : raw_index1_size * raw_index2_size ) );
+
+    /// The position in the flat storage of the item at raw indexes (index0,index1,index2)
+    static constexpr std::size_t raw_linear_index( std::size_t index0, std::size_t index1, std::size_t index2 )
+    {
+        return ( index0 * raw_index1_size + index1 ) * raw_index2_size + index2;
+    }
+
+    /// The position in the flat storage of the item at (width_pos,height_pos,depth_pos)
+    static constexpr std::size_t linear_index( std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos )
+    {
+        return width_pos * width_stride + height_pos * height_stride + depth_pos * depth_stride;
+    }
+
+    /// The first of the item_count contiguous items
+    static value_type *data( type &a ) { return a.data(); }
+
+    static value_type const *data( type const &a ) { return a.data(); }
 
     static value_type &rawget( type &a, std::size_t index0, std::size_t index1, std::size_t index2 )
     {
-        return a[index0][index1][index2];
+        return a[raw_linear_index( index0, index1, index2 )];
     }
 
     static value_type rawget( type const &a, std::size_t index0, std::size_t index1, std::size_t index2 )
     {
-        return a[index0][index1][index2];
+        return a[raw_linear_index( index0, index1, index2 )];
     }
 
     static void rawset( type &a, value_type const &v, std::size_t index0, std::size_t index1, std::size_t index2 )
     {
-        a[index0][index1][index2] = v;
+        a[raw_linear_index( index0, index1, index2 )] = v;
     }
 
     static inline T &get( type &a, std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos )
     {
-        auto pos = std::make_tuple( width_pos, height_pos, depth_pos );
-        std::size_t index0 = twist_type::width_pos_from( pos );
-        std::size_t index1 = twist_type::height_pos_from( pos );
-        std::size_t index2 = twist_type::depth_pos_from( pos );
-
-        return a[index2][index1][index0];
+        return a[linear_index( width_pos, height_pos, depth_pos )];
     }
 
     static inline T get( type const &a, std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos )
     {
-        auto pos = std::make_tuple( width_pos, height_pos, depth_pos );
-        std::size_t index0 = twist_type::width_pos_from( pos );
-        std::size_t index1 = twist_type::height_pos_from( pos );
-        std::size_t index2 = twist_type::depth_pos_from( pos );
-
-        return a[index2][index1][index0];
+        return a[linear_index( width_pos, height_pos, depth_pos )];
     }
 
     static inline void set( type &a, value_type const &v, std::size_t width_pos, std::size_t height_pos, std::size_t depth_pos )
     {
-        auto pos = std::make_tuple( width_pos, height_pos, depth_pos );
-        std::size_t index0 = twist_type::width_pos_from( pos );
-        std::size_t index1 = twist_type::height_pos_from( pos );
-        std::size_t index2 = twist_type::depth_pos_from( pos );
-
-        a[index2][index1][index0] = v;
+        a[linear_index( width_pos, height_pos, depth_pos )] = v;
     }
 };
-}
+
+DAP_NAMESPACE_END
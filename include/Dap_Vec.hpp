@@ -33,8 +33,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Dap_World.hpp"
 #include "Dap_SIMD.hpp"
 
-namespace Dap
-{
+DAP_NAMESPACE_BEGIN
 template <typename T, size_t N>
 using Vec = SIMD_Vector<T, N>;
-}
+DAP_NAMESPACE_END
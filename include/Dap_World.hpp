@@ -37,6 +37,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <array>
 #include <vector>
 #include <cmath>
+#include <cfloat>
+#include <limits>
 #include <cstdint>
 #include <complex>
 #include <functional>
@@ -47,6 +49,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iterator>
 #include <algorithm>
 #include <atomic>
+#include <thread>
 #include <iosfwd>
 #include <iostream>
 
@@ -60,6 +63,51 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define DAP_CACHE_ALIGN alignas( DAP_CACHELINESIZE )
 #endif
 
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define DAP_PREFETCH( addr ) __builtin_prefetch( addr )
+#else
+#define DAP_PREFETCH( addr )
+#endif
+
+/// Fully unroll the loop that follows, for short loops with a compile time trip count
+#if defined( __clang__ )
+#define DAP_UNROLL _Pragma( "unroll" )
+#elif defined( __GNUC__ ) && __GNUC__ >= 8
+#define DAP_UNROLL _Pragma( "GCC unroll 16" )
+#else
+#define DAP_UNROLL
+#endif
+
 #if defined(_MSC_VER)
 #define constexpr
-#endif
\ No newline at end of file
+#endif
+/**
+ * Everything in the Dap headers lives in an inline namespace named after the
+ * instruction set the including translation unit is compiled for. Code built
+ * with different ISA flags (see Dap_Dispatch.hpp) can then be linked into one
+ * program without the inline templates of one variant silently replacing
+ * those of another.
+ */
+#ifndef DAP_ARCH_NAMESPACE
+#if defined( __AVX2__ ) && defined( __FMA__ )
+#define DAP_ARCH_NAMESPACE arch_avx2
+#elif defined( __AVX__ )
+#define DAP_ARCH_NAMESPACE arch_avx
+#elif defined( __SSE2__ )
+#define DAP_ARCH_NAMESPACE arch_sse2
+#elif defined( __ARM_NEON__ )
+#define DAP_ARCH_NAMESPACE arch_neon
+#else
+#define DAP_ARCH_NAMESPACE arch_generic
+#endif
+#endif
+
+#define DAP_NAMESPACE_BEGIN                                                                                                      \
+    namespace Dap                                                                                                                \
+    {                                                                                                                            \
+    inline namespace DAP_ARCH_NAMESPACE                                                                                          \
+    {
+
+#define DAP_NAMESPACE_END                                                                                                        \
+    }                                                                                                                            \
+    }
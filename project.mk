@@ -14,4 +14,10 @@ PKGCONFIG_PACKAGES+=
 
 CXXFLAGS_MACOSX+=-std=c++11 -stdlib=libc++
 CXXFLAGS_LINUX+=-std=c++11
+LDLIBS_LINUX+=-lpthread
 
+
+# Runtime dispatched kernel variants, see include/Dap_Dispatch.hpp
+%/Dap_Dispatch_sse2.o : LOCAL_COMPILE_FLAGS+=-msse2
+%/Dap_Dispatch_avx.o : LOCAL_COMPILE_FLAGS+=-mavx
+%/Dap_Dispatch_avx2.o : LOCAL_COMPILE_FLAGS+=-mavx2 -mfma
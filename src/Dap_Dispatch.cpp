@@ -0,0 +1,213 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_Dispatch.hpp"
+#include "Dap_DispatchKernels.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define DAP_DISPATCH_X86 1
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+const char *Dap_dispatch_file = __FILE__;
+
+namespace
+{
+
+#if defined( DAP_DISPATCH_X86 )
+
+struct CpuidRegs
+{
+    unsigned int eax, ebx, ecx, edx;
+};
+
+CpuidRegs cpuid( unsigned int leaf, unsigned int subleaf )
+{
+    CpuidRegs r = {0, 0, 0, 0};
+#if defined( _MSC_VER )
+    int regs[4];
+    __cpuidex( regs, static_cast<int>( leaf ), static_cast<int>( subleaf ) );
+    r.eax = static_cast<unsigned int>( regs[0] );
+    r.ebx = static_cast<unsigned int>( regs[1] );
+    r.ecx = static_cast<unsigned int>( regs[2] );
+    r.edx = static_cast<unsigned int>( regs[3] );
+#else
+    if ( leaf <= __get_cpuid_max( 0, 0 ) )
+    {
+        __cpuid_count( leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx );
+    }
+#endif
+    return r;
+}
+
+/// The XCR0 register, which tells which register sets the operating system saves on a context switch
+unsigned long long xgetbv0()
+{
+#if defined( _MSC_VER )
+    return _xgetbv( 0 );
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+    return ( static_cast<unsigned long long>( edx ) << 32 ) | eax;
+#endif
+}
+
+struct CpuFeatures
+{
+    bool sse2, avx, avx2;
+
+    CpuFeatures() : sse2( false ), avx( false ), avx2( false )
+    {
+        CpuidRegs l1 = cpuid( 1, 0 );
+        CpuidRegs l7 = cpuid( 7, 0 );
+        bool osxsave = ( l1.ecx & ( 1u << 27 ) ) != 0;
+        bool ymm_saved = osxsave && ( xgetbv0() & 0x6 ) == 0x6;
+        bool fma = ( l1.ecx & ( 1u << 12 ) ) != 0;
+
+        sse2 = ( l1.edx & ( 1u << 26 ) ) != 0;
+        avx = ymm_saved && ( l1.ecx & ( 1u << 28 ) ) != 0;
+        avx2 = avx && fma && ( l7.ebx & ( 1u << 5 ) ) != 0;
+    }
+};
+
+#else
+
+struct CpuFeatures
+{
+    bool sse2, avx, avx2;
+
+    CpuFeatures() : sse2( false ), avx( false ), avx2( false ) {}
+};
+
+#endif
+
+CpuFeatures const &cpu_features()
+{
+    static const CpuFeatures features;
+    return features;
+}
+
+Dap::DispatchKernels const *select_kernels()
+{
+    using namespace Dap;
+
+    std::size_t limit = cpu_variant_count - 1;
+    if ( char const *forced = std::getenv( "DAP_CPU_VARIANT" ) )
+    {
+        for ( std::size_t i = 0; i < cpu_variant_count; ++i )
+        {
+            if ( std::strcmp( forced, cpu_variant_name( static_cast<CpuVariant>( i ) ) ) == 0 )
+            {
+                limit = i;
+            }
+        }
+    }
+
+    for ( std::size_t i = limit + 1; i-- > 0; )
+    {
+        if ( DispatchKernels const *k = dispatch_kernels( static_cast<CpuVariant>( i ) ) )
+        {
+            return k;
+        }
+    }
+    return DispatchVariantDetail::kernels_baseline();
+}
+}
+
+const char *Dap::cpu_variant_name( CpuVariant v )
+{
+    switch ( v )
+    {
+    case CpuVariant::baseline:
+        return "baseline";
+    case CpuVariant::sse2:
+        return "sse2";
+    case CpuVariant::avx:
+        return "avx";
+    case CpuVariant::avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+bool Dap::cpu_supports( CpuVariant v )
+{
+    switch ( v )
+    {
+    case CpuVariant::baseline:
+        return true;
+    case CpuVariant::sse2:
+        return cpu_features().sse2;
+    case CpuVariant::avx:
+        return cpu_features().avx;
+    case CpuVariant::avx2:
+        return cpu_features().avx2;
+    }
+    return false;
+}
+
+Dap::DispatchKernels const *Dap::dispatch_kernels( CpuVariant v )
+{
+    if ( !cpu_supports( v ) )
+    {
+        return nullptr;
+    }
+    switch ( v )
+    {
+    case CpuVariant::baseline:
+        return DispatchVariantDetail::kernels_baseline();
+    case CpuVariant::sse2:
+        return DispatchVariantDetail::kernels_sse2();
+    case CpuVariant::avx:
+        return DispatchVariantDetail::kernels_avx();
+    case CpuVariant::avx2:
+        return DispatchVariantDetail::kernels_avx2();
+    }
+    return nullptr;
+}
+
+Dap::DispatchKernels const &Dap::dispatch()
+{
+    static DispatchKernels const *const kernels = select_kernels();
+    return *kernels;
+}
+
+Dap::DispatchKernels const *Dap::DispatchVariantDetail::kernels_baseline()
+{
+    static const DispatchKernels kernels = DispatchDetail::make_kernels( CpuVariant::baseline );
+    return &kernels;
+}
@@ -0,0 +1,231 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_ThreadPool.hpp"
+
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+const char *Dap_threadpool_file = __FILE__;
+
+namespace
+{
+
+void pin_to_core( std::size_t core )
+{
+#if defined( __linux__ )
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( static_cast<int>( core % CPU_SETSIZE ), &set );
+    pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+#else
+    (void)core;
+#endif
+}
+}
+
+/// The tasks of one parallel_for call
+struct Dap::ThreadPool::Job
+{
+    std::function<void( std::size_t )> const *f;
+    std::atomic<std::size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+Dap::ThreadPool::ThreadPool( std::size_t threads, bool pin ) : m_pending( 0 ), m_stop( false )
+{
+    const std::size_t cores = std::max<std::size_t>( 1, std::thread::hardware_concurrency() );
+    if ( threads == 0 )
+    {
+        threads = cores;
+    }
+    for ( std::size_t i = 0; i < threads; ++i )
+    {
+        m_queues.emplace_back( new Queue );
+    }
+    m_workers.reserve( threads );
+    for ( std::size_t i = 0; i < threads; ++i )
+    {
+        m_workers.emplace_back( &ThreadPool::worker, this, i, pin );
+    }
+}
+
+Dap::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_wake_mutex );
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for ( auto &t : m_workers )
+    {
+        t.join();
+    }
+}
+
+void Dap::ThreadPool::parallel_for( std::size_t count, std::function<void( std::size_t )> const &f )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+    if ( count == 1 || m_workers.empty() )
+    {
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            f( i );
+        }
+        return;
+    }
+
+    Job job;
+    job.f = &f;
+    job.remaining.store( count );
+
+    const std::size_t queues = m_queues.size();
+    m_pending.fetch_add( count );
+    for ( std::size_t q = 0; q < queues; ++q )
+    {
+        std::lock_guard<std::mutex> lock( m_queues[q]->mutex );
+        for ( std::size_t i = q; i < count; i += queues )
+        {
+            Task task = {&job, i};
+            m_queues[q]->tasks.push_back( task );
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_wake_mutex );
+    }
+    m_wake.notify_all();
+
+    // help until nothing is left to steal, then wait for the tasks that are still running
+    Task task;
+    while ( job.remaining.load() > 0 && pop( queues, task ) )
+    {
+        run( task );
+    }
+    {
+        std::unique_lock<std::mutex> lock( job.mutex );
+        job.done.wait( lock, [&job]() { return job.remaining.load() == 0; } );
+    }
+
+    if ( job.error )
+    {
+        std::rethrow_exception( job.error );
+    }
+}
+
+Dap::ThreadPool &Dap::ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+bool Dap::ThreadPool::pop( std::size_t own, Task &task )
+{
+    const std::size_t queues = m_queues.size();
+    if ( own < queues )
+    {
+        Queue &q = *m_queues[own];
+        std::lock_guard<std::mutex> lock( q.mutex );
+        if ( !q.tasks.empty() )
+        {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+            m_pending.fetch_sub( 1 );
+            return true;
+        }
+    }
+    for ( std::size_t i = 1; i <= queues; ++i )
+    {
+        Queue &q = *m_queues[( own + i ) % queues];
+        std::lock_guard<std::mutex> lock( q.mutex );
+        if ( !q.tasks.empty() )
+        {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            m_pending.fetch_sub( 1 );
+            return true;
+        }
+    }
+    return false;
+}
+
+void Dap::ThreadPool::run( Task const &task )
+{
+    Job &job = *task.job;
+    try
+    {
+        ( *job.f )( task.index );
+    }
+    catch ( ... )
+    {
+        std::lock_guard<std::mutex> lock( job.mutex );
+        if ( !job.error )
+        {
+            job.error = std::current_exception();
+        }
+    }
+    // the last decrement is made under the lock so that parallel_for cannot return and destroy the job before the
+    // notification is done
+    std::lock_guard<std::mutex> lock( job.mutex );
+    if ( job.remaining.fetch_sub( 1 ) == 1 )
+    {
+        job.done.notify_all();
+    }
+}
+
+void Dap::ThreadPool::worker( std::size_t own, bool pin )
+{
+    if ( pin )
+    {
+        pin_to_core( own );
+    }
+    for ( ;; )
+    {
+        Task task;
+        if ( pop( own, task ) )
+        {
+            run( task );
+            continue;
+        }
+        std::unique_lock<std::mutex> lock( m_wake_mutex );
+        m_wake.wait( lock, [this]() { return m_stop || m_pending.load() > 0; } );
+        if ( m_stop )
+        {
+            return;
+        }
+    }
+}
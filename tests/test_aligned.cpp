@@ -0,0 +1,120 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+bool check_vectors()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    typedef SIMD_Vector<float, simd_native_size<float>::value> NativeFloat;
+    typedef SIMD_Vector<double, simd_native_size<double>::value> NativeDouble;
+    static_assert( alignof( NativeFloat ) == DAP_SIMD_NATIVE_BYTES, "native float vectors are aligned to their width" );
+    static_assert( alignof( NativeDouble ) == DAP_SIMD_NATIVE_BYTES, "native double vectors are aligned to their width" );
+    static_assert( alignof( SIMD_Vector<float, 16> ) == DAP_SIMD_NATIVE_BYTES,
+                   "vectors of native registers are aligned to the register width" );
+
+    std::vector<NativeFloat, aligned_allocator<NativeFloat, alignof( NativeFloat )> > v( 37 );
+    for ( std::size_t i = 0; i < v.size(); ++i )
+    {
+        ok &= is_aligned( &v[i], alignof( NativeFloat ) );
+    }
+
+    std::vector<float, aligned_allocator<float> > samples( 1001, 1.0f );
+    ok &= is_aligned( samples.data(), DAP_CACHELINESIZE );
+    std::vector<double, aligned_allocator<float>::rebind<double>::other> wide( 3 );
+    ok &= is_aligned( wide.data(), DAP_CACHELINESIZE );
+    ok &= aligned_allocator<float>() == aligned_allocator<double>();
+
+    bool threw = false;
+    try
+    {
+        aligned_allocator<double, 32>().allocate( aligned_allocator<double, 32>().max_size() + 1 );
+    }
+    catch ( std::bad_alloc const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "aligned vectors and allocator" << std::endl;
+    return ok;
+}
+
+bool check_blocks()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    typedef Block<float, twist0, 5, 3, 1> SmallBlock;
+    static_assert( SmallBlock::alignment == DAP_SIMD_NATIVE_BYTES, "Block items are aligned to the SIMD width" );
+    static_assert( BlockDetail::layout<SmallBlock>::alignment == SmallBlock::alignment, "the layout advertises it" );
+    static_assert( BlockDetail::layout<DynBlock<float, twist0> >::alignment == DAP_CACHELINESIZE,
+                   "DynBlock items are cache line aligned" );
+    static_assert( BlockDetail::layout<BlockView<float, twist0> >::alignment == alignof( float ),
+                   "a view only guarantees the alignment of its items" );
+
+    struct Holder
+    {
+        char c;
+        SmallBlock block;
+    } holder;
+    ok &= is_aligned( holder.block.data(), SmallBlock::alignment );
+
+    std::unique_ptr<SmallBlock> heap( new SmallBlock );
+    ok &= is_aligned( heap->data(), SmallBlock::alignment );
+    std::unique_ptr<SmallBlock[]> heap_array( new SmallBlock[3] );
+    ok &= is_aligned( heap_array[1].data(), SmallBlock::alignment );
+
+    auto dyn = make_block<twist2>( 2.0f, 7, 3, 2 );
+    ok &= is_aligned( dyn.data(), decltype( dyn )::alignment );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "aligned blocks" << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= check_vectors();
+    ok &= check_blocks();
+
+    return ok ? 0 : 1;
+}
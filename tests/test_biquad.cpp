@@ -0,0 +1,424 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+template <typename T>
+bool same( T const &a, T const &b )
+{
+    using item_type = typename Dap::simd_flattened_type<T>::type;
+    item_type const *pa = reinterpret_cast<item_type const *>( &a );
+    item_type const *pb = reinterpret_cast<item_type const *>( &b );
+    for ( size_t i = 0; i < Dap::simd_flattened_size<T>::value; ++i )
+    {
+        if ( pa[i] != pb[i] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Equal within tolerance, for paths where the compiler may contract a different set of multiply-adds into fma
+template <typename T>
+bool close( T const &a, T const &b )
+{
+    using item_type = typename Dap::simd_flattened_type<T>::type;
+    const double tolerance = sizeof( item_type ) == 4 ? 1e-4 : 1e-10;
+    item_type const *pa = reinterpret_cast<item_type const *>( &a );
+    item_type const *pb = reinterpret_cast<item_type const *>( &b );
+    for ( size_t i = 0; i < Dap::simd_flattened_size<T>::value; ++i )
+    {
+        if ( std::abs( double( pa[i] ) - double( pb[i] ) ) > tolerance * std::max( 1.0, std::abs( double( pb[i] ) ) ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+Dap::BiQuad<T> make_filter()
+{
+    using namespace Dap;
+    BiQuad<T> filter;
+    for ( size_t i = 0; i < simd_flattened_size<T>::value; ++i )
+    {
+        filter.coeffs.calculate_peak( i, Constants::recip_96k(), 1e3 * ( i + 1 ), 0.7, 6.0 );
+    }
+    return filter;
+}
+
+template <typename T>
+T random_value( std::mt19937 &gen )
+{
+    std::uniform_real_distribution<double> dist( -1.0, 1.0 );
+    T v;
+    for ( size_t i = 0; i < Dap::simd_flattened_size<T>::value; ++i )
+    {
+        Dap::set_flattened_item( v, static_cast<typename Dap::simd_flattened_type<T>::type>( dist( gen ) ), i );
+    }
+    return v;
+}
+
+/// The buffer API must produce exactly the same samples and final state as calling operator() per sample
+template <typename T>
+bool check_buffer( std::string const &name )
+{
+    const size_t n = 1000;
+    std::mt19937 gen( 42 );
+    std::vector<T> input( n );
+    for ( auto &v : input )
+    {
+        v = random_value<T>( gen );
+    }
+
+    Dap::BiQuad<T> reference = make_filter<T>();
+    std::vector<T> expected( n );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        expected[i] = reference( input[i] );
+    }
+
+    bool ok = true;
+
+    // split into uneven pieces to check that the state carries across calls
+    Dap::BiQuad<T> filter = make_filter<T>();
+    std::vector<T> output( n );
+    filter.process( &input[0], &output[0], 333 );
+    filter.process( &input[333], &output[333], n - 333 );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        ok &= same( output[i], expected[i] );
+    }
+    ok &= same( filter.state.z1, reference.state.z1 ) && same( filter.state.z2, reference.state.z2 );
+
+    Dap::BiQuad<T> in_place = make_filter<T>();
+    std::vector<T> buffer( input );
+    in_place.process( &buffer[0], n );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        ok &= same( buffer[i], expected[i] );
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "buffer " << name << std::endl;
+    return ok;
+}
+
+/// Filtering a block along each axis must match filtering the extracted line per sample
+template <typename T, typename TwistType>
+bool check_block( std::string const &name )
+{
+    using namespace Dap;
+    const size_t width = 64, height = 3, depth = 5;
+    std::mt19937 gen( 7 );
+    auto input = fill_block<T, TwistType, width, height, depth>( [&]( size_t, size_t, size_t )
+                                                                 { return random_value<T>( gen ); } );
+    auto output = input;
+    bool ok = true;
+
+    const Axis axes[] = {Axis::width, Axis::height, Axis::depth};
+    for ( Axis axis : axes )
+    {
+        using BlockType = decltype( input );
+        const size_t others0 = axis == Axis::width ? height : width;
+        const size_t others1 = axis == Axis::depth ? height : depth;
+        for ( size_t o0 = 0; o0 < others0; ++o0 )
+        {
+            for ( size_t o1 = 0; o1 < others1; ++o1 )
+            {
+                BiQuad<T> reference = make_filter<T>();
+                BiQuad<T> filter = make_filter<T>();
+                filter.process( input, output, axis, o0, o1 );
+
+                auto in_place = input;
+                BiQuad<T> in_place_filter = make_filter<T>();
+                in_place_filter.process( in_place, axis, o0, o1 );
+
+                for ( size_t i = 0; i < axis_size<BlockType>( axis ); ++i )
+                {
+                    auto pos = axis_position( axis, i, o0, o1 );
+                    size_t w = std::get<0>( pos ), h = std::get<1>( pos ), d = std::get<2>( pos );
+                    T expected = reference( get( input, w, h, d ) );
+                    ok &= same( get( output, w, h, d ), expected );
+                    ok &= same( get( in_place, w, h, d ), expected );
+                }
+            }
+        }
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "block " << name << std::endl;
+    return ok;
+}
+
+/// A cascade must match the same sections run one after another with per-sample operator()
+template <typename T, std::size_t Stages>
+bool check_cascade( std::string const &name )
+{
+    using namespace Dap;
+    const size_t n = 1000;
+    std::mt19937 gen( 3 );
+    std::vector<T> input( n );
+    for ( auto &v : input )
+    {
+        v = random_value<T>( gen );
+    }
+
+    BiQuadCascade<T, Stages> cascade;
+    std::array<BiQuad<T>, Stages> chain;
+    for ( size_t s = 0; s < Stages; ++s )
+    {
+        for ( size_t i = 0; i < simd_flattened_size<T>::value; ++i )
+        {
+            double freq = 100.0 * ( s + 1 ) + 10.0 * i;
+            cascade.coeffs[s].calculate_peak( i, Constants::recip_96k(), freq, 2.0, s % 2 ? 3.0 : -3.0 );
+            chain[s].coeffs.calculate_peak( i, Constants::recip_96k(), freq, 2.0, s % 2 ? 3.0 : -3.0 );
+        }
+    }
+
+    bool ok = true;
+    std::vector<T> output( n );
+    cascade.process( &input[0], &output[0], 500 );
+    for ( size_t i = 500; i < n; ++i )
+    {
+        output[i] = cascade( input[i] );
+    }
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        T v = input[i];
+        for ( auto &f : chain )
+        {
+            v = f( v );
+        }
+        ok &= close( output[i], v );
+    }
+    for ( size_t s = 0; s < Stages; ++s )
+    {
+        ok &= close( cascade.state[s].z1, chain[s].state.z1 ) && close( cascade.state[s].z2, chain[s].state.z2 );
+    }
+
+    auto block = fill_block<T, twist1, 128, 2, 1>( [&]( size_t, size_t, size_t ) { return random_value<T>( gen ); } );
+    auto expected = block;
+    BiQuadCascade<T, Stages> block_cascade = cascade;
+    cascade.process( block, Axis::width, 1, 0 );
+    for ( size_t w = 0; w < 128; ++w )
+    {
+        T v = get( expected, w, 1, 0 );
+        for ( auto &f : chain )
+        {
+            v = f( v );
+        }
+        ok &= close( get( block, w, 1, 0 ), v ) && close( get( block, w, 0, 0 ), get( expected, w, 0, 0 ) );
+    }
+    block_cascade.process( expected, expected, Axis::width, 1, 0 );
+    for ( size_t w = 0; w < 128; ++w )
+    {
+        ok &= close( get( block, w, 1, 0 ), get( expected, w, 1, 0 ) );
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "cascade " << name << std::endl;
+    return ok;
+}
+
+/// The look-ahead filter must stay within its documented error bound relative to per-sample operator(),
+/// both measured against the same section evaluated in long double
+template <typename T, std::size_t N>
+bool check_lookahead( std::string const &name )
+{
+    using namespace Dap;
+    const size_t n = 10007;
+    std::mt19937 gen( 11 );
+    std::uniform_real_distribution<double> dist( -1.0, 1.0 );
+    std::vector<T> input( n );
+    for ( auto &v : input )
+    {
+        v = static_cast<T>( dist( gen ) );
+    }
+
+    bool ok = true;
+    double worst = 0.0;
+    const double freqs[] = {50.0, 200.0, 1e3, 12e3, 40e3};
+    for ( double freq : freqs )
+    {
+        for ( int design = 0; design < 3; ++design )
+        {
+            typename BiQuad<T>::Coeffs c;
+            if ( design == 0 )
+            {
+                c.calculate_lowpass( 0, Constants::recip_96k(), freq, 0.707 );
+            }
+            else if ( design == 1 )
+            {
+                c.calculate_highpass( 0, Constants::recip_96k(), freq, 4.0 );
+            }
+            else
+            {
+                c.calculate_peak( 0, Constants::recip_96k(), freq, 1.0, 12.0 );
+            }
+
+            BiQuad<T> scalar;
+            scalar.coeffs = c;
+            BiQuadLookAhead<T, N> filter( c );
+            std::vector<T> output( n );
+            filter.process( &input[0], &output[0], n / 2 );
+            filter.process( &input[n / 2], &output[n / 2], n - n / 2 );
+
+            long double z1 = 0, z2 = 0;
+            double scalar_error = 0.0, lookahead_error = 0.0;
+            for ( size_t i = 0; i < n; ++i )
+            {
+                long double x = input[i];
+                long double y = x * c.a0 + z1;
+                z1 = x * c.a1 + z2 - c.b1 * y;
+                z2 = x * c.a2 - c.b2 * y;
+                scalar_error = std::max( scalar_error, double( std::abs( scalar( input[i] ) - y ) ) );
+                lookahead_error = std::max( lookahead_error, double( std::abs( output[i] - y ) ) );
+            }
+
+#if defined( DAP_HAS_FMA )
+            // operator() rounds once per multiply-add, so the same look-ahead error is a larger multiple of it
+            const double low_factor = 40.0;
+#else
+            const double low_factor = 20.0;
+#endif
+            const double factor = freq < 96e3 / 100.0 ? low_factor : 5.0;
+            const double ratio = lookahead_error / std::max( scalar_error, double( std::numeric_limits<T>::epsilon() ) );
+            ok &= ratio <= factor;
+            worst = std::max( worst, ratio );
+        }
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "look-ahead " << name << ": max error " << worst << "x that of operator()"
+              << std::endl;
+    return ok;
+}
+
+/// Every channel of a bank must match its own BiQuad run per sample, including the partial last chunk and
+/// when the channels are split across threads
+template <typename T, std::size_t Channels>
+bool check_bank( std::string const &name,
+                 std::size_t threads,
+                 std::size_t frames,
+                 std::size_t frame_stride,
+                 Dap::ThreadPool *pool = nullptr )
+{
+    using namespace Dap;
+    std::mt19937 gen( 5 );
+    std::uniform_real_distribution<double> dist( -1.0, 1.0 );
+    std::vector<T> input( frames * frame_stride );
+    for ( auto &v : input )
+    {
+        v = static_cast<T>( dist( gen ) );
+    }
+
+    BiQuadBank<T, Channels> bank;
+    bank.max_threads = threads;
+    bank.pool = pool;
+    std::vector<BiQuad<T> > reference( Channels );
+    for ( size_t c = 0; c < Channels; ++c )
+    {
+        reference[c].coeffs.calculate_peak( 0, Constants::recip_96k(), 100.0 + 37.0 * c, 1.5, c % 2 ? 6.0 : -6.0 );
+        bank.set_coeffs( c, reference[c].coeffs );
+    }
+
+    // first half out of place, second half in place
+    const size_t half = frames / 2;
+    std::vector<T> output( input.size(), T( 0 ) );
+    bank.process( &input[0], &output[0], half, frame_stride );
+    std::copy( input.begin() + half * frame_stride, input.end(), output.begin() + half * frame_stride );
+    bank.process( &output[half * frame_stride], frames - half, frame_stride );
+
+    bool ok = true;
+    for ( size_t f = 0; f < frames; ++f )
+    {
+        for ( size_t c = 0; c < frame_stride; ++c )
+        {
+            T const &v = output[f * frame_stride + c];
+            if ( c < Channels )
+            {
+                ok &= close( v, reference[c]( input[f * frame_stride + c] ) );
+            }
+            else
+            {
+                // channels past the bank in a wider frame are left untouched
+                ok &= ( f < half ? v == T( 0 ) : v == input[f * frame_stride + c] );
+            }
+        }
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "bank " << name << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    // float and double process() run the dispatched kernels. The baseline ones are built with the same flags as
+    // operator(), so they round the same; test_dispatch compares the other variants with the scalar code
+    setenv( "DAP_CPU_VARIANT", "baseline", 1 );
+
+    ok &= check_buffer<float>( "float" );
+    ok &= check_buffer<double>( "double" );
+    ok &= check_buffer<Vec<float, 4> >( "float x 4" );
+    ok &= check_buffer<Vec<double, 2> >( "double x 2" );
+
+    ok &= check_block<float, twist0>( "float twist0" );
+    ok &= check_block<float, twist2>( "float twist2" );
+    ok &= check_block<Vec<float, 4>, twist1>( "float x 4 twist1" );
+
+    ok &= check_cascade<float, 1>( "float x 1 stage" );
+    ok &= check_cascade<double, 8>( "double x 8 stages" );
+    ok &= check_cascade<Vec<float, 4>, 16>( "float x 4 x 16 stages" );
+
+    ok &= check_lookahead<float, 4>( "float x 4" );
+    ok &= check_lookahead<float, 8>( "float x 8" );
+    ok &= check_lookahead<double, 2>( "double x 2" );
+    ok &= check_lookahead<double, 4>( "double x 4" );
+
+    ok &= check_bank<float, 1>( "float x 1", 1, 100, 1 );
+    ok &= check_bank<float, 13>( "float x 13", 1, 100, 16 );
+    ok &= check_bank<double, 7>( "double x 7", 1, 100, 7 );
+    ok &= check_bank<float, 515>( "float x 515 threaded", 3, 512, 515 );
+    ok &= check_bank<double, 512>( "double x 512 threaded", 4, 256, 512 );
+    ThreadPool pool( 3 );
+    ok &= check_bank<float, 1000>( "float x 1000 on a pool of 3", 8, 200, 1003, &pool );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+
+namespace
+{
+
+float value_at( std::size_t w, std::size_t h, std::size_t d )
+{
+    return static_cast<float>( w * 10000 + h * 100 + d );
+}
+
+template <typename BlockT>
+bool matches( BlockT const &b, float scale, float offset )
+{
+    bool ok = true;
+    for ( std::size_t w = 0; w < Dap::Traits<BlockT>::width; ++w )
+    {
+        for ( std::size_t h = 0; h < Dap::Traits<BlockT>::height; ++h )
+        {
+            for ( std::size_t d = 0; d < Dap::Traits<BlockT>::depth; ++d )
+            {
+                ok &= Dap::get( b, w, h, d ) == value_at( w, h, d ) * scale + offset;
+            }
+        }
+    }
+    return ok;
+}
+
+template <typename SourceTwist, typename DestinationTwist>
+bool check_twists( std::string const &name )
+{
+    using namespace Dap;
+    const std::size_t width = 13, height = 5, depth = 3;
+    bool ok = true;
+
+    auto src = fill_block<float, SourceTwist, width, height, depth>( value_at );
+    ok &= matches( src, 1.0f, 0.0f );
+
+    // positions passed to the functor match the item
+    apply_block( src, []( float v, std::size_t w, std::size_t h, std::size_t d )
+                 {
+        return v == value_at( w, h, d ) ? v * 2.0f : -1.0f;
+    } );
+    ok &= matches( src, 2.0f, 0.0f );
+
+    auto dest = make_block<DestinationTwist, width, height, depth>( 0.0f );
+    apply_block( src, dest, []( float v, std::size_t, std::size_t, std::size_t )
+                 {
+        return v + 1.0f;
+    } );
+    ok &= matches( dest, 2.0f, 1.0f );
+
+    auto sum = make_block<DestinationTwist, width, height, depth>( 0.0f );
+    apply_block( src, dest, sum, []( float a, float b, std::size_t, std::size_t, std::size_t )
+                 {
+        return a + b;
+    } );
+    ok &= matches( sum, 4.0f, 1.0f );
+
+    auto copy = make_block<DestinationTwist, width, height, depth>( 7.0f );
+    ok &= matches( copy, 0.0f, 7.0f );
+    copy_block( src, copy );
+    ok &= matches( copy, 2.0f, 0.0f );
+
+    // every item sits at linear_index( w, h, d ) of the flat storage
+    using twist_array_type = typename Traits<decltype( src )>::twist_array_type;
+    float const *items = src.data();
+    std::size_t strides = 0;
+    for ( std::size_t w = 0; w < width; ++w )
+    {
+        for ( std::size_t h = 0; h < height; ++h )
+        {
+            for ( std::size_t d = 0; d < depth; ++d )
+            {
+                ok &= items + twist_array_type::linear_index( w, h, d ) == &get( src, w, h, d );
+            }
+        }
+    }
+    strides += twist_array_type::width_stride * ( width - 1 );
+    strides += twist_array_type::height_stride * ( height - 1 );
+    strides += twist_array_type::depth_stride * ( depth - 1 );
+    ok &= strides == width * height * depth - 1;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "block algorithms " << name << std::endl;
+    return ok;
+}
+
+/// Sizes that are not multiples of the tile or SIMD_Vector sizes exercise every edge of the tiled transposition
+template <typename T, typename SourceTwist, typename DestinationTwist>
+bool check_transpose( std::string const &name )
+{
+    using namespace Dap;
+    const std::size_t width = 67, height = 37, depth = 3;
+    bool ok = true;
+
+    std::unique_ptr<Block<T, SourceTwist, width, height, depth> > src( new Block<T, SourceTwist, width, height, depth> );
+    std::unique_ptr<Block<T, DestinationTwist, width, height, depth> > dest(
+        new Block<T, DestinationTwist, width, height, depth> );
+    apply_block( *src, []( T, std::size_t w, std::size_t h, std::size_t d )
+                 {
+        return static_cast<T>( value_at( w, h, d ) );
+    } );
+    copy_block( *src, *dest );
+    ok &= matches( *dest, 1.0f, 0.0f );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "transpose " << name << std::endl;
+    return ok;
+}
+
+template <int TwistAmount>
+bool check_twist_block()
+{
+    using namespace Dap;
+    auto src = fill_block<float, twist1, 19, 11, 5>( value_at );
+    auto r = twist_block<TwistAmount>( src );
+    bool ok = matches( r, 1.0f, 0.0f );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "twist_block<" << TwistAmount << ">" << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    ok &= check_twists<twist0, twist0>( "twist0 -> twist0" );
+    ok &= check_twists<twist1, twist1>( "twist1 -> twist1" );
+    ok &= check_twists<twist0, twist2>( "twist0 -> twist2" );
+    ok &= check_twists<twist3, twist1>( "twist3 -> twist1" );
+    ok &= check_twists<twist4, twist5>( "twist4 -> twist5" );
+
+    ok &= check_transpose<float, twist0, twist1>( "float twist0 -> twist1" );
+    ok &= check_transpose<float, twist0, twist3>( "float twist0 -> twist3" );
+    ok &= check_transpose<float, twist2, twist4>( "float twist2 -> twist4" );
+    ok &= check_transpose<float, twist5, twist0>( "float twist5 -> twist0" );
+    ok &= check_transpose<double, twist0, twist1>( "double twist0 -> twist1" );
+    ok &= check_transpose<double, twist4, twist2>( "double twist4 -> twist2" );
+
+    ok &= check_twist_block<0>();
+    ok &= check_twist_block<1>();
+    ok &= check_twist_block<2>();
+    ok &= check_twist_block<3>();
+    ok &= check_twist_block<4>();
+    ok &= check_twist_block<5>();
+
+    return ok ? 0 : 1;
+}
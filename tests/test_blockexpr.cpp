@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+float signal_a( std::size_t w, std::size_t h, std::size_t d )
+{
+    return std::sin( 0.1f * static_cast<float>( w + 7 * h + 31 * d ) );
+}
+
+float signal_b( std::size_t w, std::size_t h, std::size_t d )
+{
+    return std::cos( 0.07f * static_cast<float>( 3 * w + h + 17 * d ) );
+}
+
+float gain( std::size_t w, std::size_t h, std::size_t d )
+{
+    return static_cast<float>( w ) / 64.0f + 0.01f * static_cast<float>( h + d );
+}
+
+bool near( float a, float b )
+{
+    return std::fabs( a - b ) <= 1e-5f;
+}
+
+struct expr_tag
+{
+};
+
+template <typename ATwist, typename BTwist, typename GainTwist, typename OutTwist>
+bool check_crossfade( std::string const &name )
+{
+    using namespace Dap;
+    using Counter = CountingInstrument<expr_tag>;
+    const std::size_t width = 67, height = 5, depth = 3;
+    bool ok = true;
+
+    auto a = fill_block<float, ATwist, width, height, depth>( signal_a );
+    auto b = fill_block<float, BTwist>( signal_b, width, height, depth );
+    auto big_gain = fill_block<float, GainTwist>( []( std::size_t w, std::size_t h, std::size_t d )
+                                                  {
+                                                      return gain( w - 2, h - 1, d );
+                                                  },
+                                                  width + 4,
+                                                  height + 2,
+                                                  depth );
+    auto g = sub_block( big_gain, 2, 1, 0, width, height, depth );
+    auto out = make_block<OutTwist>( 0.0f, width, height, depth );
+
+    // the whole mix in one pass
+    Counter::reset();
+    evaluate_block<Counter>( a * g + b * ( 1.0f - g ), out );
+    ok &= Counter::stats( BlockOperation::apply_block ).calls == 1;
+    ok &= Counter::stats( BlockOperation::apply_block ).items == width * height * depth;
+    for ( std::size_t w = 0; w < width; ++w )
+    {
+        for ( std::size_t h = 0; h < height; ++h )
+        {
+            for ( std::size_t d = 0; d < depth; ++d )
+            {
+                const float gv = gain( w, h, d );
+                ok &= near( get( out, w, h, d ), signal_a( w, h, d ) * gv + signal_b( w, h, d ) * ( 1.0f - gv ) );
+            }
+        }
+    }
+
+    // the other operators, scalars on either side, and dest as an operand
+    evaluate_block( fma( a, 2.0f, max( min( b, 0.5f ), -0.5f ) ) / 4.0f - out, out );
+    for ( std::size_t w = 0; w < width; ++w )
+    {
+        for ( std::size_t h = 0; h < height; ++h )
+        {
+            for ( std::size_t d = 0; d < depth; ++d )
+            {
+                const float gv = gain( w, h, d );
+                const float mixed = signal_a( w, h, d ) * gv + signal_b( w, h, d ) * ( 1.0f - gv );
+                const float clipped = std::max( std::min( signal_b( w, h, d ), 0.5f ), -0.5f );
+                ok &= near( get( out, w, h, d ), ( signal_a( w, h, d ) * 2.0f + clipped ) / 4.0f - mixed );
+            }
+        }
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "block expressions " << name << std::endl;
+    return ok;
+}
+
+bool check_other_types()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    auto x = fill_block<double, twist0, 9, 4, 2>( []( std::size_t w, std::size_t h, std::size_t d )
+                                                  {
+                                                      return 0.5 * static_cast<double>( w + h + d );
+                                                  } );
+    auto y = make_block<twist0, 9, 4, 2>( 0.0 );
+    evaluate_block( x * x - 1.0, y );
+    ok &= get( y, 8, 3, 1 ) == 36.0 - 1.0 && get( y, 0, 0, 0 ) == -1.0;
+    evaluate_block( fma( 2.0, 3.0, y ), y );
+    ok &= get( y, 8, 3, 1 ) == 41.0 && get( y, 0, 0, 0 ) == 5.0;
+
+    auto i = fill_block<int, twist2, 5, 3, 2>( []( std::size_t w, std::size_t h, std::size_t d )
+                                               {
+                                                   return static_cast<int>( w * 100 + h * 10 + d );
+                                               } );
+    auto j = make_block<twist0, 5, 3, 2>( 0 );
+    evaluate_block( max( i / 2, 100 ) + 1, j );
+    ok &= get( j, 4, 2, 1 ) == 211 && get( j, 0, 1, 0 ) == 101;
+
+    auto wide = fill_block<float, twist0>( []( std::size_t w, std::size_t h, std::size_t d )
+                                           {
+                                               return static_cast<float>( w * 100 + h * 10 + d );
+                                           },
+                                           8,
+                                           4,
+                                           3 );
+    auto every_other = make_block<twist0>( 0.0f, 4, 2, 3 );
+    evaluate_block( stride_block( wide, 2, 2 ) + 0.5f, every_other );
+    ok &= get( every_other, 3, 1, 2 ) == 622.5f && get( every_other, 1, 0, 1 ) == 201.5f;
+
+    auto small = make_block<twist0>( 0.0f, 4, 2, 1 );
+    auto large = make_block<twist0>( 0.0f, 5, 2, 1 );
+    bool threw = false;
+    try
+    {
+        evaluate_block( small + large, small );
+    }
+    catch ( std::invalid_argument const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "block expressions of double and int" << std::endl;
+    return ok;
+}
+
+/// The rows that have a kernel in the runtime dispatch table, on a size that leaves a tail
+template <typename T>
+bool check_dispatched_rows( std::string const &name )
+{
+    using namespace Dap;
+    bool ok = true;
+
+    auto a = fill_block<T, twist0>( []( std::size_t w, std::size_t h, std::size_t )
+                                    {
+                                        return static_cast<T>( w ) * T( 0.25 ) - static_cast<T>( h );
+                                    },
+                                    37,
+                                    3 );
+    auto b = fill_block<T, twist0>( []( std::size_t w, std::size_t h, std::size_t )
+                                    {
+                                        return T( 1.5 ) - static_cast<T>( w + h ) * T( 0.125 );
+                                    },
+                                    37,
+                                    3 );
+    auto out = make_block<twist0>( T( 0 ), 37, 3 );
+    auto expect = [&]( std::function<T( T, T )> const &f )
+    {
+        for ( std::size_t h = 0; h < 3; ++h )
+        {
+            for ( std::size_t w = 0; w < 37; ++w )
+            {
+                ok &= near( static_cast<float>( get( out, w, h ) ), static_cast<float>( f( get( a, w, h ), get( b, w, h ) ) ) );
+            }
+        }
+    };
+
+    evaluate_block( a + b, out );
+    expect( []( T x, T y ) { return x + y; } );
+    evaluate_block( a * b, out );
+    expect( []( T x, T y ) { return x * y; } );
+    evaluate_block( a * T( 3 ), out );
+    expect( []( T x, T ) { return x * T( 3 ); } );
+    evaluate_block( T( -2 ) * b, out );
+    expect( []( T, T y ) { return T( -2 ) * y; } );
+    evaluate_block( fma( a, b, a ), out );
+    expect( []( T x, T y ) { return x * y + x; } );
+    evaluate_block( a * out, out );
+    expect( []( T x, T y ) { return x * ( x * y + x ); } );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "dispatched block expression rows " << name << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    ok &= check_crossfade<twist0, twist0, twist0, twist0>( "twist0" );
+    ok &= check_crossfade<twist2, twist2, twist2, twist2>( "twist2" );
+    ok &= check_crossfade<twist0, twist4, twist2, twist1>( "mixed twists" );
+    ok &= check_crossfade<twist3, twist5, twist1, twist0>( "mixed twists to twist0" );
+    ok &= check_crossfade<twist0, twist3, twist5, twist3>( "mixed twists to twist3" );
+    ok &= check_other_types();
+    ok &= check_dispatched_rows<float>( "float" );
+    ok &= check_dispatched_rows<double>( "double" );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+float value_at( std::size_t w, std::size_t h, std::size_t d )
+{
+    return static_cast<float>( w * 10000 + h * 100 + d );
+}
+
+template <typename ContainerT>
+float manual_sum( ContainerT const &c )
+{
+    using Layout = Dap::BlockDetail::layout<ContainerT>;
+    float r = 0.0f;
+    for ( std::size_t w = 0; w < Layout::width( c ); ++w )
+    {
+        for ( std::size_t h = 0; h < Layout::height( c ); ++h )
+        {
+            for ( std::size_t d = 0; d < Layout::depth( c ); ++d )
+            {
+                r += Dap::get( c, w, h, d );
+            }
+        }
+    }
+    return r;
+}
+
+bool near( float a, float b )
+{
+    return std::fabs( a - b ) <= 1e-5f * std::fabs( b );
+}
+
+template <typename Twist>
+bool check_views( std::string const &name )
+{
+    using namespace Dap;
+    const std::size_t width = 37, height = 9, depth = 5;
+    bool ok = true;
+
+    auto block = fill_block<float, Twist, width, height, depth>( value_at );
+    auto const &const_block = block;
+    static_assert( std::is_same<decltype( view_block( const_block ) ), BlockView<float const, Twist> >::value,
+                   "a view of a const block is read only" );
+
+    // a window sees the items of the block and writes go through to it
+    auto window = sub_block( block, 3, 2, 1, 20, 5, 3 );
+    ok &= window.width() == 20 && window.height() == 5 && window.depth() == 3;
+    ok &= get( window, 4, 3, 2 ) == value_at( 7, 5, 3 );
+    apply_block( window, []( float v, std::size_t, std::size_t, std::size_t )
+                 {
+        return -v;
+    } );
+    for ( std::size_t w = 0; w < width; ++w )
+    {
+        for ( std::size_t h = 0; h < height; ++h )
+        {
+            for ( std::size_t d = 0; d < depth; ++d )
+            {
+                const bool inside = w >= 3 && w < 23 && h >= 2 && h < 7 && d >= 1 && d < 4;
+                ok &= get( block, w, h, d ) == ( inside ? -value_at( w, h, d ) : value_at( w, h, d ) );
+            }
+        }
+    }
+    apply_block( window, []( float v, std::size_t, std::size_t, std::size_t )
+                 {
+        return -v;
+    } );
+
+    // slices along each axis, reduced without copying
+    auto width_slice = slice_block( const_block, Axis::width, 11 );
+    auto height_slice = slice_block( block, Axis::height, 4 );
+    auto depth_slice = slice_block( block, Axis::depth, 2 );
+    ok &= width_slice.width() == 1 && width_slice.height() == height && width_slice.depth() == depth;
+    ok &= near( sum_block( width_slice ), manual_sum( width_slice ) );
+    ok &= near( sum_block( height_slice ), manual_sum( height_slice ) );
+    ok &= max_block( depth_slice ) == value_at( width - 1, height - 1, 2 );
+    ok &= dot_block( height_slice, height_slice ) > 0.0f;
+
+    // decimated views, and copies between views and owning blocks of other twists
+    auto decimated = stride_block( block, 4, 2, 3 );
+    ok &= decimated.width() == 10 && decimated.height() == 5 && decimated.depth() == 2;
+    ok &= get( decimated, 9, 4, 1 ) == value_at( 36, 8, 3 );
+    auto copy = make_block<twist4>( 0.0f, 10, 5, 2 );
+    copy_block( decimated, copy );
+    ok &= get( copy, 9, 4, 1 ) == value_at( 36, 8, 3 ) && near( sum_block( copy ), manual_sum( decimated ) );
+    auto target = sub_block( block, 0, 0, 0, 10, 5, 2 );
+    copy_block( copy, target );
+    ok &= get( block, 9, 4, 1 ) == value_at( 36, 8, 3 );
+    copy_block( fill_block<float, Twist>( value_at, 10, 5, 2 ), target );
+
+    // views of views, filtering one line in place, and the parallel form
+    auto line = slice_block( slice_block( block, Axis::height, 1 ), Axis::depth, 2 );
+    BiQuad<float> filter;
+    filter.coeffs.set( 0, 0.5, 0.0, 0.0, 0.0, 0.0 );
+    filter.process( line, Axis::width );
+    ok &= get( block, 5, 1, 2 ) == 0.5f * value_at( 5, 1, 2 ) && get( block, 5, 2, 2 ) == value_at( 5, 2, 2 );
+    parallel_apply_block( ThreadPool::shared(), line, []( float v, std::size_t, std::size_t, std::size_t )
+                          {
+        return v * 2.0f;
+    } );
+    ok &= get( block, 5, 1, 2 ) == value_at( 5, 1, 2 );
+
+    bool threw = false;
+    try
+    {
+        sub_block( block, 30, 0, 0, 8 );
+    }
+    catch ( std::out_of_range const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+    threw = false;
+    try
+    {
+        stride_block( block, 0 );
+    }
+    catch ( std::invalid_argument const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "block views " << name << std::endl;
+    return ok;
+}
+
+struct materialize_tag
+{
+};
+
+template <typename Twist>
+bool check_twist_views( std::string const &name )
+{
+    using namespace Dap;
+    using Counter = CountingInstrument<materialize_tag>;
+    const std::size_t width = 37, height = 9, depth = 5;
+    bool ok = true;
+
+    auto block = fill_block<float, Twist, width, height, depth>( value_at );
+    auto twisted = twist_view<1>( twist_view<2>( block ) );
+    using composed_twist = typename Twister<typename Twister<Twist, 2>::output_twist, 1>::output_twist;
+    static_assert( std::is_same<decltype( twisted ), BlockView<float, composed_twist> >::value,
+                   "twisted views compose into one view" );
+    ok &= twisted.data() == block.data();
+    ok &= get( twisted, 21, 7, 3 ) == value_at( 21, 7, 3 );
+
+    // one tiled copy makes the same block as two twist_blocks
+    Counter::reset();
+    auto materialized = materialize<Counter>( twisted );
+    auto chained = twist_block<1>( twist_block<2>( block ) );
+    static_assert( std::is_same<typename Traits<decltype( materialized )>::twist_type,
+                                typename Traits<decltype( chained )>::twist_type>::value,
+                   "materialize keeps the composed twist" );
+    ok &= Counter::stats( BlockOperation::copy_block ).calls == 1;
+    ok &= std::equal( materialized.data(), materialized.data() + materialized.size(), chained.data() );
+
+    // a twisted window of a twisted view
+    auto window = materialize( twist_view<3>( sub_block( twisted, 4, 1, 2, 30, 6, 3 ) ) );
+    for ( std::size_t w = 0; w < 30; ++w )
+    {
+        for ( std::size_t h = 0; h < 6; ++h )
+        {
+            for ( std::size_t d = 0; d < 3; ++d )
+            {
+                ok &= get( window, w, h, d ) == value_at( w + 4, h + 1, d + 2 );
+            }
+        }
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "twisted views " << name << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    ok &= check_views<twist0>( "twist0" );
+    ok &= check_views<twist2>( "twist2" );
+    ok &= check_views<twist4>( "twist4" );
+    ok &= check_twist_views<twist0>( "twist0" );
+    ok &= check_twist_views<twist3>( "twist3" );
+    ok &= check_twist_views<twist5>( "twist5" );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+std::vector<double> random_samples( std::size_t n, unsigned seed )
+{
+    std::mt19937 gen( seed );
+    std::uniform_real_distribution<double> dist( -1.0, 1.0 );
+    std::vector<double> x( n );
+    for ( auto &v : x )
+    {
+        v = dist( gen );
+    }
+    return x;
+}
+
+/// Sample n of x convolved with h, directly
+double convolve_at( std::vector<double> const &x, std::vector<double> const &h, std::size_t n )
+{
+    double sum = 0.0;
+    for ( std::size_t j = 0; j < h.size() && j <= n; ++j )
+    {
+        sum += h[j] * x[n - j];
+    }
+    return sum;
+}
+
+template <typename T, std::size_t BlockSize>
+bool check_planar( std::size_t taps, std::size_t max_taps, std::size_t blocks, double tolerance )
+{
+    using namespace Dap;
+    const std::size_t channels = 3;
+    bool ok = true;
+
+    Convolver<T, BlockSize> convolver( channels, max_taps );
+    ok &= convolver.partitions() == ( max_taps + BlockSize - 1 ) / BlockSize;
+
+    std::vector<std::vector<double> > x( channels ), h( channels );
+    for ( std::size_t c = 0; c < channels; ++c )
+    {
+        x[c] = random_samples( BlockSize * blocks, 10 + c );
+        h[c] = random_samples( taps - c, 20 + c );
+        std::vector<T> ht( h[c].begin(), h[c].end() );
+        convolver.set_impulse_response( c, ht.data(), ht.size() );
+    }
+
+    std::vector<T> buffer( channels * BlockSize );
+    double error = 0.0;
+    for ( std::size_t b = 0; b < blocks; ++b )
+    {
+        for ( std::size_t c = 0; c < channels; ++c )
+        {
+            for ( std::size_t i = 0; i < BlockSize; ++i )
+            {
+                buffer[c * BlockSize + i] = static_cast<T>( x[c][b * BlockSize + i] );
+            }
+        }
+        convolver.process( buffer.data(), buffer.data() );
+        for ( std::size_t c = 0; c < channels; ++c )
+        {
+            for ( std::size_t i = 0; i < BlockSize; ++i )
+            {
+                error = std::max( error, std::fabs( buffer[c * BlockSize + i] - convolve_at( x[c], h[c], b * BlockSize + i ) ) );
+            }
+        }
+    }
+    ok &= error <= tolerance;
+
+    // after a reset the first block is as if nothing came before
+    convolver.reset();
+    for ( std::size_t c = 0; c < channels; ++c )
+    {
+        for ( std::size_t i = 0; i < BlockSize; ++i )
+        {
+            buffer[c * BlockSize + i] = static_cast<T>( x[c][i] );
+        }
+    }
+    convolver.process( buffer.data(), buffer.data() );
+    ok &= std::fabs( buffer[3 * BlockSize - 1] - convolve_at( x[2], h[2], BlockSize - 1 ) ) <= tolerance;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "planar Convolver<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ", "
+              << BlockSize << "> of " << taps << " taps, error " << error << std::endl;
+    return ok;
+}
+
+bool check_blocks()
+{
+    using namespace Dap;
+    const std::size_t block_size = 32, taps = 300, blocks = 20;
+    bool ok = true;
+
+    // four channels as a 2 x 2 arrangement of rows, sharing one impulse response
+    Convolver<float, block_size> convolver( 4, taps );
+    const std::vector<double> h = random_samples( taps, 1 );
+    const std::vector<float> hf( h.begin(), h.end() );
+    convolver.set_impulse_response( hf.data(), hf.size() );
+
+    std::vector<std::vector<double> > x( 4 );
+    for ( std::size_t c = 0; c < 4; ++c )
+    {
+        x[c] = random_samples( block_size * blocks, 30 + c );
+    }
+    auto in = make_block<twist2>( 0.0f, block_size, 2, 2 );
+    Block<float, twist0, block_size, 2, 2> out;
+    double error = 0.0;
+    for ( std::size_t b = 0; b < blocks; ++b )
+    {
+        for ( std::size_t c = 0; c < 4; ++c )
+        {
+            for ( std::size_t i = 0; i < block_size; ++i )
+            {
+                set( in, static_cast<float>( x[c][b * block_size + i] ), i, c % 2, c / 2 );
+            }
+        }
+        convolver.process( in, out );
+        for ( std::size_t c = 0; c < 4; ++c )
+        {
+            for ( std::size_t i = 0; i < block_size; ++i )
+            {
+                error = std::max( error, std::fabs( get( out, i, c % 2, c / 2 ) - convolve_at( x[c], h, b * block_size + i ) ) );
+            }
+        }
+    }
+    ok &= error <= 5e-5;
+
+    bool threw = false;
+    try
+    {
+        auto wrong = make_block<twist0>( 0.0f, block_size, 3, 1 );
+        convolver.process( wrong, wrong );
+    }
+    catch ( std::invalid_argument const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+    threw = false;
+    try
+    {
+        convolver.set_impulse_response( 0, hf.data(), convolver.max_taps() + 1 );
+    }
+    catch ( std::invalid_argument const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "Convolver on blocks, error " << error << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= check_planar<float, 64>( 1000, 1000, 40, 5e-5 );
+    ok &= check_planar<float, 16>( 100, 400, 40, 2e-5 );
+    ok &= check_planar<float, 2>( 9, 9, 20, 1e-5 );
+    ok &= check_planar<double, 128>( 3000, 3000, 40, 1e-11 );
+    ok &= check_blocks();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+bool close( double a, double b, double tolerance )
+{
+    return std::abs( a - b ) <= tolerance * std::max( 1.0, std::abs( b ) );
+}
+
+template <typename T>
+double tolerance()
+{
+    return sizeof( T ) == 4 ? 1e-5 : 1e-12;
+}
+
+template <typename T>
+std::vector<T> random_buffer( std::mt19937 &gen, std::size_t n, double lo, double hi )
+{
+    std::uniform_real_distribution<double> dist( lo, hi );
+    std::vector<T> v( n );
+    for ( auto &x : v )
+    {
+        x = static_cast<T>( dist( gen ) );
+    }
+    return v;
+}
+
+template <typename T>
+bool check_biquad( Dap::DispatchKernelSet<T> const &k, std::mt19937 &gen )
+{
+    using namespace Dap;
+    BiQuad<T> filter;
+    filter.coeffs.calculate_peak( 0, Constants::recip_96k(), 1e3, 0.7, 6.0 );
+    T coeffs[5] = {filter.coeffs.a0, filter.coeffs.a1, filter.coeffs.a2, filter.coeffs.b1, filter.coeffs.b2};
+    T state[2] = {0, 0};
+
+    auto in = random_buffer<T>( gen, 1000, -1, 1 );
+    std::vector<T> expected( in.size() ), out( in.size() );
+    filter.process( in.data(), expected.data(), 600 );
+    filter.process( in.data() + 600, expected.data() + 600, 400 );
+    k.biquad( coeffs, state, in.data(), out.data(), 600 );
+    k.biquad( coeffs, state, in.data() + 600, out.data() + 600, 400 );
+
+    bool ok = true;
+    for ( std::size_t i = 0; i < in.size(); ++i )
+    {
+        ok &= close( out[i], expected[i], tolerance<T>() * 10 );
+    }
+    return ok;
+}
+
+/// Run a bank of 37 channels whose arrays are zero padded to padded_channels
+template <typename T>
+bool check_biquad_bank( Dap::DispatchKernelSet<T> const &k, std::mt19937 &gen, std::size_t padded_channels )
+{
+    using namespace Dap;
+    const std::size_t channels = 37, stride = 40, frames = 300;
+    std::vector<T> a0( padded_channels, T( 0 ) ), a1( padded_channels, T( 0 ) ), a2( padded_channels, T( 0 ) );
+    std::vector<T> b1( padded_channels, T( 0 ) ), b2( padded_channels, T( 0 ) );
+    std::vector<T> z1( padded_channels, T( 0 ) ), z2( padded_channels, T( 0 ) );
+    std::vector<BiQuad<T> > reference( channels );
+    for ( std::size_t ch = 0; ch < channels; ++ch )
+    {
+        reference[ch].coeffs.calculate_lowpass( 0, Constants::recip_48k(), 100.0 * ( ch + 1 ), 0.7 );
+        a0[ch] = reference[ch].coeffs.a0;
+        a1[ch] = reference[ch].coeffs.a1;
+        a2[ch] = reference[ch].coeffs.a2;
+        b1[ch] = reference[ch].coeffs.b1;
+        b2[ch] = reference[ch].coeffs.b2;
+    }
+    DispatchBiQuadBank<T> bank
+        = {a0.data(), a1.data(), a2.data(), b1.data(), b2.data(), z1.data(), z2.data(), channels, padded_channels};
+
+    auto in = random_buffer<T>( gen, frames * stride, -1, 1 );
+    std::vector<T> out( in.size(), T( 0 ) );
+    k.biquad_bank( bank, in.data(), out.data(), frames, stride );
+
+    bool ok = true;
+    for ( std::size_t f = 0; f < frames; ++f )
+    {
+        for ( std::size_t ch = 0; ch < stride; ++ch )
+        {
+            if ( ch < channels )
+            {
+                ok &= close( out[f * stride + ch], reference[ch]( in[f * stride + ch] ), tolerance<T>() * 10 );
+            }
+            else
+            {
+                ok &= out[f * stride + ch] == T( 0 );
+            }
+        }
+    }
+    for ( std::size_t ch = channels; ch < padded_channels; ++ch )
+    {
+        ok &= z1[ch] == T( 0 ) && z2[ch] == T( 0 );
+    }
+    return ok;
+}
+
+template <typename T>
+bool check_arithmetic( Dap::DispatchKernelSet<T> const &k, std::mt19937 &gen )
+{
+    const std::size_t n = 131;
+    auto a = random_buffer<T>( gen, n, -2, 2 );
+    auto b = random_buffer<T>( gen, n, -2, 2 );
+    auto c = random_buffer<T>( gen, n, -2, 2 );
+    std::vector<T> s( n ), sum( n ), product( n ), mad( n );
+    k.scale( a.data(), T( 0.5 ), s.data(), n );
+    k.add( a.data(), b.data(), sum.data(), n );
+    k.multiply( a.data(), b.data(), product.data(), n );
+    k.multiply_add( a.data(), b.data(), c.data(), mad.data(), n );
+
+    bool ok = true;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        ok &= s[i] == a[i] * T( 0.5 );
+        ok &= sum[i] == a[i] + b[i];
+        ok &= product[i] == a[i] * b[i];
+        // the variant may fuse the multiply-add
+        ok &= close( mad[i], double( a[i] ) * double( b[i] ) + double( c[i] ), tolerance<T>() );
+    }
+    return ok;
+}
+
+template <typename T>
+bool check_transpose( Dap::DispatchKernelSet<T> const &k )
+{
+    const std::size_t rows = 37, cols = 70, src_stride = 72, dest_stride = 40;
+    std::vector<T> src( rows * src_stride ), dest( cols * dest_stride, T( -1 ) );
+    for ( std::size_t i = 0; i < src.size(); ++i )
+    {
+        src[i] = T( i );
+    }
+    k.transpose( src.data(), rows, cols, src_stride, dest.data(), dest_stride );
+
+    bool ok = true;
+    for ( std::size_t c = 0; c < cols; ++c )
+    {
+        for ( std::size_t r = 0; r < dest_stride; ++r )
+        {
+            ok &= dest[c * dest_stride + r] == ( r < rows ? src[r * src_stride + c] : T( -1 ) );
+        }
+    }
+    return ok;
+}
+
+template <typename T>
+bool check_math( Dap::DispatchKernelSet<T> const &k, std::mt19937 &gen )
+{
+    using Dap::MathFunction;
+    const std::size_t n = 77;
+    auto trig = random_buffer<T>( gen, n, -3, 3 );
+    auto positive = random_buffer<T>( gen, n, 0.01, 100 );
+
+    struct Case
+    {
+        MathFunction f;
+        std::vector<T> const *input;
+        double ( *reference )( double );
+    };
+    const Case cases[] = {{MathFunction::sin, &trig, &std::sin},
+                          {MathFunction::cos, &trig, &std::cos},
+                          {MathFunction::tan, &trig, &std::tan},
+                          {MathFunction::exp, &trig, &std::exp},
+                          {MathFunction::exp2, &trig, &std::exp2},
+                          {MathFunction::log, &positive, &std::log},
+                          {MathFunction::log2, &positive, &std::log2}};
+
+    bool ok = true;
+    for ( auto const &c : cases )
+    {
+        std::vector<T> out( n );
+        k.math[static_cast<std::size_t>( c.f )]( c.input->data(), out.data(), n );
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            ok &= close( out[i], c.reference( ( *c.input )[i] ), tolerance<T>() );
+        }
+    }
+    return ok;
+}
+
+template <typename T>
+bool check_set( Dap::DispatchKernelSet<T> const &k, std::string const &name )
+{
+    std::mt19937 gen( 1234 );
+    bool ok = true;
+    ok &= check_biquad( k, gen );
+    ok &= check_biquad_bank( k, gen, 37 );
+    ok &= check_biquad_bank( k, gen, 48 );
+    ok &= check_arithmetic( k, gen );
+    ok &= check_transpose( k );
+    ok &= check_math( k, gen );
+    std::cout << ( ok ? "ok   " : "FAIL " ) << name << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    // force the sse2 variant before the first use of dispatch()
+    setenv( "DAP_CPU_VARIANT", "sse2", 1 );
+    CpuVariant active = dispatch().variant;
+    std::cout << "active variant: " << cpu_variant_name( active ) << std::endl;
+    ok &= active == CpuVariant::sse2 || ( active == CpuVariant::baseline && !dispatch_kernels( CpuVariant::sse2 ) );
+
+    for ( std::size_t i = 0; i < cpu_variant_count; ++i )
+    {
+        CpuVariant v = static_cast<CpuVariant>( i );
+        DispatchKernels const *k = dispatch_kernels( v );
+        std::string name = cpu_variant_name( v );
+        if ( !k )
+        {
+            std::cout << "skip " << name << ( cpu_supports( v ) ? " (not compiled in)" : " (not supported)" ) << std::endl;
+            continue;
+        }
+        ok &= k->variant == v;
+        ok &= k->register_bytes == ( v == CpuVariant::avx || v == CpuVariant::avx2 ? 32u : 16u )
+              || ( v == CpuVariant::baseline && k->register_bytes >= 16 );
+        ok &= check_set( k->f32, name + " float" );
+        ok &= check_set( k->f64, name + " double" );
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+
+namespace
+{
+
+float value_at( std::size_t w, std::size_t h, std::size_t d )
+{
+    return static_cast<float>( w * 10000 + h * 100 + d );
+}
+
+template <typename BlockT>
+bool matches( BlockT const &b, float scale, float offset )
+{
+    using Layout = Dap::BlockDetail::layout<BlockT>;
+    bool ok = true;
+    for ( std::size_t w = 0; w < Layout::width( b ); ++w )
+    {
+        for ( std::size_t h = 0; h < Layout::height( b ); ++h )
+        {
+            for ( std::size_t d = 0; d < Layout::depth( b ); ++d )
+            {
+                ok &= Dap::get( b, w, h, d ) == value_at( w, h, d ) * scale + offset;
+            }
+        }
+    }
+    return ok;
+}
+
+template <typename SourceTwist, typename DestinationTwist>
+bool check_twists( std::string const &name )
+{
+    using namespace Dap;
+    const std::size_t width = 13, height = 5, depth = 3;
+    bool ok = true;
+
+    auto src = fill_block<float, SourceTwist>( value_at, width, height, depth );
+    ok &= src.width() == width && src.height() == height && src.depth() == depth;
+    ok &= src.size() == width * height * depth;
+    ok &= reinterpret_cast<std::uintptr_t>( src.data() ) % DAP_CACHELINESIZE == 0;
+    ok &= matches( src, 1.0f, 0.0f );
+
+    set( src, -1.0f, 12, 4, 2 );
+    ok &= get( src, 12, 4, 2 ) == -1.0f;
+    set( src, value_at( 12, 4, 2 ), 12, 4, 2 );
+
+    apply_block( src, []( float v, std::size_t w, std::size_t h, std::size_t d )
+                 {
+        return v == value_at( w, h, d ) ? v * 2.0f : -1.0f;
+    } );
+    ok &= matches( src, 2.0f, 0.0f );
+
+    // run time sized and compile time sized blocks mix freely
+    auto dest = make_block<DestinationTwist, width, height, depth>( 0.0f );
+    apply_block( src, dest, []( float v, std::size_t, std::size_t, std::size_t )
+                 {
+        return v + 1.0f;
+    } );
+    ok &= matches( dest, 2.0f, 1.0f );
+
+    auto sum = make_block<DestinationTwist>( 0.0f, width, height, depth );
+    apply_block( src, dest, sum, []( float a, float b, std::size_t, std::size_t, std::size_t )
+                 {
+        return a + b;
+    } );
+    ok &= matches( sum, 4.0f, 1.0f );
+
+    auto copy = make_block<SourceTwist>( 7.0f, width, height, depth );
+    ok &= matches( copy, 0.0f, 7.0f );
+    copy_block( dest, copy );
+    ok &= matches( copy, 2.0f, 1.0f );
+
+    // moves hand over the storage and leave the source empty
+    float const *p = copy.data();
+    DynBlock<float, SourceTwist> moved( std::move( copy ) );
+    ok &= moved.data() == p && copy.data() == 0 && copy.empty();
+    copy = std::move( moved );
+    ok &= copy.data() == p && moved.empty() && matches( copy, 2.0f, 1.0f );
+
+    bool threw = false;
+    try
+    {
+        auto small = make_block<DestinationTwist>( 0.0f, width - 1, height, depth );
+        copy_block( src, small );
+    }
+    catch ( std::invalid_argument const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "dynblock algorithms " << name << std::endl;
+    return ok;
+}
+
+bool check_reduce()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    auto a = make_block<twist0>( 2.0f, 37, 3 );
+    auto b = fill_block<float, twist0>( []( std::size_t w, std::size_t, std::size_t )
+                                        {
+                                            return static_cast<float>( w );
+                                        },
+                                        37,
+                                        3 );
+    ok &= sum_block( a ) == 2.0f * 37 * 3;
+    ok &= max_block( b ) == 36.0f;
+    ok &= dot_block( a, b ) == 2.0f * 3 * ( 36 * 37 / 2 );
+
+    BiQuad<float> filter;
+    filter.coeffs.set( 0, 0.5, 0.0, 0.0, 0.0, 0.0 );
+    filter.process( b, Axis::width, 1 );
+    ok &= get( b, 10, 1 ) == 5.0f && get( b, 10, 0 ) == 10.0f;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "dynblock reduce and biquad" << std::endl;
+    return ok;
+}
+
+/// An item that counts the live instances and throws from the copy that makes copies_left reach zero
+struct Counted
+{
+    static int live;
+    static int copies_left;
+
+    Counted() { ++live; }
+    Counted( Counted const & )
+    {
+        if ( --copies_left == 0 )
+        {
+            throw std::runtime_error( "copy" );
+        }
+        ++live;
+    }
+    ~Counted() { --live; }
+};
+
+int Counted::live = 0;
+int Counted::copies_left = 0;
+
+bool check_construct_failure()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    {
+        Counted elem;
+        Counted::copies_left = 10;
+        bool threw = false;
+        try
+        {
+            DynBlock<Counted, twist0> b( 4, 3, 2, elem );
+        }
+        catch ( std::runtime_error const & )
+        {
+            threw = true;
+        }
+        ok &= threw && Counted::live == 1;
+
+        Counted::copies_left = 100;
+        {
+            DynBlock<Counted, twist0> b( 4, 3, 2, elem );
+            ok &= Counted::live == 25;
+        }
+        ok &= Counted::live == 1;
+    }
+    ok &= Counted::live == 0;
+
+    const std::size_t huge = std::size_t( 1 ) << ( sizeof( std::size_t ) * 4 );
+    bool threw = false;
+    try
+    {
+        DynBlock<float, twist0> b( huge, huge, 2 );
+    }
+    catch ( std::bad_alloc const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    threw = false;
+    try
+    {
+        DynBlock<double, twist0> b( std::numeric_limits<std::size_t>::max() / 4, 1, 1 );
+    }
+    catch ( std::bad_alloc const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "dynblock construct failure" << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    ok &= check_twists<twist0, twist0>( "twist0 -> twist0" );
+    ok &= check_twists<twist1, twist1>( "twist1 -> twist1" );
+    ok &= check_twists<twist0, twist2>( "twist0 -> twist2" );
+    ok &= check_twists<twist3, twist1>( "twist3 -> twist1" );
+    ok &= check_twists<twist4, twist5>( "twist4 -> twist5" );
+    ok &= check_reduce();
+    ok &= check_construct_failure();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,319 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+typedef std::complex<long double> reference_complex;
+
+/// The plain O( n^2 ) DFT, in long double
+std::vector<reference_complex> dft( std::vector<reference_complex> const &x, bool inverse )
+{
+    const std::size_t n = x.size();
+    const long double pi = 3.14159265358979323846264338327950288L;
+    std::vector<reference_complex> y( n );
+    for ( std::size_t k = 0; k < n; ++k )
+    {
+        reference_complex sum;
+        for ( std::size_t j = 0; j < n; ++j )
+        {
+            const long double angle = ( inverse ? 2.0L : -2.0L ) * pi * static_cast<long double>( ( j * k ) % n ) / n;
+            sum += x[j] * reference_complex( std::cos( angle ), std::sin( angle ) );
+        }
+        y[k] = sum;
+    }
+    return y;
+}
+
+template <typename T>
+double tolerance()
+{
+    return std::numeric_limits<T>::epsilon() * 16;
+}
+
+/// Accumulates the largest error against the reference, relative to the largest reference magnitude
+struct error_meter
+{
+    long double m_error = 0;
+    long double m_scale = 0;
+
+    template <typename T>
+    void add( std::complex<T> const &got, reference_complex const &want )
+    {
+        m_error = std::max( m_error, std::abs( reference_complex( got.real(), got.imag() ) - want ) );
+        m_scale = std::max( m_scale, std::abs( want ) );
+    }
+
+    template <typename T>
+    void add( T got, long double want )
+    {
+        add( std::complex<T>( got ), reference_complex( want ) );
+    }
+
+    template <typename T>
+    bool within() const
+    {
+        return m_error <= tolerance<T>() * m_scale;
+    }
+};
+
+template <typename T>
+std::vector<reference_complex> random_signal( std::size_t n, bool real, unsigned seed )
+{
+    std::mt19937 gen( seed );
+    std::uniform_real_distribution<T> dist( -1, 1 );
+    std::vector<reference_complex> x( n );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        const T re = dist( gen );
+        x[i] = reference_complex( re, real ? T( 0 ) : dist( gen ) );
+    }
+    return x;
+}
+
+template <typename T, std::size_t Size>
+bool check_complex()
+{
+    using namespace Dap;
+    bool ok = true;
+    FFT<T, Size> fft;
+
+    const std::vector<reference_complex> x = random_signal<T>( Size, false, Size );
+    const std::vector<reference_complex> fx = dft( x, false );
+    const std::vector<reference_complex> ix = dft( x, true );
+    std::vector<std::complex<T> > in( Size ), out( Size ), round( Size );
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        in[i] = std::complex<T>( static_cast<T>( x[i].real() ), static_cast<T>( x[i].imag() ) );
+    }
+
+    error_meter forward, inverse, in_place;
+    fft.forward( in.data(), out.data() );
+    fft.inverse( in.data(), round.data() );
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        forward.add( out[i], fx[i] );
+        inverse.add( round[i], ix[i] );
+    }
+    round = in;
+    fft.forward( round.data(), round.data() );
+    fft.inverse( round.data(), round.data() );
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        in_place.add( round[i], x[i] * static_cast<long double>( Size ) );
+    }
+    ok &= forward.within<T>() && inverse.within<T>() && in_place.within<T>();
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "complex FFT<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ", "
+              << Size << ">" << std::endl;
+    return ok;
+}
+
+template <typename T, std::size_t Size>
+bool check_real()
+{
+    using namespace Dap;
+    bool ok = true;
+    FFT<T, Size> fft;
+
+    const std::vector<reference_complex> x = random_signal<T>( Size, true, Size + 1 );
+    const std::vector<reference_complex> fx = dft( x, false );
+    std::vector<T> in( Size ), round( Size );
+    std::vector<std::complex<T> > spectrum( Size / 2 );
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        in[i] = static_cast<T>( x[i].real() );
+    }
+
+    error_meter forward, inverse;
+    fft.forward_real( in.data(), spectrum.data() );
+    forward.add( spectrum[0], reference_complex( fx[0].real(), fx[Size / 2].real() ) );
+    for ( std::size_t k = 1; k < Size / 2; ++k )
+    {
+        forward.add( spectrum[k], fx[k] );
+    }
+    fft.inverse_real( spectrum.data(), round.data() );
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        inverse.add( round[i], x[i].real() * Size );
+    }
+    ok &= forward.within<T>() && inverse.within<T>();
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "real FFT<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ", " << Size
+              << ">" << std::endl;
+    return ok;
+}
+
+template <typename T, std::size_t N, std::size_t Size>
+bool check_batched()
+{
+    using namespace Dap;
+    typedef SIMD_SplitComplex<T, N> split_type;
+    typedef SIMD_Vector<T, N> real_type;
+    bool ok = true;
+    FFT<T, Size> fft;
+    fft.template reserve<N>();
+
+    // complex channels
+    std::vector<split_type, aligned_allocator<split_type> > in( Size ), out( Size );
+    std::vector<std::vector<reference_complex> > want( N );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        const std::vector<reference_complex> x = random_signal<T>( Size, false, 100 + c );
+        want[c] = dft( x, false );
+        for ( std::size_t i = 0; i < Size; ++i )
+        {
+            in[i].real()[c] = static_cast<T>( x[i].real() );
+            in[i].imag()[c] = static_cast<T>( x[i].imag() );
+        }
+    }
+    error_meter forward, inverse;
+    fft.forward( in.data(), out.data() );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        for ( std::size_t i = 0; i < Size; ++i )
+        {
+            forward.add( out[i][c], want[c][i] );
+        }
+    }
+    fft.inverse( out.data(), out.data() );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        for ( std::size_t i = 0; i < Size; ++i )
+        {
+            inverse.add( out[i][c] / static_cast<T>( Size ), reference_complex( in[i][c].real(), in[i][c].imag() ) );
+        }
+    }
+
+    // real channels
+    std::vector<real_type, aligned_allocator<real_type> > real_in( Size ), real_round( Size );
+    std::vector<split_type, aligned_allocator<split_type> > spectrum( Size / 2 );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        const std::vector<reference_complex> x = random_signal<T>( Size, true, 200 + c );
+        want[c] = dft( x, false );
+        for ( std::size_t i = 0; i < Size; ++i )
+        {
+            real_in[i][c] = static_cast<T>( x[i].real() );
+        }
+    }
+    fft.forward_real( real_in.data(), spectrum.data() );
+    fft.inverse_real( spectrum.data(), real_round.data() );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        forward.add( spectrum[0][c], reference_complex( want[c][0].real(), want[c][Size / 2].real() ) );
+        for ( std::size_t k = 1; k < Size / 2; ++k )
+        {
+            forward.add( spectrum[k][c], want[c][k] );
+        }
+        for ( std::size_t i = 0; i < Size; ++i )
+        {
+            inverse.add( real_round[i][c] / static_cast<T>( Size ), static_cast<long double>( real_in[i][c] ) );
+        }
+    }
+    ok &= forward.within<T>() && inverse.within<T>();
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "batched FFT<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ", " << Size
+              << "> of " << N << " channels" << std::endl;
+    return ok;
+}
+
+/// A large transform against its own inverse, where the DFT would be too slow
+template <typename T, std::size_t Size>
+bool check_round_trip()
+{
+    using namespace Dap;
+    bool ok = true;
+    std::unique_ptr<FFT<T, Size> > fft( new FFT<T, Size> );
+
+    const std::vector<reference_complex> x = random_signal<T>( Size, true, 7 );
+    std::vector<T> in( Size );
+    std::vector<std::complex<T> > spectrum( Size / 2 );
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        in[i] = static_cast<T>( x[i].real() );
+    }
+    fft->forward_real( in.data(), spectrum.data() );
+    fft->inverse_real( spectrum.data(), in.data() );
+    error_meter meter;
+    for ( std::size_t i = 0; i < Size; ++i )
+    {
+        meter.add( in[i] / static_cast<T>( Size ), static_cast<long double>( static_cast<T>( x[i].real() ) ) );
+    }
+    ok &= meter.within<T>();
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "round trip FFT<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ", "
+              << Size << ">" << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= check_complex<float, 4>();
+    ok &= check_complex<float, 8>();
+    ok &= check_complex<float, 16>();
+    ok &= check_complex<float, 32>();
+    ok &= check_complex<float, 64>();
+    ok &= check_complex<float, 512>();
+    ok &= check_complex<float, 1024>();
+    ok &= check_complex<double, 4>();
+    ok &= check_complex<double, 8>();
+    ok &= check_complex<double, 32>();
+    ok &= check_complex<double, 128>();
+    ok &= check_complex<double, 512>();
+
+    ok &= check_real<float, 4>();
+    ok &= check_real<float, 8>();
+    ok &= check_real<float, 16>();
+    ok &= check_real<float, 256>();
+    ok &= check_real<float, 1024>();
+    ok &= check_real<double, 4>();
+    ok &= check_real<double, 32>();
+    ok &= check_real<double, 512>();
+
+    ok &= check_batched<float, 4, 8>();
+    ok &= check_batched<float, 8, 64>();
+    ok &= check_batched<float, 8, 128>();
+    ok &= check_batched<double, 2, 32>();
+    ok &= check_batched<double, 4, 256>();
+
+    ok &= check_round_trip<float, 65536>();
+    ok &= check_round_trip<double, 32768>();
+
+    return ok ? 0 : 1;
+}
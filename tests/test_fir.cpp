@@ -0,0 +1,307 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+std::vector<double> random_samples( std::size_t n, unsigned seed )
+{
+    std::mt19937 gen( seed );
+    std::uniform_real_distribution<double> dist( -1.0, 1.0 );
+    std::vector<double> x( n );
+    for ( auto &v : x )
+    {
+        v = dist( gen );
+    }
+    return x;
+}
+
+/// Sample n of x filtered by h, directly
+double filter_at( std::vector<double> const &x, std::vector<double> const &h, std::size_t n )
+{
+    double sum = 0.0;
+    for ( std::size_t j = 0; j < h.size() && j <= n; ++j )
+    {
+        sum += h[j] * x[n - j];
+    }
+    return sum;
+}
+
+/// Sample n of x upsampled by l with zeros and filtered by h
+double interpolate_at( std::vector<double> const &x, std::vector<double> const &h, std::size_t l, std::size_t n )
+{
+    double sum = 0.0;
+    for ( std::size_t j = 0; j < h.size() && j <= n; ++j )
+    {
+        if ( ( n - j ) % l == 0 )
+        {
+            sum += h[j] * x[( n - j ) / l];
+        }
+    }
+    return sum;
+}
+
+/// The frame counts of successive calls, uneven so that the state carries across calls at every phase
+const std::size_t chunks[] = {1, 7, 64, 3, 100, 13, 2, 50};
+
+template <typename T>
+bool check_direct( std::size_t taps, double tolerance )
+{
+    using namespace Dap;
+    bool ok = true;
+    const std::size_t frames = 240;
+    const std::vector<double> h = random_samples( taps, 1 );
+    const std::vector<double> x = random_samples( frames, 2 );
+    const std::vector<T> ht( h.begin(), h.end() );
+    std::vector<T> buffer( x.begin(), x.end() );
+
+    FIR<T> fir( ht.data(), ht.size() );
+    ok &= fir.taps() == taps;
+    std::size_t done = 0;
+    for ( std::size_t c = 0; done < frames; ++c )
+    {
+        const std::size_t n = std::min( chunks[c % 8], frames - done );
+        fir.process( buffer.data() + done, buffer.data() + done, n );
+        done += n;
+    }
+    double error = 0.0;
+    for ( std::size_t i = 0; i < frames; ++i )
+    {
+        error = std::max( error, std::fabs( buffer[i] - filter_at( x, h, i ) ) );
+    }
+    ok &= error <= tolerance;
+
+    fir.reset();
+    ok &= std::fabs( fir.process( T( 1 ) ) - h[0] ) <= tolerance;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "FIR<" << ( sizeof( T ) == 4 ? "float" : "double" ) << "> of " << taps
+              << " taps, error " << error << std::endl;
+    return ok;
+}
+
+template <typename T, std::size_t N>
+bool check_channels( std::size_t taps, double tolerance )
+{
+    using namespace Dap;
+    typedef SIMD_Vector<T, N> frame_type;
+    bool ok = true;
+    const std::size_t frames = 150;
+
+    // a different filter in each lane, then one filter shared by all of them
+    std::vector<std::vector<double> > h( N ), x( N );
+    std::vector<frame_type, aligned_allocator<frame_type> > ht( taps ), buffer( frames );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        h[c] = random_samples( taps, 10 + c );
+        x[c] = random_samples( frames, 20 + c );
+        for ( std::size_t i = 0; i < taps; ++i )
+        {
+            ht[i][c] = static_cast<T>( h[c][i] );
+        }
+        for ( std::size_t i = 0; i < frames; ++i )
+        {
+            buffer[i][c] = static_cast<T>( x[c][i] );
+        }
+    }
+    std::vector<frame_type, aligned_allocator<frame_type> > input = buffer;
+
+    FIR<frame_type> fir( ht.data(), taps );
+    fir.process( buffer.data(), buffer.data(), frames );
+    double error = 0.0;
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        for ( std::size_t i = 0; i < frames; ++i )
+        {
+            error = std::max( error, std::fabs( buffer[i][c] - filter_at( x[c], h[c], i ) ) );
+        }
+    }
+
+    std::vector<T> shared( h[0].begin(), h[0].end() );
+    fir.set_coefficients( shared.data(), taps );
+    fir.process( input.data(), buffer.data(), frames );
+    for ( std::size_t c = 0; c < N; ++c )
+    {
+        for ( std::size_t i = 0; i < frames; ++i )
+        {
+            error = std::max( error, std::fabs( buffer[i][c] - filter_at( x[c], h[0], i ) ) );
+        }
+    }
+    ok &= error <= tolerance;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "FIR<SIMD_Vector<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ", " << N
+              << "> > of " << taps << " taps, error " << error << std::endl;
+    return ok;
+}
+
+bool check_decimate( std::size_t taps, std::size_t factor )
+{
+    using namespace Dap;
+    bool ok = true;
+    const std::size_t frames = 240;
+    const std::vector<double> h = random_samples( taps, 3 );
+    const std::vector<double> x = random_samples( frames, 4 );
+    const std::vector<float> ht( h.begin(), h.end() );
+    std::vector<float> buffer( x.begin(), x.end() );
+
+    FIR<float> fir( ht.data(), ht.size() );
+    std::size_t done = 0, written = 0;
+    for ( std::size_t c = 0; done < frames; ++c )
+    {
+        const std::size_t n = std::min( chunks[c % 8], frames - done );
+        written += fir.decimate( buffer.data() + done, n, buffer.data() + written, factor );
+        done += n;
+    }
+    ok &= written == ( frames + factor - 1 ) / factor;
+    double error = 0.0;
+    for ( std::size_t i = 0; i < written; ++i )
+    {
+        error = std::max( error, std::fabs( buffer[i] - filter_at( x, h, i * factor ) ) );
+    }
+    ok &= error <= 1e-5;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "FIR decimate by " << factor << " with " << taps << " taps, error " << error
+              << std::endl;
+    return ok;
+}
+
+bool check_interpolate( std::size_t taps, std::size_t factor )
+{
+    using namespace Dap;
+    bool ok = true;
+    const std::size_t frames = 120;
+    const std::vector<double> h = random_samples( taps, 5 );
+    const std::vector<double> x = random_samples( frames, 6 );
+    const std::vector<float> ht( h.begin(), h.end() ), xt( x.begin(), x.end() );
+    std::vector<float> out( frames * factor );
+
+    FIR<float> fir( ht.data(), ht.size(), factor );
+    ok &= fir.interpolation() == factor;
+    std::size_t done = 0;
+    for ( std::size_t c = 0; done < frames; ++c )
+    {
+        const std::size_t n = std::min( chunks[c % 8], frames - done );
+        fir.interpolate( xt.data() + done, n, out.data() + done * factor );
+        done += n;
+    }
+    double error = 0.0;
+    for ( std::size_t i = 0; i < out.size(); ++i )
+    {
+        error = std::max( error, std::fabs( out[i] - interpolate_at( x, h, factor, i ) ) );
+    }
+    ok &= error <= 1e-5;
+
+    bool threw = false;
+    try
+    {
+        fir.process( out.data(), out.data(), 1 );
+    }
+    catch ( std::logic_error const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "FIR interpolate by " << factor << " with " << taps << " taps, error "
+              << error << std::endl;
+    return ok;
+}
+
+/// A default constructed FIR refuses to filter until it has coefficients
+bool check_no_coefficients()
+{
+    using namespace Dap;
+    bool ok = true;
+    float x[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float y[16];
+
+    FIR<float> fir;
+    ok &= fir.taps() == 0;
+    std::size_t refused = 0;
+    try
+    {
+        fir.process( x, y, 4 );
+    }
+    catch ( std::logic_error const & )
+    {
+        ++refused;
+    }
+    try
+    {
+        fir.decimate( x, 4, y, 2 );
+    }
+    catch ( std::logic_error const & )
+    {
+        ++refused;
+    }
+    try
+    {
+        fir.interpolate( x, 4, y );
+    }
+    catch ( std::logic_error const & )
+    {
+        ++refused;
+    }
+    ok &= refused == 3;
+
+    const float h[2] = {0.5f, 0.5f};
+    fir.set_coefficients( h, 2 );
+    fir.process( x, y, 4 );
+    ok &= y[0] == 0.5f && y[3] == 3.5f;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "FIR without coefficients" << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= check_direct<float>( 16, 1e-5 );
+    ok &= check_direct<float>( 37, 1e-5 );
+    ok &= check_direct<float>( 256, 5e-5 );
+    ok &= check_direct<float>( 1, 1e-6 );
+    ok &= check_direct<double>( 61, 1e-13 );
+    ok &= check_channels<float, 8>( 33, 1e-5 );
+    ok &= check_channels<float, 4>( 16, 1e-5 );
+    ok &= check_channels<double, 4>( 20, 1e-13 );
+    ok &= check_decimate( 48, 4 );
+    ok &= check_decimate( 31, 3 );
+    ok &= check_interpolate( 64, 4 );
+    ok &= check_interpolate( 33, 3 );
+    ok &= check_no_coefficients();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+
+namespace
+{
+
+struct TestTag
+{
+};
+
+using Counting = Dap::CountingInstrument<TestTag>;
+
+static_assert( std::is_empty<Dap::InstrumentDetail::scope<Dap::NoInstrument> >::value,
+               "a disabled instrumentation policy must keep no state" );
+
+bool expect( Dap::BlockOperation op, std::uint64_t calls, std::uint64_t items, std::uint64_t bytes )
+{
+    Dap::InstrumentStats s = Counting::stats( op );
+    bool ok = s.calls == calls && s.items == items && s.bytes == bytes;
+    std::cout << ( ok ? "ok   " : "FAIL " ) << Dap::block_operation_name( op ) << ": " << s.calls << " calls " << s.items
+              << " items " << s.bytes << " bytes " << s.cycles << " cycles" << std::endl;
+    return ok;
+}
+
+float position_sum( std::size_t w, std::size_t h, std::size_t d )
+{
+    return static_cast<float>( w + h + d );
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+    const std::size_t n = 16 * 4 * 2;
+
+    Counting::reset();
+
+    auto a = make_block<twist0, 16, 4, 2, Counting>( 1.0f );
+    auto b = fill_block<float, twist2, 16, 4, 2, Counting>( position_sum );
+    auto c = make_block<twist0, Counting>( 0.0f, 16, 4, 2 );
+    auto d = fill_block<float, twist0, Counting>( position_sum, 16, 4, 2 );
+    ok &= expect( BlockOperation::make_block, 2, 2 * n, 2 * n * sizeof( float ) );
+    ok &= expect( BlockOperation::fill_block, 2, 2 * n, 2 * n * sizeof( float ) );
+
+    apply_block<Counting>( a, []( float v, std::size_t, std::size_t, std::size_t )
+                           {
+        return v * 2.0f;
+    } );
+    apply_block<Counting>( a, c, []( float v, std::size_t, std::size_t, std::size_t )
+                           {
+        return v + 1.0f;
+    } );
+    apply_block<Counting>( a, b, d, []( float x, float y, std::size_t, std::size_t, std::size_t )
+                           {
+        return x * y;
+    } );
+    ok &= expect( BlockOperation::apply_block, 3, 3 * n, ( 2 + 2 + 3 ) * n * sizeof( float ) );
+    ok &= get( c, 3, 2, 1 ) == 3.0f && get( d, 3, 2, 1 ) == 12.0f;
+
+    copy_block<Counting>( b, c );
+    ok &= expect( BlockOperation::copy_block, 1, n, 2 * n * sizeof( float ) );
+
+    auto t = twist_block<3, Counting>( b );
+    ok &= expect( BlockOperation::twist_block, 1, n, 2 * n * sizeof( float ) );
+    ok &= get( t, 15, 3, 1 ) == 19.0f;
+
+    // the default policy records nothing
+    apply_block( a, []( float v, std::size_t, std::size_t, std::size_t )
+                 {
+        return v;
+    } );
+    twist_block<1>( b );
+    ok &= expect( BlockOperation::apply_block, 3, 3 * n, ( 2 + 2 + 3 ) * n * sizeof( float ) );
+    ok &= expect( BlockOperation::copy_block, 1, n, 2 * n * sizeof( float ) );
+
+    Counting::reset();
+    ok &= expect( BlockOperation::twist_block, 0, 0, 0 );
+
+    return ok ? 0 : 1;
+}
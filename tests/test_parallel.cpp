@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+
+namespace
+{
+
+float value_at( std::size_t w, std::size_t h, std::size_t d )
+{
+    return static_cast<float>( w * 10000 + h * 100 + d );
+}
+
+template <typename Block1T, typename Block2T>
+bool same_items( Block1T const &a, Block2T const &b )
+{
+    bool ok = true;
+    for ( std::size_t w = 0; w < a.width(); ++w )
+    {
+        for ( std::size_t h = 0; h < a.height(); ++h )
+        {
+            for ( std::size_t d = 0; d < a.depth(); ++d )
+            {
+                ok &= Dap::get( a, w, h, d ) == Dap::get( b, w, h, d );
+            }
+        }
+    }
+    return ok;
+}
+
+bool check_parallel_for( Dap::ThreadPool &pool )
+{
+    const std::size_t count = 1000;
+    std::vector<std::atomic<int> > hits( count );
+    for ( auto &h : hits )
+    {
+        h.store( 0 );
+    }
+    pool.parallel_for( count, [&]( std::size_t i )
+                       {
+        hits[i].fetch_add( 1 );
+    } );
+    bool ok = true;
+    for ( auto &h : hits )
+    {
+        ok &= h.load() == 1;
+    }
+
+    // nested calls are run by the calling worker while it waits
+    std::atomic<std::size_t> inner( 0 );
+    pool.parallel_for( 8, [&]( std::size_t )
+                       {
+        pool.parallel_for( 8, [&]( std::size_t )
+                           {
+            inner.fetch_add( 1 );
+        } );
+    } );
+    ok &= inner.load() == 64;
+
+    bool threw = false;
+    try
+    {
+        pool.parallel_for( 100, []( std::size_t i )
+                           {
+            if ( i == 42 )
+            {
+                throw std::runtime_error( "task" );
+            }
+        } );
+    }
+    catch ( std::runtime_error const & )
+    {
+        threw = true;
+    }
+    ok &= threw;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "parallel_for on " << pool.size() << " workers" << std::endl;
+    return ok;
+}
+
+/// The parallel forms must give exactly the serial results
+template <typename SourceTwist, typename DestinationTwist>
+bool check_twists( Dap::ThreadPool &pool, std::string const &name )
+{
+    using namespace Dap;
+    const std::size_t width = 1031, height = 37, depth = 3;
+    bool ok = true;
+
+    auto src = fill_block<float, SourceTwist>( value_at, width, height, depth );
+    auto f1 = []( float v, std::size_t w, std::size_t h, std::size_t d )
+    {
+        return std::sqrt( v ) * 0.5f + static_cast<float>( w + 2 * h + 3 * d );
+    };
+    auto f2 = []( float a, float b, std::size_t w, std::size_t, std::size_t )
+    {
+        return a * 0.25f - b + static_cast<float>( w );
+    };
+
+    auto serial = make_block<SourceTwist>( 0.0f, width, height, depth );
+    auto parallel = make_block<SourceTwist>( 0.0f, width, height, depth );
+    copy_block( src, serial );
+    copy_block( src, parallel );
+    apply_block( serial, f1 );
+    parallel_apply_block( pool, parallel, f1 );
+    ok &= same_items( serial, parallel );
+
+    auto serial_dest = make_block<DestinationTwist>( 0.0f, width, height, depth );
+    auto parallel_dest = make_block<DestinationTwist>( 0.0f, width, height, depth );
+    apply_block( src, serial_dest, f1 );
+    parallel_apply_block( pool, src, parallel_dest, f1 );
+    ok &= same_items( serial_dest, parallel_dest );
+
+    apply_block( src, serial, serial_dest, f2 );
+    parallel_apply_block( pool, src, parallel, parallel_dest, f2 );
+    ok &= same_items( serial_dest, parallel_dest );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "parallel_apply_block " << name << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    ThreadPool pool( 4 );
+    ok &= check_parallel_for( pool );
+    ok &= check_parallel_for( ThreadPool::shared() );
+
+    ThreadPool pinned( 2, true );
+    ok &= check_parallel_for( pinned );
+
+    ok &= check_twists<twist0, twist0>( pool, "twist0 -> twist0" );
+    ok &= check_twists<twist2, twist2>( pool, "twist2 -> twist2" );
+    ok &= check_twists<twist2, twist4>( pool, "twist2 -> twist4" );
+    ok &= check_twists<twist5, twist1>( pool, "twist5 -> twist1" );
+
+    return ok ? 0 : 1;
+}
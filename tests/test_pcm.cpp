@@ -0,0 +1,290 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+using Dap::PCMFormat;
+
+const PCMFormat formats[] = {PCMFormat::int16, PCMFormat::int24, PCMFormat::int32};
+
+const char *format_name( PCMFormat format )
+{
+    return format == PCMFormat::int16 ? "int16" : format == PCMFormat::int24 ? "int24" : "int32";
+}
+
+double full_scale( PCMFormat format )
+{
+    return format == PCMFormat::int16 ? 32768.0 : format == PCMFormat::int24 ? 8388608.0 : 2147483648.0;
+}
+
+std::int64_t read_sample( std::vector<unsigned char> const &pcm, PCMFormat format, std::size_t i )
+{
+    const std::size_t bytes = Dap::pcm_format_bytes( format );
+    std::uint32_t u = 0;
+    for ( std::size_t b = 0; b < bytes; ++b )
+    {
+        u |= std::uint32_t( pcm[i * bytes + b] ) << ( 8 * b );
+    }
+    std::int64_t v = u;
+    return v >= full_scale( format ) ? v - 2 * static_cast<std::int64_t>( full_scale( format ) ) : v;
+}
+
+void write_sample( std::vector<unsigned char> &pcm, PCMFormat format, std::size_t i, std::int64_t v )
+{
+    const std::size_t bytes = Dap::pcm_format_bytes( format );
+    const std::uint32_t u = static_cast<std::uint32_t>( v );
+    for ( std::size_t b = 0; b < bytes; ++b )
+    {
+        pcm[i * bytes + b] = static_cast<unsigned char>( u >> ( 8 * b ) );
+    }
+}
+
+/// Random samples of the format, with its extremes at the start
+std::vector<std::int64_t> random_samples( PCMFormat format, std::size_t n, unsigned seed )
+{
+    const std::int64_t fs = static_cast<std::int64_t>( full_scale( format ) );
+    std::mt19937 gen( seed );
+    std::uniform_int_distribution<std::int64_t> dist( -fs, fs - 1 );
+    std::vector<std::int64_t> v( n );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        v[i] = i == 0 ? -fs : i == 1 ? fs - 1 : i == 2 ? 0 : dist( gen );
+    }
+    return v;
+}
+
+/// Every count from 0 to 40, to go through the vector loops and every length of scalar tail, then a long buffer
+template <typename T>
+bool check_round_trip( Dap::DispatchKernelSet<T> const &k, PCMFormat format )
+{
+    bool ok = true;
+    const std::size_t f = static_cast<std::size_t>( format );
+    const std::size_t bytes = Dap::pcm_format_bytes( format );
+    const T gain = T( 0.5 );
+    for ( std::size_t n = 0; n <= 1000; n = n < 40 ? n + 1 : n + 960 )
+    {
+        const std::vector<std::int64_t> samples = random_samples( format, n, static_cast<unsigned>( n ) );
+        // a guard byte after the samples catches stores past the end
+        std::vector<unsigned char> pcm( n * bytes + 1, 0xa5 ), back( n * bytes + 1, 0xa5 );
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            write_sample( pcm, format, i, samples[i] );
+        }
+        std::vector<T> decoded( n + 1, T( -7 ) );
+        k.pcm_decode[f]( pcm.data(), gain, decoded.data(), n );
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            const T want = static_cast<T>( samples[i] ) * static_cast<T>( gain / full_scale( format ) );
+            ok &= decoded[i] == want;
+        }
+        ok &= decoded[n] == T( -7 );
+
+        // back by the inverse gain, to the same samples unless a float could not hold them
+        k.pcm_encode[f]( decoded.data(), 1 / gain, back.data(), n, 0 );
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            const double exact = static_cast<double>( samples[i] );
+            const double held = static_cast<double>( static_cast<T>( exact ) );
+            const std::int64_t got = read_sample( back, format, i );
+            ok &= held == exact ? got == samples[i] : std::abs( double( got ) - held ) <= 128.0 || got == samples[i];
+        }
+        ok &= back[n * bytes] == 0xa5;
+    }
+    return ok;
+}
+
+template <typename T>
+bool check_limits( Dap::DispatchKernelSet<T> const &k, PCMFormat format )
+{
+    bool ok = true;
+    const std::size_t f = static_cast<std::size_t>( format );
+    const std::size_t bytes = Dap::pcm_format_bytes( format );
+    const std::int64_t fs = static_cast<std::int64_t>( full_scale( format ) );
+    const T lsb = static_cast<T>( 1 / full_scale( format ) );
+
+    // the same pattern at every lane, then in the scalar tail
+    const std::size_t n = 64 + 5;
+    std::vector<T> in( n );
+    std::vector<std::int64_t> want( n );
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        switch ( i % 8 )
+        {
+        case 0:
+            in[i] = T( 1.5 ), want[i] = fs - 1;
+            break;
+        case 1:
+            in[i] = T( -3 ), want[i] = -fs;
+            break;
+        case 2:
+            in[i] = T( 1 ), want[i] = fs - 1;
+            break;
+        case 3:
+            in[i] = T( -1 ), want[i] = -fs;
+            break;
+        case 4:
+            in[i] = nan, want[i] = -fs;
+            break;
+        case 5:
+            in[i] = T( 0.25 ) * lsb, want[i] = 0;
+            break;
+        case 6:
+            in[i] = T( -2.75 ) * lsb, want[i] = -3;
+            break;
+        default:
+            in[i] = T( 7.5 ) * lsb, want[i] = 8;
+            break;
+        }
+    }
+    std::vector<unsigned char> pcm( n * bytes );
+    k.pcm_encode[f]( in.data(), T( 1 ), pcm.data(), n, 0 );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        const std::int64_t got = read_sample( pcm, format, i );
+        // the largest float below 2^31 is 128 under the largest int32
+        ok &= got == want[i] || ( sizeof( T ) == 4 && format == PCMFormat::int32 && got == want[i] - 127 );
+    }
+    return ok;
+}
+
+/// TPDF dither of a constant a third of a step: each output is the step below or above it or one further out, and
+/// the average is the constant
+template <typename T>
+bool check_dither( Dap::DispatchKernelSet<T> const &k, PCMFormat format )
+{
+    bool ok = true;
+    const std::size_t f = static_cast<std::size_t>( format );
+    const std::size_t n = 20003;
+    const T value = static_cast<T>( ( 100.0 + 1.0 / 3.0 ) / full_scale( format ) );
+    std::vector<T> in( n, value );
+    std::vector<unsigned char> pcm( n * Dap::pcm_format_bytes( format ) );
+    Dap::PCMDither dither( 42 );
+    k.pcm_encode[f]( in.data(), T( 1 ), pcm.data(), n, dither.state() );
+    double sum = 0.0;
+    std::size_t counts[4] = {0, 0, 0, 0};
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        const std::int64_t got = read_sample( pcm, format, i );
+        ok &= got >= 99 && got <= 101;
+        counts[std::min<std::int64_t>( 3, std::max<std::int64_t>( 0, got - 98 ) )]++;
+        sum += double( got );
+    }
+    ok &= std::fabs( sum / n - ( 100.0 + 1.0 / 3.0 ) ) < 0.02;
+    ok &= counts[1] > 0 && counts[2] > 0 && counts[3] > 0;
+    return ok;
+}
+
+template <typename T>
+bool check_set( Dap::DispatchKernelSet<T> const &k, std::string const &name )
+{
+    bool ok = true;
+    for ( PCMFormat format : formats )
+    {
+        bool format_ok = check_round_trip( k, format );
+        format_ok &= check_limits( k, format );
+        format_ok &= check_dither( k, format );
+        std::cout << ( format_ok ? "ok   " : "FAIL " ) << name << " " << format_name( format ) << std::endl;
+        ok &= format_ok;
+    }
+    return ok;
+}
+
+template <typename BlockT>
+bool check_block( BlockT &block, std::string const &name )
+{
+    using namespace Dap;
+    bool ok = true;
+    const auto view = view_block( block );
+    const std::size_t frames = view.width(), height = view.height(), channels = height * view.depth();
+    const PCMFormat format = PCMFormat::int24;
+    const std::vector<std::int64_t> samples = random_samples( format, frames * channels, 9 );
+    std::vector<unsigned char> pcm( samples.size() * 3 ), back( samples.size() * 3 );
+    for ( std::size_t i = 0; i < samples.size(); ++i )
+    {
+        write_sample( pcm, format, i, samples[i] );
+    }
+
+    pcm_to_block( pcm.data(), format, block, 2.0f );
+    for ( std::size_t f = 0; f < frames; ++f )
+    {
+        for ( std::size_t c = 0; c < channels; ++c )
+        {
+            ok &= get( block, f, c % height, c / height ) == float( samples[f * channels + c] ) * 2.0f / 8388608.0f;
+        }
+    }
+    block_to_pcm( block, back.data(), format, 0.5f );
+    ok &= back == pcm;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "PCM and " << name << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    for ( std::size_t i = 0; i < cpu_variant_count; ++i )
+    {
+        CpuVariant v = static_cast<CpuVariant>( i );
+        DispatchKernels const *k = dispatch_kernels( v );
+        if ( !k )
+        {
+            continue;
+        }
+        ok &= check_set( k->f32, std::string( cpu_variant_name( v ) ) + " float" );
+        ok &= check_set( k->f64, std::string( cpu_variant_name( v ) ) + " double" );
+    }
+
+    // interleaved storage, planar rows through the tiled transpose, and other strides one item at a time
+    Block<float, twist0, 300, 4, 1> interleaved;
+    ok &= check_block( interleaved, "an interleaved Block" );
+    auto planar = make_block<twist3>( 0.0f, 5000, 3, 1 );
+    ok &= check_block( planar, "a planar DynBlock" );
+    auto layers = make_block<twist4>( 0.0f, 77, 3, 2 );
+    ok &= check_block( layers, "a twist4 DynBlock" );
+    auto wide = make_block<twist3>( 0.0f, 40, 2, 3 );
+    auto window = sub_block( wide, 3, 0, 0, 37, 2, 3 );
+    ok &= check_block( window, "a planar sub_block view" );
+    Block<float, twist1, 50, 3, 1> rows;
+    ok &= check_block( rows, "a twist1 Block" );
+    auto mixed = make_block<twist2>( 0.0f, 77, 3, 2 );
+    ok &= check_block( mixed, "a twist2 DynBlock" );
+
+    return ok ? 0 : 1;
+}
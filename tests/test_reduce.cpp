@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+template <typename T>
+bool close( T a, long double b, std::size_t n )
+{
+    const long double tolerance = std::numeric_limits<T>::epsilon() * 4.0L * ( n + 1 );
+    return std::abs( static_cast<long double>( a ) - b ) <= tolerance * ( 1.0L + std::abs( b ) );
+}
+
+template <typename VecT>
+bool check_horizontal()
+{
+    using namespace Dap;
+    using value_type = typename simd_value_type<VecT>::type;
+    const size_t n = simd_size<VecT>::value;
+    std::mt19937 gen( 99 );
+    std::uniform_real_distribution<double> dist( -4.0, 4.0 );
+    bool ok = true;
+
+    for ( size_t iter = 0; iter < 1000; ++iter )
+    {
+        VecT a, b;
+        long double sum = 0, prod = 0;
+        value_type lo = std::numeric_limits<value_type>::infinity(), hi = -lo, peak = 0;
+        for ( size_t i = 0; i < n; ++i )
+        {
+            a[i] = static_cast<value_type>( dist( gen ) );
+            b[i] = static_cast<value_type>( dist( gen ) );
+            sum += a[i];
+            prod += static_cast<long double>( a[i] ) * b[i];
+            lo = std::min( lo, a[i] );
+            hi = std::max( hi, a[i] );
+            peak = std::max( peak, std::abs( a[i] ) );
+        }
+        ok &= close( hsum( a ), sum, n ) && close( dot( a, b ), prod, n );
+        ok &= hmin( a ) == lo && hmax( a ) == hi && habsmax( a ) == peak;
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "horizontal<" << ( sizeof( value_type ) == 4 ? "float" : "double" ) << ","
+              << n << ">" << std::endl;
+    return ok;
+}
+
+template <typename T>
+bool check_blocks()
+{
+    using namespace Dap;
+    std::mt19937 gen( 7 );
+    std::uniform_real_distribution<double> dist( -1.0, 1.0 );
+    bool ok = true;
+
+    // every length up to a few multiples of the four accumulator stride, so every tail is covered
+    for ( size_t n = 0; n < 16 * simd_native_size<T>::value + 3; ++n )
+    {
+        std::vector<T> a( n ), b( n );
+        long double sum = 0, prod = 0;
+        T lo = std::numeric_limits<T>::infinity(), hi = -lo, peak = 0;
+        for ( size_t i = 0; i < n; ++i )
+        {
+            a[i] = static_cast<T>( dist( gen ) );
+            b[i] = static_cast<T>( dist( gen ) );
+            sum += a[i];
+            prod += static_cast<long double>( a[i] ) * b[i];
+            lo = std::min( lo, a[i] );
+            hi = std::max( hi, a[i] );
+            peak = std::max( peak, std::abs( a[i] ) );
+        }
+        ok &= close( sum_block( a.data(), n ), sum, n ) && close( dot_block( a.data(), b.data(), n ), prod, n );
+        ok &= min_block( a.data(), n ) == lo && max_block( a.data(), n ) == hi && absmax_block( a.data(), n ) == peak;
+    }
+
+    auto block = fill_block<T, twist1, 7, 5, 3>( []( size_t w, size_t h, size_t d )
+                                                 {
+        return static_cast<T>( w ) - static_cast<T>( h * d );
+    } );
+    ok &= sum_block( block ) == T( 3 * 5 * 21 - 7 * 10 * 3 );
+    ok &= min_block( block ) == T( -8 ) && max_block( block ) == T( 6 ) && absmax_block( block ) == T( 8 );
+    ok &= dot_block( block, block ) == sum_block( fill_block<T, twist1, 7, 5, 3>( [&block]( size_t w, size_t h, size_t d )
+                                                                                  {
+        T v = get( block, w, h, d );
+        return v * v;
+    } ) );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "block reductions<" << ( sizeof( T ) == 4 ? "float" : "double" ) << ">"
+              << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    ok &= check_horizontal<Vec<float, 4> >();
+    ok &= check_horizontal<Vec<double, 2> >();
+    ok &= check_horizontal<Vec<float, 8> >();
+    ok &= check_horizontal<Vec<double, 4> >();
+    ok &= check_horizontal<Vec<float, 16> >();
+    ok &= check_horizontal<Vec<float, 12> >();
+    ok &= check_horizontal<Vec<double, 8> >();
+    ok &= check_horizontal<Vec<float, 3> >();
+    ok &= check_blocks<float>();
+    ok &= check_blocks<double>();
+
+    return ok ? 0 : 1;
+}
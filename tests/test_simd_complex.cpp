@@ -0,0 +1,291 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+template <typename T>
+struct tolerance
+{
+};
+
+template <>
+struct tolerance<float>
+{
+    static double value()
+    {
+        return 2e-6;
+    }
+};
+
+template <>
+struct tolerance<double>
+{
+    static double value()
+    {
+        return 4e-15;
+    }
+};
+
+typedef std::complex<long double> reference_type;
+
+/// Is a within the tolerance of T of the reference r, relative to scale
+template <typename T>
+bool near( std::complex<T> const &a, reference_type const &r, long double scale )
+{
+    return std::abs( reference_type( a.real(), a.imag() ) - r ) <= tolerance<T>::value() * scale;
+}
+
+template <typename T>
+reference_type widen( std::complex<T> const &a )
+{
+    return reference_type( a.real(), a.imag() );
+}
+
+/// Distance between a and the reference r in units of the last place of T
+template <typename T>
+double ulp_error( T a, long double r )
+{
+    T rounded = static_cast<T>( r );
+    T ulp = std::nextafter( std::abs( rounded ), std::numeric_limits<T>::infinity() ) - std::abs( rounded );
+    return static_cast<double>( std::abs( static_cast<long double>( a ) - r ) / ulp );
+}
+
+template <typename T, size_t N>
+bool check_interleaved( std::string const &name )
+{
+    using namespace Dap;
+    typedef std::complex<T> C;
+    typedef SIMD_Vector<C, N> V;
+    std::mt19937 gen( 42 );
+    std::uniform_real_distribution<T> dist( T( -4 ), T( 4 ) );
+    bool ok = true;
+
+    for ( size_t iter = 0; iter < 2000; ++iter )
+    {
+        V a, b, c;
+        for ( size_t i = 0; i < N; ++i )
+        {
+            a[i] = C( dist( gen ), dist( gen ) );
+            b[i] = C( dist( gen ), dist( gen ) );
+            c[i] = C( dist( gen ), dist( gen ) );
+        }
+        const C s( dist( gen ), dist( gen ) );
+        const V product = a * b;
+        const V mac = fma( a, b, c );
+        const V msc = fms( a, b, c );
+        const V correlation = conj_multiply( a, b );
+        const V quotient = a / b;
+        const V inverse = reciprocal( b );
+        const V scaled = a * s + c;
+        const V conjugate = conj( a );
+        const V n = norm( a );
+        const V m = abs( a );
+        const V phase = arg( a );
+        reference_type sum( 0, 0 );
+        for ( size_t i = 0; i < N; ++i )
+        {
+            const reference_type ra = widen( a[i] ), rb = widen( b[i] ), rc = widen( c[i] );
+            const long double scale = std::abs( ra ) * std::abs( rb ) + std::abs( rc );
+            ok &= near( product[i], ra * rb, scale );
+            ok &= near( mac[i], ra * rb + rc, scale );
+            ok &= near( msc[i], ra * rb - rc, scale );
+            ok &= near( correlation[i], ra * std::conj( rb ), scale );
+            ok &= near( quotient[i], ra / rb, 4 * std::abs( ra / rb ) );
+            ok &= near( inverse[i], 1.0L / rb, 4 * std::abs( 1.0L / rb ) );
+            ok &= near( scaled[i], ra * widen( s ) + rc, std::abs( ra ) * std::abs( widen( s ) ) + std::abs( rc ) );
+            ok &= conjugate[i] == std::conj( a[i] );
+            ok &= near( n[i], std::norm( ra ), std::norm( ra ) );
+            ok &= near( m[i], std::abs( ra ), std::abs( ra ) );
+            ok &= near( phase[i], std::arg( ra ), 4 );
+            sum += ra;
+        }
+        ok &= near( hsum( a ), sum, 4 * N );
+    }
+
+    V z;
+    zero( z );
+    ok &= abs( z )[0] == C( 0, 0 ) && arg( z )[0] == C( 0, 0 ) && norm( z )[0] == C( 0, 0 );
+
+    if ( !ok )
+    {
+        std::cout << "FAIL " << name << std::endl;
+    }
+    else
+    {
+        std::cout << "ok   " << name << std::endl;
+    }
+    return ok;
+}
+
+template <typename T, size_t N>
+bool check_split( std::string const &name )
+{
+    using namespace Dap;
+    typedef std::complex<T> C;
+    typedef SIMD_SplitComplex<T, N> V;
+    std::mt19937 gen( 7 );
+    std::uniform_real_distribution<T> dist( T( -4 ), T( 4 ) );
+    bool ok = true;
+
+    for ( size_t iter = 0; iter < 2000; ++iter )
+    {
+        C ia[N], ib[N], ic[N], out[N];
+        T re[N], im[N];
+        for ( size_t i = 0; i < N; ++i )
+        {
+            ia[i] = C( dist( gen ), dist( gen ) );
+            ib[i] = C( dist( gen ), dist( gen ) );
+            ic[i] = C( dist( gen ), dist( gen ) );
+            re[i] = ib[i].real();
+            im[i] = ib[i].imag();
+        }
+        V a, b, c;
+        a.load( ia );
+        b.load( re, im );
+        c.load( ic );
+        const V product = a * b;
+        const V mac = fma( a, b, c );
+        const V correlation = conj_multiply( a, b );
+        const V quotient = a / b;
+        const typename V::plane_type n = norm( a );
+        const typename V::plane_type m = abs( a );
+        const typename V::plane_type phase = arg( a );
+        mac.store( out );
+        product.store( re, im );
+        reference_type sum( 0, 0 );
+        for ( size_t i = 0; i < N; ++i )
+        {
+            const reference_type ra = widen( ia[i] ), rb = widen( ib[i] ), rc = widen( ic[i] );
+            const long double scale = std::abs( ra ) * std::abs( rb ) + std::abs( rc );
+            ok &= near( C( re[i], im[i] ), ra * rb, scale );
+            ok &= near( out[i], ra * rb + rc, scale );
+            ok &= near( correlation[i], ra * std::conj( rb ), scale );
+            ok &= near( quotient[i], ra / rb, 4 * std::abs( ra / rb ) );
+            ok &= conj( a )[i] == std::conj( ia[i] );
+            ok &= near( C( n[i] ), std::norm( ra ), std::norm( ra ) );
+            ok &= near( C( m[i] ), std::abs( ra ), std::abs( ra ) );
+            ok &= near( C( phase[i] ), std::arg( ra ), 4 );
+            sum += ra;
+        }
+        ok &= near( hsum( a ), sum, 4 * N );
+    }
+
+    if ( !ok )
+    {
+        std::cout << "FAIL " << name << std::endl;
+    }
+    else
+    {
+        std::cout << "ok   " << name << std::endl;
+    }
+    return ok;
+}
+
+template <typename T, size_t N>
+bool check_atan2( std::string const &name, double max_ulp )
+{
+    using namespace Dap;
+    typedef SIMD_Vector<T, N> V;
+    std::mt19937 gen( 1234 );
+    std::uniform_real_distribution<double> angle( -3.14159265358979323846, 3.14159265358979323846 );
+    std::uniform_real_distribution<double> magnitude( -20.0, 20.0 );
+    double worst = 0.0;
+
+    for ( size_t iter = 0; iter < 100000; ++iter )
+    {
+        V y, x;
+        for ( size_t i = 0; i < N; ++i )
+        {
+            const double theta = angle( gen ), r = std::exp2( magnitude( gen ) );
+            y[i] = static_cast<T>( r * std::sin( theta ) );
+            x[i] = static_cast<T>( r * std::cos( theta ) );
+        }
+        const V a = atan2( y, x );
+        for ( size_t i = 0; i < N; ++i )
+        {
+            worst = std::max( worst, ulp_error<T>( a[i], std::atan2( static_cast<long double>( y[i] ), x[i] ) ) );
+        }
+    }
+
+    V y, x;
+    y[0] = 0;
+    x[0] = 0;
+    y[N - 1] = 0;
+    x[N - 1] = -1;
+    const V a = atan2( y, x );
+    bool ok = worst <= max_ulp && a[0] == 0 && a[N - 1] == T( 3.14159265358979323846 );
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << name << " max " << worst << " ulp" << std::endl;
+    return ok;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+#if defined( __SSE2__ )
+    static_assert( std::is_same<SIMD_Vector<std::complex<float>, 8>::chunk_type,
+                                SIMD_Vector<std::complex<float>, simd_register_sizes<std::complex<float> >::wide> >::value,
+                   "complex float vectors are made of native registers" );
+    static_assert( std::is_same<SIMD_Vector<std::complex<double>, 3>::chunk_type, SIMD_Vector<std::complex<double>, 1> >::value,
+                   "a complex double fills an SSE register" );
+#endif
+
+    ok &= check_interleaved<float, 1>( "SIMD_Vector<std::complex<float>, 1>" );
+    ok &= check_interleaved<float, 2>( "SIMD_Vector<std::complex<float>, 2>" );
+    ok &= check_interleaved<float, 4>( "SIMD_Vector<std::complex<float>, 4>" );
+    ok &= check_interleaved<float, 8>( "SIMD_Vector<std::complex<float>, 8>" );
+    ok &= check_interleaved<float, 3>( "SIMD_Vector<std::complex<float>, 3>" );
+    ok &= check_interleaved<double, 1>( "SIMD_Vector<std::complex<double>, 1>" );
+    ok &= check_interleaved<double, 2>( "SIMD_Vector<std::complex<double>, 2>" );
+    ok &= check_interleaved<double, 4>( "SIMD_Vector<std::complex<double>, 4>" );
+    ok &= check_interleaved<double, 3>( "SIMD_Vector<std::complex<double>, 3>" );
+
+    ok &= check_split<float, 4>( "SIMD_SplitComplex<float, 4>" );
+    ok &= check_split<float, 8>( "SIMD_SplitComplex<float, 8>" );
+    ok &= check_split<double, 2>( "SIMD_SplitComplex<double, 2>" );
+    ok &= check_split<double, 4>( "SIMD_SplitComplex<double, 4>" );
+
+    ok &= check_atan2<float, 4>( "atan2 SIMD_Vector<float, 4>", 3.5 );
+    ok &= check_atan2<float, 8>( "atan2 SIMD_Vector<float, 8>", 3.5 );
+    ok &= check_atan2<double, 2>( "atan2 SIMD_Vector<double, 2>", 2.0 );
+    ok &= check_atan2<double, 4>( "atan2 SIMD_Vector<double, 4>", 2.0 );
+
+    return ok ? 0 : 1;
+}
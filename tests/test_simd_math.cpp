@@ -0,0 +1,278 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <iostream>
+#include <random>
+
+/// Distance between a and the correctly rounded reference r, in units of the last place of T
+template <typename T>
+double ulp_error( T a, long double r )
+{
+    if ( std::isnan( r ) )
+    {
+        return std::isnan( a ) ? 0.0 : 1e9;
+    }
+    T rounded = static_cast<T>( r );
+    if ( std::isinf( rounded ) || std::isinf( a ) )
+    {
+        return ( a == rounded ) ? 0.0 : 1e9;
+    }
+    T ulp = std::nextafter( std::abs( rounded ), std::numeric_limits<T>::infinity() ) - std::abs( rounded );
+    return static_cast<double>( std::abs( static_cast<long double>( a ) - r ) / ulp );
+}
+
+template <typename VecT, typename VecFunc, typename RefFunc>
+bool check( std::string const &name, VecFunc vf, RefFunc rf, double lo, double hi, double max_ulp, bool log_scale = false )
+{
+    using value_type = typename Dap::simd_value_type<VecT>::type;
+    const size_t n = Dap::simd_size<VecT>::value;
+    std::mt19937 gen( 1234 );
+    std::uniform_real_distribution<double> dist( lo, hi );
+    double worst = 0.0;
+    value_type worst_x = 0;
+
+    for ( size_t iter = 0; iter < 200000; ++iter )
+    {
+        VecT x;
+        for ( size_t i = 0; i < n; ++i )
+        {
+            double v = dist( gen );
+            x[i] = static_cast<value_type>( log_scale ? std::exp2( v ) : v );
+        }
+        VecT r = vf( x );
+        for ( size_t i = 0; i < n; ++i )
+        {
+            double e = ulp_error<value_type>( r[i], rf( static_cast<long double>( x[i] ) ) );
+            if ( e > worst )
+            {
+                worst = e;
+                worst_x = x[i];
+            }
+        }
+    }
+
+    bool ok = worst <= max_ulp;
+    std::cout << ( ok ? "ok   " : "FAIL " ) << name << "<" << ( sizeof( value_type ) == 4 ? "float" : "double" ) << "," << n
+              << ">: max " << worst << " ulp at " << worst_x << " (limit " << max_ulp << ")" << std::endl;
+    return ok;
+}
+
+template <typename VecT>
+bool check_special()
+{
+    using namespace Dap;
+    using value_type = typename Dap::simd_value_type<VecT>::type;
+    const value_type inf = std::numeric_limits<value_type>::infinity();
+    const value_type nan = std::numeric_limits<value_type>::quiet_NaN();
+    VecT x;
+    bool ok = true;
+
+    splat( x, value_type( 0 ) );
+    ok &= log( x )[0] == -inf && log2( x )[0] == -inf && exp( x )[0] == 1 && exp2( x )[0] == 1;
+    splat( x, value_type( -1 ) );
+    ok &= std::isnan( log( x )[0] ) && std::isnan( log2( x )[0] );
+    splat( x, inf );
+    ok &= log( x )[0] == inf && exp( x )[0] == inf && exp2( x )[0] == inf;
+    splat( x, -inf );
+    ok &= exp( x )[0] == 0 && exp2( x )[0] == 0;
+    splat( x, nan );
+    ok &= std::isnan( exp( x )[0] ) && std::isnan( log( x )[0] ) && std::isnan( sin( x )[0] );
+    splat( x, value_type( -2 ) );
+    ok &= arg( x )[0] == static_cast<value_type>( Constants::pi() ) && abs( x )[0] == 2;
+    splat( x, value_type( 2 ) );
+    ok &= arg( x )[0] == 0;
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "special values<" << ( sizeof( value_type ) == 4 ? "float" : "double" ) << ","
+              << Dap::simd_size<VecT>::value << ">" << std::endl;
+    return ok;
+}
+
+/// fma and fms are exactly the fused result when the target has FMA, and exactly the separate multiply and add otherwise
+template <typename VecT>
+bool check_fma()
+{
+    using namespace Dap;
+    using value_type = typename Dap::simd_value_type<VecT>::type;
+    const size_t n = Dap::simd_size<VecT>::value;
+    std::mt19937 gen( 1234 );
+    std::uniform_real_distribution<double> dist( -2.0, 2.0 );
+    bool ok = true;
+
+    for ( size_t iter = 0; iter < 10000; ++iter )
+    {
+        VecT a, b, c;
+        for ( size_t i = 0; i < n; ++i )
+        {
+            a[i] = static_cast<value_type>( dist( gen ) );
+            b[i] = static_cast<value_type>( dist( gen ) );
+            c[i] = static_cast<value_type>( dist( gen ) );
+        }
+        VecT r = fma( a, b, c );
+        VecT s = fms( a, b, c );
+        VecT rr = fma( SIMD_VectorConstRef<value_type, n>( a ), SIMD_VectorConstRef<value_type, n>( b ), c );
+        for ( size_t i = 0; i < n; ++i )
+        {
+#if defined( DAP_HAS_FMA )
+            const value_type expect_fma = std::fma( a[i], b[i], c[i] );
+            const value_type expect_fms = std::fma( a[i], b[i], -c[i] );
+#else
+            const value_type product = a[i] * b[i];
+            const value_type expect_fma = product + c[i];
+            const value_type expect_fms = product - c[i];
+#endif
+            ok &= r[i] == expect_fma && s[i] == expect_fms && rr[i] == expect_fma;
+            ok &= Dap::fma( a[i], b[i], c[i] ) == expect_fma && Dap::fms( a[i], b[i], c[i] ) == expect_fms;
+        }
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "fma/fms<" << ( sizeof( value_type ) == 4 ? "float" : "double" ) << "," << n
+              << ">" << std::endl;
+    return ok;
+}
+
+template <typename VecT>
+bool check_mask()
+{
+    using namespace Dap;
+    using value_type = typename Dap::simd_value_type<VecT>::type;
+    typedef typename VecT::mask_type mask_type;
+    const size_t n = Dap::simd_size<VecT>::value;
+    std::mt19937 gen( 4321 );
+    std::uniform_int_distribution<int> dist( -3, 3 );
+    bool ok = true;
+
+    const unsigned int full = n < 32 ? ( 1u << n ) - 1 : ~0u;
+
+    for ( size_t iter = 0; iter < 1000; ++iter )
+    {
+        VecT a, b;
+        for ( size_t i = 0; i < n; ++i )
+        {
+            a[i] = static_cast<value_type>( dist( gen ) );
+            b[i] = static_cast<value_type>( dist( gen ) );
+        }
+        const mask_type eq = a == b, ne = a != b, lt = a < b, le = a <= b, gt = a > b, ge = a >= b;
+        const VecT lo = select( lt, a, b );
+        const VecT hi = select( lt, b, a );
+        const VecT lt_v = less( a, b ), le_v = less_equal( a, b ), gt_v = greater( a, b ), ge_v = greater_equal( a, b );
+        const VecT eq_v = equal_to( a, b ), ne_v = not_equal_to( a, b );
+        unsigned int bits = 0;
+        for ( size_t i = 0; i < n; ++i )
+        {
+            const value_type x = a[i], y = b[i];
+            ok &= eq[i] == ( x == y ) && ne[i] == ( x != y ) && lt[i] == ( x < y ) && le[i] == ( x <= y )
+                  && gt[i] == ( x > y ) && ge[i] == ( x >= y );
+            ok &= lt_v[i] == less( x, y ) && le_v[i] == less_equal( x, y ) && gt_v[i] == greater( x, y )
+                  && ge_v[i] == greater_equal( x, y ) && eq_v[i] == equal_to( x, y ) && ne_v[i] == not_equal_to( x, y );
+            ok &= lo[i] == select( x < y, x, y ) && hi[i] == std::max( x, y );
+            ok &= ( lt | eq )[i] == le[i] && ( le & ge )[i] == eq[i] && ( lt ^ le )[i] == eq[i] && ( ~lt )[i] == ge[i];
+            bits |= ( x < y ) ? ( 1u << i ) : 0u;
+        }
+        ok &= lt.movemask() == bits;
+        ok &= any( lt ) == ( bits != 0 ) && none( lt ) == ( bits == 0 ) && all( le ) == ( le.movemask() == full );
+        ok &= all( eq | ne ) && none( eq & ne );
+    }
+    ok &= all( mask_type( true ) ) && none( mask_type( false ) );
+
+    // branch free clip of a ramp to +/- 1
+    VecT x, limit, r;
+    splat( limit, value_type( 1 ) );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        x[i] = static_cast<value_type>( i ) - value_type( 1.5 );
+    }
+    r = select( x > limit, limit, select( x < -limit, -limit, x ) );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        ok &= r[i] == std::min( value_type( 1 ), std::max( value_type( -1 ), x[i] ) );
+    }
+
+    std::cout << ( ok ? "ok   " : "FAIL " ) << "mask<" << ( sizeof( value_type ) == 4 ? "float" : "double" ) << "," << n
+              << ">" << std::endl;
+    return ok;
+}
+
+template <typename VecT>
+bool check_all( double trig_ulp, double tan_ulp, double exp_ulp, double log_ulp )
+{
+    using namespace Dap;
+    bool ok = true;
+    const double trig_range = sizeof( typename simd_value_type<VecT>::type ) == 4 ? 8192.0 : 1048576.0;
+    const double exp_range = sizeof( typename simd_value_type<VecT>::type ) == 4 ? 87.0 : 708.0;
+    const double exp2_range = sizeof( typename simd_value_type<VecT>::type ) == 4 ? 126.0 : 1022.0;
+
+    ok &= check<VecT>( "sin", []( VecT const &x ) { return sin( x ); }, []( long double x ) { return std::sin( x ); },
+                       -trig_range, trig_range, trig_ulp );
+    ok &= check<VecT>( "cos", []( VecT const &x ) { return cos( x ); }, []( long double x ) { return std::cos( x ); },
+                       -trig_range, trig_range, trig_ulp );
+    ok &= check<VecT>( "tan", []( VecT const &x ) { return tan( x ); }, []( long double x ) { return std::tan( x ); },
+                       -trig_range, trig_range, tan_ulp );
+    ok &= check<VecT>( "sin", []( VecT const &x ) { return sin( x ); }, []( long double x ) { return std::sin( x ); },
+                       -10.0, 10.0, trig_ulp );
+    ok &= check<VecT>( "exp", []( VecT const &x ) { return exp( x ); }, []( long double x ) { return std::exp( x ); },
+                       -exp_range, exp_range, exp_ulp );
+    ok &= check<VecT>( "exp2", []( VecT const &x ) { return exp2( x ); }, []( long double x ) { return std::exp2( x ); },
+                       -exp2_range, exp2_range, exp_ulp + 0.5 );
+    ok &= check<VecT>( "log", []( VecT const &x ) { return log( x ); }, []( long double x ) { return std::log( x ); },
+                       -exp2_range, exp2_range, log_ulp, true );
+    ok &= check<VecT>( "log", []( VecT const &x ) { return log( x ); }, []( long double x ) { return std::log( x ); },
+                       0.5, 2.0, log_ulp );
+    ok &= check<VecT>( "log2", []( VecT const &x ) { return log2( x ); }, []( long double x ) { return std::log2( x ); },
+                       -exp2_range, exp2_range, log_ulp + 0.5, true );
+    ok &= check_special<VecT>();
+    ok &= check_fma<VecT>();
+    ok &= check_mask<VecT>();
+    return ok;
+}
+
+int main()
+{
+    using namespace Dap;
+    bool ok = true;
+
+    // limits are the bounds documented on the SIMD_Vector specializations
+    ok &= check_all<Vec<float, 4> >( 2.5, 3.5, 1.0, 1.0 );
+    ok &= check_all<Vec<double, 2> >( 2.0, 2.5, 2.0, 1.0 );
+    ok &= check_all<Vec<float, 8> >( 2.5, 3.5, 1.0, 1.0 );
+    ok &= check_all<Vec<double, 4> >( 2.0, 2.5, 2.0, 1.0 );
+
+    // wide vectors are made of native registers and keep their bounds
+    ok &= check_all<Vec<float, 16> >( 2.5, 3.5, 1.0, 1.0 );
+    ok &= check_all<Vec<double, 8> >( 2.0, 2.5, 2.0, 1.0 );
+    ok &= check_mask<Vec<float, 32> >();
+    ok &= check_mask<Vec<float, 12> >();
+
+    ok &= check_mask<SIMD_Vector<float, 3> >();
+    ok &= check_mask<SIMD_Vector<double, 5> >();
+
+    return ok ? 0 : 1;
+}
@@ -54,7 +54,7 @@ std::ostream &operator<<( std::ostream &ostr, Dap::Block<T, TwistType, Width, He
         std::cout << ( w < Width - 1 ? "},\n" : "}\n" );
     }
     std::size_t num = Width * Height * Depth;
-    T const *p = &v.content[0][0][0];
+    T const *p = v.data();
     for ( std::size_t i = 0; i < num; ++i, ++p )
     {
         std::cout << *p << "\n";
@@ -107,10 +107,7 @@ void do_biquad( double freq, double q )
     std::cout << filter.coeffs << std::endl;
     std::cout << filter.state << std::endl;
 
-    for ( size_t w = 0; w < output_audio.width; ++w )
-    {
-        set( output_audio, filter( get( input_audio, w, 0, 0 ) ), w, 0, 0 );
-    }
+    filter.process( input_audio, output_audio, Axis::width );
 
     std::cout << output_audio << std::endl;
 }
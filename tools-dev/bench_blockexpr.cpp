@@ -0,0 +1,112 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/// Time the crossfade out = a * g + b * ( 1 - g ) of float blocks as one
+/// fused evaluate_block against the three apply_block passes and two
+/// temporary blocks it replaces. Prints milliseconds per crossfade.
+
+namespace
+{
+
+const std::size_t bench_width = 4096;
+const std::size_t bench_height = 256;
+const std::size_t bench_depth = 4;
+const int bench_repeats = 20;
+
+template <typename F>
+double ms_per_pass( F f )
+{
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>( end - start ).count() / bench_repeats;
+}
+
+template <typename GainTwist>
+void bench_crossfade( std::string const &name )
+{
+    using namespace Dap;
+    auto a = make_block<twist2>( 0.25f, bench_width, bench_height, bench_depth );
+    auto b = make_block<twist2>( 0.75f, bench_width, bench_height, bench_depth );
+    auto g = fill_block<float, GainTwist>( []( std::size_t w, std::size_t, std::size_t )
+                                           {
+                                               return static_cast<float>( w ) / bench_width;
+                                           },
+                                           bench_width,
+                                           bench_height,
+                                           bench_depth );
+    auto out = make_block<twist2>( 0.0f, bench_width, bench_height, bench_depth );
+    auto faded_a = make_block<twist2>( 0.0f, bench_width, bench_height, bench_depth );
+    auto faded_b = make_block<twist2>( 0.0f, bench_width, bench_height, bench_depth );
+
+    double passes = ms_per_pass( [&]()
+                                 {
+        apply_block( a, g, faded_a, []( float x, float y, std::size_t, std::size_t, std::size_t )
+                     {
+            return x * y;
+        } );
+        apply_block( b, g, faded_b, []( float x, float y, std::size_t, std::size_t, std::size_t )
+                     {
+            return x * ( 1.0f - y );
+        } );
+        apply_block( faded_a, faded_b, out, []( float x, float y, std::size_t, std::size_t, std::size_t )
+                     {
+            return x + y;
+        } );
+    } );
+    double fused = ms_per_pass( [&]()
+                                {
+        evaluate_block( a * g + b * ( 1.0f - g ), out );
+    } );
+
+    std::cout << std::setw( 12 ) << name << std::fixed << std::setprecision( 2 ) << std::setw( 10 ) << passes
+              << " ms apply_block" << std::setw( 10 ) << fused << " ms fused" << std::endl;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+
+    std::cout << "float " << bench_width << " x " << bench_height << " x " << bench_depth << " crossfade" << std::endl;
+    bench_crossfade<twist2>( "same twist" );
+    bench_crossfade<twist0>( "gain twist0" );
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+/// Time Convolver<float, BlockSize> on two channels of impulse responses from 32k to 256k taps. Prints the mean,
+/// fastest and slowest microseconds per block, and the share of real time that is at 48 kHz.
+
+namespace
+{
+
+const size_t bench_channels = 2;
+const size_t bench_blocks = 400;
+const double sample_rate = 48000.0;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <size_t BlockSize>
+void bench( size_t taps )
+{
+    using namespace Dap;
+    std::unique_ptr<Convolver<float, BlockSize> > convolver( new Convolver<float, BlockSize>( bench_channels, taps ) );
+    std::vector<float> h( taps );
+    for ( size_t i = 0; i < taps; ++i )
+    {
+        h[i] = float( std::exp( -6.9 * double( i ) / taps ) * std::sin( 0.37 * i ) );
+    }
+    convolver->set_impulse_response( h.data(), h.size() );
+
+    Block<float, twist0, BlockSize, bench_channels> buffer;
+    double total = 0.0, fastest = 1e30, slowest = 0.0;
+    for ( size_t b = 0; b < bench_blocks; ++b )
+    {
+        for ( size_t c = 0; c < bench_channels; ++c )
+        {
+            for ( size_t i = 0; i < BlockSize; ++i )
+            {
+                set( buffer, float( std::sin( 0.01 * double( b * BlockSize + i ) + c ) ), i, c );
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        convolver->process( buffer, buffer );
+        auto end = std::chrono::steady_clock::now();
+        consume( buffer.data() );
+        const double us = std::chrono::duration<double, std::micro>( end - start ).count();
+        total += us;
+        fastest = std::min( fastest, us );
+        slowest = std::max( slowest, us );
+    }
+    const double mean = total / bench_blocks;
+    const double budget = 1e6 * BlockSize / sample_rate;
+
+    std::cout << std::setw( 7 ) << taps << " taps, block " << std::setw( 4 ) << BlockSize << ", " << convolver->partitions()
+              << " partitions: " << std::fixed << std::setprecision( 1 ) << mean << " us/block (fastest " << fastest
+              << ", slowest " << slowest << "), " << std::setprecision( 2 ) << 100.0 * mean / budget
+              << "% of real time at 48 kHz" << std::endl;
+}
+}
+
+int main()
+{
+    const size_t taps[] = {32768, 65536, 131072, 262144};
+    for ( size_t t : taps )
+    {
+        bench<256>( t );
+        bench<512>( t );
+    }
+    return 0;
+}
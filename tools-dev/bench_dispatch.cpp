@@ -0,0 +1,122 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/// Time each runtime dispatched kernel variant that the CPU supports.
+/// Prints nanoseconds per sample for each kernel and variant.
+
+namespace
+{
+
+const size_t bench_items = 4096;
+const int bench_repeats = 1000;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename F>
+double time_ns_per_item( std::vector<float> const &out, F f )
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+        consume( out.data() );
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>( end - start ).count();
+    return ns / ( double( bench_repeats ) * bench_items );
+}
+
+void report( std::string const &kernel, Dap::CpuVariant v, double ns )
+{
+    std::cout << std::setw( 12 ) << kernel << " " << std::setw( 8 ) << Dap::cpu_variant_name( v ) << std::fixed
+              << std::setprecision( 3 ) << std::setw( 8 ) << ns << " ns/item" << std::endl;
+}
+
+void bench_variant( Dap::DispatchKernels const &k )
+{
+    using namespace Dap;
+    auto const &f = k.f32;
+    std::vector<float> in( bench_items ), in2( bench_items ), out( bench_items );
+    for ( size_t i = 0; i < bench_items; ++i )
+    {
+        in[i] = 0.5f + float( i ) / float( bench_items );
+        in2[i] = 1.0f - float( i ) / float( bench_items );
+    }
+
+    report( "multiply_add", k.variant, time_ns_per_item( out, [&]() {
+                f.multiply_add( in.data(), in2.data(), out.data(), out.data(), bench_items );
+            } ) );
+
+    static const char *math_names[math_function_count] = {"sin", "cos", "tan", "exp", "exp2", "log", "log2"};
+    for ( size_t m = 0; m < math_function_count; ++m )
+    {
+        report( math_names[m], k.variant,
+                time_ns_per_item( out, [&]() { f.math[m]( in.data(), out.data(), bench_items ); } ) );
+    }
+
+    const size_t channels = 64;
+    std::vector<float> coeffs( channels, 0.1f ), z1( channels, 0.0f ), z2( channels, 0.0f );
+    DispatchBiQuadBank<float> bank
+        = {coeffs.data(), coeffs.data(), coeffs.data(), coeffs.data(), coeffs.data(), z1.data(), z2.data(), channels, channels};
+    report( "biquad_bank", k.variant, time_ns_per_item( out, [&]() {
+                f.biquad_bank( bank, in.data(), out.data(), bench_items / channels, channels );
+            } ) );
+
+    report( "transpose", k.variant,
+            time_ns_per_item( out, [&]() { f.transpose( in.data(), 64, 64, 64, out.data(), 64 ); } ) );
+}
+}
+
+int main()
+{
+    using namespace Dap;
+
+    std::cout << "selected: " << cpu_variant_name( dispatch().variant ) << std::endl;
+    for ( size_t i = 0; i < cpu_variant_count; ++i )
+    {
+        if ( DispatchKernels const *k = dispatch_kernels( static_cast<CpuVariant>( i ) ) )
+        {
+            bench_variant( *k );
+        }
+    }
+
+    return 0;
+}
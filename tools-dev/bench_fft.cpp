@@ -0,0 +1,189 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+/// Time FFT<T, Size> for sizes 64 to 65536: complex, packed real, and batched over the lanes of SIMD_SplitComplex,
+/// against a textbook radix 2 FFT on std::complex. Prints nanoseconds per transform (per channel for the batched
+/// ones) and MFLOPS counted as 5 N log2 N per complex transform.
+
+namespace
+{
+
+const size_t bench_points = size_t( 1 ) << 23;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename F>
+double time_ns_per_transform( size_t size, F f )
+{
+    const size_t repeats = bench_points / size;
+    auto start = std::chrono::steady_clock::now();
+    for ( size_t rep = 0; rep < repeats; ++rep )
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>( end - start ).count() / double( repeats );
+}
+
+/// The iterative radix 2 FFT of the textbooks, with the bit reversal up front and twiddles from a table
+template <typename T>
+void textbook_fft( std::vector<std::complex<T> > &x, std::vector<std::complex<T> > const &twiddles )
+{
+    const size_t n = x.size();
+    for ( size_t i = 1, j = 0; i < n; ++i )
+    {
+        size_t bit = n >> 1;
+        for ( ; j & bit; bit >>= 1 )
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if ( i < j )
+        {
+            std::swap( x[i], x[j] );
+        }
+    }
+    for ( size_t len = 2; len <= n; len <<= 1 )
+    {
+        const size_t step = n / len;
+        for ( size_t i = 0; i < n; i += len )
+        {
+            for ( size_t k = 0; k < len / 2; ++k )
+            {
+                const std::complex<T> u = x[i + k];
+                const std::complex<T> v = x[i + k + len / 2] * twiddles[k * step];
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+            }
+        }
+    }
+}
+
+double mflops( size_t size, double ns )
+{
+    return 5.0 * size * std::log2( double( size ) ) / ns * 1e3;
+}
+
+template <typename T, size_t Size>
+void bench( std::string const &type_name )
+{
+    using namespace Dap;
+    typedef std::complex<T> C;
+    typedef SIMD_SplitComplex<T, simd_native_size<T>::value> Split;
+    typedef SIMD_Vector<T, simd_native_size<T>::value> Real;
+    const size_t lanes = Split::vector_size;
+
+    std::unique_ptr<FFT<T, Size> > fft( new FFT<T, Size> );
+    std::vector<C, aligned_allocator<C> > x( Size ), y( Size );
+    std::vector<T, aligned_allocator<T> > r( Size );
+    std::vector<Split, aligned_allocator<Split> > bx( Size ), by( Size );
+    std::vector<Real, aligned_allocator<Real> > br( Size );
+    std::vector<C> tx( Size ), twiddles( Size / 2 );
+    for ( size_t i = 0; i < Size; ++i )
+    {
+        x[i] = C( T( std::sin( 0.1 * i ) ), T( std::cos( 0.3 * i ) ) );
+        r[i] = x[i].real();
+        splat( bx[i], x[i] );
+        splat( br[i], r[i] );
+    }
+    for ( size_t k = 0; k < Size / 2; ++k )
+    {
+        twiddles[k] = std::polar( T( 1 ), T( -2 * 3.14159265358979323846 * k / Size ) );
+    }
+
+    double textbook_ns = time_ns_per_transform( Size, [&]()
+                                                {
+                                                    tx.assign( x.begin(), x.end() );
+                                                    textbook_fft( tx, twiddles );
+                                                    consume( tx.data() );
+                                                } );
+    double complex_ns = time_ns_per_transform( Size, [&]()
+                                               {
+                                                   fft->forward( x.data(), y.data() );
+                                                   consume( y.data() );
+                                               } );
+    double real_ns = time_ns_per_transform( Size, [&]()
+                                            {
+                                                fft->forward_real( r.data(), y.data() );
+                                                consume( y.data() );
+                                            } );
+    double batched_ns = time_ns_per_transform( Size, [&]()
+                                               {
+                                                   fft->forward( bx.data(), by.data() );
+                                                   consume( by.data() );
+                                               } ) /
+                        lanes;
+    double batched_real_ns = time_ns_per_transform( Size, [&]()
+                                                    {
+                                                        fft->forward_real( br.data(), by.data() );
+                                                        consume( by.data() );
+                                                    } ) /
+                             lanes;
+
+    std::cout << std::setw( 7 ) << type_name << std::setw( 6 ) << Size << std::fixed << std::setprecision( 1 )
+              << ": textbook " << textbook_ns << " ns (" << mflops( Size, textbook_ns ) << " MFLOPS), complex "
+              << complex_ns << " ns (" << mflops( Size, complex_ns ) << "), real " << real_ns << " ns, batched x "
+              << lanes << " " << batched_ns << " ns (" << mflops( Size, batched_ns ) << "), batched real "
+              << batched_real_ns << " ns" << std::endl;
+}
+
+template <typename T>
+void bench_sizes( std::string const &type_name )
+{
+    bench<T, 64>( type_name );
+    bench<T, 256>( type_name );
+    bench<T, 512>( type_name );
+    bench<T, 1024>( type_name );
+    bench<T, 4096>( type_name );
+    bench<T, 8192>( type_name );
+    bench<T, 16384>( type_name );
+    bench<T, 65536>( type_name );
+}
+}
+
+int main()
+{
+    bench_sizes<float>( "float" );
+    bench_sizes<double>( "double" );
+    return 0;
+}
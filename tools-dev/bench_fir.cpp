@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+/// Time FIR<float> against a scalar FIR over a circular history, for 16 to 256 taps, and the multi-channel,
+/// decimating and interpolating forms. Prints nanoseconds per output sample, per channel for the multi-channel one.
+
+namespace
+{
+
+const size_t bench_frames = 4096;
+const int bench_repeats = 200;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename F>
+double time_ns( size_t outputs, F f )
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>( end - start ).count() / ( double( bench_repeats ) * outputs );
+}
+
+/// The textbook FIR: one history slot written per sample, read back with a wrapping index
+struct ScalarFIR
+{
+    std::vector<float> coeffs;
+    std::vector<float> history;
+    size_t position;
+
+    explicit ScalarFIR( std::vector<float> const &c ) : coeffs( c ), history( c.size(), 0.0f ), position( 0 )
+    {
+    }
+
+    void process( float const *in, float *out, size_t frames )
+    {
+        const size_t n = coeffs.size();
+        for ( size_t i = 0; i < frames; ++i )
+        {
+            history[position] = in[i];
+            float sum = 0.0f;
+            size_t k = position;
+            for ( size_t j = 0; j < n; ++j )
+            {
+                sum += coeffs[j] * history[k];
+                k = ( k == 0 ) ? n - 1 : k - 1;
+            }
+            out[i] = sum;
+            position = ( position + 1 == n ) ? 0 : position + 1;
+        }
+    }
+};
+
+void bench( size_t taps )
+{
+    using namespace Dap;
+    typedef SIMD_Vector<float, simd_native_size<float>::value> Frame;
+    const size_t lanes = Frame::vector_size;
+    const size_t factor = 4;
+
+    std::vector<float> h( taps );
+    for ( size_t i = 0; i < taps; ++i )
+    {
+        h[i] = float( std::sin( 0.3 * i ) / ( i + 1 ) );
+    }
+    std::vector<float, aligned_allocator<float> > x( bench_frames ), y( bench_frames * factor );
+    std::vector<Frame, aligned_allocator<Frame> > fx( bench_frames ), fy( bench_frames );
+    for ( size_t i = 0; i < bench_frames; ++i )
+    {
+        x[i] = float( std::sin( 0.01 * i ) );
+        splat( fx[i], x[i] );
+    }
+
+    ScalarFIR scalar( h );
+    FIR<float> fir( h.data(), taps );
+    FIR<Frame> channels;
+    channels.set_coefficients( h.data(), taps );
+    FIR<float> interpolator( h.data(), taps, factor );
+
+    double scalar_ns = time_ns( bench_frames, [&]()
+                                {
+                                    scalar.process( x.data(), y.data(), bench_frames );
+                                    consume( y.data() );
+                                } );
+    double fir_ns = time_ns( bench_frames, [&]()
+                             {
+                                 fir.process( x.data(), y.data(), bench_frames );
+                                 consume( y.data() );
+                             } );
+    double channels_ns = time_ns( bench_frames * lanes, [&]()
+                                  {
+                                      channels.process( fx.data(), fy.data(), bench_frames );
+                                      consume( fy.data() );
+                                  } );
+    double decimate_ns = time_ns( bench_frames / factor, [&]()
+                                  {
+                                      fir.decimate( x.data(), bench_frames, y.data(), factor );
+                                      consume( y.data() );
+                                  } );
+    double interpolate_ns = time_ns( bench_frames * factor, [&]()
+                                     {
+                                         interpolator.interpolate( x.data(), bench_frames, y.data() );
+                                         consume( y.data() );
+                                     } );
+
+    std::cout << std::setw( 4 ) << taps << " taps: " << std::fixed << std::setprecision( 2 ) << "scalar " << scalar_ns
+              << " ns/sample, FIR<float> " << fir_ns << ", " << lanes << " channels " << channels_ns << ", decimate by "
+              << factor << " " << decimate_ns << ", interpolate by " << factor << " " << interpolate_ns << std::endl;
+}
+}
+
+int main()
+{
+    const size_t taps[] = {16, 32, 64, 128, 256};
+    for ( size_t t : taps )
+    {
+        bench( t );
+    }
+    return 0;
+}
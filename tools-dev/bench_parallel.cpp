@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/// Time parallel_apply_block on pools of 1, 2, 4 ... workers up to the number of
+/// hardware threads against the serial apply_block. Prints milliseconds per
+/// pass and the speed up over serial for a memory bound and a compute bound
+/// functor.
+
+namespace
+{
+
+const std::size_t bench_width = 4096;
+const std::size_t bench_height = 256;
+const std::size_t bench_depth = 16;
+const int bench_repeats = 10;
+
+template <typename F>
+double ms_per_pass( F f )
+{
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>( end - start ).count() / bench_repeats;
+}
+
+void report( std::string const &name, std::string const &threads, double ms, double serial_ms )
+{
+    std::cout << std::setw( 8 ) << name << std::setw( 10 ) << threads << std::fixed << std::setprecision( 2 ) << std::setw( 10 )
+              << ms << " ms" << std::setw( 8 ) << serial_ms / ms << "x" << std::endl;
+}
+
+template <typename Functor>
+void bench_functor( std::string const &name, Functor f )
+{
+    using namespace Dap;
+    auto block = make_block<twist2>( 1.0f, bench_width, bench_height, bench_depth );
+
+    double serial_ms = ms_per_pass( [&]()
+                                    {
+        apply_block( block, f );
+    } );
+    report( name, "serial", serial_ms, serial_ms );
+
+    const std::size_t cores = std::max<std::size_t>( 1, std::thread::hardware_concurrency() );
+    for ( std::size_t workers = 1; workers <= cores; workers *= 2 )
+    {
+        ThreadPool pool( workers );
+        double ms = ms_per_pass( [&]()
+                                 {
+            parallel_apply_block( pool, block, f );
+        } );
+        report( name, std::to_string( workers ), ms, serial_ms );
+    }
+}
+}
+
+int main()
+{
+    std::cout << "float " << bench_width << " x " << bench_height << " x " << bench_depth << " on "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    bench_functor( "scale", []( float v, std::size_t, std::size_t, std::size_t )
+                   {
+        return v * 0.999f + 0.001f;
+    } );
+    bench_functor( "math", []( float v, std::size_t, std::size_t, std::size_t )
+                   {
+        return std::sqrt( v + std::sin( v ) * std::cos( v ) );
+    } );
+
+    return 0;
+}
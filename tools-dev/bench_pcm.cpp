@@ -0,0 +1,160 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+/// Time the PCM conversions of the dispatched kernel set against plain scalar loops, for each format, to and from
+/// float, and interleaved stereo PCM to and from a planar Block. Prints nanoseconds per sample.
+
+namespace
+{
+
+const size_t bench_samples = 8192;
+const int bench_repeats = 2000;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename F>
+double time_ns( size_t samples, F f )
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>( end - start ).count() / ( double( bench_repeats ) * samples );
+}
+
+/// The usual byte-wise conversion loops, one sample at a time
+void scalar_decode( unsigned char const *in, size_t bytes, float *out, size_t count )
+{
+    const float scale = 1.0f / float( 1u << ( 8 * bytes - 1 ) );
+    for ( size_t i = 0; i < count; ++i, in += bytes )
+    {
+        std::uint32_t u = 0;
+        for ( size_t b = 0; b < bytes; ++b )
+        {
+            u |= std::uint32_t( in[b] ) << ( 8 * ( 4 - bytes + b ) );
+        }
+        out[i] = float( std::int32_t( u ) >> ( 8 * ( 4 - bytes ) ) ) * scale;
+    }
+}
+
+void scalar_encode( float const *in, unsigned char *out, size_t bytes, size_t count )
+{
+    const double scale = double( 1u << ( 8 * bytes - 1 ) );
+    for ( size_t i = 0; i < count; ++i, out += bytes )
+    {
+        double v = std::lrint( double( in[i] ) * scale );
+        v = v < -scale ? -scale : v > scale - 1 ? scale - 1 : v;
+        const std::uint32_t u = std::uint32_t( std::int32_t( v ) );
+        for ( size_t b = 0; b < bytes; ++b )
+        {
+            out[b] = static_cast<unsigned char>( u >> ( 8 * b ) );
+        }
+    }
+}
+
+void bench( Dap::PCMFormat format, char const *name )
+{
+    using namespace Dap;
+    const size_t bytes = pcm_format_bytes( format );
+    std::vector<float, aligned_allocator<float> > x( bench_samples ), y( bench_samples );
+    std::vector<unsigned char> pcm( bench_samples * bytes );
+    for ( size_t i = 0; i < bench_samples; ++i )
+    {
+        x[i] = float( 0.9 * std::sin( 0.01 * i ) );
+    }
+    auto planar = make_block<twist3>( 0.0f, bench_samples / 2, 2, 1 );
+    PCMDither dither;
+
+    double scalar_decode_ns = time_ns( bench_samples, [&]()
+                                       {
+                                           scalar_decode( pcm.data(), bytes, y.data(), bench_samples );
+                                           consume( y.data() );
+                                       } );
+    double decode_ns = time_ns( bench_samples, [&]()
+                                {
+                                    pcm_decode( pcm.data(), format, y.data(), bench_samples );
+                                    consume( y.data() );
+                                } );
+    double scalar_encode_ns = time_ns( bench_samples, [&]()
+                                       {
+                                           scalar_encode( x.data(), pcm.data(), bytes, bench_samples );
+                                           consume( pcm.data() );
+                                       } );
+    double encode_ns = time_ns( bench_samples, [&]()
+                                {
+                                    pcm_encode( x.data(), pcm.data(), format, bench_samples );
+                                    consume( pcm.data() );
+                                } );
+    double dither_ns = time_ns( bench_samples, [&]()
+                                {
+                                    pcm_encode( x.data(), pcm.data(), format, bench_samples, 1.0f, &dither );
+                                    consume( pcm.data() );
+                                } );
+    double to_block_ns = time_ns( bench_samples, [&]()
+                                  {
+                                      pcm_to_block( pcm.data(), format, planar );
+                                      consume( planar.data() );
+                                  } );
+    double from_block_ns = time_ns( bench_samples, [&]()
+                                    {
+                                        block_to_pcm( planar, pcm.data(), format );
+                                        consume( pcm.data() );
+                                    } );
+
+    std::cout << name << ": " << std::fixed << std::setprecision( 2 ) << "decode scalar " << scalar_decode_ns
+              << " ns/sample, dispatched " << decode_ns << "; encode scalar " << scalar_encode_ns << ", dispatched "
+              << encode_ns << ", dithered " << dither_ns << "; stereo to planar Block " << to_block_ns << ", from "
+              << from_block_ns << std::endl;
+}
+}
+
+int main()
+{
+    std::cout << "selected: " << Dap::cpu_variant_name( Dap::dispatch().variant ) << std::endl;
+    bench( Dap::PCMFormat::int16, "int16" );
+    bench( Dap::PCMFormat::int24, "int24" );
+    bench( Dap::PCMFormat::int32, "int32" );
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+/// Time the complex multiply accumulate y += a * b and its conjugate form over a spectrum, as std::complex,
+/// as interleaved SIMD_Vector<std::complex<T>, N> and as split SIMD_SplitComplex<T, N>.
+/// Prints nanoseconds per complex item.
+
+namespace
+{
+
+const size_t bench_items = 4096;
+const int bench_repeats = 4000;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename F>
+double time_ns_per_item( F f )
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>( end - start ).count() / ( double( bench_repeats ) * bench_items );
+}
+
+template <typename T>
+void bench( std::string const &type_name )
+{
+    using namespace Dap;
+    typedef std::complex<T> C;
+    typedef SIMD_Vector<C, simd_native_size<C>::value> Interleaved;
+    typedef SIMD_SplitComplex<T, simd_native_size<T>::value> Split;
+    const size_t ni = Interleaved::vector_size;
+    const size_t ns = Split::vector_size;
+
+    std::vector<C, aligned_allocator<C> > a( bench_items ), b( bench_items ), y( bench_items );
+    std::vector<T, aligned_allocator<T> > are( bench_items ), aim( bench_items ), bre( bench_items ), bim( bench_items ),
+        yre( bench_items ), yim( bench_items );
+    for ( size_t i = 0; i < bench_items; ++i )
+    {
+        a[i] = C( T( std::sin( 0.1 * i ) ), T( std::cos( 0.3 * i ) ) );
+        b[i] = C( T( std::cos( 0.2 * i ) ), T( std::sin( 0.7 * i ) ) );
+        are[i] = a[i].real();
+        aim[i] = a[i].imag();
+        bre[i] = b[i].real();
+        bim[i] = b[i].imag();
+    }
+
+    double scalar_ns = time_ns_per_item( [&]()
+                                         {
+                                             for ( size_t i = 0; i < bench_items; ++i )
+                                             {
+                                                 y[i] += a[i] * b[i];
+                                             }
+                                             consume( y.data() );
+                                         } );
+    double interleaved_ns = time_ns_per_item( [&]()
+                                              {
+                                                  Interleaved va, vb, vy;
+                                                  for ( size_t i = 0; i < bench_items; i += ni )
+                                                  {
+                                                      va.load( &a[i] );
+                                                      vb.load( &b[i] );
+                                                      vy.load( &y[i] );
+                                                      fma( va, vb, vy ).store( &y[i] );
+                                                  }
+                                                  consume( y.data() );
+                                              } );
+    double split_ns = time_ns_per_item( [&]()
+                                        {
+                                            Split va, vb, vy;
+                                            for ( size_t i = 0; i < bench_items; i += ns )
+                                            {
+                                                va.load( &are[i], &aim[i] );
+                                                vb.load( &bre[i], &bim[i] );
+                                                vy.load( &yre[i], &yim[i] );
+                                                fma( va, vb, vy ).store( &yre[i], &yim[i] );
+                                            }
+                                            consume( yre.data() );
+                                        } );
+    double scalar_conj_ns = time_ns_per_item( [&]()
+                                              {
+                                                  for ( size_t i = 0; i < bench_items; ++i )
+                                                  {
+                                                      y[i] += a[i] * std::conj( b[i] );
+                                                  }
+                                                  consume( y.data() );
+                                              } );
+    double interleaved_conj_ns = time_ns_per_item( [&]()
+                                                   {
+                                                       Interleaved va, vb, vy;
+                                                       for ( size_t i = 0; i < bench_items; i += ni )
+                                                       {
+                                                           va.load( &a[i] );
+                                                           vb.load( &b[i] );
+                                                           vy.load( &y[i] );
+                                                           ( vy + conj_multiply( va, vb ) ).store( &y[i] );
+                                                       }
+                                                       consume( y.data() );
+                                                   } );
+
+    std::cout << std::setw( 16 ) << type_name << std::fixed << std::setprecision( 3 ) << " y += a * b: std::complex "
+              << scalar_ns << " ns/item, interleaved x " << ni << " " << interleaved_ns << " ns/item, split x " << ns << " "
+              << split_ns << " ns/item" << std::endl;
+    std::cout << std::setw( 16 ) << type_name << " y += a * conj( b ): std::complex " << scalar_conj_ns
+              << " ns/item, interleaved x " << ni << " " << interleaved_conj_ns << " ns/item" << std::endl;
+}
+}
+
+int main()
+{
+    bench<float>( "complex<float>" );
+    bench<double>( "complex<double>" );
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <array>
+
+/// Compare the vectorized transcendental functions against a per-lane loop over the std:: functions.
+/// Prints nanoseconds per element for each function and vector type.
+
+namespace
+{
+
+const size_t bench_items = 4096;
+const int bench_repeats = 2000;
+
+template <typename VecT>
+struct PerLane
+{
+    template <typename F>
+    static VecT apply( VecT const &a, F f )
+    {
+        VecT r;
+        for ( size_t i = 0; i < Dap::simd_size<VecT>::value; ++i )
+        {
+            r[i] = f( a[i] );
+        }
+        return r;
+    }
+};
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename VecT>
+struct BenchBuffer
+{
+    // std::array rather than std::vector so that the 32 byte AVX types keep their alignment
+    typedef std::array<VecT, bench_items / Dap::simd_size<VecT>::value> type;
+};
+
+template <typename VecT, typename F>
+double time_ns_per_item( typename BenchBuffer<VecT>::type const &in, typename BenchBuffer<VecT>::type &out, F f )
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        for ( size_t i = 0; i < in.size(); ++i )
+        {
+            out[i] = f( in[i] );
+        }
+        consume( out.data() );
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>( end - start ).count();
+    return ns / ( double( bench_repeats ) * in.size() * Dap::simd_size<VecT>::value );
+}
+
+template <typename VecT, typename VecFunc, typename LaneFunc>
+void bench( std::string const &name, std::string const &type_name, double lo, double hi, VecFunc vf, LaneFunc lf )
+{
+    typedef typename Dap::simd_value_type<VecT>::type value_type;
+    const size_t n = Dap::simd_size<VecT>::value;
+    typename BenchBuffer<VecT>::type in;
+    typename BenchBuffer<VecT>::type out;
+    for ( size_t i = 0; i < in.size(); ++i )
+    {
+        for ( size_t j = 0; j < n; ++j )
+        {
+            in[i][j] = value_type( lo + ( hi - lo ) * double( i * n + j ) / double( bench_items ) );
+        }
+    }
+
+    double vec_ns = time_ns_per_item<VecT>( in, out, vf );
+    double lane_ns = time_ns_per_item<VecT>( in, out, [&]( VecT const &a ) { return PerLane<VecT>::apply( a, lf ); } );
+
+    std::cout << std::setw( 6 ) << name << " " << std::setw( 12 ) << type_name << std::fixed << std::setprecision( 3 )
+              << " vector " << std::setw( 8 ) << vec_ns << " ns/item"
+              << "  per-lane " << std::setw( 8 ) << lane_ns << " ns/item"
+              << "  speedup " << std::setprecision( 2 ) << lane_ns / vec_ns << "x" << std::endl;
+}
+
+template <typename VecT>
+void bench_all( std::string const &type_name )
+{
+    typedef typename Dap::simd_value_type<VecT>::type value_type;
+    using namespace Dap;
+
+    bench<VecT>( "sin", type_name, -100.0, 100.0, []( VecT const &a ) { return sin( a ); },
+                 []( value_type x ) { return std::sin( x ); } );
+    bench<VecT>( "cos", type_name, -100.0, 100.0, []( VecT const &a ) { return cos( a ); },
+                 []( value_type x ) { return std::cos( x ); } );
+    bench<VecT>( "tan", type_name, -100.0, 100.0, []( VecT const &a ) { return tan( a ); },
+                 []( value_type x ) { return std::tan( x ); } );
+    bench<VecT>( "exp", type_name, -80.0, 80.0, []( VecT const &a ) { return exp( a ); },
+                 []( value_type x ) { return std::exp( x ); } );
+    bench<VecT>( "exp2", type_name, -120.0, 120.0, []( VecT const &a ) { return exp2( a ); },
+                 []( value_type x ) { return std::exp2( x ); } );
+    bench<VecT>( "log", type_name, 1e-6, 1e6, []( VecT const &a ) { return log( a ); },
+                 []( value_type x ) { return std::log( x ); } );
+    bench<VecT>( "log2", type_name, 1e-6, 1e6, []( VecT const &a ) { return log2( a ); },
+                 []( value_type x ) { return std::log2( x ); } );
+}
+}
+
+int main()
+{
+    using namespace Dap;
+
+    bench_all<Vec<float, 4> >( "float x 4" );
+    bench_all<Vec<double, 2> >( "double x 2" );
+    bench_all<Vec<float, 8> >( "float x 8" );
+    bench_all<Vec<double, 4> >( "double x 4" );
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2014, Jeff Koftinoff <jeffk@jdkoftinoff.com> and J.D. Koftinoff Software, Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the {organization} nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Dap_World.hpp"
+#include "Dap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/// Time copy_block from a sample-major block into each of the six twists.
+/// Prints GB/s, counting every item once read and once written, for the tiled
+/// transposition and for the item by item gather it replaced. Then time two
+/// chained twists through an intermediate block against one materialize of
+/// the composed twist_view.
+
+namespace
+{
+
+const std::size_t bench_width = 4096;
+const std::size_t bench_height = 64;
+const std::size_t bench_depth = 4;
+const int bench_repeats = 20;
+
+void consume_nothing( void const * )
+{
+}
+
+/// Called through a volatile pointer so the optimizer has to assume the results are used
+void ( *volatile consume )( void const * ) = &consume_nothing;
+
+template <typename F>
+double gbytes_per_second( void const *out, F f )
+{
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for ( int rep = 0; rep < bench_repeats; ++rep )
+    {
+        f();
+        consume( out );
+    }
+    auto end = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>( end - start ).count();
+    double bytes = 2.0 * sizeof( float ) * bench_width * bench_height * bench_depth * bench_repeats;
+    return bytes / s * 1e-9;
+}
+
+template <typename SourceTwist, typename DestinationTwist>
+void bench_twist( std::string const &name )
+{
+    using namespace Dap;
+    auto src = fill_block<float, SourceTwist>( []( std::size_t w, std::size_t h, std::size_t d )
+                                               {
+                                                   return static_cast<float>( w + h + d );
+                                               },
+                                               bench_width,
+                                               bench_height,
+                                               bench_depth );
+    auto dest = make_block<DestinationTwist>( 0.0f, bench_width, bench_height, bench_depth );
+
+    double tiled = gbytes_per_second( dest.data(), [&]()
+                                      {
+        copy_block( src, dest );
+    } );
+    double gathered = gbytes_per_second( dest.data(), [&]()
+                                         {
+        BlockDetail::apply_items( src,
+                                  dest,
+                                  []( float v, std::size_t, std::size_t, std::size_t )
+                                  {
+                                      return v;
+                                  },
+                                  std::false_type() );
+    } );
+
+    std::cout << std::setw( 8 ) << name << std::fixed << std::setprecision( 2 ) << std::setw( 10 ) << tiled
+              << " GB/s tiled" << std::setw( 10 ) << gathered << " GB/s per item" << std::endl;
+}
+
+template <typename SourceTwist>
+void bench_chain()
+{
+    using namespace Dap;
+    using intermediate_twist = typename Twister<SourceTwist, 2>::output_twist;
+    using output_twist = typename Twister<intermediate_twist, 1>::output_twist;
+    auto src = fill_block<float, SourceTwist>( []( std::size_t w, std::size_t h, std::size_t d )
+                                               {
+                                                   return static_cast<float>( w + h + d );
+                                               },
+                                               bench_width,
+                                               bench_height,
+                                               bench_depth );
+    auto intermediate = make_block<intermediate_twist>( 0.0f, bench_width, bench_height, bench_depth );
+    auto dest = make_block<output_twist>( 0.0f, bench_width, bench_height, bench_depth );
+
+    double chained = gbytes_per_second( dest.data(), [&]()
+                                        {
+        copy_block( src, intermediate );
+        copy_block( intermediate, dest );
+    } );
+    double composed = gbytes_per_second( dest.data(), [&]()
+                                         {
+        copy_block( twist_view<1>( twist_view<2>( src ) ), dest );
+    } );
+
+    std::cout << "twist<2> then twist<1>" << std::fixed << std::setprecision( 2 ) << std::setw( 10 ) << chained
+              << " GB/s chained" << std::setw( 10 ) << composed << " GB/s composed view" << std::endl;
+}
+}
+
+int main()
+{
+    using namespace Dap;
+
+    std::cout << "float " << bench_width << " x " << bench_height << " x " << bench_depth << " from twist2" << std::endl;
+    bench_twist<twist2, twist0>( "twist0" );
+    bench_twist<twist2, twist1>( "twist1" );
+    bench_twist<twist2, twist2>( "twist2" );
+    bench_twist<twist2, twist3>( "twist3" );
+    bench_twist<twist2, twist4>( "twist4" );
+    bench_twist<twist2, twist5>( "twist5" );
+    bench_chain<twist2>();
+
+    return 0;
+}